@@ -0,0 +1,911 @@
+#include "../audioProcessor.h"
+#include "../analysisServer.h"
+#include "../captureHistory.h"
+#include "../columnStore.h"
+#include "../fingerprint.h"
+#include "../mfccExtractor.h"
+#include "../reassignment.h"
+#include "../selfSimilarity.h"
+#include "../rtSafety.h"
+#include "../similaritySearch.h"
+#include "../spectrogramPyramid.h"
+#include "../spectralFeatures.h"
+#include "../takeAlignment.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Headless analysis benchmark.
+ *
+ * Feeds a synthetic signal into an AudioQueue in CHUNK-sized blocks, as the recording
+ * callback would, and runs the steady-state analysis loop without a console.
+ *
+ * Usage: analysisBench [--frames N] [--rt-check] [--streams N [--workers W]] [--history] [--reassign] [--features]
+ *                     [--fingerprint [--workers W]] [--similarity [--hours H] [--workers W]] [--mfcc]
+ *                     [--pyramid [--hours H]] [--columns [--hours H]] [--sections [--hours H] [--workers W]]
+ *                     [--align [--hours H]]
+ *   --frames N   Number of analysis frames to time (default 50)
+ *   --rt-check   Mark the loop real-time and fail if it allocates, locks or writes files
+ *                (needs a build with RT_SAFETY_HOOKS)
+ *   --streams N  Instead, time the analysis server with 1, 2, 4, ... up to N streams
+ *   --workers W  Worker threads for --streams (default: hardware threads)
+ *   --history    Instead, time compression and random-access decoding of the capture history
+ *   --reassign   Instead, compare pitch accuracy and cost of long, short and reassigned frames
+ *   --features   Instead, time the fused feature bank against one pass per feature
+ *   --fingerprint  Instead, build a fingerprint index of synthetic tracks and time queries against it
+ *   --similarity   Instead, time feature extraction, and exact against inverted-file nearest-neighbour
+ *                  search over H hours of synthetic feature rows (default 100)
+ *   --mfcc         Instead, time batched MFCC extraction against one frame at a time through Stft
+ *   --pyramid      Instead, time building a spectrogram pyramid over H hours (default 100) and drawing views of it
+ *   --columns      Instead, time recording H hours (default 100) of per-hop results in a column store and querying the last hour
+ *   --sections     Instead, time finding section boundaries in H hours (default 1) of synthetic audio
+ *   --align        Instead, time aligning a take of H hours (default 1) of synthetic chroma against its reference
+ */
+
+/**
+ * @brief Generates one block of a three-note chord.
+ *
+ * @param output Array to store the samples.
+ * @param n Number of samples to generate.
+ * @param start Index of the first sample in the stream.
+ */
+static void synthesize(sample *output, int n, long start)
+{
+    static const double freqs[] = {220.0, 277.18, 329.63}; // A major
+    for (int i = 0; i < n; i++)
+    {
+        double t = static_cast<double>(start + i) / RATE, v = 0;
+        for (double f : freqs)
+            v += std::sin(2 * M_PI * f * t);
+        output[i] = static_cast<sample>(8000 * v);
+    }
+}
+
+/**
+ * @brief Times the analysis server as streams are added.
+ *
+ * One feeder thread pushes synthetic audio into every stream round-robin, as fast as the
+ * server accepts it, so the measured rate is the server's throughput.
+ * @param maxStreams Largest number of streams to time.
+ * @param workers Worker threads in the server.
+ * @return Exit status.
+ */
+static int benchServer(int maxStreams, int workers)
+{
+    const int seconds = 5; // Audio per stream
+    const int hops = seconds * RATE / SERVER_HOP;
+    std::vector<sample> block(SERVER_HOP);
+
+    std::cout << "workers: " << workers << ", frame: " << SERVER_FRAME << ", hop: " << SERVER_HOP << "\n"
+              << "streams  frames/s  x real time  KiB/stream\n";
+    for (int streams = 1; streams <= maxStreams; streams *= 2)
+    {
+        AnalysisServer server(workers);
+        for (int i = 0; i < streams; i++)
+            server.addStream("synthetic" + std::to_string(i));
+        server.start();
+
+        auto begin = std::chrono::steady_clock::now();
+        for (int h = 0; h < hops; h++)
+        {
+            synthesize(block.data(), SERVER_HOP, static_cast<long>(h) * SERVER_HOP);
+            for (int i = 0; i < streams; i++)
+            {
+                while (!server.spaceAvailable(i, SERVER_HOP))
+                    std::this_thread::yield();
+                server.push(i, block.data(), SERVER_HOP);
+            }
+        }
+        server.drain();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+        double framesPerSecond = server.framesAnalyzed() / elapsed;
+        std::cout << streams << "\t " << static_cast<long>(framesPerSecond) << "\t   "
+                  << framesPerSecond * SERVER_HOP / RATE << "\t\t" << server.report(0).memoryBytes / 1024 << "\n";
+    }
+    return 0;
+}
+
+/**
+ * @brief Times the capture history codec on a minute of synthetic audio with a little noise.
+ *
+ * @return Exit status; 1 if any decoded range differs from the input.
+ */
+static int benchHistory()
+{
+    const int seconds = 60;
+    const int total = seconds * RATE / HISTORY_BLOCK * HISTORY_BLOCK;
+    std::vector<sample> signal(total), output(RATE);
+    synthesize(signal.data(), total, 0);
+    unsigned seed = 1;
+    for (sample &s : signal)
+    {
+        seed = seed * 1103515245u + 12345u;
+        s += static_cast<sample>((seed >> 26) - 32); // Microphone-like noise floor
+    }
+
+    CaptureHistory history(size_t(1) << 30, HISTORY_RAW);
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < total; i += CHUNK)
+    {
+        history.write(signal.data() + i, CHUNK, 0);
+        if (i % HISTORY_BLOCK == 0)
+            history.compressPending();
+    }
+    history.compressPending();
+    double encodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    // Decode one-second ranges at pseudo-random positions outside the raw ring
+    const int reads = 200;
+    uint64_t compressedEnd = total - HISTORY_RAW;
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < reads; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        uint64_t position = seed % (compressedEnd - RATE);
+        if (!history.read(position, output.data(), RATE) || !std::equal(output.begin(), output.end(), signal.begin() + position))
+        {
+            std::cout << "history read at " << position << " does not match the input\n";
+            return 1;
+        }
+    }
+    double decodeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "history: " << seconds << " s of audio, " << history.compressedBytes() / 1024 << " KiB compressed, ratio "
+              << history.compressionRatio() << "\n"
+              << "encode: " << seconds / encodeSeconds << "x real time\n"
+              << "decode: " << reads / decodeSeconds << "x real time (random 1 s ranges)\n";
+    return 0;
+}
+
+/**
+ * @brief Peak frequency of a magnitude spectrum, optionally refined by parabolic interpolation.
+ */
+static double peakFrequency(const std::vector<float> &magnitude, int bins, int frameSize, bool interpolate)
+{
+    int best = static_cast<int>(std::max_element(magnitude.begin() + 2, magnitude.begin() + bins - 1) - magnitude.begin());
+    double offset = 0;
+    if (interpolate)
+    {
+        double left = magnitude[best - 1], m = magnitude[best], right = magnitude[best + 1];
+        offset = 0.5 * (left - right) / (left - 2 * m + right);
+    }
+    return (best + offset) * RATE / frameSize;
+}
+
+/**
+ * @brief Compares pitch accuracy against cost for the tuner's frame choices.
+ *
+ * Each trial is a random fundamental between 80 Hz and 1 kHz with two weaker harmonics and a
+ * noise floor. Errors are in cents from the true fundamental.
+ * @return Exit status.
+ */
+static int benchReassign()
+{
+    const int trials = 200;
+    struct Method
+    {
+        const char *name;
+        int frameSize;
+        int mode; // 0 peak bin, 1 parabolic, 2 reassigned
+        double totalError = 0, maxError = 0, seconds = 0;
+    };
+    Method methods[] = {{"65536 peak bin", FFTLEN, 0}, {"65536 parabolic", FFTLEN, 1}, {"4096 parabolic", REASSIGN_FRAME, 1}, {"4096 reassigned", REASSIGN_FRAME, 2}};
+
+    Stft longFrame(FFTLEN), shortFrame(REASSIGN_FRAME);
+    ReassignedStft analyzer(REASSIGN_FRAME);
+    std::vector<float> magnitude(longFrame.bins()), frequency(analyzer.bins());
+    std::vector<sample> signal(FFTLEN + 1);
+    unsigned seed = 7;
+    for (int t = 0; t < trials; t++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        double fundamental = 80 * std::pow(12.5, (seed >> 8) / 16777216.0);
+        for (size_t i = 0; i < signal.size(); i++)
+        {
+            double phase = 2 * M_PI * fundamental * i / RATE;
+            seed = seed * 1103515245u + 12345u;
+            signal[i] = static_cast<sample>(8000 * std::sin(phase) + 4000 * std::sin(2 * phase + 1) + 2400 * std::sin(3 * phase + 2) + static_cast<int>(seed >> 25) - 64);
+        }
+
+        for (Method &method : methods)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            double estimate;
+            if (method.mode == 2)
+            {
+                analyzer.analyze(signal.data(), magnitude.data(), frequency.data());
+                estimate = reassignedPeakFrequency(magnitude.data(), frequency.data(), analyzer.bins());
+            }
+            else
+            {
+                Stft &stft = method.frameSize == FFTLEN ? longFrame : shortFrame;
+                stft.magnitude(signal.data(), magnitude.data());
+                estimate = peakFrequency(magnitude, stft.bins(), method.frameSize, method.mode == 1);
+            }
+            method.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            double error = std::abs(1200 * std::log2(estimate / fundamental));
+            method.totalError += error;
+            method.maxError = std::max(method.maxError, error);
+        }
+    }
+
+    for (const Method &method : methods)
+        std::cout << method.name << ": mean error " << method.totalError / trials << " cents, max " << method.maxError << " cents, "
+                  << method.seconds / trials * 1e6 << " us/frame, latency " << 1000.0 * method.frameSize / RATE << " ms\n";
+    return 0;
+}
+
+/**
+ * @brief Times all spectral descriptors in one fused pass against one pass per descriptor.
+ *
+ * Runs on FFTLEN-point spectra, so each pass reads FFTLEN / 2 + 1 bins.
+ * @param frames Number of spectra to time.
+ * @return Exit status.
+ */
+static int benchFeatures(int frames)
+{
+    Stft stft(FFTLEN);
+    std::vector<sample> signal(FFTLEN);
+    for (int i = 0; i < FFTLEN; i++)
+        synthesize(signal.data() + i, 1, i);
+    std::vector<float> magnitude(stft.bins());
+    stft.magnitude(signal.data(), magnitude.data());
+
+    float binHz = static_cast<float>(RATE) / FFTLEN;
+    FeatureBank<AllFeatures> fused(stft.bins(), binHz);
+    FeatureBank<FeatureCentroid> centroid(stft.bins(), binHz);
+    FeatureBank<FeatureSpread> spread(stft.bins(), binHz);
+    FeatureBank<FeatureRolloff> rolloff(stft.bins(), binHz);
+    FeatureBank<FeatureFlatness> flatness(stft.bins(), binHz);
+    FeatureBank<FeatureFlux> flux(stft.bins(), binHz);
+    FeatureBank<FeatureBandEnergy> bands(stft.bins(), binHz);
+    SpectralFeatures features;
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+        fused.compute(magnitude.data(), features);
+    double fusedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++)
+    {
+        centroid.compute(magnitude.data(), features);
+        spread.compute(magnitude.data(), features);
+        rolloff.compute(magnitude.data(), features);
+        flatness.compute(magnitude.data(), features);
+        flux.compute(magnitude.data(), features);
+        bands.compute(magnitude.data(), features);
+    }
+    double separateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << stft.bins() << " bins: fused " << fusedSeconds / frames * 1e6 << " us/frame, one pass per feature "
+              << separateSeconds / frames * 1e6 << " us/frame (centroid " << features.centroid << " Hz)\n";
+    return 0;
+}
+
+/**
+ * @brief Builds a fingerprint index over synthetic tracks and measures it.
+ *
+ * Tracks are random melodies of three-partial notes. Queries are 4 s excerpts at random
+ * positions, at half level with added noise. Reports build speed, index bytes per hour of audio,
+ * query throughput and accuracy.
+ * @param workers Threads for building and querying.
+ * @return Exit status.
+ */
+static int benchFingerprint(int workers)
+{
+    const int trackCount = 16, queries = 64;
+    const double trackSeconds = 120, querySeconds = 4;
+    unsigned seed = 11;
+    auto next = [&seed]()
+    {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 8;
+    };
+
+    std::vector<std::string> names;
+    std::vector<std::vector<sample>> tracks(trackCount);
+    for (int t = 0; t < trackCount; t++)
+    {
+        names.push_back("track" + std::to_string(t));
+        tracks[t].resize(static_cast<size_t>(trackSeconds * RATE));
+        double f[3] = {0, 0, 0}, phase[3] = {0, 0, 0};
+        for (size_t i = 0; i < tracks[t].size(); i++)
+        {
+            if (i % (RATE / 6) == 0)
+                for (double &frequency : f)
+                    frequency = 150 * std::pow(2.0, next() % 48 / 12.0);
+            double value = 0;
+            for (int p = 0; p < 3; p++)
+                value += std::sin(phase[p] += 2 * M_PI * f[p] / RATE);
+            tracks[t][i] = static_cast<sample>(6000 * value + static_cast<int>(next() % 1024) - 512);
+        }
+    }
+
+    FingerprintIndex index;
+    auto begin = std::chrono::steady_clock::now();
+    index.build(names, tracks, workers);
+    double buildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<std::vector<sample>> clips(queries);
+    std::vector<int> truth(queries);
+    std::vector<double> starts(queries);
+    for (int q = 0; q < queries; q++)
+    {
+        truth[q] = static_cast<int>(next() % trackCount);
+        size_t start = next() % static_cast<size_t>((trackSeconds - querySeconds) * RATE);
+        starts[q] = static_cast<double>(start) / RATE;
+        clips[q].assign(tracks[truth[q]].begin() + start, tracks[truth[q]].begin() + start + static_cast<size_t>(querySeconds * RATE));
+        for (sample &s : clips[q])
+            s = static_cast<sample>(s / 2 + static_cast<int>(next() % 4096) - 2048);
+    }
+
+    begin = std::chrono::steady_clock::now();
+    std::vector<FingerprintMatch> matches = index.queryBatch(clips, workers);
+    double querySecondsTotal = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    int correct = 0;
+    for (int q = 0; q < queries; q++)
+        correct += matches[q].track == truth[q] && std::abs(matches[q].offsetSeconds - starts[q]) < 0.05;
+
+    std::cout << "index: " << trackCount << " tracks, " << index.audioHours() * 60 << " min, built in " << buildSeconds << " s ("
+              << index.audioHours() * 3600 / buildSeconds << "x real time) with " << workers << " workers\n"
+              << "size: " << index.landmarkCount() << " landmarks, " << index.indexBytes() / 1048576.0 << " MiB, "
+              << index.indexBytes() / index.audioHours() / 1048576.0 << " MiB per hour\n"
+              << "queries: " << queries / querySecondsTotal << " per second, " << correct << "/" << queries << " correct\n";
+    return 0;
+}
+
+/**
+ * @brief Times similarity features and nearest-neighbour search over a large synthetic library.
+ *
+ * Extraction speed is measured on a minute of the chord signal. The library is hours of feature
+ * rows built like music: runs of 8 to 40 rows that stay near one of 4096 random prototypes.
+ * Queries are library rows with added noise; inverted-file results are compared with the exact
+ * top 10.
+ * @param hours Hours of audio the library stands for.
+ * @param workers Threads for training.
+ * @return Exit status.
+ */
+static int benchSimilarity(double hours, int workers)
+{
+    const int prototypes = 4096, queries = 200, k = 10;
+    const size_t fileRows = 10 * 60 * RATE / SIMILARITY_HOP;
+    unsigned seed = 23;
+    auto uniform = [&seed]()
+    {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<float>(seed >> 8) / (1 << 24);
+    };
+
+    std::vector<sample> audio(60 * RATE);
+    synthesize(audio.data(), static_cast<int>(audio.size()), 0);
+    std::vector<float> rows;
+    auto begin = std::chrono::steady_clock::now();
+    extractSimilarityFeatures(audio.data(), audio.size(), rows);
+    double extractSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<float> centers(static_cast<size_t>(prototypes) * SIMILARITY_DIMS);
+    for (float &value : centers)
+        value = uniform() * 2 - 1;
+    size_t totalRows = static_cast<size_t>(hours * 3600 * RATE / SIMILARITY_HOP);
+    std::vector<std::string> names;
+    std::vector<std::vector<float>> files;
+    for (size_t made = 0; made < totalRows; made += files.back().size() / SIMILARITY_DIMS)
+    {
+        names.push_back("file" + std::to_string(files.size()));
+        files.emplace_back(std::min(fileRows, totalRows - made) * SIMILARITY_DIMS);
+        const float *center = centers.data();
+        for (size_t i = 0, runLeft = 0; i < files.back().size(); i++)
+        {
+            if (i % SIMILARITY_DIMS == 0 && runLeft-- == 0)
+            {
+                center = centers.data() + static_cast<size_t>(uniform() * prototypes) * SIMILARITY_DIMS;
+                runLeft = 8 + static_cast<size_t>(uniform() * 32);
+            }
+            files.back()[i] = center[i % SIMILARITY_DIMS] + (uniform() - 0.5f) * 0.2f;
+        }
+    }
+    FeatureMatrix matrix;
+    matrix.setFeatures(names, files);
+    std::vector<std::vector<float>>().swap(files);
+
+    SimilarityIndex index(matrix);
+    begin = std::chrono::steady_clock::now();
+    index.train(0, workers);
+    double trainSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<std::vector<float>> probes(queries, std::vector<float>(SIMILARITY_DIMS));
+    for (std::vector<float> &query : probes)
+    {
+        const uint16_t *row = matrix.row(static_cast<size_t>(uniform() * matrix.rowCount()));
+        for (int d = 0; d < SIMILARITY_DIMS; d++)
+            query[d] = halfToFloat(row[d]) + (uniform() - 0.5f) * 0.1f;
+    }
+    std::vector<std::vector<SimilarityMatch>> exact(queries), approximate(queries);
+    begin = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries / 10; q++)
+        exact[q] = index.exact(probes[q].data(), k);
+    double exactSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / (queries / 10);
+    begin = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+        approximate[q] = index.search(probes[q].data(), k);
+    double searchSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / queries;
+
+    int found = 0;
+    for (int q = 0; q < queries / 10; q++)
+        for (const SimilarityMatch &truth : exact[q])
+            for (const SimilarityMatch &match : approximate[q])
+                found += match.row == truth.row;
+
+    std::cout << "extraction: " << 60 / extractSeconds << "x real time\n"
+              << "library: " << matrix.audioHours() << " h, " << matrix.rowCount() << " rows, " << matrix.bytes() / 1048576.0 << " MiB of half floats\n"
+              << "training: " << index.listCount() << " lists in " << trainSeconds << " s with " << workers << " workers\n"
+              << "exact: " << exactSeconds * 1e3 << " ms per query\n"
+              << "inverted file: " << searchSeconds * 1e3 << " ms per query (" << SEARCH_PROBES << " probes), recall@" << k << " "
+              << 100.0 * found / (queries / 10 * k) << "%\n";
+    return 0;
+}
+
+/**
+ * @brief Times batched MFCC extraction against the same features one frame at a time.
+ *
+ * The per-frame path is what a caller would write with Stft: a magnitude spectrum, squared, then
+ * the filterbank and the same precomputed DCT for every frame. Both run over ten minutes of the chord signal.
+ * @return Exit status.
+ */
+static int benchMfcc()
+{
+    const double seconds = 600;
+    std::vector<sample> audio(static_cast<size_t>(seconds * RATE));
+    synthesize(audio.data(), static_cast<int>(audio.size()), 0);
+
+    MfccExtractor extractor;
+    std::vector<float> batched;
+    auto begin = std::chrono::steady_clock::now();
+    extractor.extract(audio.data(), audio.size(), batched);
+    double batchedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    Stft stft(MFCC_FRAME);
+    Filterbank mel(MFCC_MEL_BANDS, MFCC_FRAME, MFCC_MIN_FREQ, MFCC_MAX_FREQ);
+    std::vector<float> power(stft.bins()), bands(MFCC_MEL_BANDS), single(batched.size()), dct(MFCC_COEFFICIENTS * MFCC_MEL_BANDS);
+    for (int c = 0; c < MFCC_COEFFICIENTS; c++)
+        for (int b = 0; b < MFCC_MEL_BANDS; b++)
+            dct[c * MFCC_MEL_BANDS + b] = static_cast<float>(std::sqrt((c == 0 ? 1.0 : 2.0) / MFCC_MEL_BANDS) * std::cos(M_PI * c * (b + 0.5) / MFCC_MEL_BANDS));
+    size_t frames = extractor.frameCount(audio.size());
+    begin = std::chrono::steady_clock::now();
+    for (size_t f = 0; f < frames; f++)
+    {
+        stft.magnitude(audio.data() + f * MFCC_HOP, power.data());
+        for (float &p : power)
+            p *= p;
+        mel.applyLog(power.data(), bands.data());
+        for (int c = 0; c < MFCC_COEFFICIENTS; c++)
+        {
+            float sum = 0;
+            for (int b = 0; b < MFCC_MEL_BANDS; b++)
+                sum += bands[b] * dct[c * MFCC_MEL_BANDS + b];
+            single[f * MFCC_COEFFICIENTS + c] = sum;
+        }
+    }
+    double singleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "mfcc: " << frames << " frames of " << MFCC_FRAME << " samples, hop " << MFCC_HOP << ", " << MFCC_COEFFICIENTS << " coefficients\n"
+              << "batched:   " << batchedSeconds / frames * 1e6 << " us/frame, " << seconds / batchedSeconds << "x real time\n"
+              << "per frame: " << singleSeconds / frames * 1e6 << " us/frame, " << seconds / singleSeconds << "x real time\n";
+    return 0;
+}
+
+/**
+ * @brief Times appending to a spectrogram pyramid and drawing views from it.
+ *
+ * Columns are synthetic PYRAMID_BANDS-band spectra at the overview rate. Views of the whole
+ * recording, an hour and a minute are drawn 200 columns wide from the pyramid and, for the whole
+ * recording, by pooling every column of the spectrogram directly.
+ * @param hours Hours of overview columns.
+ * @return Exit status.
+ */
+static int benchPyramid(double hours)
+{
+    const int width = 200;
+    const uint64_t columns = static_cast<uint64_t>(hours * 3600 * RATE / PYRAMID_FRAME);
+    SpectrogramPyramid pyramid;
+    std::vector<float> column(PYRAMID_BANDS);
+    unsigned seed = 3;
+    auto begin = std::chrono::steady_clock::now();
+    for (uint64_t c = 0; c < columns; c++)
+    {
+        for (float &level : column)
+        {
+            seed = seed * 1103515245u + 12345u;
+            level = -100.0f + (seed >> 25);
+        }
+        pyramid.append(column.data());
+    }
+    double appendSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::vector<float> view(static_cast<size_t>(width) * PYRAMID_BANDS);
+    auto timeView = [&](uint64_t span)
+    {
+        const int repeats = 100;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++)
+            pyramid.render(columns - std::min(span, columns), columns, width, view.data());
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() / repeats;
+    };
+    double wholeSeconds = timeView(columns), hourSeconds = timeView(3600 * RATE / PYRAMID_FRAME), minuteSeconds = timeView(60 * RATE / PYRAMID_FRAME);
+
+    // The same whole-recording view by reading every spectrogram column
+    std::vector<float> pooled(PYRAMID_BANDS), one(PYRAMID_BANDS);
+    begin = std::chrono::steady_clock::now();
+    for (int x = 0; x < width; x++)
+    {
+        std::fill(pooled.begin(), pooled.end(), PYRAMID_FLOOR_DB);
+        for (uint64_t c = columns * x / width; c < columns * (x + 1) / width; c++)
+        {
+            pyramid.render(c, c + 1, 1, one.data());
+            for (int b = 0; b < PYRAMID_BANDS; b++)
+                pooled[b] = std::max(pooled[b], one[b]);
+        }
+    }
+    double directSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    std::cout << "pyramid: " << columns << " columns (" << hours << " h) in " << pyramid.levelCount() << " levels, "
+              << pyramid.bytes() / 1048576.0 << " MiB, " << appendSeconds / columns * 1e9 << " ns per append\n"
+              << "view " << width << " wide: whole " << wholeSeconds * 1e6 << " us, hour " << hourSeconds * 1e6 << " us, minute "
+              << minuteSeconds * 1e6 << " us\n"
+              << "whole view from every column: " << directSeconds * 1e3 << " ms\n";
+    return 0;
+}
+
+/**
+ * @brief Times appending per-hop results to a column store and querying the last hour.
+ *
+ * Rows mimic practice: notes held for about a second with drifting cents, a chord that changes
+ * every few seconds, a slowly varying level and an onset per note. The last hour is summarized
+ * with the time out of tune by more than 10 cents, and the same number is computed by scanning
+ * the whole cents column.
+ * @param hours Hours of rows.
+ * @return Exit status.
+ */
+static int benchColumns(double hours)
+{
+    const std::string directory = "analysisBench.columns";
+    std::filesystem::remove_all(directory);
+    const uint64_t rows = static_cast<uint64_t>(hours * 3600 * RATE / 512);
+    const int64_t start = 1700000000000;
+    auto rowTime = [&](uint64_t row)
+    { return start + static_cast<int64_t>(row * 512 * 1000 / RATE); };
+
+    double appendSeconds, outOfTune = 0, scanned = 0, querySeconds, scanSeconds;
+    uint64_t bytes, decoded;
+    {
+        ColumnStore store(directory, {{"pitch", ColumnType::Float}, {"cents", ColumnType::Float}, {"chord", ColumnType::Text}, {"rms", ColumnType::Float}, {"onset", ColumnType::Int}});
+        int chord = store.column("chord");
+        for (const char *name : {"", "C", "Am", "F", "G7"})
+            store.textCode(chord, name);
+        unsigned seed = 9;
+        double values[5];
+        auto begin = std::chrono::steady_clock::now();
+        for (uint64_t r = 0; r < rows; r++)
+        {
+            uint64_t note = r / 86;
+            seed = seed * 1103515245u + 12345u;
+            bool resting = note % 16 == 15;
+            values[0] = resting ? 0 : 110.0 * std::pow(2.0, (note * 7 % 24) / 12.0);
+            values[1] = resting ? 0 : static_cast<float>(15 * std::sin(note * 0.7) + (r % 86) * 0.1);
+            values[2] = resting ? 0 : 1 + static_cast<double>((r / 400) % 4);
+            values[3] = static_cast<float>(-30 + 10 * std::sin(r * 1e-3) + (seed >> 29));
+            values[4] = r % 86 == 0 ? 1 : 0;
+            store.append(rowTime(r), values);
+        }
+        store.flush();
+        appendSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        bytes = store.bytesOnDisk();
+
+        const double infinity = std::numeric_limits<double>::infinity();
+        int cents = store.column("cents");
+        int64_t to = store.lastTime() + 1, from = to - 3600 * 1000;
+        begin = std::chrono::steady_clock::now();
+        outOfTune = store.secondsWithin(cents, std::nextafter(10.0f, 100.0f), infinity, from, to) +
+                    store.secondsWithin(cents, -infinity, std::nextafter(-10.0f, -100.0f), from, to);
+        querySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        decoded = store.blocksDecoded();
+
+        std::vector<int64_t> times;
+        std::vector<double> centsValues;
+        begin = std::chrono::steady_clock::now();
+        store.scan(cents, store.lastTime() - static_cast<int64_t>(hours * 3600 * 1000), to, times, centsValues);
+        for (size_t i = 0; i + 1 < times.size(); i++)
+            if (times[i] >= from && std::fabs(centsValues[i]) > 10)
+                scanned += std::min<int64_t>(times[i + 1] - times[i], COLUMN_MAX_GAP_MS) / 1000.0;
+        scanSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    std::filesystem::remove_all(directory);
+
+    std::cout << "columns: " << rows << " rows (" << hours << " h), " << appendSeconds / rows * 1e9 << " ns per row, "
+              << static_cast<double>(bytes) / rows << " bytes per row (" << 6 * 8.0 * rows / bytes << "x smaller than doubles)\n"
+              << "out of tune in the last hour: " << outOfTune << " s in " << querySeconds * 1e3 << " ms, " << decoded << " blocks decoded\n"
+              << "same from a scan of the whole column: " << scanned << " s in " << scanSeconds * 1e3 << " ms\n";
+    return 0;
+}
+
+/**
+ * @brief Times section segmentation of a long synthetic rehearsal.
+ *
+ * The audio changes chord every 90 s, with a little noise. Feature extraction, the banded
+ * self-similarity matrix and the novelty curve are timed separately, with the given workers.
+ * @param hours Hours of audio.
+ * @param workers Worker threads.
+ * @return Exit status.
+ */
+static int benchSections(double hours, int workers)
+{
+    const size_t n = static_cast<size_t>(hours * 3600 * RATE);
+    const int sectionSeconds = 90;
+    std::vector<float> table(4096);
+    for (size_t i = 0; i < table.size(); i++)
+        table[i] = static_cast<float>(std::sin(2 * M_PI * i / table.size()));
+    std::vector<sample> audio(n);
+    unsigned seed = 5;
+    double phases[3] = {0, 0, 0};
+    for (size_t i = 0; i < n; i++)
+    {
+        int root = static_cast<int>(i / (static_cast<size_t>(sectionSeconds) * RATE) * 5 % 12);
+        float value = 0;
+        for (int t = 0; t < 3; t++)
+        {
+            phases[t] += 220.0 * std::exp2((root + 4 * t - (t == 2)) / 12.0) / RATE; // Root, major third, fifth
+            phases[t] -= std::floor(phases[t]);
+            value += table[static_cast<size_t>(phases[t] * table.size())];
+        }
+        seed = seed * 1103515245u + 12345u;
+        audio[i] = static_cast<sample>(4000 * value + static_cast<int>(seed >> 22) - 512);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<float> features, curve;
+    extractSimilarityFeatures(audio.data(), n, features, workers);
+    double extractSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    int frames = static_cast<int>(features.size() / SIMILARITY_DIMS);
+
+    SelfSimilarity matrix;
+    begin = std::chrono::steady_clock::now();
+    matrix.compute(features.data(), frames, SIMILARITY_DIMS, SSM_BAND, workers);
+    double matrixSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    begin = std::chrono::steady_clock::now();
+    matrix.novelty(curve, NOVELTY_KERNEL, workers);
+    std::vector<int> peaks = noveltyPeaks(curve);
+    double noveltySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    int found = 0;
+    for (int peak : peaks)
+    {
+        double seconds = static_cast<double>(peak) * SIMILARITY_HOP / RATE;
+        double offset = std::fmod(seconds, sectionSeconds);
+        found += std::min(offset, sectionSeconds - offset) < 1.0;
+    }
+    std::cout << "sections: " << frames << " frames (" << hours << " h) with " << workers << " workers: features " << extractSeconds
+              << " s, similarity band " << matrixSeconds * 1e3 << " ms, novelty " << noveltySeconds * 1e3 << " ms\n"
+              << "band of " << SSM_BAND << " lags: " << matrix.memoryBytes() / 1048576.0 << " MiB (full matrix "
+              << static_cast<double>(frames) * frames * sizeof(float) / 1048576.0 << " MiB)\n"
+              << peaks.size() << " boundaries, " << found << " within 1 s of the " << static_cast<int>(hours * 3600 / sectionSeconds) - 1 << " chord changes\n";
+    return 0;
+}
+
+/**
+ * @brief Times aligning a long take against its reference by multiscale DTW and by a fixed band.
+ *
+ * The reference is chroma of notes lasting 8 to 40 frames, each frame with its own noise. The
+ * take plays it with a tempo drifting 20% either side over ten-minute swings, plus a little noise
+ * of its own, so where each take frame belongs is known. A frame is counted as aligned when the
+ * path puts it within two frames (0.2 s) of that.
+ * @param hours Hours of reference.
+ * @return Exit status.
+ */
+static int benchAlign(double hours)
+{
+    const int dims = SIMILARITY_CHROMA;
+    const int n = static_cast<int>(hours * 3600 * RATE / SIMILARITY_HOP);
+    const double period = 600.0 * RATE / SIMILARITY_HOP;
+    unsigned seed = 31;
+    auto random = [&seed]()
+    {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<float>(seed >> 8) / (1u << 24);
+    };
+    auto normalize = [dims](float *row)
+    {
+        float energy = 0;
+        for (int d = 0; d < dims; d++)
+            energy += row[d] * row[d];
+        for (int d = 0; d < dims; d++)
+            row[d] /= std::sqrt(energy);
+    };
+
+    std::vector<float> reference(static_cast<size_t>(n) * dims), note(dims);
+    for (int i = 0, left = 0; i < n; i++, left--)
+    {
+        if (left == 0)
+        {
+            for (float &value : note)
+                value = random() < 0.25f ? 1.0f : 0.05f;
+            left = 8 + static_cast<int>(random() * 33);
+        }
+        for (int d = 0; d < dims; d++)
+            reference[static_cast<size_t>(i) * dims + d] = note[d] + 0.3f * random();
+        normalize(&reference[static_cast<size_t>(i) * dims]);
+    }
+    std::vector<double> truth; // Reference frame played by each take frame
+    std::vector<float> take;
+    for (double position = 0; position < n - 1; position += 1 + 0.2 * std::sin(2 * M_PI * truth.size() / period))
+    {
+        truth.push_back(position);
+        int i = static_cast<int>(std::lround(position));
+        for (int d = 0; d < dims; d++)
+            take.push_back(reference[static_cast<size_t>(i) * dims + d] + 0.1f * random());
+        normalize(&take[take.size() - dims]);
+    }
+    const int m = static_cast<int>(truth.size());
+
+    auto accuracy = [&](const std::vector<WarpStep> &path)
+    {
+        size_t good = 0;
+        for (const WarpStep &step : path)
+            good += std::fabs(step.first - truth[step.second]) <= 2;
+        return 100.0 * good / path.size();
+    };
+
+    size_t cells = 0, bytes = 0;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<WarpStep> path = multiscaleDtw(reference.data(), n, take.data(), m, dims, DTW_RADIUS, &cells, &bytes);
+    double multiscaleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "align: " << n << " reference and " << m << " take frames (" << hours << " h), full matrix "
+              << static_cast<double>(n) * m * sizeof(float) / 1048576.0 << " MiB\n"
+              << "multiscale, radius " << DTW_RADIUS << ": " << multiscaleSeconds * 1e3 << " ms, " << cells / 1e6 << " M cells ("
+              << cells / multiscaleSeconds / 1e6 << " M per second), " << bytes / 1048576.0 << " MiB, " << accuracy(path) << "% of frames aligned\n";
+
+    const int radius = m / 20;
+    begin = std::chrono::steady_clock::now();
+    Dtw dtw(reference.data(), n, take.data(), m, dims);
+    DtwWindow band = DtwWindow::band(n, m, radius);
+    dtw.align(band, path);
+    double bandSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "band, radius " << radius << ": " << bandSeconds * 1e3 << " ms, " << dtw.cellsEvaluated() / 1e6 << " M cells ("
+              << dtw.cellsEvaluated() / bandSeconds / 1e6 << " M per second), " << dtw.peakBytes() / 1048576.0 << " MiB, "
+              << accuracy(path) << "% of frames aligned\n";
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    int frames = 50, streams = 0;
+    int workers = std::max(1u, std::thread::hardware_concurrency());
+    double hours = 0; // 0 takes each mode's default
+    bool rtCheck = false, fingerprint = false, similarity = false, pyramid = false, columns = false, sections = false, align = false;
+    for (int i = 1; i < argc; i++)
+    {
+        if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+            frames = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--rt-check"))
+            rtCheck = true;
+        else if (!std::strcmp(argv[i], "--streams") && i + 1 < argc)
+            streams = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--workers") && i + 1 < argc)
+            workers = std::stoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "--history"))
+            return benchHistory();
+        else if (!std::strcmp(argv[i], "--reassign"))
+            return benchReassign();
+        else if (!std::strcmp(argv[i], "--features"))
+            return benchFeatures(frames);
+        else if (!std::strcmp(argv[i], "--fingerprint"))
+            fingerprint = true;
+        else if (!std::strcmp(argv[i], "--mfcc"))
+            return benchMfcc();
+        else if (!std::strcmp(argv[i], "--similarity"))
+            similarity = true;
+        else if (!std::strcmp(argv[i], "--pyramid"))
+            pyramid = true;
+        else if (!std::strcmp(argv[i], "--columns"))
+            columns = true;
+        else if (!std::strcmp(argv[i], "--sections"))
+            sections = true;
+        else if (!std::strcmp(argv[i], "--align"))
+            align = true;
+        else if (!std::strcmp(argv[i], "--hours") && i + 1 < argc)
+            hours = std::stod(argv[++i]);
+    }
+    if (similarity)
+        return benchSimilarity(hours > 0 ? hours : 100, workers);
+    if (pyramid)
+        return benchPyramid(hours > 0 ? hours : 100);
+    if (columns)
+        return benchColumns(hours > 0 ? hours : 100);
+    if (sections)
+        return benchSections(hours > 0 ? hours : 1, workers);
+    if (align)
+        return benchAlign(hours > 0 ? hours : 1);
+    if (fingerprint)
+        return benchFingerprint(workers);
+    if (streams > 0)
+        return benchServer(streams, workers);
+
+    AudioQueue queue(4 * FFTLEN);
+    std::vector<sample> block(CHUNK), workingBuffer(FFTLEN), spectrum(FFTLEN);
+    long position = 0;
+    const int hop = FFTLEN / 4;
+
+    // Simulated recording callback: push n samples in CHUNK-sized blocks, dropping the oldest when full
+    auto capture = [&](int n)
+    {
+        for (int i = 0; i < n; i += CHUNK)
+        {
+            synthesize(block.data(), CHUNK, position);
+            position += CHUNK;
+            if (!queue.space_available(CHUNK))
+                queue.pop(workingBuffer.data(), CHUNK);
+            queue.push(block.data(), CHUNK);
+        }
+    };
+
+    // One analysis step: capture a hop of audio, then analyze the freshest FFTLEN samples
+    auto step = [&]()
+    {
+        capture(hop);
+        queue.peekFreshData(workingBuffer.data(), FFTLEN);
+        FindFrequencyContent(spectrum.data(), workingBuffer.data(), FFTLEN, false);
+    };
+
+    // Warm-up: fill the queue and let scratch buffers grow
+    capture(FFTLEN);
+    for (int i = 0; i < 4; i++)
+        step();
+
+    RTSafetyChecker &checker = RTSafetyChecker::getInstance();
+    if (rtCheck)
+    {
+        if (!RTSafetyChecker::hooksInstalled())
+        {
+            std::cerr << "--rt-check needs a build with RT_SAFETY_HOOKS\n";
+            return 2;
+        }
+        checker.reset();
+        checker.arm();
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    {
+        RealtimeScope realtime; // Only recorded when --rt-check armed the checker
+        for (int i = 0; i < frames; i++)
+            step();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - begin).count();
+    double audioSeconds = static_cast<double>(frames) * hop / RATE;
+    std::cout << "frames: " << frames << ", FFT size: " << FFTLEN << ", hop: " << hop << "\n"
+              << "time per frame: " << 1000 * seconds / frames << " ms\n"
+              << "speed: " << audioSeconds / seconds << "x real time\n";
+
+    if (rtCheck)
+    {
+        checker.disarm();
+        if (checker.violationCount() > 0)
+        {
+            std::cout << "steady-state loop is NOT real-time safe:\n" << checker.report() << "\n";
+            return 1;
+        }
+        std::cout << "steady-state loop is real-time safe (no allocations, locks or file writes)\n";
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include "../analysisServer.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief Pushes a sine tone into one server stream in hop-sized blocks, waiting for space.
+ */
+static void pushTone(AnalysisServer &server, int id, float freq, int samples)
+{
+    std::vector<sample> block(SERVER_HOP);
+    for (int start = 0; start < samples; start += SERVER_HOP)
+    {
+        for (int i = 0; i < SERVER_HOP; i++)
+            block[i] = static_cast<sample>(12000 * std::sin(2 * M_PI * freq * (start + i) / RATE));
+        while (!server.spaceAvailable(id, SERVER_HOP))
+            std::this_thread::yield();
+        server.push(id, block.data(), SERVER_HOP);
+    }
+}
+
+TEST(AnalysisServerTest, Constructor_InvalidConfiguration)
+{
+    EXPECT_THROW(AnalysisServer(0), std::invalid_argument);
+    EXPECT_THROW(AnalysisServer(2, 3000), std::invalid_argument);
+    EXPECT_THROW(AnalysisServer(2, 1024, 2048), std::invalid_argument);
+}
+
+// Each stream keeps its own detector state while sharing the worker pool
+TEST(AnalysisServerTest, StreamsAreAnalyzedIndependently)
+{
+    AnalysisServer server(3);
+    const float tones[] = {220.0f, 330.0f, 440.0f, 262.0f};
+    for (int i = 0; i < 4; i++)
+        server.addStream("stream" + std::to_string(i));
+    server.start();
+    EXPECT_THROW(server.addStream("late"), std::logic_error);
+
+    for (int i = 0; i < 4; i++)
+        pushTone(server, i, tones[i], 4 * SERVER_FRAME);
+    server.drain();
+
+    for (int i = 0; i < 4; i++)
+    {
+        StreamReport report = server.report(i);
+        EXPECT_EQ(report.frames, static_cast<uint64_t>((4 * SERVER_FRAME - SERVER_FRAME) / SERVER_HOP + 1));
+        EXPECT_NEAR(report.pitch, tones[i], tones[i] * 0.03f) << report.name;
+        EXPECT_EQ(report.dropped, 0u);
+    }
+    EXPECT_EQ(server.framesAnalyzed(), 4u * 13u);
+}
+
+// A stream with a long backlog does not hold up a stream that becomes ready later
+TEST(AnalysisServerTest, SchedulesStreamsFairly)
+{
+    AnalysisServer server(1);
+    server.addStream("busy");
+    server.addStream("quiet");
+    pushTone(server, 0, 440.0f, 4 * SERVER_FRAME); // Fills the busy stream's ring before any worker runs
+    pushTone(server, 1, 220.0f, SERVER_FRAME);
+    server.start();
+
+    server.drain();
+
+    // Round-robin: the quiet stream's single frame was the second frame analyzed, not the last
+    EXPECT_EQ(server.report(1).lastSequence, 2u);
+    EXPECT_EQ(server.report(0).lastSequence, server.framesAnalyzed());
+}
+
+TEST(AnalysisServerTest, ReportsPerStreamMemory)
+{
+    AnalysisServer server(1);
+    server.addStream("a");
+    size_t bytes = server.report(0).memoryBytes;
+    EXPECT_GE(bytes, 4 * SERVER_FRAME * sizeof(sample));
+    EXPECT_LT(bytes, 256u * 1024u); // Small enough for hundreds of streams
+}
@@ -101,6 +101,18 @@ TEST_F(AudioQueueTest, Pop_Underflow)
     EXPECT_THROW(queue->pop(output, QUEUE_SIZE / 2), std::underflow_error);
 }
 
+TEST_F(AudioQueueTest, Discard_DropsOldest)
+{
+    sample input[4] = {1, 2, 3, 4};
+    sample output[2];
+    queue->push(input, 4);
+    queue->discard(2);
+    queue->pop(output, 2);
+    EXPECT_EQ(output[0], 3);
+    EXPECT_EQ(output[1], 4);
+    EXPECT_THROW(queue->discard(1), std::underflow_error);
+}
+
 // Test peek method
 // TEST_F(AudioQueueTest, Peek_ValidOutput)
 // {
@@ -0,0 +1,93 @@
+#include "../bufferController.h"
+#include "../audioDevice.h"
+#include <gtest/gtest.h>
+
+/// Builds a window of callback statistics
+static CallbackStats window(int xruns, double maxIntervalMs, double maxDurationMs)
+{
+    return CallbackStats{100, xruns, maxIntervalMs, maxDurationMs};
+}
+
+TEST(BufferSizeControllerTest, Constructor_InvalidLimits)
+{
+    EXPECT_THROW(BufferSizeController(50, 100), std::invalid_argument); // Not a power of two
+    EXPECT_THROW(BufferSizeController(1, CHUNK), std::invalid_argument); // Ceiling below one CHUNK
+}
+
+TEST(BufferSizeControllerTest, RespectsLatencyCeiling)
+{
+    BufferSizeController controller(50);
+    EXPECT_EQ(controller.maxChunkSize(), 1024); // 2 x 1024 samples = 46 ms
+    for (int i = 0; i < 20; i++)
+        controller.evaluate(window(5, 100, 100));
+    EXPECT_EQ(controller.currentChunk(), 1024);
+}
+
+TEST(BufferSizeControllerTest, GrowsOnXrunsAndLateCallbacks)
+{
+    BufferSizeController controller(100);
+    std::string reason;
+    EXPECT_EQ(controller.evaluate(window(1, 1.5, 0.1), &reason), 2 * CHUNK);
+    EXPECT_NE(reason.find("xruns"), std::string::npos);
+    EXPECT_EQ(controller.evaluate(window(0, 20, 0.1)), 4 * CHUNK); // Late callback
+    EXPECT_EQ(controller.evaluate(window(0, 6, 5.5)), 8 * CHUNK);  // Callback uses most of its period
+}
+
+TEST(BufferSizeControllerTest, ShrinksOnlyAfterQuietWindows)
+{
+    BufferSizeController controller(100, CHUNK, 3);
+    controller.evaluate(window(1, 0, 0));
+    controller.evaluate(window(1, 0, 0));
+    ASSERT_EQ(controller.currentChunk(), 4 * CHUNK);
+
+    controller.evaluate(window(0, 3, 0.1));
+    controller.evaluate(window(0, 3, 0.1));
+    EXPECT_EQ(controller.currentChunk(), 4 * CHUNK);
+    controller.evaluate(window(0, 3, 0.1));
+    EXPECT_EQ(controller.currentChunk(), 2 * CHUNK);
+
+    // Work that would not fit at half the size keeps the buffer where it is
+    for (int i = 0; i < 10; i++)
+        controller.evaluate(window(0, 3, 1.0));
+    EXPECT_EQ(controller.currentChunk(), 2 * CHUNK);
+}
+
+// End to end with SDL's dummy driver: slow callbacks grow the buffer, fast ones shrink it again
+TEST(AdaptiveBufferTest, DummyDriverWithInjectedDelay)
+{
+    SDL_SetHint(SDL_HINT_AUDIODRIVER, "dummy");
+    ASSERT_EQ(SDL_InitSubSystem(SDL_INIT_AUDIO), 0) << SDL_GetError();
+
+    sample prefill[8192] = {0}; // Stands in for the 2 second prefill of InitializeAudio()
+    MainAudioQueue.push(prefill, 8192);
+
+    SDL_AudioDeviceID rec, play;
+    OpenAudioDevices(rec, play, CHUNK);
+    SDL_PauseAudioDevice(rec, 0);
+    SDL_PauseAudioDevice(play, 0);
+
+    BufferSizeController controller(50, CHUNK, 2);
+    SetCallbackDelay(5);
+    for (int i = 0; i < 8; i++)
+    {
+        SDL_Delay(200);
+        AdaptBufferSize(controller, rec, play);
+    }
+    int grown = deviceChunk;
+    EXPECT_GT(grown, CHUNK);
+    EXPECT_LE(grown, controller.maxChunkSize());
+
+    SetCallbackDelay(0);
+    for (int i = 0; i < 12; i++)
+    {
+        SDL_Delay(200);
+        AdaptBufferSize(controller, rec, play);
+    }
+    EXPECT_LT(deviceChunk, grown);
+
+    SDL_CloseAudioDevice(rec);
+    SDL_CloseAudioDevice(play);
+    SDL_QuitSubSystem(SDL_INIT_AUDIO);
+    while (MainAudioQueue.data_available())
+        MainAudioQueue.discard(1);
+}
@@ -0,0 +1,168 @@
+#include "../captureEngine.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Feeds a source with a shared test signal as a device would deliver it.
+ *
+ * The source starts capturing at timeline time startTime; each block is delivered when its
+ * last sample has been captured plus some jitter, with every fifth block on time.
+ */
+static void feed(CaptureSource &source, double startTime, int blocks, unsigned seed)
+{
+    std::vector<sample> block(CHUNK);
+    long first = std::lround(startTime * RATE);
+    for (int b = 0; b < blocks; b++)
+    {
+        for (int i = 0; i < CHUNK; i++)
+        {
+            long t = first + b * CHUNK + i;
+            block[i] = static_cast<sample>(8000 * std::sin(t * 0.013) + (t % 97) * 10);
+        }
+        seed = seed * 1103515245u + 12345u;
+        double jitter = (b % 5 == 0) ? 0 : (seed % 2000) * 1e-6;
+        source.write(block.data(), CHUNK, startTime + static_cast<double>((b + 1) * CHUNK) / RATE + jitter);
+    }
+}
+
+TEST(CaptureSourceTest, Constructor_InvalidCapacity)
+{
+    EXPECT_THROW(CaptureSource("bad", 1000), std::invalid_argument);
+}
+
+TEST(CaptureSourceTest, ReadWrapsAndRejectsOverwritten)
+{
+    CaptureSource source("ring", 256);
+    std::vector<sample> block(CHUNK), output(CHUNK);
+    for (int b = 0; b < 6; b++)
+    {
+        for (int i = 0; i < CHUNK; i++)
+            block[i] = static_cast<sample>(b * CHUNK + i);
+        source.write(block.data(), CHUNK, 0);
+    }
+
+    ASSERT_TRUE(source.read(4 * CHUNK + 10, output.data(), CHUNK - 10));
+    for (int i = 0; i < CHUNK - 10; i++)
+        EXPECT_EQ(output[i], 4 * CHUNK + 10 + i);
+    EXPECT_FALSE(source.read(CHUNK, output.data(), CHUNK));     // Overwritten
+    EXPECT_FALSE(source.read(5 * CHUNK + 1, output.data(), CHUNK)); // Not written yet
+}
+
+// A read of the oldest samples races the block that is overwriting them; it may fail but never tears
+TEST(CaptureSourceTest, ReadNeverReturnsBlockInFlight)
+{
+    CaptureSource source("race", 256);
+    std::atomic<bool> done(false);
+    std::thread producer([&]
+                         {
+                             std::vector<sample> block(64);
+                             for (uint64_t position = 0; position < 40000000; position += block.size())
+                             {
+                                 for (size_t i = 0; i < block.size(); i++)
+                                     block[i] = static_cast<sample>((position + i) & 0x7fff);
+                                 source.write(block.data(), static_cast<int>(block.size()), 0);
+                             }
+                             done = true; });
+
+    std::vector<sample> output(64);
+    int torn = 0, reads = 0;
+    while (!done)
+    {
+        uint64_t end = source.samplesWritten();
+        if (end < 256)
+            continue;
+        uint64_t position = end - 192; // Exactly what the next block overwrites
+        if (!source.read(position, output.data(), 64))
+            continue;
+        reads++;
+        for (int i = 0; i < 64; i++)
+            torn += output[i] != static_cast<sample>((position + i) & 0x7fff);
+    }
+    producer.join();
+    EXPECT_GT(reads, 0);
+    EXPECT_EQ(torn, 0);
+}
+
+TEST(CaptureSourceTest, ClockIgnoresLateDelivery)
+{
+    CaptureSource source("clock");
+    feed(source, 2.5, 3 * CLOCK_WINDOW_BLOCKS, 7);
+    EXPECT_NEAR(source.clockOrigin(), 2.5, 1e-9);
+}
+
+// Two sources started at different times line up sample for sample
+TEST(CaptureEngineTest, AlignsSourcesOnCommonTimeline)
+{
+    CaptureEngine engine;
+    engine.addSource("early");
+    engine.addSource("late");
+    feed(engine.source(0), 1.0, 400, 1);
+    feed(engine.source(1), 1.0 + 441.0 / RATE, 380, 2);
+
+    int calls = 0;
+    engine.addNode([&](const AlignedFrame &frame)
+                   {
+                       calls++;
+                       ASSERT_EQ(frame.channels.size(), 2u);
+                       for (int i = 0; i < frame.length; i++)
+                           ASSERT_EQ(frame.channels[0][i], frame.channels[1][i]) << "at sample " << i; });
+    ASSERT_TRUE(engine.process(4096));
+    EXPECT_EQ(calls, 1);
+
+    const AlignedFrame *frame;
+    ASSERT_TRUE(engine.alignedFrame(4096, frame));
+    EXPECT_NEAR(frame->time + 4096.0 / RATE, engine.source(1).endTime(), 1e-9); // The late source ends first
+}
+
+TEST(CaptureEngineTest, NoFrameUntilEverySourceHasData)
+{
+    CaptureEngine engine;
+    engine.addSource("a");
+    engine.addSource("b");
+    feed(engine.source(0), 0, 100, 3);
+    EXPECT_FALSE(engine.process(1024));
+    EXPECT_THROW(engine.source(2), std::out_of_range);
+}
+
+// One engine drives several devices, each on its own callback thread
+TEST(CaptureEngineTest, CapturesFromSeveralDevices)
+{
+    SDL_Init(SDL_INIT_AUDIO);
+    CaptureEngine engine;
+    ASSERT_EQ(engine.openAllDevices(2), 2);
+    engine.start();
+    EXPECT_THROW(engine.addSource("late"), std::logic_error);
+
+    bool aligned = false;
+    for (int i = 0; i < 100 && !aligned; i++)
+    {
+        SDL_Delay(10);
+        aligned = engine.process(1024);
+    }
+    engine.stop();
+    EXPECT_TRUE(aligned);
+    EXPECT_NEAR(engine.source(0).clockOrigin(), engine.source(1).clockOrigin(), 0.05);
+}
+
+// The default device is usually held open already and is left out on request
+TEST(CaptureEngineTest, SkipsTheDefaultDevice)
+{
+    SDL_Init(SDL_INIT_AUDIO);
+    CaptureEngine engine;
+    int available = SDL_GetNumAudioDevices(1);
+    char *defaultName = nullptr;
+    SDL_AudioSpec spec{};
+    if (available < 1 || SDL_GetDefaultAudioInfo(&defaultName, &spec, 1) != 0)
+        GTEST_SKIP() << "No identifiable default capture device";
+    std::string name = defaultName;
+    SDL_free(defaultName);
+
+    int opened = engine.openAllDevices(available, true);
+    EXPECT_EQ(opened, engine.sourceCount());
+    EXPECT_LT(opened, available);
+    for (int i = 0; i < engine.sourceCount(); i++)
+        EXPECT_NE(engine.source(i).getName(), name);
+}
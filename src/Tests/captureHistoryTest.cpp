@@ -0,0 +1,109 @@
+#include "../captureHistory.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+/**
+ * @brief Deterministic test audio: a decaying chord plus a little noise, with occasional full-scale spikes.
+ */
+static std::vector<sample> testSignal(int n, unsigned seed = 1)
+{
+    std::vector<sample> signal(n);
+    for (int i = 0; i < n; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        double v = 6000 * std::sin(0.031 * i) + 3000 * std::sin(0.047 * i) + static_cast<int>(seed >> 24) - 128;
+        if (i % 5000 == 17)
+            v = (i & 1) ? 32767 : -32768;
+        signal[i] = static_cast<sample>(std::max(-32768.0, std::min(32767.0, v)));
+    }
+    return signal;
+}
+
+TEST(CaptureHistoryTest, BlockRoundTripIsLossless)
+{
+    std::vector<sample> input = testSignal(HISTORY_BLOCK), output(HISTORY_BLOCK);
+    std::vector<uint8_t> bytes;
+    size_t size = compressBlock(input.data(), HISTORY_BLOCK, bytes);
+    EXPECT_LT(size, HISTORY_BLOCK * sizeof(sample));
+
+    decompressBlock(bytes.data(), bytes.size(), HISTORY_BLOCK, output.data());
+    EXPECT_EQ(input, output);
+}
+
+// Extreme blocks (alternating full scale, silence) still round-trip exactly
+TEST(CaptureHistoryTest, ExtremeBlocksRoundTrip)
+{
+    std::vector<sample> square(HISTORY_BLOCK), silence(HISTORY_BLOCK, 0), output(HISTORY_BLOCK);
+    for (int i = 0; i < HISTORY_BLOCK; i++)
+        square[i] = (i & 1) ? 32767 : -32768;
+
+    for (const std::vector<sample> *input : {&square, &silence})
+    {
+        std::vector<uint8_t> bytes;
+        compressBlock(input->data(), HISTORY_BLOCK, bytes);
+        decompressBlock(bytes.data(), bytes.size(), HISTORY_BLOCK, output.data());
+        EXPECT_EQ(*input, output);
+    }
+}
+
+// Ranges older than the raw ring decode from the chunk store, including ranges spanning both tiers
+TEST(CaptureHistoryTest, ReadsAcrossTiers)
+{
+    CaptureHistory history(1 << 24, 4 * HISTORY_BLOCK);
+    std::vector<sample> signal = testSignal(40 * HISTORY_BLOCK);
+    for (size_t i = 0; i < signal.size(); i += CHUNK)
+    {
+        history.write(signal.data() + i, CHUNK, 0);
+        if (i % HISTORY_BLOCK == 0)
+            history.compressPending();
+    }
+    history.compressPending();
+
+    EXPECT_EQ(history.oldestPosition(), 0u);
+    EXPECT_GT(history.compressionRatio(), 1.5);
+
+    std::vector<sample> output(3 * HISTORY_BLOCK);
+    for (uint64_t position : {uint64_t(0), uint64_t(1234), uint64_t(35 * HISTORY_BLOCK + 77), uint64_t(37 * HISTORY_BLOCK)})
+    {
+        ASSERT_TRUE(history.read(position, output.data(), static_cast<int>(output.size()))) << position;
+        EXPECT_TRUE(std::equal(output.begin(), output.end(), signal.begin() + position)) << position;
+    }
+    EXPECT_FALSE(history.read(signal.size() - 10, output.data(), 20)); // Not captured yet
+}
+
+// The chunk store stays within its budget by evicting the oldest blocks
+TEST(CaptureHistoryTest, EvictsOldestWithinBudget)
+{
+    const size_t budget = 64 * 1024;
+    CaptureHistory history(budget, 4 * HISTORY_BLOCK);
+    std::vector<sample> signal = testSignal(200 * HISTORY_BLOCK);
+    for (size_t i = 0; i < signal.size(); i += HISTORY_BLOCK)
+    {
+        history.write(signal.data() + i, HISTORY_BLOCK, 0);
+        history.compressPending();
+    }
+
+    EXPECT_LE(history.compressedBytes(), budget);
+    EXPECT_GT(history.oldestPosition(), 0u);
+    EXPECT_EQ(history.getLostSamples(), 0u);
+
+    std::vector<sample> output(100);
+    EXPECT_FALSE(history.read(0, output.data(), 100));
+    uint64_t oldest = history.oldestPosition();
+    ASSERT_TRUE(history.read(oldest, output.data(), 100));
+    EXPECT_TRUE(std::equal(output.begin(), output.end(), signal.begin() + oldest));
+}
+
+// If compression falls a whole ring behind, the overwritten blocks are counted as lost
+TEST(CaptureHistoryTest, CountsLostBlocks)
+{
+    CaptureHistory history(1 << 20, 4 * HISTORY_BLOCK);
+    std::vector<sample> signal = testSignal(10 * HISTORY_BLOCK);
+    for (size_t i = 0; i < signal.size(); i += HISTORY_BLOCK)
+        history.write(signal.data() + i, HISTORY_BLOCK, 0);
+    history.compressPending();
+    EXPECT_GT(history.getLostSamples(), 0u);
+    EXPECT_EQ(history.getLostSamples() % HISTORY_BLOCK, 0u);
+}
@@ -0,0 +1,194 @@
+#include "../columnStore.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <vector>
+
+static const std::vector<ColumnSpec> testColumns = {
+    {"pitch", ColumnType::Float}, {"cents", ColumnType::Float}, {"chord", ColumnType::Text}, {"onset", ColumnType::Int}};
+
+/// One row every 512 samples, with a two-minute pause after row 5000
+static int64_t rowTime(uint64_t row)
+{
+    return 1700000000000 + static_cast<int64_t>(row * 512 * 1000 / 44100) + (row > 5000 ? 120000 : 0);
+}
+
+/// Pitch that holds for a while then jumps, cents drifting through +-30, a chord code and onsets
+static std::vector<double> rowValues(uint64_t row)
+{
+    double pitch = row % 700 < 50 ? 0.0 : 110.0 * (1 + (row / 700) % 5);
+    double cents = pitch > 0 ? 30 * std::sin(row * 0.01) : 0;
+    return {pitch, static_cast<float>(cents), static_cast<double>((row / 300) % 3), row % 43 == 0 ? 1.0 : 0.0};
+}
+
+class ColumnStoreTest : public ::testing::Test
+{
+protected:
+    std::string directory = "columnStoreTest.store";
+
+    void SetUp() override { std::filesystem::remove_all(directory); }
+    void TearDown() override { std::filesystem::remove_all(directory); }
+
+    void fill(ColumnStore &store, uint64_t first, uint64_t last)
+    {
+        int chord = store.column("chord");
+        for (const char *name : {"C", "Am", "G7"})
+            store.textCode(chord, name);
+        for (uint64_t row = first; row < last; row++)
+            store.append(rowTime(row), rowValues(row).data());
+    }
+};
+
+TEST_F(ColumnStoreTest, ScanReturnsTheRowsOfARangeAfterReopening)
+{
+    {
+        ColumnStore store(directory, testColumns);
+        fill(store, 0, 10000);
+    }
+    ColumnStore store(directory, testColumns);
+    ASSERT_EQ(store.rows(), 10000u);
+    EXPECT_EQ(store.lastTime(), rowTime(9999));
+    std::vector<int64_t> times;
+    std::vector<double> values;
+    int64_t from = rowTime(3000), to = rowTime(8500);
+    ASSERT_EQ(store.scan(store.column("cents"), from, to, times, values), 5500u);
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        EXPECT_EQ(times[i], rowTime(3000 + i));
+        EXPECT_EQ(values[i], rowValues(3000 + i)[1]);
+    }
+    store.scan(store.column("chord"), from, to, times, values);
+    EXPECT_EQ(store.text(store.column("chord"), static_cast<int>(values[0])), "Am");
+}
+
+TEST_F(ColumnStoreTest, SecondsWithinMatchesBruteForce)
+{
+    ColumnStore store(directory, testColumns);
+    fill(store, 0, 20000); // Leaves rows in memory as well
+    int cents = store.column("cents");
+    int64_t from = rowTime(1234), to = rowTime(19000);
+    double expected = 0;
+    for (uint64_t row = 1234; row < 19000; row++)
+    {
+        if (std::fabs(rowValues(row)[1]) > 10)
+            expected += std::min<int64_t>(rowTime(row + 1) - rowTime(row), COLUMN_MAX_GAP_MS) / 1000.0;
+    }
+    const double infinity = std::numeric_limits<double>::infinity();
+    double outOfTune = store.secondsWithin(cents, std::nextafter(10.0, infinity), infinity, from, to) +
+                       store.secondsWithin(cents, -infinity, std::nextafter(-10.0, -infinity), from, to);
+    EXPECT_NEAR(outOfTune, expected, 1e-9);
+
+    // The pause after row 5000 counts one gap, not two minutes
+    double all = store.secondsWithin(store.column("onset"), 0, 1, rowTime(0), rowTime(10000));
+    EXPECT_NEAR(all, (rowTime(10000) - rowTime(0) - (rowTime(5001) - rowTime(5000)) + COLUMN_MAX_GAP_MS) / 1000.0, 1e-9);
+}
+
+TEST_F(ColumnStoreTest, IndexSettlesWholeBlocksWithoutDecoding)
+{
+    ColumnStore store(directory, testColumns);
+    fill(store, 0, 8 * COLUMN_BLOCK_ROWS);
+    int onset = store.column("onset"), pitch = store.column("pitch");
+
+    uint64_t before = store.blocksDecoded();
+    ColumnSummary onsets = store.summarize(onset, rowTime(0), rowTime(8 * COLUMN_BLOCK_ROWS - 1) + 1);
+    EXPECT_EQ(store.blocksDecoded(), before);
+    EXPECT_EQ(onsets.rows, 8u * COLUMN_BLOCK_ROWS);
+    EXPECT_EQ(onsets.sum, (8 * COLUMN_BLOCK_ROWS + 42) / 43);
+    EXPECT_EQ(onsets.max, 1);
+
+    // Pitch never exceeds 550 Hz and is never negative, so neither query reads a block
+    EXPECT_EQ(store.secondsWithin(pitch, 1000, 2000, rowTime(0), rowTime(30000)), 0);
+    EXPECT_GT(store.secondsWithin(pitch, -1, 1000, rowTime(0), rowTime(8 * COLUMN_BLOCK_ROWS)), 300);
+    EXPECT_EQ(store.blocksDecoded(), before);
+
+    ColumnSummary middle = store.summarize(pitch, rowTime(5000), rowTime(25000));
+    double sum = 0;
+    for (uint64_t row = 5000; row < 25000; row++)
+        sum += rowValues(row)[0];
+    EXPECT_EQ(middle.rows, 20000u);
+    EXPECT_NEAR(middle.sum, sum, 1e-6);
+    EXPECT_EQ(middle.min, 0);
+    EXPECT_EQ(middle.max, 550);
+    EXPECT_EQ(store.blocksDecoded(), before + 4); // Time and pitch of the two blocks cut by the range
+}
+
+TEST_F(ColumnStoreTest, CompressesRepeatedValues)
+{
+    ColumnStore store(directory, testColumns);
+    fill(store, 0, 16 * COLUMN_BLOCK_ROWS);
+    store.flush();
+    // Raw rows would take 8 bytes of time and 4 of each value
+    EXPECT_LT(store.bytesOnDisk(), 16u * COLUMN_BLOCK_ROWS * 24 / 4);
+}
+
+// Residuals wider than 33 bits take the two-word path of the Rice code
+TEST_F(ColumnStoreTest, WideIntegersRoundTrip)
+{
+    const std::vector<ColumnSpec> wideColumns = {{"bits34", ColumnType::Int}, {"bits44", ColumnType::Int}};
+    const uint64_t count = 2 * COLUMN_BLOCK_ROWS + 100;
+    auto value = [](uint64_t row, int bits)
+    {
+        uint64_t mixed = (row + 1) * 0x9e3779b97f4a7c15ull;
+        return static_cast<double>((mixed >> (64 - bits)) | (uint64_t(1) << (bits - 1)));
+    };
+    {
+        ColumnStore store(directory, wideColumns);
+        for (uint64_t row = 0; row < count; row++)
+        {
+            double values[2] = {value(row, 34), value(row, 44)};
+            store.append(rowTime(row), values);
+        }
+    }
+    ColumnStore store(directory, wideColumns);
+    ASSERT_EQ(store.rows(), count);
+    std::vector<int64_t> times;
+    std::vector<double> values;
+    for (int bits : {34, 44})
+    {
+        ASSERT_EQ(store.scan(store.column("bits" + std::to_string(bits)), rowTime(0), rowTime(count - 1) + 1, times, values), count);
+        for (uint64_t row = 0; row < count; row++)
+            ASSERT_EQ(values[row], value(row, bits)) << bits << "-bit row " << row;
+    }
+}
+
+TEST_F(ColumnStoreTest, DropsABlockOnlySomeColumnsReached)
+{
+    {
+        ColumnStore store(directory, testColumns);
+        fill(store, 0, 3 * COLUMN_BLOCK_ROWS + 10);
+    }
+    // Lose the last index entry of one column, as if the process died while flushing
+    std::string index = directory + "/pitch.idx";
+    std::filesystem::resize_file(index, std::filesystem::file_size(index) - 1);
+    {
+        ColumnStore store(directory, testColumns);
+        EXPECT_EQ(store.rows(), 3u * COLUMN_BLOCK_ROWS);
+        fill(store, 3 * COLUMN_BLOCK_ROWS, 3 * COLUMN_BLOCK_ROWS + 100);
+    }
+    ColumnStore store(directory, testColumns);
+    ASSERT_EQ(store.rows(), 3u * COLUMN_BLOCK_ROWS + 100);
+    std::vector<int64_t> times;
+    std::vector<double> values;
+    store.scan(store.column("pitch"), rowTime(3 * COLUMN_BLOCK_ROWS), rowTime(3 * COLUMN_BLOCK_ROWS + 100), times, values);
+    ASSERT_EQ(values.size(), 100u);
+    EXPECT_EQ(values[99], rowValues(3 * COLUMN_BLOCK_ROWS + 99)[0]);
+}
+
+TEST_F(ColumnStoreTest, RejectsMismatchedColumnsAndBadValues)
+{
+    {
+        ColumnStore store(directory, testColumns);
+        EXPECT_THROW(store.column("volume"), std::invalid_argument);
+        std::vector<double> row = {440, 0, 5, 0}; // No chord code 5 yet
+        EXPECT_THROW(store.append(0, row.data()), std::invalid_argument);
+    }
+    std::vector<ColumnSpec> retyped = testColumns;
+    retyped[0].type = ColumnType::Int;
+    EXPECT_THROW(ColumnStore(directory, retyped), std::runtime_error);
+    retyped = testColumns;
+    retyped.push_back({"rms", ColumnType::Float});
+    EXPECT_THROW(ColumnStore(directory, retyped), std::runtime_error);
+    EXPECT_THROW(ColumnStore(directory, {{"../escape", ColumnType::Int}}), std::invalid_argument);
+}
@@ -0,0 +1,65 @@
+#include "../delayEstimator.h"
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <vector>
+
+/// White noise at about -12 dBFS, reproducible between runs
+static std::vector<sample> noise(int length, unsigned seed)
+{
+    std::srand(seed);
+    std::vector<sample> out(length);
+    for (int i = 0; i < length; i++)
+        out[i] = static_cast<sample>((std::rand() % 16384) - 8192);
+    return out;
+}
+
+/// Delays source by a whole number of samples plus, if half is set, half a sample by averaging neighbours
+static std::vector<sample> delayed(const std::vector<sample> &source, int delay, bool half)
+{
+    std::vector<sample> out(source.size(), 0);
+    for (int i = 0; i < static_cast<int>(source.size()); i++)
+    {
+        int j = i - delay;
+        if (j - 1 < 0 || j >= static_cast<int>(source.size()))
+            continue;
+        out[i] = half ? static_cast<sample>((source[j] + source[j - 1]) / 2) : source[j];
+    }
+    return out;
+}
+
+TEST(DelayEstimatorTest, FindsWholeSampleDelay)
+{
+    std::vector<sample> a = noise(GCC_FRAME + 100, 1), b = delayed(a, 23, false);
+    DelayEstimator estimator;
+    DelayEstimate estimate = estimator.update(a.data() + 100, b.data() + 100);
+    EXPECT_NEAR(estimate.samples, 23.0, 0.1);
+    EXPECT_NEAR(estimate.seconds, 23.0 / RATE, 1e-5);
+    EXPECT_GT(estimate.confidence, 0.5f);
+}
+
+TEST(DelayEstimatorTest, LeadingInputGivesNegativeDelay)
+{
+    std::vector<sample> b = noise(GCC_FRAME + 100, 2), a = delayed(b, 40, false);
+    DelayEstimator estimator;
+    EXPECT_NEAR(estimator.update(a.data() + 100, b.data() + 100).samples, -40.0, 0.1);
+}
+
+TEST(DelayEstimatorTest, InterpolatesHalfSample)
+{
+    std::vector<sample> a = noise(GCC_FRAME + 100, 3), b = delayed(a, 7, true);
+    DelayEstimator estimator;
+    EXPECT_NEAR(estimator.update(a.data() + 100, b.data() + 100).samples, 7.5, 0.15);
+}
+
+TEST(DelayEstimatorTest, UnrelatedInputsHaveLowConfidence)
+{
+    std::vector<sample> a = noise(GCC_FRAME, 4), b = noise(GCC_FRAME, 5);
+    DelayEstimator estimator;
+    EXPECT_LT(estimator.update(a.data(), b.data()).confidence, 0.2f);
+}
+
+TEST(DelayEstimatorTest, RejectsSearchRangeBeyondFrame)
+{
+    EXPECT_THROW(DelayEstimator(1024, 512), std::invalid_argument);
+    EXPECT_THROW(DelayEstimator(1024, 0), std::invalid_argument);
+}
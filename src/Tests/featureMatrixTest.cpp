@@ -0,0 +1,141 @@
+#include "../featureMatrix.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+TEST(FeatureMatrixTest, HalfConversionRoundsToNearest)
+{
+    EXPECT_EQ(floatToHalf(1.0f), 0x3C00);
+    EXPECT_EQ(floatToHalf(-2.0f), 0xC000);
+    EXPECT_EQ(floatToHalf(0.0f), 0x0000);
+    EXPECT_EQ(floatToHalf(65504.0f), 0x7BFF);
+    EXPECT_EQ(floatToHalf(1e9f), 0x7BFF);          // Clamped to the largest half
+    EXPECT_EQ(floatToHalf(5.9604645e-8f), 0x0001); // Smallest subnormal
+    EXPECT_EQ(floatToHalf(1.0f + 1.0f / 2048), 0x3C00); // Tie rounds to even
+    EXPECT_EQ(floatToHalf(1.0f + 3.0f / 2048), 0x3C02);
+
+    for (uint32_t h = 0; h < 0x7C00; h++)
+    {
+        EXPECT_EQ(floatToHalf(halfToFloat(static_cast<uint16_t>(h))), h);
+        EXPECT_EQ(floatToHalf(halfToFloat(static_cast<uint16_t>(h | 0x8000))), h | 0x8000);
+    }
+    for (float x = -300.0f; x < 300.0f; x += 0.37f)
+        EXPECT_LE(std::fabs(halfToFloat(floatToHalf(x)) - x), std::fabs(x) / 2048 + 3e-8f);
+}
+
+TEST(FeatureMatrixTest, ChromaFollowsThePlayedNote)
+{
+    std::vector<sample> tone(RATE);
+    for (size_t i = 0; i < tone.size(); i++)
+        tone[i] = static_cast<sample>(8000 * std::sin(2 * M_PI * 440.0 * i / RATE));
+    std::vector<float> rows;
+    extractSimilarityFeatures(tone.data(), tone.size(), rows);
+    ASSERT_EQ(rows.size(), static_cast<size_t>((RATE - SIMILARITY_FRAME) / SIMILARITY_HOP + 1) * SIMILARITY_DIMS);
+
+    const float *row = rows.data() + 3 * SIMILARITY_DIMS;
+    EXPECT_GT(row[9], 0.95f); // A
+    float norm = 0;
+    for (int c = 0; c < SIMILARITY_CHROMA; c++)
+        norm += row[c] * row[c];
+    EXPECT_NEAR(norm, 1.0f, 1e-4f);
+
+    std::vector<sample> silence(RATE / 2, 0);
+    extractSimilarityFeatures(silence.data(), silence.size(), rows);
+    for (float value : rows)
+        EXPECT_NEAR(value, 0.0f, 1e-4f);
+}
+
+TEST(FeatureMatrixTest, ThreadedExtractionMatchesSingleThread)
+{
+    std::vector<sample> audio(SIMILARITY_FRAME + 600 * SIMILARITY_HOP + 77);
+    unsigned seed = 2;
+    for (size_t i = 0; i < audio.size(); i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        audio[i] = static_cast<sample>(6000 * std::sin(2 * M_PI * (200.0 + i / 2000) * i / RATE) + static_cast<int>(seed >> 22) - 512);
+    }
+    std::vector<float> single, threaded;
+    extractSimilarityFeatures(audio.data(), audio.size(), single);
+    extractSimilarityFeatures(audio.data(), audio.size(), threaded, 3);
+    EXPECT_EQ(threaded, single);
+}
+
+TEST(FeatureMatrixTest, SavedMatrixMapsBack)
+{
+    std::vector<std::vector<float>> features(3);
+    for (int f = 0; f < 3; f++)
+        for (int i = 0; i < (f == 1 ? 0 : 5 + f) * SIMILARITY_DIMS; i++)
+            features[f].push_back(static_cast<float>(f) + i * 0.01f);
+    FeatureMatrix matrix;
+    matrix.setFeatures({"a.wav", "empty.wav", "c.wav"}, features);
+    ASSERT_EQ(matrix.rowCount(), 12u);
+    EXPECT_EQ(matrix.fileOf(4), 0);
+    EXPECT_EQ(matrix.fileOf(5), 2);
+    EXPECT_NEAR(matrix.timeOf(7), 2.0 * SIMILARITY_HOP / RATE, 1e-12);
+
+    const char *path = "featureMatrixTest.fm";
+    matrix.save(path);
+    {
+        FeatureMatrix loaded;
+        loaded.load(path);
+        ASSERT_EQ(loaded.rowCount(), matrix.rowCount());
+        EXPECT_EQ(loaded.fileCount(), 3);
+        EXPECT_EQ(loaded.fileName(2), "c.wav");
+        EXPECT_EQ(loaded.fileOf(11), 2);
+        for (size_t r = 0; r < loaded.rowCount(); r++)
+            for (int d = 0; d < SIMILARITY_DIMS; d++)
+                EXPECT_EQ(loaded.row(r)[d], matrix.row(r)[d]);
+        EXPECT_NEAR(halfToFloat(loaded.row(5)[1]), 2.01f, 2.01f / 2048);
+    }
+    std::remove(path);
+}
+
+TEST(FeatureMatrixTest, RejectsRaggedRowsAndOtherFiles)
+{
+    FeatureMatrix matrix;
+    EXPECT_THROW(matrix.setFeatures({"a.wav"}, {std::vector<float>(SIMILARITY_DIMS + 1)}), std::invalid_argument);
+
+    const char *path = "featureMatrixTest.bad";
+    FILE *file = std::fopen(path, "wb");
+    std::fputs("not a feature matrix", file);
+    std::fclose(file);
+    EXPECT_THROW(matrix.load(path), std::runtime_error);
+    std::remove(path);
+}
+
+// Files with the right size and header but inconsistent contents are refused before any row is read
+TEST(FeatureMatrixTest, LoadRejectsDamagedFiles)
+{
+    std::vector<std::vector<float>> features(3, std::vector<float>(4 * SIMILARITY_DIMS, 1.0f));
+    FeatureMatrix matrix;
+    matrix.setFeatures({"a.wav", "b.wav", "c.wav"}, features);
+    const char *path = "featureMatrixTest.fm";
+    matrix.save(path);
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t headerBytes = 32;
+    uint32_t namesBytes;
+    std::memcpy(&namesBytes, bytes.data() + 20, sizeof(namesBytes));
+
+    auto rejects = [&](size_t at, const std::vector<char> &patch)
+    {
+        std::vector<char> damaged = bytes;
+        std::copy(patch.begin(), patch.end(), damaged.begin() + at);
+        std::ofstream(path, std::ios::binary).write(damaged.data(), static_cast<std::streamsize>(damaged.size()));
+        FeatureMatrix loaded;
+        EXPECT_THROW(loaded.load(path), std::runtime_error) << "patch at byte " << at;
+    };
+    rejects(headerBytes, std::vector<char>(namesBytes, 'x'));                                // Names run past their block
+    rejects(headerBytes + namesBytes + sizeof(uint64_t), {-1, -1, -1, -1, -1, -1, -1, -1});  // A file start past the rows
+    rejects(headerBytes + namesBytes + 3 * sizeof(uint64_t), {0, 0, 0, 0, 0, 0, 0, 0});      // Starts that do not end at the row count
+    rejects(16, {-1, -1, -1, -1});                                                           // A file count the table cannot hold
+    std::remove(path);
+}
@@ -0,0 +1,121 @@
+#include "../fftPlan.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(FFTPlanTest, Constructor_InvalidSize)
+{
+    EXPECT_THROW(FFTPlan(12), std::invalid_argument);
+    EXPECT_THROW(FFTPlan::get(0), std::invalid_argument);
+}
+
+TEST(FFTPlanTest, PlansAreShared)
+{
+    const FFTPlan &a = FFTPlan::get(1024);
+    const FFTPlan &b = FFTPlan::get(1024);
+    EXPECT_EQ(&a, &b);
+    EXPECT_EQ(a.size(), 1024);
+    EXPECT_GT(a.memoryBytes(), 1024 * sizeof(int));
+}
+
+// The planned transform agrees with a direct DFT, both in and out of place
+TEST(FFTPlanTest, MatchesDirectDft)
+{
+    const int n = 64;
+    std::vector<cmplx> input(n), output(n), inplace(n);
+    for (int i = 0; i < n; i++)
+        input[i] = cmplx(std::sin(0.3 * i) + (i % 5), std::cos(0.7 * i));
+
+    const FFTPlan &plan = FFTPlan::get(n);
+    plan.forward(output.data(), input.data());
+    inplace = input;
+    plan.forward(inplace.data(), inplace.data());
+
+    for (int k = 0; k < n; k++)
+    {
+        cmplx expected = 0;
+        for (int i = 0; i < n; i++)
+            expected += input[i] * std::polar(1.0, -2 * M_PI * k * i / n);
+        EXPECT_NEAR(std::abs(output[k] - expected), 0, 1e-9);
+        EXPECT_NEAR(std::abs(inplace[k] - expected), 0, 1e-9);
+    }
+}
+
+// A full-scale sine on a bin centre shows up in that bin with magnitude close to 1
+TEST(StftTest, SinePeakAtItsBin)
+{
+    Stft stft(2048);
+    std::vector<sample> frame(2048);
+    const int bin = 100;
+    for (int i = 0; i < 2048; i++)
+        frame[i] = static_cast<sample>(32767 * std::sin(2 * M_PI * bin * i / 2048.0));
+
+    std::vector<float> magnitude(stft.bins());
+    stft.magnitude(frame.data(), magnitude.data());
+
+    int peak = std::max_element(magnitude.begin(), magnitude.end()) - magnitude.begin();
+    EXPECT_EQ(peak, bin);
+    EXPECT_NEAR(magnitude[bin], 1.0f, 0.01f);
+    EXPECT_NEAR(stft.binFrequency(bin), bin * static_cast<float>(RATE) / 2048, 1e-3);
+}
+
+// A range starting high needs far fewer points than FFTLEN; a budget caps low ranges
+TEST(FFTPlanTest, AnalysisPlanFollowsRangeAndBudget)
+{
+    AnalysisPlan high = chooseAnalysisPlan(2000, 20000, 100, true);
+    EXPECT_LT(high.fftSize, FFTLEN);
+    double firstColumn = 2000 * (std::pow(10.0, 1.0 / 100) - 1);
+    EXPECT_LE(static_cast<double>(RATE) / high.fftSize, firstColumn);
+    EXPECT_GT(static_cast<double>(RATE) / (high.fftSize / 2), firstColumn);
+    EXPECT_LE(high.hop, high.fftSize / 2);
+
+    EXPECT_EQ(chooseAnalysisPlan(20, 20000, 120, true).fftSize, FFTLEN);
+    EXPECT_EQ(chooseAnalysisPlan(20, 20000, 120, true, 100).fftSize, 4096);
+    EXPECT_EQ(chooseAnalysisPlan(1000, 5000, 4, false).fftSize, FFT_MIN_DISPLAY);
+    EXPECT_THROW(chooseAnalysisPlan(500, 100, 10, true), std::invalid_argument);
+}
+
+// Packing two real frames into one transform matches transforming each on its own
+TEST(FFTPlanTest, RealPairMatchesSeparateTransforms)
+{
+    const int n = 256;
+    std::vector<float> a(n), b(n);
+    for (int i = 0; i < n; i++)
+    {
+        a[i] = static_cast<float>(std::sin(0.21 * i) + 0.1 * (i % 7));
+        b[i] = static_cast<float>(std::cos(1.3 * i) - 0.05 * (i % 3));
+    }
+
+    const FFTPlan &plan = FFTPlan::get(n);
+    std::vector<cmplx> outA(n / 2 + 1), outB(n / 2 + 1), scratch(n), ref(n);
+    plan.forwardRealPair(a.data(), b.data(), outA.data(), outB.data(), scratch.data());
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        const std::vector<float> &input = pass ? b : a;
+        const std::vector<cmplx> &packed = pass ? outB : outA;
+        for (int i = 0; i < n; i++)
+            ref[i] = input[i];
+        plan.forward(ref.data(), ref.data());
+        for (int k = 0; k <= n / 2; k++)
+            EXPECT_NEAR(std::abs(packed[k] - ref[k]), 0, 1e-9);
+    }
+}
+
+TEST(FFTPlanTest, StftPairMatchesSingleFrames)
+{
+    Stft stft(1024);
+    std::vector<sample> left(1024), right(1024);
+    for (int i = 0; i < 1024; i++)
+    {
+        left[i] = static_cast<sample>(10000 * std::sin(0.05 * i));
+        right[i] = static_cast<sample>(3000 * std::sin(0.4 * i) + (i % 11) * 50);
+    }
+    std::vector<float> l(stft.bins()), r(stft.bins()), ref(stft.bins());
+    stft.magnitudePair(left.data(), right.data(), l.data(), r.data());
+    stft.magnitude(left.data(), ref.data());
+    for (int k = 0; k < stft.bins(); k++)
+        EXPECT_NEAR(l[k], ref[k], 1e-6);
+    stft.magnitude(right.data(), ref.data());
+    for (int k = 0; k < stft.bins(); k++)
+        EXPECT_NEAR(r[k], ref[k], 1e-6);
+}
@@ -0,0 +1,69 @@
+#include "../filterbank.h"
+#include <gtest/gtest.h>
+#include <vector>
+
+TEST(FilterbankTest, Constructor_InvalidConfiguration)
+{
+    EXPECT_THROW(Filterbank(0, 4096, 20, 8000), std::invalid_argument);
+    EXPECT_THROW(Filterbank(40, 4096, 8000, 20), std::invalid_argument);
+    EXPECT_THROW(Filterbank(40, 4096, 20, 30000), std::invalid_argument);
+}
+
+TEST(FilterbankTest, ScaleConversionsRoundTrip)
+{
+    for (float hz : {50.0f, 440.0f, 1000.0f, 8000.0f})
+    {
+        EXPECT_NEAR(melToHz(hzToMel(hz)), hz, hz * 1e-4f);
+        EXPECT_NEAR(barkToHz(hzToBark(hz)), hz, hz * 1e-4f);
+    }
+    EXPECT_NEAR(hzToMel(1000), 1000, 1);
+}
+
+// Centre frequencies rise monotonically and every band responds, even below the bin spacing
+TEST(FilterbankTest, BandsCoverRange)
+{
+    for (BandScale scale : {BandScale::Mel, BandScale::Bark})
+    {
+        Filterbank bank(128, 4096, 20, 20000, scale);
+        ASSERT_EQ(bank.size(), 128);
+        for (int b = 1; b < bank.size(); b++)
+            EXPECT_GT(bank.centerFrequency(b), bank.centerFrequency(b - 1));
+
+        std::vector<float> flat(bank.inputBins(), 1.0f), out(bank.size());
+        bank.apply(flat.data(), out.data());
+        for (float e : out)
+            EXPECT_GT(e, 0);
+    }
+}
+
+// A single bin excites the band centred on it the most, and only bands that overlap it
+TEST(FilterbankTest, SparseProductMatchesTriangle)
+{
+    const int fftSize = 4096;
+    Filterbank bank(40, fftSize, 20, 16000);
+    int band = 25;
+    int bin = static_cast<int>(bank.centerFrequency(band) * fftSize / 44100 + 0.5f);
+
+    std::vector<float> power(bank.inputBins(), 0.0f), out(bank.size());
+    power[bin] = 1.0f;
+    bank.apply(power.data(), out.data());
+
+    EXPECT_GT(out[band], 0.8f);
+    for (int b = 0; b < bank.size(); b++)
+    {
+        if (b < band - 1 || b > band + 1)
+        {
+            EXPECT_EQ(out[b], 0.0f);
+        }
+        EXPECT_LE(out[b], out[band]);
+    }
+
+    bank.applyLog(power.data(), out.data());
+    EXPECT_NEAR(out[0], -120.0f, 1e-3f);
+}
+
+TEST(FilterbankTest, SparseStorageIsSmall)
+{
+    Filterbank bank(128, 65536, 20, 20000);
+    EXPECT_LT(bank.memoryBytes(), 128 * (65536 / 2 + 1) * sizeof(float) / 20);
+}
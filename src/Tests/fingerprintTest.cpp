@@ -0,0 +1,166 @@
+#include "../fingerprint.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+/// A random melody of short three-partial notes over a little noise, reproducible from its seed
+static std::vector<sample> melody(unsigned seed, double seconds)
+{
+    std::vector<sample> out(static_cast<size_t>(seconds * RATE));
+    const int noteLength = RATE / 6;
+    double f[3] = {0, 0, 0}, phase[3] = {0, 0, 0};
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        if (i % noteLength == 0)
+        {
+            for (double &frequency : f)
+            {
+                seed = seed * 1103515245u + 12345u;
+                frequency = 150 * std::pow(2.0, (seed >> 8) % 48 / 12.0); // Four octaves from 150 Hz
+            }
+        }
+        double value = 0;
+        for (int p = 0; p < 3; p++)
+        {
+            phase[p] += 2 * M_PI * f[p] / RATE;
+            value += std::sin(phase[p]);
+        }
+        seed = seed * 1103515245u + 12345u;
+        out[i] = static_cast<sample>(6000 * value + static_cast<int>(seed >> 22) - 512);
+    }
+    return out;
+}
+
+class FingerprintTest : public ::testing::Test
+{
+protected:
+    static FingerprintIndex index;
+    static std::vector<std::vector<sample>> tracks;
+
+    static void SetUpTestSuite()
+    {
+        for (unsigned t = 0; t < 4; t++)
+            tracks.push_back(melody(100 + t, 30));
+        index.build({"a.wav", "b.wav", "c.wav", "d.wav"}, tracks, 2);
+    }
+
+    /// A quieter, noisier excerpt of a track that does not start on the analysis hop grid
+    static std::vector<sample> excerpt(int track, double start, double seconds)
+    {
+        std::vector<sample> clip(tracks[track].begin() + static_cast<size_t>(start * RATE), tracks[track].begin() + static_cast<size_t>((start + seconds) * RATE));
+        unsigned seed = 9;
+        for (sample &s : clip)
+        {
+            seed = seed * 1103515245u + 12345u;
+            s = static_cast<sample>(s / 2 + static_cast<int>(seed >> 21) - 1024);
+        }
+        return clip;
+    }
+};
+
+FingerprintIndex FingerprintTest::index;
+std::vector<std::vector<sample>> FingerprintTest::tracks;
+
+TEST_F(FingerprintTest, LandmarksAreDeterministicAndHashesFit)
+{
+    std::vector<Landmark> first, second;
+    extractLandmarks(tracks[0].data(), RATE * 5, first);
+    extractLandmarks(tracks[0].data(), RATE * 5, second);
+    ASSERT_GT(first.size(), 100u);
+    ASSERT_EQ(first.size(), second.size());
+    for (size_t i = 0; i < first.size(); i++)
+    {
+        EXPECT_EQ(first[i].hash, second[i].hash);
+        EXPECT_LT(first[i].hash, 1u << FINGERPRINT_HASH_BITS);
+    }
+}
+
+TEST_F(FingerprintTest, IdentifiesTrackAndOffset)
+{
+    std::vector<sample> clip = excerpt(2, 12.345, 4);
+    FingerprintMatch match = index.query(clip.data(), clip.size());
+    EXPECT_EQ(match.track, 2);
+    EXPECT_EQ(match.name, "c.wav");
+    EXPECT_NEAR(match.offsetSeconds, 12.345, 0.03);
+    EXPECT_GE(match.votes, FINGERPRINT_MIN_VOTES);
+}
+
+TEST_F(FingerprintTest, RejectsUnknownAudio)
+{
+    std::vector<sample> clip = melody(999, 4);
+    EXPECT_EQ(index.query(clip.data(), clip.size()).track, -1);
+}
+
+TEST_F(FingerprintTest, BatchMatchesSingleQueries)
+{
+    std::vector<std::vector<sample>> clips = {excerpt(0, 3, 3), excerpt(1, 20.01, 3), excerpt(3, 7.5, 3)};
+    std::vector<FingerprintMatch> matches = index.queryBatch(clips, 3);
+    ASSERT_EQ(matches.size(), 3u);
+    EXPECT_EQ(matches[0].track, 0);
+    EXPECT_EQ(matches[1].track, 1);
+    EXPECT_EQ(matches[2].track, 3);
+}
+
+TEST_F(FingerprintTest, SavedIndexMapsBack)
+{
+    const char *path = "fingerprintTest.idx";
+    index.save(path);
+    {
+        FingerprintIndex loaded;
+        loaded.load(path);
+        EXPECT_EQ(loaded.trackCount(), 4);
+        EXPECT_EQ(loaded.trackName(3), "d.wav");
+        EXPECT_EQ(loaded.landmarkCount(), index.landmarkCount());
+        EXPECT_NEAR(loaded.audioHours(), index.audioHours(), 1e-9);
+
+        std::vector<sample> clip = excerpt(1, 5.5, 4);
+        FingerprintMatch fromFile = loaded.query(clip.data(), clip.size()), fromMemory = index.query(clip.data(), clip.size());
+        EXPECT_EQ(fromFile.track, 1);
+        EXPECT_EQ(fromFile.votes, fromMemory.votes);
+        EXPECT_DOUBLE_EQ(fromFile.offsetSeconds, fromMemory.offsetSeconds);
+    }
+    std::remove(path);
+}
+
+TEST_F(FingerprintTest, LoadRejectsOtherFiles)
+{
+    const char *path = "fingerprintTest.bad";
+    FILE *file = std::fopen(path, "wb");
+    std::fputs("not an index", file);
+    std::fclose(file);
+    FingerprintIndex loaded;
+    EXPECT_THROW(loaded.load(path), std::runtime_error);
+    std::remove(path);
+}
+
+// Files with the right size and header but inconsistent contents are refused before any query reads them
+TEST_F(FingerprintTest, LoadRejectsDamagedFiles)
+{
+    const char *path = "fingerprintTest.idx";
+    index.save(path);
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t headerBytes = 40;
+    uint32_t namesBytes;
+    std::memcpy(&namesBytes, bytes.data() + 20, sizeof(namesBytes));
+
+    auto rejects = [&](size_t at, const std::vector<char> &patch)
+    {
+        std::vector<char> damaged = bytes;
+        std::copy(patch.begin(), patch.end(), damaged.begin() + at);
+        std::ofstream(path, std::ios::binary).write(damaged.data(), static_cast<std::streamsize>(damaged.size()));
+        FingerprintIndex loaded;
+        EXPECT_THROW(loaded.load(path), std::runtime_error) << "patch at byte " << at;
+    };
+    rejects(headerBytes, std::vector<char>(namesBytes, 'x'));                     // Names run past their block
+    rejects(headerBytes + namesBytes + 5 * sizeof(uint32_t), {-1, -1, -1, -1});   // A bucket offset out of order
+    rejects(bytes.size() - sizeof(uint32_t), {-1, -1, -1, -1});                   // A posting for a track that does not exist
+    std::remove(path);
+}
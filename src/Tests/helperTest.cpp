@@ -4,6 +4,8 @@
 #include <vector>
 #include <cmath>
 #include <stdexcept>
+#include <atomic>
+#include <thread>
 
 /// Test show_bargraph function
 TEST(HelperTest, ShowBarGraph)
@@ -94,3 +96,18 @@ TEST(HelperTest, PitchName)
     int length = pitchName(name, 1, true);
     ASSERT_EQ(std::string(name, length), "A");
 }
+
+/// Test runWorkers rethrows a failure on the calling thread after the other threads finish
+TEST(HelperTest, RunWorkersJoinsBeforeRethrowing)
+{
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<int> finished(0);
+    ASSERT_THROW(runWorkers(4, [&]()
+                            {
+                                if (std::this_thread::get_id() == caller)
+                                    throw std::runtime_error("job failed");
+                                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                                finished++; }),
+                 std::runtime_error);
+    ASSERT_EQ(finished.load(), 3);
+}
@@ -0,0 +1,113 @@
+#include "../jitterBuffer.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+class JitterBufferTest : public ::testing::Test
+{
+protected:
+    JitterBuffer buffer;
+    long long captured = 0; // Samples written so far
+    std::vector<sample> out = std::vector<sample>(CHUNK);
+
+    /// Simulates one capture callback of n samples of a 440 Hz sine
+    void capture(int n)
+    {
+        std::vector<sample> block(n);
+        for (int i = 0; i < n; i++)
+            block[i] = static_cast<sample>(10000 * std::sin(2 * M_PI * 440.0 * (captured + i) / RATE));
+        buffer.write(block.data(), n);
+        captured += n;
+    }
+
+    /// Simulates one playback callback
+    void play()
+    {
+        buffer.read(out.data(), CHUNK);
+    }
+};
+
+TEST_F(JitterBufferTest, Constructor_InvalidBounds)
+{
+    EXPECT_THROW(JitterBuffer(1024, 0, 64), std::invalid_argument);
+    EXPECT_THROW(JitterBuffer(1024, 128, 64), std::invalid_argument);
+    EXPECT_THROW(JitterBuffer(1024, 64, 512), std::invalid_argument);
+}
+
+// Playback is silent until the writer is a target distance ahead, then starts immediately
+TEST_F(JitterBufferTest, StartsWithinTargetDistance)
+{
+    capture(CHUNK);
+    play();
+    EXPECT_EQ(out[0], 0);
+
+    for (int i = 0; i < 4; i++)
+    {
+        capture(CHUNK);
+        play();
+    }
+    EXPECT_NE(out[CHUNK - 1], 0);
+    EXPECT_LT(buffer.stats().latencyMs, 10.0);
+}
+
+// An underrun widens the target; a long stable run narrows it back down
+TEST_F(JitterBufferTest, WidensAfterUnderrunAndNarrowsWhenStable)
+{
+    for (int i = 0; i < 100; i++)
+    {
+        capture(CHUNK);
+        play();
+    }
+    int initialTarget = buffer.stats().targetSamples;
+
+    for (int i = 0; i < 3; i++)
+        play(); // Capture stalls
+    MonitorStats widened = buffer.stats();
+    EXPECT_GE(widened.underruns, 1);
+    EXPECT_GT(widened.targetSamples, initialTarget);
+
+    for (int i = 0; i < 100 * MONITOR_WINDOW; i++)
+    {
+        capture(CHUNK);
+        play();
+    }
+    EXPECT_LT(buffer.stats().targetSamples, widened.targetSamples);
+}
+
+// A capture clock running fast is absorbed by dropping samples, keeping latency bounded
+TEST_F(JitterBufferTest, DropsSamplesForFastCapture)
+{
+    for (int i = 0; i < 20000; i++)
+    {
+        capture(i % 8 == 0 ? CHUNK + 1 : CHUNK);
+        play();
+    }
+    MonitorStats stats = buffer.stats();
+    EXPECT_GT(stats.drops, 0);
+    EXPECT_EQ(stats.underruns, 0);
+    EXPECT_LT(stats.latencyMs, 32.0 * CHUNK * 1000 / RATE);
+}
+
+// A capture clock running slow is absorbed by repeating samples under a crossfade
+TEST_F(JitterBufferTest, InsertsSamplesSmoothlyForSlowCapture)
+{
+    int maxStep = 0;
+    sample last = 0;
+    for (int i = 0; i < 20000; i++)
+    {
+        capture(i % 8 == 0 ? CHUNK - 1 : CHUNK);
+        play();
+        if (i < 100)
+        {
+            last = out[CHUNK - 1];
+            continue;
+        }
+        for (int j = 0; j < CHUNK; j++)
+        {
+            maxStep = std::max(maxStep, std::abs(out[j] - last));
+            last = out[j];
+        }
+    }
+    EXPECT_GT(buffer.stats().inserts, 0);
+    EXPECT_LT(maxStep, 700); // Max slope of the sine is about 627 per sample
+}
@@ -0,0 +1,117 @@
+#include "../mappedHistory.h"
+#include <gtest/gtest.h>
+#include <filesystem>
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+#include <vector>
+
+/// Temporary history file removed at the end of each test
+class MappedHistoryTest : public ::testing::Test
+{
+protected:
+    std::string path = (std::filesystem::temp_directory_path() / "mappedHistoryTest.bin").string();
+    const uint64_t capacity = 4 * MAPPED_PREFAULT;
+
+    void SetUp() override { std::filesystem::remove(path); }
+    void TearDown() override { std::filesystem::remove(path); }
+
+    /// Writes count samples whose values encode their position
+    static void fill(MappedHistory &history, uint64_t from, uint64_t count)
+    {
+        std::vector<sample> block(CHUNK);
+        for (uint64_t p = from; p < from + count; p += CHUNK)
+        {
+            for (int i = 0; i < CHUNK; i++)
+                block[i] = static_cast<sample>((p + i) * 7);
+            history.write(block.data(), CHUNK, 0);
+            if (p % 4096 == 0)
+                history.maintain();
+        }
+    }
+};
+
+TEST_F(MappedHistoryTest, Constructor_CapacityTooSmall)
+{
+    EXPECT_THROW(MappedHistory(path, 1000), std::invalid_argument);
+}
+
+#ifdef __linux__
+// A file that cannot be sized is refused without leaking its descriptor
+TEST_F(MappedHistoryTest, Constructor_ReleasesFileOnFailure)
+{
+    auto openFiles = []
+    { return std::distance(std::filesystem::directory_iterator("/proc/self/fd"), std::filesystem::directory_iterator()); };
+    auto before = openFiles();
+    EXPECT_THROW(MappedHistory("/dev/null", capacity), std::runtime_error);
+    EXPECT_EQ(openFiles(), before);
+}
+
+// Pages ahead of the writer are prefaulted writable, so the recording callback takes no faults
+TEST_F(MappedHistoryTest, WritesAheadDoNotFault)
+{
+    MappedHistory history(path, capacity);
+    std::vector<sample> block(CHUNK, 1);
+    rusage before, after;
+    getrusage(RUSAGE_THREAD, &before);
+    for (uint64_t written = 0; written + CHUNK <= MAPPED_PREFAULT; written += CHUNK)
+        history.write(block.data(), CHUNK, 0);
+    getrusage(RUSAGE_THREAD, &after);
+    EXPECT_EQ(after.ru_minflt + after.ru_majflt, before.ru_minflt + before.ru_majflt);
+}
+#endif
+
+// The file is preallocated to its full size up front
+TEST_F(MappedHistoryTest, PreallocatesFile)
+{
+    MappedHistory history(path, capacity);
+    EXPECT_EQ(std::filesystem::file_size(path), MAPPED_HEADER + capacity * sizeof(sample));
+}
+
+// Spans point straight into the mapping and split where the buffer wraps
+TEST_F(MappedHistoryTest, ZeroCopySpansAcrossWrap)
+{
+    MappedHistory history(path, capacity);
+    fill(history, 0, capacity + 10 * CHUNK);
+    EXPECT_EQ(history.oldestPosition(), 10u * CHUNK);
+
+    uint64_t position = capacity - 100;
+    HistorySpan view = history.span(position, 300);
+    ASSERT_EQ(view.size(), 300u);
+    EXPECT_EQ(view.firstCount, 100u);
+    EXPECT_EQ(view.secondCount, 200u);
+    for (size_t i = 0; i < view.size(); i++)
+        EXPECT_EQ(view[i], static_cast<sample>((position + i) * 7));
+    EXPECT_EQ(history.span(position, 300).first, view.first); // Same memory every time
+    EXPECT_TRUE(history.stillValid(position));
+
+    EXPECT_EQ(history.span(0, 10).size(), 0u);                             // Overwritten
+    EXPECT_EQ(history.span(history.newestPosition() - 5, 10).size(), 0u); // Not written yet
+}
+
+// Reopening the same file resumes with the samples of the previous session
+TEST_F(MappedHistoryTest, SurvivesReopen)
+{
+    {
+        MappedHistory history(path, capacity);
+        fill(history, 0, 100 * CHUNK);
+    }
+    MappedHistory reopened(path, capacity);
+    EXPECT_EQ(reopened.newestPosition(), 100u * CHUNK);
+
+    std::vector<sample> output(50);
+    ASSERT_TRUE(reopened.read(1000, output.data(), output.size()));
+    for (size_t i = 0; i < output.size(); i++)
+        EXPECT_EQ(output[i], static_cast<sample>((1000 + i) * 7));
+}
+
+// A file created with a different capacity is reset rather than misread
+TEST_F(MappedHistoryTest, ResetsOnCapacityChange)
+{
+    {
+        MappedHistory history(path, capacity);
+        fill(history, 0, 10 * CHUNK);
+    }
+    MappedHistory resized(path, 2 * capacity);
+    EXPECT_EQ(resized.newestPosition(), 0u);
+}
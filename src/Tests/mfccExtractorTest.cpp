@@ -0,0 +1,117 @@
+#include "../mfccExtractor.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+/// Two tones and a little noise, reproducible
+static std::vector<sample> testSignal(size_t n)
+{
+    std::vector<sample> out(n);
+    unsigned seed = 5;
+    for (size_t i = 0; i < n; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        out[i] = static_cast<sample>(7000 * std::sin(2 * M_PI * 330.0 * i / RATE) + 3000 * std::sin(2 * M_PI * 2900.0 * i / RATE) +
+                                     static_cast<int>(seed >> 22) - 512);
+    }
+    return out;
+}
+
+/// Power spectrum of one pre-emphasized, windowed frame by a direct DFT
+static std::vector<float> referencePower(const std::vector<sample> &audio, size_t frame)
+{
+    const int n = MFCC_FRAME, bins = n / 2 + 1;
+    const sample *x = audio.data() + frame * MFCC_HOP;
+    double windowSum = 0;
+    for (int i = 0; i < n; i++)
+        windowSum += 0.54 - 0.46 * std::cos(2 * M_PI * i / n);
+    std::vector<double> framed(n);
+    for (int i = 0; i < n; i++)
+    {
+        double previous = i > 0 ? x[i - 1] : (frame > 0 ? x[-1] : 0);
+        framed[i] = (x[i] - MFCC_PRE_EMPHASIS * previous) * (0.54 - 0.46 * std::cos(2 * M_PI * i / n)) * 2 / (windowSum * 32768);
+    }
+    std::vector<float> power(bins);
+    for (int k = 0; k < bins; k++)
+    {
+        double re = 0, im = 0;
+        for (int i = 0; i < n; i++)
+        {
+            re += framed[i] * std::cos(2 * M_PI * k * i / n);
+            im -= framed[i] * std::sin(2 * M_PI * k * i / n);
+        }
+        power[k] = static_cast<float>(re * re + im * im);
+    }
+    return power;
+}
+
+/// MFCC of one frame the slow way: a direct DFT and a direct DCT-II
+static std::vector<float> referenceMfcc(const std::vector<sample> &audio, size_t frame)
+{
+    const int n = MFCC_FRAME;
+    std::vector<float> power = referencePower(audio, frame);
+    Filterbank mel(MFCC_MEL_BANDS, n, MFCC_MIN_FREQ, MFCC_MAX_FREQ);
+    std::vector<float> bands(MFCC_MEL_BANDS);
+    mel.applyLog(power.data(), bands.data());
+    std::vector<float> out(MFCC_COEFFICIENTS);
+    for (int c = 0; c < MFCC_COEFFICIENTS; c++)
+    {
+        double sum = 0;
+        for (int b = 0; b < MFCC_MEL_BANDS; b++)
+            sum += bands[b] * std::cos(M_PI * c * (b + 0.5) / MFCC_MEL_BANDS);
+        out[c] = static_cast<float>(sum * std::sqrt((c == 0 ? 1.0 : 2.0) / MFCC_MEL_BANDS));
+    }
+    return out;
+}
+
+TEST(MfccExtractorTest, MatchesDirectComputationAcrossBatches)
+{
+    MfccExtractor extractor;
+    std::vector<sample> audio = testSignal(MFCC_FRAME + 74 * MFCC_HOP + 100);
+    std::vector<float> mfcc;
+    extractor.extract(audio.data(), audio.size(), mfcc);
+    ASSERT_EQ(extractor.frameCount(audio.size()), 75u);
+    ASSERT_EQ(mfcc.size(), 75u * MFCC_COEFFICIENTS);
+
+    for (size_t frame : {size_t(0), size_t(1), size_t(MFCC_BATCH - 1), size_t(MFCC_BATCH), size_t(74)})
+    {
+        std::vector<float> expected = referenceMfcc(audio, frame);
+        for (int c = 0; c < MFCC_COEFFICIENTS; c++)
+            EXPECT_NEAR(mfcc[frame * MFCC_COEFFICIENTS + c], expected[c], 0.01f) << "frame " << frame << " c" << c;
+    }
+}
+
+TEST(MfccExtractorTest, SilenceHasOnlyC0)
+{
+    MfccExtractor extractor;
+    std::vector<sample> silence(4 * MFCC_FRAME, 0);
+    std::vector<float> mfcc;
+    extractor.extract(silence.data(), silence.size(), mfcc);
+    ASSERT_FALSE(mfcc.empty());
+    for (size_t f = 0; f < mfcc.size() / MFCC_COEFFICIENTS; f++)
+    {
+        EXPECT_NEAR(mfcc[f * MFCC_COEFFICIENTS], -120.0f * std::sqrt(static_cast<float>(MFCC_MEL_BANDS)), 1e-2f);
+        for (int c = 1; c < MFCC_COEFFICIENTS; c++)
+            EXPECT_NEAR(mfcc[f * MFCC_COEFFICIENTS + c], 0.0f, 1e-3f);
+    }
+}
+
+TEST(MfccExtractorTest, CepstrumOfGivenSpectraMatchesExtract)
+{
+    MfccExtractor extractor;
+    std::vector<sample> audio = testSignal(MFCC_FRAME + 3 * MFCC_HOP);
+    std::vector<float> fromAudio, fromSpectra(2 * MFCC_COEFFICIENTS);
+    extractor.extract(audio.data(), audio.size(), fromAudio);
+
+    std::vector<float> spectra = referencePower(audio, 2), next = referencePower(audio, 3);
+    spectra.insert(spectra.end(), next.begin(), next.end());
+    extractor.cepstrum(spectra.data(), 2, fromSpectra.data());
+    for (int i = 0; i < 2 * MFCC_COEFFICIENTS; i++)
+        EXPECT_NEAR(fromSpectra[i], fromAudio[2 * MFCC_COEFFICIENTS + i], 0.01f);
+}
+
+TEST(MfccExtractorTest, RejectsBadParameters)
+{
+    EXPECT_THROW(MfccExtractor(1024, 512, 30, 26), std::invalid_argument);
+    EXPECT_THROW(MfccExtractor(1024, 0), std::invalid_argument);
+}
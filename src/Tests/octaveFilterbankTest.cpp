@@ -0,0 +1,85 @@
+#include "../octaveFilterbank.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+// Feeds a sine in device-sized blocks and returns the settled band levels
+static std::vector<float> levelsForSine(OctaveFilterbank &bank, double freq, double amplitude = 0.5, int block = 256)
+{
+    std::vector<sample> input(RATE / 2);
+    for (size_t i = 0; i < input.size(); i++)
+        input[i] = static_cast<sample>(amplitude * 32767 * std::sin(2 * M_PI * freq * i / RATE));
+    for (size_t i = 0; i < input.size(); i += block)
+        bank.process(input.data() + i, static_cast<int>(std::min<size_t>(block, input.size() - i)));
+
+    std::vector<float> levels(bank.size());
+    bank.levels(levels.data());
+    return levels;
+}
+
+static int nearestBand(const OctaveFilterbank &bank, double freq)
+{
+    int best = 0;
+    for (int b = 1; b < bank.size(); b++)
+        if (std::abs(std::log(bank.centerFrequency(b) / freq)) < std::abs(std::log(bank.centerFrequency(best) / freq)))
+            best = b;
+    return best;
+}
+
+TEST(OctaveFilterbankTest, Constructor_InvalidConfiguration)
+{
+    EXPECT_THROW(OctaveFilterbank(0), std::invalid_argument);
+    EXPECT_THROW(OctaveFilterbank(3, 100, 50), std::invalid_argument);
+    EXPECT_THROW(OctaveFilterbank(3, 25, 21000), std::invalid_argument);
+}
+
+TEST(OctaveFilterbankTest, ThirdOctaveLayout)
+{
+    OctaveFilterbank bank;
+    EXPECT_EQ(bank.size(), 29); // Nominal 25 Hz to 16 kHz
+    EXPECT_NEAR(bank.centerFrequency(nearestBand(bank, 1000)), 1000, 1e-3);
+    EXPECT_EQ(bank.stageCount(), OCTAVE_MAX_STAGES);
+}
+
+// A sine reads 0 dB in its own band at every decimation stage, and neighbours fall away
+TEST(OctaveFilterbankTest, SineLandsInItsBand)
+{
+    for (double freq : {31.5, 250.0, 1000.0, 8000.0})
+    {
+        OctaveFilterbank bank;
+        int band = nearestBand(bank, freq);
+        std::vector<float> levels = levelsForSine(bank, bank.centerFrequency(band), 1.0);
+
+        EXPECT_NEAR(levels[band], 0.0f, 1.0f) << freq;
+        for (int b = 0; b < bank.size(); b++)
+        {
+            if (std::abs(b - band) >= 2)
+            {
+                EXPECT_LT(levels[b], -20.0f) << freq << " Hz in band " << bank.centerFrequency(b);
+            }
+            if (std::abs(b - band) >= 4)
+            {
+                EXPECT_LT(levels[b], -35.0f) << freq << " Hz in band " << bank.centerFrequency(b);
+            }
+        }
+    }
+}
+
+// High frequencies must not alias into the decimated low octaves
+TEST(OctaveFilterbankTest, NoAliasingIntoLowBands)
+{
+    OctaveFilterbank bank;
+    std::vector<float> levels = levelsForSine(bank, 15000, 1.0, 64);
+    for (int b = 0; b < bank.size() && bank.centerFrequency(b) < 5000; b++)
+        EXPECT_LT(levels[b], -40.0f) << bank.centerFrequency(b);
+}
+
+TEST(OctaveFilterbankTest, SilenceAndReset)
+{
+    OctaveFilterbank bank(1, 31.5, 8000);
+    levelsForSine(bank, 1000);
+    bank.reset();
+    std::vector<float> levels = levelsForSine(bank, 1000, 0.0);
+    for (float level : levels)
+        EXPECT_LT(level, -120.0f);
+}
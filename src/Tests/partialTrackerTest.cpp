@@ -0,0 +1,92 @@
+#include "../partialTracker.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+static int countEvents(const std::vector<PartialUpdate> &events, PartialEvent kind)
+{
+    int n = 0;
+    for (const PartialUpdate &update : events)
+        n += update.event == kind;
+    return n;
+}
+
+TEST(PartialTrackerTest, Constructor_InvalidConfiguration)
+{
+    EXPECT_THROW(PartialTracker(0), std::invalid_argument);
+    EXPECT_THROW(PartialTracker(8, -1), std::invalid_argument);
+}
+
+// Interpolation recovers a frequency between bins from a Gaussian-shaped peak
+TEST(PartialTrackerTest, FindPeaksInterpolates)
+{
+    std::vector<float> magnitude(64, 0.0f);
+    for (int k = 0; k < 64; k++)
+        magnitude[k] = std::exp(-0.5f * (k - 20.3f) * (k - 20.3f)) + 0.5f * std::exp(-0.5f * (k - 40.0f) * (k - 40.0f));
+
+    std::vector<SpectralPeak> peaks;
+    findPeaks(peaks, magnitude.data(), 64, 10.0f, 0.1f);
+    ASSERT_EQ(peaks.size(), 2u);
+    EXPECT_NEAR(peaks[0].frequency, 203.0f, 1.0f);
+    EXPECT_NEAR(peaks[1].frequency, 400.0f, 0.1f);
+
+    findPeaks(peaks, magnitude.data(), 64, 10.0f, 0.1f, 1);
+    ASSERT_EQ(peaks.size(), 1u);
+    EXPECT_NEAR(peaks[0].frequency, 203.0f, 1.0f);
+}
+
+// Gliding partials keep their ids; a vanished one dies after the grace period
+TEST(PartialTrackerTest, BirthContinueDeath)
+{
+    PartialTracker tracker(8, 50, 1);
+    std::vector<PartialUpdate> events;
+
+    tracker.update({{200, 1}, {300, 1}}, events);
+    EXPECT_EQ(countEvents(events, PartialEvent::Birth), 2);
+    int low = tracker.partials()[0].id, high = tracker.partials()[1].id;
+
+    tracker.update({{202, 1}, {303, 1}}, events);
+    EXPECT_EQ(countEvents(events, PartialEvent::Continue), 2);
+    EXPECT_EQ(tracker.partials()[0].id, low);
+    EXPECT_EQ(tracker.partials()[1].id, high);
+    EXPECT_FLOAT_EQ(tracker.partials()[1].frequency, 303);
+
+    tracker.update({{204, 1}}, events); // 303 Hz coasts
+    EXPECT_EQ(events.size(), 1u);
+    EXPECT_EQ(tracker.partials().size(), 2u);
+    tracker.update({{206, 1}}, events); // And dies
+    ASSERT_EQ(countEvents(events, PartialEvent::Death), 1);
+    EXPECT_EQ(tracker.partials().size(), 1u);
+    EXPECT_EQ(tracker.partials()[0].id, low);
+    EXPECT_EQ(tracker.partials()[0].age, 3);
+}
+
+// A partial takes the closer of two candidate peaks; the other is born
+TEST(PartialTrackerTest, PrefersCloserPeak)
+{
+    PartialTracker tracker;
+    std::vector<PartialUpdate> events;
+    tracker.update({{440, 1}}, events);
+    int id = tracker.partials()[0].id;
+
+    tracker.update({{436, 1}, {441, 1}}, events);
+    ASSERT_EQ(tracker.partials().size(), 2u);
+    EXPECT_NE(tracker.partials()[0].id, id);
+    EXPECT_EQ(tracker.partials()[1].id, id);
+    EXPECT_FLOAT_EQ(tracker.partials()[1].frequency, 441);
+}
+
+// Births beyond capacity keep the strongest peaks
+TEST(PartialTrackerTest, BoundedState)
+{
+    PartialTracker tracker(4);
+    std::vector<SpectralPeak> peaks;
+    for (int i = 0; i < 10; i++)
+        peaks.push_back({100.0f * (i + 1), static_cast<float>(i)});
+    std::vector<PartialUpdate> events;
+    tracker.update(peaks, events);
+
+    ASSERT_EQ(tracker.partials().size(), 4u);
+    for (int i = 0; i < 4; i++)
+        EXPECT_FLOAT_EQ(tracker.partials()[i].frequency, 100.0f * (i + 7));
+}
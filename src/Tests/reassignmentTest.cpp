@@ -0,0 +1,46 @@
+#include "../reassignment.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+static std::vector<sample> sine(double freq, int n, double amplitude = 0.5, double phase = 0.3)
+{
+    std::vector<sample> output(n);
+    for (int i = 0; i < n; i++)
+        output[i] = static_cast<sample>(amplitude * 32767 * std::sin(2 * M_PI * freq * i / RATE + phase));
+    return output;
+}
+
+TEST(ReassignmentTest, Constructor_InvalidSize)
+{
+    EXPECT_THROW(ReassignedStft(1000), std::invalid_argument);
+}
+
+// A 4096-point frame pins steady tones to well under a cent across the musical range
+TEST(ReassignmentTest, SubCentAccuracy)
+{
+    ReassignedStft analyzer;
+    std::vector<float> magnitude(analyzer.bins()), frequency(analyzer.bins());
+    for (double freq : {82.41, 110.0, 261.63, 440.0, 443.7, 1318.5})
+    {
+        std::vector<sample> input = sine(freq, analyzer.samplesNeeded());
+        analyzer.analyze(input.data(), magnitude.data(), frequency.data());
+        float estimate = reassignedPeakFrequency(magnitude.data(), frequency.data(), analyzer.bins());
+        EXPECT_NEAR(1200 * std::log2(estimate / freq), 0.0, 0.2) << freq;
+    }
+}
+
+TEST(ReassignmentTest, MagnitudeMatchesStft)
+{
+    ReassignedStft analyzer(1024);
+    Stft stft(1024);
+    std::vector<float> magnitude(analyzer.bins()), frequency(analyzer.bins()), reference(stft.bins());
+    std::vector<sample> input = sine(1000, analyzer.samplesNeeded());
+    analyzer.analyze(input.data(), magnitude.data(), frequency.data());
+    stft.magnitude(input.data(), reference.data());
+    for (int k = 0; k < analyzer.bins(); k++)
+        EXPECT_NEAR(magnitude[k], reference[k], 1e-5);
+
+    std::vector<float> silence(analyzer.bins(), 0.0f);
+    EXPECT_EQ(reassignedPeakFrequency(silence.data(), frequency.data(), analyzer.bins()), 0.0f);
+}
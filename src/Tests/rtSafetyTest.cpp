@@ -0,0 +1,120 @@
+#include "../rtSafety.h"
+#include "../audioDevice.h"
+#include <gtest/gtest.h>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+
+class RTSafetyTest : public ::testing::Test
+{
+protected:
+    RTSafetyChecker &checker = RTSafetyChecker::getInstance();
+
+    void SetUp() override
+    {
+        if (!RTSafetyChecker::hooksInstalled())
+            GTEST_SKIP() << "Built without RT_SAFETY_HOOKS";
+        checker.reset();
+    }
+
+    void TearDown() override
+    {
+        checker.disarm();
+        checker.reset();
+    }
+};
+
+// Allocations on a real-time thread are recorded with a stack trace
+TEST_F(RTSafetyTest, DetectsAllocation)
+{
+    checker.arm();
+    {
+        RealtimeScope realtime;
+        std::vector<int> *v = new std::vector<int>(16);
+        delete v;
+    }
+    checker.disarm();
+
+    EXPECT_GE(checker.violationCount(), 2);
+    EXPECT_NE(checker.report().find("allocation"), std::string::npos);
+}
+
+// The same allocation outside a RealtimeScope is not a violation
+TEST_F(RTSafetyTest, IgnoresNonRealtimeThreads)
+{
+    checker.arm();
+    std::vector<int> v(16);
+    checker.disarm();
+
+    EXPECT_EQ(checker.violationCount(), 0) << checker.report();
+}
+
+// Nothing is recorded while the checker is disarmed
+TEST_F(RTSafetyTest, IgnoresWhenDisarmed)
+{
+    {
+        RealtimeScope realtime;
+        std::vector<int> v(16);
+    }
+    EXPECT_EQ(checker.violationCount(), 0) << checker.report();
+}
+
+#if defined(__GLIBC__)
+// Locks and file writes are caught by the glibc hooks
+TEST_F(RTSafetyTest, DetectsLockAndFileWrite)
+{
+    std::mutex m;
+    checker.arm();
+    {
+        RealtimeScope realtime;
+        m.lock();
+        m.unlock();
+        std::fwrite("", 1, 0, stderr);
+    }
+    checker.disarm();
+
+    std::string report = checker.report();
+    EXPECT_NE(report.find("mutex lock"), std::string::npos) << report;
+    EXPECT_NE(report.find("file write"), std::string::npos) << report;
+}
+#endif
+
+// The audio callbacks must stay real-time safe in the normal case and on underflow/overflow,
+// including the history writes. Without glibc (the MinGW build) only operator new/delete are
+// hooked, so there this proves the callbacks make no C++ allocations and nothing more.
+TEST_F(RTSafetyTest, AudioCallbacksAreRealtimeSafe)
+{
+    if (!RTSafetyChecker::libcHooksInstalled())
+        std::cout << "[   NOTE   ] Only operator new/delete are checked in this build\n";
+
+    sample block[CHUNK] = {1};
+    sample out[CHUNK];
+    int hop = AnalysisNotifier.getHop();
+    AnalysisNotifier.setHop(CHUNK); // Make the recording callback signal the analysis thread
+
+    std::string path = (std::filesystem::temp_directory_path() / "rtSafetyHistory.bin").string();
+    CaptureHistory history(1 << 20);
+    MappedHistory *fileHistory = new MappedHistory(path, 4 * MAPPED_PREFAULT);
+    fileHistory->maintain();
+    OctaveFilterbank octaveBank;
+    History = &history;
+    FileHistory = fileHistory;
+    OctaveBank.store(&octaveBank);
+
+    checker.arm();
+    RecCallback(nullptr, (Uint8 *)block, sizeof(block));
+    PlayCallback(nullptr, (Uint8 *)out, sizeof(out));
+    PlayCallback(nullptr, (Uint8 *)out, sizeof(out)); // Underflow plays silence
+    checker.disarm();
+    AnalysisNotifier.setHop(hop);
+    History = nullptr;
+    FileHistory = nullptr;
+    OctaveBank.store(nullptr);
+    delete fileHistory;
+    std::filesystem::remove(path);
+
+    EXPECT_EQ(checker.violationCount(), 0) << checker.report();
+    EXPECT_EQ(out[0], 0);
+}
@@ -0,0 +1,52 @@
+#include "../sampleNotifier.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+TEST(SampleNotifierTest, Constructor_InvalidHop)
+{
+    EXPECT_THROW(SampleNotifier(0, false), std::invalid_argument);
+}
+
+// Fewer than hop samples do not wake the analysis thread; completing the hop does
+TEST(SampleNotifierTest, SignalsEveryHop)
+{
+    SampleNotifier notifier(256, false);
+    char key = 0;
+
+    notifier.notify(200);
+    EXPECT_EQ(notifier.wait(0, key), WakeReason::Idle);
+    notifier.notify(64);
+    EXPECT_EQ(notifier.wait(0, key), WakeReason::Samples);
+    EXPECT_EQ(notifier.wait(0, key), WakeReason::Idle);
+}
+
+// Several hops before the analysis thread wakes collapse into one wakeup
+TEST(SampleNotifierTest, CoalescesPendingHops)
+{
+    SampleNotifier notifier(64, false);
+    char key = 0;
+    for (int i = 0; i < 10; i++)
+        notifier.notify(64);
+    EXPECT_EQ(notifier.wait(0, key), WakeReason::Samples);
+    EXPECT_EQ(notifier.wait(0, key), WakeReason::Idle);
+}
+
+// A sleeping waiter wakes as soon as the capture thread completes a hop
+TEST(SampleNotifierTest, WakesBlockedWaiter)
+{
+    SampleNotifier notifier(64, false);
+    std::thread capture([&]()
+                        {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                            notifier.notify(64); });
+
+    char key = 0;
+    auto start = std::chrono::steady_clock::now();
+    WakeReason reason = notifier.wait(5000, key);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    capture.join();
+
+    EXPECT_EQ(reason, WakeReason::Samples);
+    EXPECT_LT(elapsed, std::chrono::milliseconds(1000));
+}
@@ -0,0 +1,79 @@
+#include "../scheduling.h"
+#include <gtest/gtest.h>
+#include <thread>
+
+#ifdef __linux__
+TEST(SchedulingTest, ParseArguments)
+{
+    const char *args[] = {"main", "--analysis-cpu", "1", "--render-cpu", "2", "--rt-policy", "rr", "--rt-priority", "50", "--mlock", "--monitor"};
+    char **argv = const_cast<char **>(args);
+    int argc = 11;
+    SchedulingOptions options;
+
+    int i = 1;
+    while (i < argc && parseSchedulingArgument(options, i, argc, argv))
+        i++;
+    EXPECT_EQ(i, 10); // Stops at --monitor
+    EXPECT_EQ(options.analysisCpu, 1);
+    EXPECT_EQ(options.renderCpu, 2);
+    EXPECT_EQ(options.audioPolicy, SchedPolicy::RoundRobin);
+    EXPECT_EQ(options.audioPriority, 50);
+    EXPECT_TRUE(options.lockMemory);
+}
+#else
+// Options the platform cannot apply are refused instead of silently ignored
+TEST(SchedulingTest, RejectsUnsupportedArguments)
+{
+    const char *mlock[] = {"main", "--mlock"};
+    SchedulingOptions options;
+    int i = 1;
+    EXPECT_THROW(parseSchedulingArgument(options, i, 2, const_cast<char **>(mlock)), std::invalid_argument);
+    EXPECT_FALSE(options.lockMemory);
+}
+#endif
+
+TEST(SchedulingTest, ParseInvalidArguments)
+{
+    const char *bad_policy[] = {"main", "--rt-policy", "idle"};
+    const char *bad_priority[] = {"main", "--rt-priority", "100"};
+    const char *missing[] = {"main", "--analysis-cpu"};
+    SchedulingOptions options;
+    int i = 1;
+    EXPECT_THROW(parseSchedulingArgument(options, i, 3, const_cast<char **>(bad_policy)), std::invalid_argument);
+    i = 1;
+    EXPECT_THROW(parseSchedulingArgument(options, i, 3, const_cast<char **>(bad_priority)), std::invalid_argument);
+    i = 1;
+    EXPECT_THROW(parseSchedulingArgument(options, i, 2, const_cast<char **>(missing)), std::invalid_argument);
+}
+
+#ifdef __linux__
+TEST(SchedulingTest, PinThreadReportsCpu)
+{
+    std::string result;
+    std::thread worker([&]()
+                       { result = pinCurrentThread(0); });
+    worker.join();
+    EXPECT_NE(result.find("CPUs 0"), std::string::npos) << result;
+}
+
+// Either the policy is granted or the denial is reported with a hint; never silent
+TEST(SchedulingTest, AudioThreadPolicyIsReported)
+{
+    AudioThreadPolicy slot;
+    requestAudioThreadPolicy(SchedPolicy::Fifo, 10);
+    std::thread audio([&]()
+                      { applyAudioThreadPolicy(slot); });
+    audio.join();
+    requestAudioThreadPolicy(SchedPolicy::Default, 0);
+
+    EXPECT_NE(slot.state.load(), 0);
+    requestAudioThreadPolicy(SchedPolicy::Fifo, 10);
+    std::string description = describeAudioThreadPolicy("Test", slot);
+    requestAudioThreadPolicy(SchedPolicy::Default, 0);
+    EXPECT_NE(description.find("SCHED_FIFO priority 10"), std::string::npos) << description;
+    if (slot.state.load() != 1)
+    {
+        EXPECT_NE(description.find("denied"), std::string::npos) << description;
+    }
+}
+#endif
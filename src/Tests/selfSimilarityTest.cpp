@@ -0,0 +1,128 @@
+#include "../selfSimilarity.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+/// Reproducible features in [-1, 1)
+static std::vector<float> randomFeatures(int frames, int dims, unsigned seed)
+{
+    std::vector<float> out(static_cast<size_t>(frames) * dims);
+    for (float &value : out)
+    {
+        seed = seed * 1103515245u + 12345u;
+        value = static_cast<float>(seed >> 8) / (1u << 23) - 1.0f;
+    }
+    return out;
+}
+
+/// Frames that repeat one random pattern per section, with a little noise
+static std::vector<float> sectionFeatures(const std::vector<int> &starts, int frames, int dims)
+{
+    std::vector<float> noise = randomFeatures(frames, dims, 7), out(static_cast<size_t>(frames) * dims);
+    for (int i = 0; i < frames; i++)
+    {
+        int section = 0;
+        while (section + 1 < static_cast<int>(starts.size()) && i >= starts[section + 1])
+            section++;
+        std::vector<float> pattern = randomFeatures(1, dims, 100 + section);
+        for (int d = 0; d < dims; d++)
+            out[static_cast<size_t>(i) * dims + d] = std::fabs(pattern[d]) + 0.1f * noise[static_cast<size_t>(i) * dims + d];
+    }
+    return out;
+}
+
+TEST(SelfSimilarityTest, BandMatchesDirectCosines)
+{
+    const int frames = 300, dims = 24, band = 50;
+    std::vector<float> features = randomFeatures(frames, dims, 3);
+    SelfSimilarity matrix;
+    matrix.compute(features.data(), frames, dims, band, 3);
+    ASSERT_EQ(matrix.band(), band);
+    EXPECT_EQ(matrix.memoryBytes(), static_cast<size_t>(frames) * band * sizeof(float));
+
+    for (int i = 0; i < frames; i += 7)
+    {
+        for (int j = std::max(0, i - band - 2); j < std::min(frames, i + band + 2); j++)
+        {
+            double dot = 0, a = 0, b = 0;
+            for (int d = 0; d < dims; d++)
+            {
+                dot += features[i * dims + d] * features[j * dims + d];
+                a += features[i * dims + d] * features[i * dims + d];
+                b += features[j * dims + d] * features[j * dims + d];
+            }
+            float expected = std::abs(i - j) < band ? static_cast<float>(dot / std::sqrt(a * b)) : 0.0f;
+            EXPECT_NEAR(matrix.at(i, j), expected, 1e-5f) << i << "," << j;
+        }
+    }
+}
+
+TEST(SelfSimilarityTest, FullBandIsTheWholeSymmetricMatrix)
+{
+    const int frames = 150, dims = 5;
+    std::vector<float> features = randomFeatures(frames, dims, 11);
+    for (int d = 0; d < dims; d++)
+        features[40 * dims + d] = 0; // A silent frame is similar to nothing
+    SelfSimilarity matrix;
+    matrix.compute(features.data(), frames, dims, 0, 2);
+    ASSERT_EQ(matrix.band(), frames);
+    for (int i = 0; i < frames; i++)
+    {
+        EXPECT_NEAR(matrix.at(i, i), i == 40 ? 0.0f : 1.0f, 1e-5f);
+        EXPECT_EQ(matrix.at(i, frames - 1 - i), matrix.at(frames - 1 - i, i));
+        EXPECT_EQ(matrix.at(40, i), 0.0f);
+    }
+}
+
+TEST(SelfSimilarityTest, NoveltyPeaksAtSectionBoundaries)
+{
+    const int frames = 900, dims = 24;
+    std::vector<int> starts = {0, 200, 450, 700};
+    std::vector<float> features = sectionFeatures(starts, frames, dims), curve;
+    SelfSimilarity matrix;
+    matrix.compute(features.data(), frames, dims, 2 * NOVELTY_KERNEL, 4);
+    matrix.novelty(curve, NOVELTY_KERNEL, 2);
+    ASSERT_EQ(curve.size(), static_cast<size_t>(frames));
+
+    std::vector<int> peaks = noveltyPeaks(curve);
+    ASSERT_EQ(peaks.size(), 3u);
+    for (int p = 0; p < 3; p++)
+        EXPECT_NEAR(peaks[p], starts[p + 1], 1);
+    EXPECT_LT(curve[100], NOVELTY_THRESHOLD);
+
+    // Threads and band width beyond the kernel do not change the curve
+    SelfSimilarity wide;
+    std::vector<float> single;
+    wide.compute(features.data(), frames, dims, 300, 1);
+    wide.novelty(single, NOVELTY_KERNEL, 1);
+    for (int i = 0; i < frames; i++)
+        EXPECT_NEAR(single[i], curve[i], 1e-5f);
+}
+
+TEST(SelfSimilarityTest, SectionBoundariesOfAudio)
+{
+    // 20 s of an A minor triad, 20 s of noise, 20 s of the triad again
+    std::vector<sample> audio(60 * RATE);
+    unsigned seed = 1;
+    for (size_t i = 0; i < audio.size(); i++)
+    {
+        double t = static_cast<double>(i) / RATE;
+        seed = seed * 1103515245u + 12345u;
+        bool middle = t >= 20 && t < 40;
+        audio[i] = static_cast<sample>(middle ? static_cast<int>(seed >> 18) - 8192
+                                              : 4000 * (std::sin(2 * M_PI * 220 * t) + std::sin(2 * M_PI * 261.63 * t) + std::sin(2 * M_PI * 329.63 * t)));
+    }
+    std::vector<double> boundaries = sectionBoundaries(audio.data(), audio.size(), 2);
+    ASSERT_EQ(boundaries.size(), 2u);
+    EXPECT_NEAR(boundaries[0], 20.0, 0.5);
+    EXPECT_NEAR(boundaries[1], 40.0, 0.5);
+}
+
+TEST(SelfSimilarityTest, RejectsKernelWiderThanBand)
+{
+    std::vector<float> features = randomFeatures(100, 4, 5), curve;
+    SelfSimilarity matrix;
+    matrix.compute(features.data(), 100, 4, 20);
+    EXPECT_THROW(matrix.novelty(curve, 16), std::invalid_argument);
+    EXPECT_THROW(matrix.compute(features.data(), 100, 0), std::invalid_argument);
+}
@@ -0,0 +1,174 @@
+#include "../similaritySearch.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+/// A random melody of three-partial chords, each held for a third of a second, reproducible from its seed
+static std::vector<sample> melody(unsigned seed, double seconds)
+{
+    std::vector<sample> out(static_cast<size_t>(seconds * RATE));
+    const int noteLength = RATE / 3;
+    double f[3] = {0, 0, 0}, phase[3] = {0, 0, 0};
+    for (size_t i = 0; i < out.size(); i++)
+    {
+        if (i % noteLength == 0)
+        {
+            for (double &frequency : f)
+            {
+                seed = seed * 1103515245u + 12345u;
+                frequency = 110 * std::pow(2.0, (seed >> 8) % 36 / 12.0); // Three octaves from 110 Hz
+            }
+        }
+        double value = 0;
+        for (int p = 0; p < 3; p++)
+        {
+            phase[p] += 2 * M_PI * f[p] / RATE;
+            value += std::sin(phase[p]);
+        }
+        out[i] = static_cast<sample>(6000 * value);
+    }
+    return out;
+}
+
+/// Rows of uniform random features, reproducible from the seed
+static std::vector<float> randomRows(unsigned seed, size_t rows)
+{
+    std::vector<float> out(rows * SIMILARITY_DIMS);
+    for (float &value : out)
+    {
+        seed = seed * 1103515245u + 12345u;
+        value = static_cast<float>(seed >> 8) / (1 << 24) * 2 - 1;
+    }
+    return out;
+}
+
+class SimilaritySearchTest : public ::testing::Test
+{
+protected:
+    static FeatureMatrix random, music;
+    static std::vector<std::vector<sample>> tracks;
+
+    static void SetUpTestSuite()
+    {
+        random.setFeatures({"x", "y"}, {randomRows(1, 2500), randomRows(2, 1500)});
+        std::vector<std::vector<float>> features(3);
+        for (unsigned t = 0; t < 3; t++)
+        {
+            tracks.push_back(melody(40 + t, 20));
+            extractSimilarityFeatures(tracks[t].data(), tracks[t].size(), features[t]);
+        }
+        music.setFeatures({"a.wav", "b.wav", "c.wav"}, features);
+    }
+
+    static std::vector<float> decoded(const FeatureMatrix &matrix, size_t r)
+    {
+        std::vector<float> out(SIMILARITY_DIMS);
+        for (int d = 0; d < SIMILARITY_DIMS; d++)
+            out[d] = halfToFloat(matrix.row(r)[d]);
+        return out;
+    }
+};
+
+FeatureMatrix SimilaritySearchTest::random, SimilaritySearchTest::music;
+std::vector<std::vector<sample>> SimilaritySearchTest::tracks;
+
+TEST_F(SimilaritySearchTest, ExactFindsTheQueryRowFirst)
+{
+    SimilarityIndex index(random);
+    std::vector<float> query = decoded(random, 3210);
+    std::vector<SimilarityMatch> matches = index.exact(query.data(), 5);
+    ASSERT_EQ(matches.size(), 5u);
+    EXPECT_EQ(matches[0].row, 3210u);
+    EXPECT_FLOAT_EQ(matches[0].distance, 0.0f);
+    for (size_t i = 1; i < matches.size(); i++)
+        EXPECT_GE(matches[i].distance, matches[i - 1].distance);
+    EXPECT_EQ(random.fileOf(matches[0].row), 1);
+}
+
+TEST_F(SimilaritySearchTest, InvertedListsAgreeWithExactSearch)
+{
+    SimilarityIndex index(random);
+    index.train(0, 2);
+    ASSERT_TRUE(index.trained());
+    EXPECT_EQ(index.listCount(), 63);
+
+    int agreed = 0;
+    for (size_t r = 7; r < random.rowCount(); r += 97)
+    {
+        std::vector<float> query = decoded(random, r);
+        for (float &value : query)
+            value += 0.05f;
+        std::vector<SimilarityMatch> approximate = index.search(query.data(), 1), reference = index.exact(query.data(), 1);
+        agreed += approximate[0].row == reference[0].row;
+    }
+    EXPECT_GE(agreed, 38); // Of 42 queries
+}
+
+TEST_F(SimilaritySearchTest, PassageSearchFindsTheExcerpt)
+{
+    SimilarityIndex index(music);
+    index.train(0, 2);
+    size_t start = static_cast<size_t>(7.3 * RATE);
+    std::vector<PassageMatch> passages = index.searchPassage(tracks[1].data() + start, 3 * RATE, 3);
+    ASSERT_FALSE(passages.empty());
+    EXPECT_EQ(passages[0].file, 1);
+    EXPECT_EQ(passages[0].name, "b.wav");
+    EXPECT_NEAR(passages[0].seconds, 7.3, 1.5 * SIMILARITY_HOP / RATE);
+    for (size_t p = 1; p < passages.size(); p++)
+        EXPECT_LT(passages[p].votes, passages[0].votes);
+}
+
+TEST_F(SimilaritySearchTest, SavedIndexMapsBack)
+{
+    SimilarityIndex index(random);
+    index.train(20, 1);
+    const char *path = "similaritySearchTest.ivf";
+    index.save(path);
+    {
+        SimilarityIndex loaded(random);
+        loaded.load(path);
+        EXPECT_EQ(loaded.listCount(), 20);
+        std::vector<float> query = decoded(random, 100);
+        std::vector<SimilarityMatch> fromFile = loaded.search(query.data(), 4), fromMemory = index.search(query.data(), 4);
+        ASSERT_EQ(fromFile.size(), fromMemory.size());
+        for (size_t i = 0; i < fromFile.size(); i++)
+            EXPECT_EQ(fromFile[i].row, fromMemory[i].row);
+
+        SimilarityIndex other(music);
+        EXPECT_THROW(other.load(path), std::runtime_error);
+    }
+    std::remove(path);
+}
+
+// Files with the right size and header but inconsistent lists are refused before any search reads them
+TEST_F(SimilaritySearchTest, LoadRejectsDamagedFiles)
+{
+    SimilarityIndex index(random);
+    index.train(20, 1);
+    const char *path = "similaritySearchTest.ivf";
+    index.save(path);
+    std::vector<char> bytes;
+    {
+        std::ifstream in(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    const size_t offsetsAt = 24 + 20 * SIMILARITY_DIMS * sizeof(float);
+
+    auto rejects = [&](size_t at, const std::vector<char> &patch)
+    {
+        std::vector<char> damaged = bytes;
+        std::copy(patch.begin(), patch.end(), damaged.begin() + at);
+        std::ofstream(path, std::ios::binary).write(damaged.data(), static_cast<std::streamsize>(damaged.size()));
+        SimilarityIndex loaded(random);
+        EXPECT_THROW(loaded.load(path), std::runtime_error) << "patch at byte " << at;
+    };
+    rejects(offsetsAt + 5 * sizeof(uint32_t), {-1, -1, -1, -1});  // A list offset out of order
+    rejects(offsetsAt + 20 * sizeof(uint32_t), {0, 0, 0, 0});     // Offsets that do not end at the row count
+    rejects(bytes.size() - sizeof(uint32_t), {-1, -1, -1, -1});   // A list entry for a row that does not exist
+    rejects(12, {-1, -1, -1, -1});                                // A list count the file cannot hold
+    std::remove(path);
+}
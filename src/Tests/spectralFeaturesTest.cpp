@@ -0,0 +1,92 @@
+#include "../spectralFeatures.h"
+#include "../fftPlan.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+static std::vector<float> spectrumOf(const std::vector<sample> &signal)
+{
+    Stft stft(FEATURE_FFT);
+    std::vector<float> magnitude(stft.bins());
+    stft.magnitude(signal.data(), magnitude.data());
+    return magnitude;
+}
+
+static std::vector<sample> sine(double frequency, double amplitude)
+{
+    std::vector<sample> out(FEATURE_FFT);
+    for (int i = 0; i < FEATURE_FFT; i++)
+        out[i] = static_cast<sample>(amplitude * 32767 * std::sin(2 * M_PI * frequency * i / RATE));
+    return out;
+}
+
+static const float binHz = static_cast<float>(RATE) / FEATURE_FFT;
+
+TEST(SpectralFeaturesTest, SegmentsCoverEveryBinOnce)
+{
+    std::vector<FeatureSegment> segments = featureSegments(FEATURE_FFT / 2 + 1, binHz);
+    int next = 0;
+    for (const FeatureSegment &segment : segments)
+    {
+        EXPECT_EQ(segment.start, next);
+        EXPECT_GT(segment.count, 0);
+        EXPECT_LE(segment.count, FEATURE_BLOCK);
+        EXPECT_EQ(segment.block, segment.start / FEATURE_BLOCK);
+        EXPECT_EQ((segment.start + segment.count - 1) / FEATURE_BLOCK, segment.block);
+        EXPECT_GE(segment.start * binHz, featureBandEdge(segment.band));
+        next = segment.start + segment.count;
+    }
+    EXPECT_EQ(next, FEATURE_FFT / 2 + 1);
+}
+
+TEST(SpectralFeaturesTest, SineIsTonalAndCentred)
+{
+    std::vector<float> magnitude = spectrumOf(sine(1500, 0.5));
+    FeatureBank<AllFeatures> bank(static_cast<int>(magnitude.size()), binHz);
+    SpectralFeatures features;
+    bank.compute(magnitude.data(), features);
+
+    EXPECT_NEAR(features.centroid, 1500.0f, 20.0f);
+    EXPECT_LT(features.spread, 300.0f); // Magnitude weighting gives the window's sidelobes some say
+    EXPECT_NEAR(features.rolloff, 1500.0f, 2 * binHz);
+    EXPECT_LT(features.flatness, 0.01f);
+    EXPECT_NEAR(features.bands[4], -6.0f, 0.5f); // The 1-2 kHz band
+    EXPECT_LT(features.bands[1], -40.0f);
+    EXPECT_GT(features.flux, 0.0f); // Rising from silence
+}
+
+TEST(SpectralFeaturesTest, NoiseIsFlatAndFluxTracksChange)
+{
+    std::srand(7);
+    std::vector<sample> noise(FEATURE_FFT);
+    for (sample &s : noise)
+        s = static_cast<sample>((std::rand() % 16384) - 8192);
+    std::vector<float> magnitude = spectrumOf(noise);
+    FeatureBank<AllFeatures> bank(static_cast<int>(magnitude.size()), binHz);
+    SpectralFeatures features;
+    bank.compute(magnitude.data(), features);
+
+    EXPECT_GT(features.flatness, 0.3f);
+    EXPECT_NEAR(features.centroid, RATE / 4.0f, 1000.0f);
+    EXPECT_NEAR(features.rolloff, 0.85f * RATE / 2, 1000.0f);
+
+    bank.compute(magnitude.data(), features);
+    EXPECT_FLOAT_EQ(features.flux, 0.0f); // Same frame again
+}
+
+TEST(SpectralFeaturesTest, SubsetMatchesFullSet)
+{
+    std::vector<float> magnitude = spectrumOf(sine(3000, 0.25));
+    FeatureBank<AllFeatures> full(static_cast<int>(magnitude.size()), binHz);
+    FeatureBank<FeatureCentroid | FeatureRolloff> subset(static_cast<int>(magnitude.size()), binHz);
+    SpectralFeatures all, some;
+    full.compute(magnitude.data(), all);
+    subset.compute(magnitude.data(), some);
+
+    EXPECT_FLOAT_EQ(some.centroid, all.centroid);
+    EXPECT_FLOAT_EQ(some.rolloff, all.rolloff);
+    EXPECT_EQ(some.spread, 0.0f);
+    EXPECT_EQ(some.flatness, 0.0f);
+    EXPECT_EQ(some.bands[0], 0.0f);
+}
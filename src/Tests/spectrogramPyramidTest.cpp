@@ -0,0 +1,127 @@
+#include "../spectrogramPyramid.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+/// A column whose bins fall from -20 dB with a slope that changes with its index
+static std::vector<float> column(int bins, uint64_t index)
+{
+    std::vector<float> out(bins);
+    for (int b = 0; b < bins; b++)
+        out[b] = -20.0f - static_cast<float>((index * 7 + b * 3) % 80);
+    return out;
+}
+
+TEST(SpectrogramPyramidTest, EachLevelHalvesTheColumns)
+{
+    SpectrogramPyramid pyramid(8);
+    for (uint64_t c = 0; c < 1000; c++)
+        pyramid.append(column(8, c).data());
+    EXPECT_EQ(pyramid.columns(), 1000u);
+    ASSERT_EQ(pyramid.levelCount(), 10);
+    for (int level = 1; level < pyramid.levelCount(); level++)
+        EXPECT_EQ(pyramid.levelColumns(level), pyramid.levelColumns(level - 1) / 2);
+    EXPECT_EQ(pyramid.bytes(), (1000u + 500 + 250 + 125 + 62 + 31 + 15 + 7 + 3 + 1) * 8);
+}
+
+TEST(SpectrogramPyramidTest, FullResolutionViewReturnsTheColumns)
+{
+    SpectrogramPyramid pyramid(16);
+    for (uint64_t c = 0; c < 100; c++)
+        pyramid.append(column(16, c).data());
+    std::vector<float> view(40 * 16);
+    pyramid.render(30, 70, 40, view.data());
+    for (int x = 0; x < 40; x++)
+    {
+        std::vector<float> expected = column(16, 30 + x);
+        for (int b = 0; b < 16; b++)
+            EXPECT_NEAR(view[x * 16 + b], expected[b], 0.25f);
+    }
+}
+
+TEST(SpectrogramPyramidTest, ZoomedOutViewsPoolLikeBruteForce)
+{
+    SpectrogramPyramid maxPyramid(4, PyramidPooling::Max), meanPyramid(4, PyramidPooling::Mean);
+    std::vector<std::vector<float>> columns;
+    for (uint64_t c = 0; c < 4096; c++)
+    {
+        columns.push_back(column(4, c));
+        maxPyramid.append(columns.back().data());
+        meanPyramid.append(columns.back().data());
+    }
+
+    const int width = 16; // 256 columns per output column, aligned with level 8
+    std::vector<float> maxView(width * 4), meanView(width * 4);
+    maxPyramid.render(0, 4096, width, maxView.data());
+    meanPyramid.render(0, 4096, width, meanView.data());
+    for (int x = 0; x < width; x++)
+    {
+        for (int b = 0; b < 4; b++)
+        {
+            float maximum = -1000, sum = 0;
+            for (int c = x * 256; c < (x + 1) * 256; c++)
+            {
+                maximum = std::max(maximum, columns[c][b]);
+                sum += columns[c][b];
+            }
+            EXPECT_NEAR(maxView[x * 4 + b], maximum, 0.25f);
+            EXPECT_NEAR(meanView[x * 4 + b], sum / 256, 2.5f); // Rounds up by up to half a step per level
+        }
+    }
+}
+
+TEST(SpectrogramPyramidTest, UnpairedRecentColumnsStillShow)
+{
+    SpectrogramPyramid pyramid(2);
+    std::vector<float> quiet = {-100, -100}, loud = {0, -100};
+    for (int c = 0; c < 12; c++)
+        pyramid.append(quiet.data());
+    pyramid.append(loud.data()); // Column 12 has no partner yet
+    std::vector<float> view(2);
+    pyramid.render(0, 13, 1, view.data());
+    EXPECT_NEAR(view[0], 0.0f, 0.25f);
+    EXPECT_NEAR(view[1], -100.0f, 0.25f);
+
+    std::vector<float> wide(4 * 2);
+    pyramid.render(0, 26, 4, wide.data()); // Half the view lies beyond the recording
+    EXPECT_NEAR(wide[2], 0.0f, 0.25f);
+    EXPECT_FLOAT_EQ(wide[6], PYRAMID_FLOOR_DB);
+}
+
+TEST(SpectrogramPyramidTest, SavedPyramidMapsBackAndKeepsGrowing)
+{
+    SpectrogramPyramid pyramid(8, PyramidPooling::Mean);
+    for (uint64_t c = 0; c < 333; c++)
+        pyramid.append(column(8, c).data());
+    const char *path = "spectrogramPyramidTest.spy";
+    pyramid.save(path);
+    {
+        SpectrogramPyramid loaded;
+        loaded.load(path);
+        ASSERT_EQ(loaded.bins(), 8);
+        ASSERT_EQ(loaded.columns(), 333u);
+        std::vector<float> a(20 * 8), b(20 * 8);
+        pyramid.render(0, 333, 20, a.data());
+        loaded.render(0, 333, 20, b.data());
+        EXPECT_EQ(a, b);
+
+        for (uint64_t c = 333; c < 400; c++)
+        {
+            pyramid.append(column(8, c).data());
+            loaded.append(column(8, c).data());
+        }
+        pyramid.render(0, 400, 7, a.data());
+        loaded.render(0, 400, 7, b.data());
+        EXPECT_EQ(a, b);
+        EXPECT_EQ(loaded.levelCount(), pyramid.levelCount());
+    }
+    std::remove(path);
+
+    FILE *file = std::fopen(path, "wb");
+    std::fputs("not a pyramid", file);
+    std::fclose(file);
+    SpectrogramPyramid other;
+    EXPECT_THROW(other.load(path), std::runtime_error);
+    std::remove(path);
+}
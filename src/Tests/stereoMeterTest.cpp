@@ -0,0 +1,75 @@
+#include "../stereoMeter.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+static void feed(StereoMeter &meter, double leftGain, double rightGain, double rightPhase = 0)
+{
+    std::vector<sample> left(RATE), right(RATE);
+    for (int i = 0; i < RATE; i++)
+    {
+        left[i] = static_cast<sample>(leftGain * 32767 * std::sin(2 * M_PI * 500 * i / RATE));
+        right[i] = static_cast<sample>(rightGain * 32767 * std::sin(2 * M_PI * 500 * i / RATE + rightPhase));
+    }
+    for (int i = 0; i < RATE; i += 441)
+        meter.process(left.data() + i, right.data() + i, 441);
+}
+
+TEST(StereoMeterTest, MonoIsFullyCorrelated)
+{
+    StereoMeter meter;
+    feed(meter, 0.5, 0.5);
+    EXPECT_NEAR(meter.correlation(), 1.0f, 1e-3);
+    EXPECT_NEAR(meter.leftDb(), -6.0f, 0.2f);
+    EXPECT_NEAR(meter.midDb(), -6.0f, 0.2f);
+    EXPECT_LT(meter.sideDb(), -60.0f);
+
+    // The trace lies on the vertical axis
+    const std::vector<float> &scope = meter.goniometer();
+    float offAxis = 0, total = 0;
+    for (int row = 0; row < SCOPE_SIZE; row++)
+        for (int column = 0; column < SCOPE_SIZE; column++)
+        {
+            total += scope[row * SCOPE_SIZE + column];
+            if (column != SCOPE_SIZE / 2)
+                offAxis += scope[row * SCOPE_SIZE + column];
+        }
+    EXPECT_GT(total, 0);
+    EXPECT_EQ(offAxis, 0);
+}
+
+TEST(StereoMeterTest, PhaseAndBalance)
+{
+    StereoMeter inverted;
+    feed(inverted, 0.5, 0.5, M_PI);
+    EXPECT_NEAR(inverted.correlation(), -1.0f, 1e-3);
+    EXPECT_LT(inverted.midDb(), -60.0f);
+
+    StereoMeter quadrature;
+    feed(quadrature, 0.5, 0.5, M_PI / 2);
+    EXPECT_NEAR(quadrature.correlation(), 0.0f, 0.02f);
+
+    StereoMeter leftOnly;
+    feed(leftOnly, 0.5, 0.0);
+    EXPECT_NEAR(leftOnly.midDb(), leftOnly.sideDb(), 0.1f);
+    EXPECT_LT(leftOnly.rightDb(), -90.0f);
+}
+
+TEST(StereoMeterTest, InterleavedMatchesDeinterleaved)
+{
+    std::vector<sample> left(5000), right(5000), interleaved(10000);
+    for (int i = 0; i < 5000; i++)
+    {
+        left[i] = static_cast<sample>((i * 37) % 2001 - 1000);
+        right[i] = static_cast<sample>((i * 91) % 1501 - 750);
+        interleaved[2 * i] = left[i];
+        interleaved[2 * i + 1] = right[i];
+    }
+    StereoMeter a, b;
+    for (int i = 0; i < 5000; i += STEREO_BLOCK)
+        a.process(left.data() + i, right.data() + i, std::min(STEREO_BLOCK, 5000 - i));
+    b.processInterleaved(interleaved.data(), 5000);
+    EXPECT_FLOAT_EQ(a.correlation(), b.correlation());
+    EXPECT_FLOAT_EQ(a.sideDb(), b.sideDb());
+    EXPECT_EQ(a.goniometer(), b.goniometer());
+}
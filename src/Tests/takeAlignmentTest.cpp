@@ -0,0 +1,189 @@
+#include "../takeAlignment.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+/// Reproducible rows of non-negative values scaled to unit length, like chroma
+static std::vector<float> randomRows(int frames, int dims, unsigned seed)
+{
+    std::vector<float> out(static_cast<size_t>(frames) * dims);
+    for (int r = 0; r < frames; r++)
+    {
+        double energy = 0;
+        for (int d = 0; d < dims; d++)
+        {
+            seed = seed * 1103515245u + 12345u;
+            out[r * dims + d] = static_cast<float>(seed >> 8) / (1u << 24);
+            energy += out[r * dims + d] * out[r * dims + d];
+        }
+        for (int d = 0; d < dims; d++)
+            out[r * dims + d] = static_cast<float>(out[r * dims + d] / std::sqrt(energy));
+    }
+    return out;
+}
+
+static float distance(const std::vector<float> &a, int i, const std::vector<float> &b, int j, int dims)
+{
+    float dot = 0;
+    for (int d = 0; d < dims; d++)
+        dot += a[i * dims + d] * b[j * dims + d];
+    return 1.0f - dot;
+}
+
+/// Textbook DTW over the whole matrix, skipping cells outside the window
+static double bruteForce(const std::vector<float> &a, int n, const std::vector<float> &b, int m, int dims, const DtwWindow &window)
+{
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> cost(static_cast<size_t>(n) * m, infinity);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < m; j++)
+        {
+            if (i < window.low[i + j] || i > window.high[i + j])
+                continue;
+            double best = i == 0 && j == 0 ? 0 : infinity;
+            if (i > 0)
+                best = std::min(best, cost[(i - 1) * m + j]);
+            if (j > 0)
+                best = std::min(best, cost[i * m + j - 1]);
+            if (i > 0 && j > 0)
+                best = std::min(best, cost[(i - 1) * m + j - 1]);
+            cost[i * m + j] = best + distance(a, i, b, j, dims);
+        }
+    }
+    return cost.back();
+}
+
+/// Checks the path is connected and monotone from the first cell to the last, and returns its cost
+static double pathCost(const std::vector<WarpStep> &path, const std::vector<float> &a, int n, const std::vector<float> &b, int m, int dims)
+{
+    EXPECT_EQ(path.front(), WarpStep(0, 0));
+    EXPECT_EQ(path.back(), WarpStep(n - 1, m - 1));
+    double total = 0;
+    for (size_t s = 0; s < path.size(); s++)
+    {
+        if (s > 0)
+        {
+            int di = path[s].first - path[s - 1].first, dj = path[s].second - path[s - 1].second;
+            EXPECT_TRUE((di == 0 || di == 1) && (dj == 0 || dj == 1) && di + dj > 0) << "step " << s;
+        }
+        total += distance(a, path[s].first, b, path[s].second, dims);
+    }
+    return total;
+}
+
+TEST(TakeAlignmentTest, FullWindowMatchesBruteForce)
+{
+    // Over DTW_CHECKPOINT anti-diagonals, so the path is traced across several segments
+    const int n = 230, m = 190, dims = 12;
+    std::vector<float> a = randomRows(n, dims, 1), b = randomRows(m, dims, 2);
+    Dtw dtw(a.data(), n, b.data(), m, dims);
+    std::vector<WarpStep> path;
+    DtwWindow window = DtwWindow::full(n, m);
+    ASSERT_EQ(window.cells(), static_cast<size_t>(n) * m);
+    double total = dtw.align(window, path);
+    EXPECT_NEAR(total, bruteForce(a, n, b, m, dims, window), 1e-3);
+    EXPECT_NEAR(pathCost(path, a, n, b, m, dims), total, 1e-3);
+    EXPECT_EQ(dtw.cellsEvaluated(), 2 * window.cells()); // Once to accumulate, once to trace
+}
+
+TEST(TakeAlignmentTest, BandMatchesBruteForceInsideIt)
+{
+    const int n = 400, m = 300, dims = 5;
+    std::vector<float> a = randomRows(n, dims, 3), b = randomRows(m, dims, 4);
+    DtwWindow window = DtwWindow::band(n, m, 10);
+    EXPECT_LT(window.cells(), static_cast<size_t>(n) * m / 8);
+    Dtw dtw(a.data(), n, b.data(), m, dims);
+    std::vector<WarpStep> path;
+    double total = dtw.align(window, path);
+    EXPECT_NEAR(total, bruteForce(a, n, b, m, dims, window), 1e-3);
+    EXPECT_NEAR(pathCost(path, a, n, b, m, dims), total, 1e-3);
+    for (const WarpStep &step : path)
+        EXPECT_LE(std::fabs(step.second - step.first * (m - 1.0) / (n - 1)), 11.0);
+}
+
+TEST(TakeAlignmentTest, MultiscaleFollowsAKnownWarp)
+{
+    // The take lingers over the middle of the piece: take frame j plays reference frame warp(j)
+    const int n = 6000, m = 7500, dims = 12;
+    std::vector<float> a = randomRows(n, dims, 5), b(static_cast<size_t>(m) * dims);
+    auto warp = [&](int j)
+    {
+        double t = static_cast<double>(j) / (m - 1);
+        return static_cast<int>(std::lround((n - 1) * (t - 0.1 * std::sin(2 * M_PI * t))));
+    };
+    for (int j = 0; j < m; j++)
+        std::copy(a.begin() + warp(j) * dims, a.begin() + (warp(j) + 1) * dims, b.begin() + j * dims);
+
+    size_t cells = 0, bytes = 0;
+    std::vector<WarpStep> path = multiscaleDtw(a.data(), n, b.data(), m, dims, DTW_RADIUS, &cells, &bytes);
+    pathCost(path, a, n, b, m, dims);
+    int off = 0;
+    for (const WarpStep &step : path)
+        off += std::abs(step.first - warp(step.second)) > 1;
+    EXPECT_EQ(off, 0);
+    EXPECT_LT(cells, static_cast<size_t>(n) * m / 10);
+    EXPECT_LT(bytes, static_cast<size_t>(n) * m * sizeof(float) / 100);
+}
+
+TEST(TakeAlignmentTest, TimeMapOfASlowerTake)
+{
+    // Four chords of 3 s in the reference; the take starts 2 s late and plays them 1.5 times slower
+    static const double roots[] = {220.0, 293.66, 246.94, 329.63};
+    auto render = [](double offset, double stretch, double seconds)
+    {
+        std::vector<sample> audio(static_cast<size_t>(seconds * RATE));
+        for (size_t i = 0; i < audio.size(); i++)
+        {
+            double t = static_cast<double>(i) / RATE, score = (t - offset) / stretch;
+            if (score < 0 || score >= 12)
+                continue;
+            double root = roots[static_cast<int>(score / 3)];
+            audio[i] = static_cast<sample>(5000 * (std::sin(2 * M_PI * root * t) + std::sin(2 * M_PI * root * 1.25 * t) +
+                                                   std::sin(2 * M_PI * root * 1.5 * t)));
+        }
+        return audio;
+    };
+    std::vector<sample> reference = render(0, 1, 12), take = render(2, 1.5, 20);
+    std::vector<std::pair<double, double>> map = alignTakes(reference.data(), reference.size(), take.data(), take.size(), 2);
+    ASSERT_FALSE(map.empty());
+    for (size_t r = 1; r < map.size(); r++)
+    {
+        EXPECT_GT(map[r].first, map[r - 1].first);
+        EXPECT_GE(map[r].second, map[r - 1].second);
+    }
+
+    // A held chord may be stretched anywhere along it, but the frames either side of a change map either side of it
+    for (double change : {3.0, 6.0, 9.0})
+    {
+        double takeChange = 2 + 1.5 * change;
+        for (const std::pair<double, double> &point : map)
+        {
+            if (point.first < change - 0.3)
+            {
+                EXPECT_LT(point.second, takeChange + 0.3) << point.first;
+            }
+            else if (point.first > change + 0.3)
+            {
+                EXPECT_GT(point.second, takeChange - 0.3) << point.first;
+            }
+        }
+    }
+}
+
+TEST(TakeAlignmentTest, RejectsWindowsThatDoNotFit)
+{
+    std::vector<float> a = randomRows(20, 3, 6), b = randomRows(30, 3, 7);
+    Dtw dtw(a.data(), 20, b.data(), 30, 3);
+    std::vector<WarpStep> path;
+    EXPECT_THROW(dtw.align(DtwWindow::full(20, 31), path), std::invalid_argument);
+    DtwWindow outside = DtwWindow::full(20, 30);
+    outside.high[10] = 11;
+    EXPECT_THROW(dtw.align(outside, path), std::invalid_argument);
+    DtwWindow broken = DtwWindow::full(20, 30);
+    broken.low[25] = broken.high[25] + 1;
+    broken.low[26] = broken.high[26] + 1;
+    EXPECT_THROW(dtw.align(broken, path), std::runtime_error);
+    EXPECT_THROW(Dtw(a.data(), 0, b.data(), 30, 3), std::invalid_argument);
+}
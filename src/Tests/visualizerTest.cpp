@@ -0,0 +1,44 @@
+#include "../visualizer.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+
+/// Fills the queue with FFTLEN samples of a sum of sines, or of silence without frequencies
+static void play(AudioQueue &queue, const std::vector<double> &frequencies)
+{
+    std::vector<sample> block(FFTLEN);
+    for (int i = 0; i < FFTLEN; i++)
+    {
+        double value = 0;
+        for (double f : frequencies)
+            value += std::sin(2 * M_PI * f * i / RATE);
+        block[i] = static_cast<sample>(200 * value);
+    }
+    queue.push(block.data(), FFTLEN);
+}
+
+// Releasing a held chord into silence leaves no tones to name, which must not reach identify_chord
+TEST(VisualizerTest, ChordGuesserSurvivesReleaseIntoSilence)
+{
+    AudioQueue queue(4 * FFTLEN);
+    testing::internal::CaptureStdout();
+    for (int frame = 0; frame < PARTIAL_MIN_AGE + 2; frame++) // Long enough for the partials to be established
+    {
+        play(queue, {261.63, 329.63, 392.0}); // C major
+        ChordGuesser(queue, false);
+        queue.discard(FFTLEN);
+    }
+    testing::internal::GetCapturedStdout();
+
+    testing::internal::CaptureStdout();
+    for (int frame = 0; frame < PARTIAL_MIN_AGE + PARTIAL_GRACE + 2; frame++)
+    {
+        play(queue, {});
+        EXPECT_NO_THROW(ChordGuesser(queue, false));
+        queue.discard(FFTLEN);
+    }
+    std::string released = testing::internal::GetCapturedStdout();
+    const std::string last = "\nNo Chord Detected\n";
+    ASSERT_GE(released.size(), last.size());
+    EXPECT_EQ(released.substr(released.size() - last.size()), last);
+}
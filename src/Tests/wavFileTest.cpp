@@ -0,0 +1,85 @@
+#include "../wavFile.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+/// Writes a WAV file with any encoding, for the reader to convert
+static void writeRaw(const char *path, int format, int channels, int rate, int bits, const std::vector<uint8_t> &data, bool withListChunk = false)
+{
+    auto put = [](std::ofstream &out, uint32_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; i++, value >>= 8)
+            out.put(static_cast<char>(value & 0xFF));
+    };
+    std::ofstream out(path, std::ios::binary);
+    out.write("RIFF", 4);
+    put(out, 36 + static_cast<uint32_t>(data.size()) + (withListChunk ? 12 : 0), 4);
+    out.write("WAVE", 4);
+    if (withListChunk)
+    {
+        out.write("LIST", 4);
+        put(out, 3, 4);
+        out.write("abc", 3);
+        out.put(0); // Pad byte
+    }
+    out.write("fmt ", 4);
+    put(out, 16, 4);
+    put(out, format, 2);
+    put(out, channels, 2);
+    put(out, rate, 4);
+    put(out, rate * channels * bits / 8, 4);
+    put(out, channels * bits / 8, 2);
+    put(out, bits, 2);
+    out.write("data", 4);
+    put(out, static_cast<uint32_t>(data.size()), 4);
+    out.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+TEST(WavFileTest, RoundTripsMonoPcm)
+{
+    std::vector<sample> samples = {0, 1, -1, 32767, -32768, 1234};
+    writeWav("wavFileTest.wav", samples.data(), samples.size());
+    WavAudio audio = readWav("wavFileTest.wav");
+    EXPECT_EQ(audio.sourceRate, RATE);
+    EXPECT_EQ(audio.sourceChannels, 1);
+    EXPECT_EQ(audio.samples, samples);
+    std::remove("wavFileTest.wav");
+}
+
+TEST(WavFileTest, MixesDownStereo24BitAndSkipsOtherChunks)
+{
+    // Frames: (+0.5, -0.5) and (+0.5, +0.5) of full scale in 24 bits
+    std::vector<uint8_t> data = {0x00, 0x00, 0x40, 0x00, 0x00, 0xC0, 0x00, 0x00, 0x40, 0x00, 0x00, 0x40};
+    writeRaw("wavFileTest24.wav", 1, 2, RATE, 24, data, true);
+    WavAudio audio = readWav("wavFileTest24.wav");
+    EXPECT_EQ(audio.sourceChannels, 2);
+    ASSERT_EQ(audio.samples.size(), 2u);
+    EXPECT_EQ(audio.samples[0], 0);
+    EXPECT_EQ(audio.samples[1], 16384);
+    std::remove("wavFileTest24.wav");
+}
+
+TEST(WavFileTest, ResamplesFloatInput)
+{
+    std::vector<float> values(22050, 0.25f);
+    std::vector<uint8_t> data(values.size() * 4);
+    std::memcpy(data.data(), values.data(), data.size());
+    writeRaw("wavFileTestFloat.wav", 3, 1, 22050, 32, data);
+    WavAudio audio = readWav("wavFileTestFloat.wav");
+    EXPECT_EQ(audio.sourceRate, 22050);
+    EXPECT_EQ(audio.samples.size(), static_cast<size_t>(RATE));
+    EXPECT_NEAR(audio.seconds(), 1.0, 1e-9);
+    EXPECT_EQ(audio.samples[RATE / 2], 8192);
+    std::remove("wavFileTestFloat.wav");
+}
+
+TEST(WavFileTest, RejectsUnsupportedFiles)
+{
+    writeRaw("wavFileTestAdpcm.wav", 2, 1, RATE, 4, {0, 0});
+    EXPECT_THROW(readWav("wavFileTestAdpcm.wav"), std::runtime_error);
+    std::remove("wavFileTestAdpcm.wav");
+    EXPECT_THROW(readWav("noSuchFile.wav"), std::runtime_error);
+}
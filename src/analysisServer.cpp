@@ -0,0 +1,416 @@
+#include "analysisServer.h"
+#include "helper.h"
+#include "logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * @brief Constructor for StreamContext.
+ *
+ * @param id Stream index.
+ * @param name Name used in reports, usually the pipe path.
+ * @param ringCapacity Ring size in samples (a power of two).
+ * @param bins Number of spectrum bins.
+ */
+StreamContext::StreamContext(int id, const std::string &name, int ringCapacity, int bins)
+    : id(id), ring(name, ringCapacity), spectrum(bins, 0.0f)
+{
+    tones.reserve(4);
+}
+
+/**
+ * @brief Checks whether a full frame past the read position has arrived.
+ */
+bool StreamContext::ready(int frameSize) const
+{
+    return ring.samplesWritten() >= readPosition.load() + frameSize;
+}
+
+/**
+ * @brief Memory owned by this context, in bytes.
+ */
+size_t StreamContext::memoryBytes() const
+{
+    return sizeof(*this) + ring.capacity() * sizeof(sample) + spectrum.capacity() * sizeof(float) +
+           tones.capacity() * sizeof(int) + ring.getName().capacity();
+}
+
+/**
+ * @brief Constructor for AnalysisServer.
+ *
+ * @param workers Number of worker threads.
+ * @param frameSize Samples per analysis frame (a power of two).
+ * @param hop Samples between successive frames of a stream.
+ * @throws std::invalid_argument if any parameter is out of range.
+ */
+AnalysisServer::AnalysisServer(int workers, int frameSize, int hop) : frameSize(frameSize), hop(hop), workerCount(workers)
+{
+    if (workers <= 0 || hop <= 0 || hop > frameSize || frameSize <= 0 || (frameSize & (frameSize - 1)) != 0)
+    {
+        logMessage("Invalid analysis server configuration.", "ERROR");
+        throw std::invalid_argument("Invalid analysis server configuration.");
+    }
+    FFTPlan::get(frameSize);       // Build the shared plan before any worker needs it
+    initialize_chord_dictionary(); // Workers only read the dictionary
+}
+
+/**
+ * @brief Destructor for AnalysisServer. Stops the workers.
+ */
+AnalysisServer::~AnalysisServer()
+{
+    stop();
+}
+
+/**
+ * @brief Adds a stream context.
+ *
+ * @param name Name of the stream.
+ * @return Index of the new stream.
+ * @throws std::logic_error if the server is running.
+ */
+int AnalysisServer::addStream(const std::string &name)
+{
+    if (running)
+    {
+        logMessage("Streams cannot be added while the analysis server is running.", "ERROR");
+        throw std::logic_error("Streams cannot be added while the analysis server is running.");
+    }
+    // Four frames of ring leave room for the producer while a worker is busy elsewhere
+    int capacity = 1;
+    while (capacity < 4 * frameSize)
+        capacity <<= 1;
+    int id = streamCount();
+    streams.push_back(std::unique_ptr<StreamContext>(new StreamContext(id, name, capacity, frameSize / 2 + 1)));
+    return id;
+}
+
+/**
+ * @brief Appends samples to a stream and queues it once a frame is ready.
+ *
+ * @param id Stream index.
+ * @param data Samples to append.
+ * @param n Number of samples.
+ */
+void AnalysisServer::push(int id, const sample *data, int n)
+{
+    StreamContext &stream = *streams.at(id);
+    stream.ring.write(data, n, 0);
+    if (stream.ready(frameSize) && !stream.queued.exchange(true))
+        enqueue(stream);
+}
+
+/**
+ * @brief Checks whether n more samples fit without overwriting samples a worker still needs.
+ *
+ * File and pipe readers wait on this, so the analysis applies backpressure instead of dropping.
+ */
+bool AnalysisServer::spaceAvailable(int id, int n) const
+{
+    const StreamContext &stream = *streams.at(id);
+    return stream.ring.samplesWritten() + n - stream.readPosition.load() <= static_cast<uint64_t>(stream.ring.capacity());
+}
+
+/**
+ * @brief Puts a stream at the back of the ready queue.
+ */
+void AnalysisServer::enqueue(StreamContext &stream)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        readyQueue.push_back(&stream);
+    }
+    workReady.notify_one();
+}
+
+/**
+ * @brief Starts the worker pool.
+ */
+void AnalysisServer::start()
+{
+    if (running)
+        return;
+    running = true;
+    for (int i = 0; i < workerCount; i++)
+        workers.emplace_back(&AnalysisServer::workerLoop, this);
+    logMessage("Analysis server started with " + std::to_string(workerCount) + " workers for " + std::to_string(streamCount()) + " streams", "INFO");
+}
+
+/**
+ * @brief Stops the workers once they finish their current frame. Queued streams stay queued.
+ */
+void AnalysisServer::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!running)
+            return;
+        running = false;
+    }
+    workReady.notify_all();
+    for (std::thread &worker : workers)
+        worker.join();
+    workers.clear();
+    workDone.notify_all();
+}
+
+/**
+ * @brief Blocks until every pending frame has been analyzed.
+ */
+void AnalysisServer::drain()
+{
+    std::unique_lock<std::mutex> lock(queueMutex);
+    workDone.wait(lock, [this]()
+                  { return !running || (readyQueue.empty() && busyWorkers == 0); });
+}
+
+/**
+ * @brief Worker thread: analyzes one hop of the stream at the front of the queue, then requeues it.
+ *
+ * Each worker owns one Stft, so the per-stream state stays small.
+ */
+void AnalysisServer::workerLoop()
+{
+    Stft stft(frameSize);
+    std::vector<sample> frame(frameSize);
+    std::vector<float> magnitude(stft.bins());
+
+    while (true)
+    {
+        StreamContext *stream;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            workReady.wait(lock, [this]()
+                           { return !running || !readyQueue.empty(); });
+            if (!running)
+                return;
+            stream = readyQueue.front();
+            readyQueue.pop_front();
+            busyWorkers++;
+        }
+
+        analyze(*stream, stft, frame, magnitude);
+
+        bool requeued;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            busyWorkers--;
+            requeued = stream->ready(frameSize);
+            if (requeued)
+                readyQueue.push_back(stream);
+            else
+                stream->queued.store(false);
+        }
+        // A push between the check and clearing the flag would not have queued the stream
+        if (!requeued && stream->ready(frameSize) && !stream->queued.exchange(true))
+            enqueue(*stream);
+        else if (requeued)
+            workReady.notify_one();
+        workDone.notify_all();
+    }
+}
+
+/**
+ * @brief Analyzes the next frame of a stream and advances it by one hop.
+ *
+ * Updates the running spectrum, then estimates the pitch from the strongest peaks the same way
+ * the auto tuner does and the chord the same way the chord guesser does. The chord lookup only
+ * runs when the set of chord tones changes.
+ * @param stream The stream to analyze; owned by this worker until it is requeued.
+ * @param stft The worker's STFT.
+ * @param frame Worker scratch for the frame samples.
+ * @param magnitude Worker scratch for the frame spectrum.
+ */
+void AnalysisServer::analyze(StreamContext &stream, Stft &stft, std::vector<sample> &frame, std::vector<float> &magnitude)
+{
+    uint64_t position = stream.readPosition.load();
+    uint64_t skipped = 0;
+    if (!stream.ring.read(position, frame.data(), frameSize))
+    {
+        // The producer overran the ring; resume from the newest full frame
+        uint64_t newest = stream.ring.samplesWritten() - frameSize;
+        skipped = (newest - position) / hop;
+        position = newest;
+        if (!stream.ring.read(position, frame.data(), frameSize))
+            return;
+    }
+
+    stft.magnitude(frame.data(), magnitude.data());
+    int bins = stft.bins();
+    for (int i = 0; i < bins; i++)
+    {
+        stream.spectrum[i] += SERVER_SMOOTHING * (magnitude[i] - stream.spectrum[i]);
+    }
+
+    // Strongest local maxima between 60 Hz and 5 kHz, at least 60 dB below full scale
+    int peaks[SERVER_PEAKS];
+    float strengths[SERVER_PEAKS];
+    int numPeaks = 0;
+    int lo = std::max(2, static_cast<int>(60 * frameSize / RATE));
+    int hi = std::min(bins - 2, static_cast<int>(5000 * frameSize / RATE));
+    for (int i = lo; i <= hi; i++)
+    {
+        float v = stream.spectrum[i];
+        if (v < 0.001f || v < stream.spectrum[i - 1] || v <= stream.spectrum[i + 1])
+            continue;
+        if (numPeaks == SERVER_PEAKS && v <= strengths[SERVER_PEAKS - 1])
+            continue;
+        int slot = numPeaks < SERVER_PEAKS ? numPeaks++ : SERVER_PEAKS - 1;
+        while (slot > 0 && strengths[slot - 1] < v)
+        {
+            peaks[slot] = peaks[slot - 1];
+            strengths[slot] = strengths[slot - 1];
+            slot--;
+        }
+        peaks[slot] = i;
+        strengths[slot] = v;
+    }
+
+    float frequencies[SERVER_PEAKS];
+    for (int i = 0; i < numPeaks; i++)
+    {
+        frequencies[i] = stft.binFrequency(peaks[i]);
+    }
+
+    float pitch = 0;
+    if (numPeaks >= 2)
+        pitch = approx_hcf(frequencies, std::min(numPeaks, 5), false, 5, 5);
+    else if (numPeaks == 1)
+        pitch = frequencies[0];
+
+    const float quartertone = std::pow(2.0f, 1.0f / 24.0f);
+    std::vector<int> tones;
+    tones.reserve(4);
+    std::vector<float> toneFrequencies;
+    for (int i = 0; i < numPeaks && tones.size() < 4; i++)
+    {
+        bool distinct = true;
+        for (float f : toneFrequencies)
+        {
+            if (std::max(f, frequencies[i]) / std::min(f, frequencies[i]) < quartertone)
+            {
+                distinct = false;
+                break;
+            }
+        }
+        if (distinct)
+        {
+            toneFrequencies.push_back(frequencies[i]);
+            tones.push_back(pitchNumber(frequencies[i], false));
+        }
+    }
+    std::sort(tones.begin(), tones.end());
+    tones.erase(std::unique(tones.begin(), tones.end()), tones.end());
+
+    char chord[CHORD_NAME_SIZE] = {0};
+    bool chordChanged = tones != stream.tones;
+    if (chordChanged && !tones.empty())
+        identify_chord(chord, tones.data(), static_cast<int>(tones.size()));
+    stream.tones = tones;
+
+    stream.readPosition.store(position + hop);
+    uint64_t sequence = ++totalFrames;
+
+    std::lock_guard<std::mutex> lock(stream.reportMutex);
+    stream.pitch = pitch;
+    if (chordChanged)
+        std::memcpy(stream.chord, chord, CHORD_NAME_SIZE);
+    stream.frames++;
+    stream.dropped += skipped;
+    stream.lastSequence = sequence;
+}
+
+/**
+ * @brief Returns the latest detector output and counters for a stream.
+ *
+ * @param id Stream index.
+ * @throws std::out_of_range if id is invalid.
+ */
+StreamReport AnalysisServer::report(int id) const
+{
+    const StreamContext &stream = *streams.at(id);
+    StreamReport result;
+    result.id = id;
+    result.name = stream.ring.getName();
+    result.memoryBytes = stream.memoryBytes();
+
+    std::lock_guard<std::mutex> lock(stream.reportMutex);
+    result.pitch = stream.pitch;
+    std::memcpy(result.chord, stream.chord, CHORD_NAME_SIZE);
+    result.frames = stream.frames;
+    result.dropped = stream.dropped;
+    result.lastSequence = stream.lastSequence;
+    return result;
+}
+
+/**
+ * @brief Runs the analysis server over raw PCM inputs.
+ *
+ * Each input is a named pipe (or file) of 16-bit mono samples at RATE. One reader thread per
+ * input feeds its stream, waiting whenever the stream's ring is full, so a slow server pushes
+ * back on the writers instead of dropping audio. Throughput is printed once a second and the
+ * final detector state of every stream at the end.
+ * @param pipes Paths of the inputs.
+ * @param workers Number of analysis worker threads.
+ */
+void runAnalysisServer(const std::vector<std::string> &pipes, int workers)
+{
+    AnalysisServer server(workers);
+    for (const std::string &path : pipes)
+        server.addStream(path);
+    server.start();
+
+    size_t perStream = server.report(0).memoryBytes;
+    std::cout << "Serving " << pipes.size() << " streams with " << workers << " workers, "
+              << perStream / 1024 << " KiB per stream\n";
+    logMessage("Per-stream memory: " + std::to_string(perStream) + " bytes", "INFO");
+
+    std::atomic<int> open(static_cast<int>(pipes.size()));
+    std::vector<std::thread> readers;
+    for (int id = 0; id < static_cast<int>(pipes.size()); id++)
+    {
+        readers.emplace_back([&server, &pipes, &open, id]()
+                             {
+                                 std::FILE *input = std::fopen(pipes[id].c_str(), "rb");
+                                 if (!input)
+                                 {
+                                     logMessage("Cannot open stream input: " + pipes[id], "WARNING");
+                                     open--;
+                                     return;
+                                 }
+                                 std::vector<sample> block(SERVER_HOP);
+                                 size_t n;
+                                 while ((n = std::fread(block.data(), sizeof(sample), block.size(), input)) > 0)
+                                 {
+                                     while (!server.spaceAvailable(id, static_cast<int>(n)))
+                                         std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                     server.push(id, block.data(), static_cast<int>(n));
+                                 }
+                                 std::fclose(input);
+                                 open--; });
+    }
+
+    uint64_t lastFrames = 0;
+    while (open > 0)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        uint64_t frames = server.framesAnalyzed();
+        std::cout << open << " streams open, " << frames - lastFrames << " frames/s ("
+                  << (frames - lastFrames) * SERVER_HOP / RATE << "x real time)\n";
+        lastFrames = frames;
+    }
+    for (std::thread &reader : readers)
+        reader.join();
+    server.drain();
+    server.stop();
+
+    for (int id = 0; id < server.streamCount(); id++)
+    {
+        StreamReport r = server.report(id);
+        std::cout << "[" << id << "] " << r.name << ": " << r.frames << " frames, pitch " << r.pitch << " Hz, chord "
+                  << (r.chord[0] ? r.chord : "-") << ", " << r.dropped << " dropped\n";
+    }
+    logMessage("Analysis server processed " + std::to_string(server.framesAnalyzed()) + " frames", "INFO");
+}
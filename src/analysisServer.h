@@ -0,0 +1,114 @@
+#ifndef ANALYSIS_SERVER_H
+#define ANALYSIS_SERVER_H
+
+#include "captureSource.h"
+#include "chordDictionary.h"
+#include "fftPlan.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define SERVER_FRAME 8192        /// Samples per analysis frame in server mode
+#define SERVER_HOP 2048          /// Samples between successive frames of a stream
+#define SERVER_PEAKS 10          /// Spectral peaks considered by the pitch and chord detectors
+#define SERVER_SMOOTHING 0.5f    /// Weight of the newest frame in each stream's running spectrum
+
+/// Latest detector output for one stream
+struct StreamReport
+{
+    int id;
+    std::string name;
+    float pitch;                 /// Estimated fundamental in Hz, 0 if none
+    char chord[CHORD_NAME_SIZE]; /// Detected chord name, empty if none
+    uint64_t frames;             /// Frames analyzed
+    uint64_t dropped;            /// Hops skipped because the stream fell a full ring behind
+    uint64_t lastSequence;       /// Server-wide number of this stream's latest frame, 0 if none
+    size_t memoryBytes;          /// Memory owned by this stream context
+};
+
+/**
+ * ---------------------------
+ * ----class StreamContext-----
+ * ---------------------------
+ * Everything the server keeps per input stream: its ring, its STFT state (read position and
+ * running spectrum) and its detector state. Only one worker touches a context at a time.
+ */
+class StreamContext
+{
+public:
+    StreamContext(int id, const std::string &name, int ringCapacity, int bins);
+
+    int id;
+    CaptureSource ring;                     /// Samples pushed by the producer
+    std::atomic<uint64_t> readPosition{0}; /// Stream position of the next frame
+    std::vector<float> spectrum;           /// Running magnitude spectrum
+    std::vector<int> tones;                /// Chord tones of the last frame (pitch numbers 1-12)
+    std::atomic<bool> queued{false};       /// Whether the context is waiting in the ready queue
+
+    mutable std::mutex reportMutex; /// Guards the fields below against concurrent report()
+    float pitch = 0;
+    char chord[CHORD_NAME_SIZE] = {0};
+    uint64_t frames = 0;
+    uint64_t dropped = 0;
+    uint64_t lastSequence = 0;
+
+    bool ready(int frameSize) const; /// A full frame past readPosition has arrived
+    size_t memoryBytes() const;
+};
+
+/**
+ * ---------------------------
+ * ----class AnalysisServer----
+ * ---------------------------
+ * Runs the pitch and chord detectors over many independent streams with a fixed worker pool.
+ * Producers push samples into a stream's lock-free ring; a stream joins the ready queue once a
+ * whole frame is available. Workers take the stream at the front, analyze one hop, and put it at
+ * the back if it is still ready, so streams share the workers round-robin by data readiness and
+ * no busy stream can starve a quiet one. FFT plans are shared by all workers.
+ */
+class AnalysisServer
+{
+private:
+    int frameSize, hop, workerCount;
+    std::vector<std::unique_ptr<StreamContext>> streams;
+    std::vector<std::thread> workers;
+    std::deque<StreamContext *> readyQueue;
+    std::mutex queueMutex;
+    std::condition_variable workReady; /// Signalled when a stream joins the queue
+    std::condition_variable workDone;  /// Signalled when a worker finishes a frame
+    int busyWorkers = 0;
+    bool running = false;
+    std::atomic<uint64_t> totalFrames{0};
+
+    void enqueue(StreamContext &stream);
+    void workerLoop();
+    void analyze(StreamContext &stream, Stft &stft, std::vector<sample> &frame, std::vector<float> &magnitude);
+
+public:
+    AnalysisServer(int workers, int frameSize = SERVER_FRAME, int hop = SERVER_HOP); /// Constructor
+    ~AnalysisServer();                                                               /// Destructor, stops the workers
+    AnalysisServer(const AnalysisServer &) = delete;
+    AnalysisServer &operator=(const AnalysisServer &) = delete;
+
+    int addStream(const std::string &name);          /// Adds a stream; only before start()
+    void push(int id, const sample *data, int n);    /// Producer side; one producer per stream
+    bool spaceAvailable(int id, int n) const;        /// Whether n samples fit without overwriting unread ones
+    void start();                                    /// Starts the worker pool
+    void stop();                                     /// Stops the workers after their current frame
+    void drain();                                    /// Blocks until no stream has a full frame pending
+
+    int streamCount() const { return static_cast<int>(streams.size()); }
+    int getWorkerCount() const { return workerCount; }
+    uint64_t framesAnalyzed() const { return totalFrames.load(); }
+    StreamReport report(int id) const;
+};
+
+/// Runs the server over raw 16-bit mono PCM pipes or files until all reach end of input
+void runAnalysisServer(const std::vector<std::string> &pipes, int workers);
+
+#endif // ANALYSIS_SERVER_H
@@ -0,0 +1,259 @@
+#include "audioDevice.h"
+#include "captureEngine.h"
+#include "logger.h"
+#include "rtSafety.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+
+float echoVolume;                    // Echo playback volume
+AudioQueue MainAudioQueue(10000000); // Main AudioQueue for recording and playback
+bool monitoringMode = false;         // Set by InitializeAudio()
+JitterBuffer MonitorBuffer;          // Playback source in monitoring mode
+int deviceChunk = CHUNK;             // Current device buffer size
+AudioThreadPolicy RecThreadPolicy, PlayThreadPolicy; // Filled in by the audio threads themselves
+SampleNotifier AnalysisNotifier;     // Wakes the analysis loop every hop of captured audio
+CaptureHistory *History = nullptr;   // Set before the devices start when history is enabled
+MappedHistory *FileHistory = nullptr; // Set before the devices start when a history file is used
+std::atomic<OctaveFilterbank *> OctaveBank(nullptr); // Switched on and off while the devices run
+std::atomic<CaptureSource *> DefaultCapture(nullptr); // Likewise, while the capture engine runs
+
+static CallbackMonitor RecMonitor, PlayMonitor; // Callback timing for the buffer size controller
+static int lastMonitorUnderruns = 0;            // MonitorBuffer underruns already reported as xruns
+
+#ifdef AUDIO_TEST_HOOKS
+static std::atomic<int> callbackDelayMs(0); // Artificial callback delay for tests
+
+/**
+ * @brief Sleeps for the injected callback delay, if any. Only test builds have this hook.
+ */
+static void injectCallbackDelay()
+{
+    int delay = callbackDelayMs.load(std::memory_order_relaxed);
+    if (delay > 0)
+        SDL_Delay(delay);
+}
+#else
+static inline void injectCallbackDelay() {}
+#endif
+
+/**
+ * @brief Callback for recording audio data.
+ *
+ * Pushes audio samples from the recording stream into the MainAudioQueue.
+ * Runs on the SDL audio thread, so it must not allocate, lock, log or throw:
+ * if the queue is full the block is dropped. In monitoring mode nothing pops the queue,
+ * so the oldest samples are discarded instead and the block also feeds MonitorBuffer.
+ * Every completed analysis hop wakes the analysis loop through AnalysisNotifier. When History is
+ * set, every block is also appended to its raw ring; the analysis thread compresses it later.
+ * FileHistory likewise only receives a copy into pages the analysis thread has made resident.
+ * DefaultCapture, when set, is the capture engine's source for this device, which SDL opens only once.
+ * @param userdata Unused user data pointer.
+ * @param stream Pointer to the audio stream buffer.
+ * @param streamLength Length of the audio stream buffer in bytes.
+ */
+void RecCallback(void *userdata, Uint8 *stream, int streamLength)
+{
+    (void)userdata;
+    RealtimeScope realtime;
+    Uint64 start = SDL_GetPerformanceCounter();
+    applyAudioThreadPolicy(RecThreadPolicy);
+    injectCallbackDelay();
+
+    int n_samples = (Uint32)streamLength / sizeof(sample);
+    if (History)
+        History->write((sample *)stream, n_samples, captureClock());
+    if (FileHistory)
+        FileHistory->write((sample *)stream, n_samples, captureClock());
+    if (OctaveFilterbank *bank = OctaveBank.load(std::memory_order_acquire))
+        bank->process((sample *)stream, n_samples);
+    if (CaptureSource *source = DefaultCapture.load(std::memory_order_acquire))
+        source->write((sample *)stream, n_samples, captureClock());
+    if (monitoringMode)
+    {
+        MonitorBuffer.write((sample *)stream, n_samples);
+        if (!MainAudioQueue.space_available(n_samples))
+            MainAudioQueue.discard(n_samples);
+    }
+    if (MainAudioQueue.space_available(n_samples))
+    {
+        MainAudioQueue.push((sample *)stream, n_samples);
+        AnalysisNotifier.notify(n_samples);
+    }
+    else
+        RecMonitor.xrun();
+
+    RecMonitor.record(start, SDL_GetPerformanceCounter());
+}
+
+/**
+ * @brief Callback for playing back audio data.
+ *
+ * Pops audio samples from the MainAudioQueue and writes them to the playback stream.
+ * Runs on the SDL audio thread; on underflow it plays silence instead of throwing.
+ * In monitoring mode the samples come from MonitorBuffer instead.
+ * @param userdata Unused user data pointer.
+ * @param stream Pointer to the audio stream buffer.
+ * @param streamLength Length of the audio stream buffer in bytes.
+ */
+void PlayCallback(void *userdata, Uint8 *stream, int streamLength)
+{
+    (void)userdata;
+    RealtimeScope realtime;
+    Uint64 start = SDL_GetPerformanceCounter();
+    applyAudioThreadPolicy(PlayThreadPolicy);
+    injectCallbackDelay();
+
+    int n_samples = (Uint32)streamLength / sizeof(sample);
+    if (monitoringMode)
+        MonitorBuffer.read((sample *)stream, n_samples, ::echoVolume);
+    else if (MainAudioQueue.data_available(n_samples))
+        MainAudioQueue.pop((sample *)stream, n_samples, ::echoVolume);
+    else
+    {
+        std::memset(stream, 0, streamLength);
+        PlayMonitor.xrun();
+    }
+
+    PlayMonitor.record(start, SDL_GetPerformanceCounter());
+}
+
+/**
+ * @brief Opens the recording and playback devices paused, with the given buffer size.
+ *
+ * @param RecDevice Reference to the recording audio device ID.
+ * @param PlayDevice Reference to the playback audio device ID.
+ * @param chunk Device buffer size in samples (a power of two).
+ * @throws std::runtime_error if either device fails to open.
+ */
+void OpenAudioDevices(SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice, int chunk)
+{
+    SDL_AudioSpec RecSpec{}, PlaySpec{};
+    RecSpec.freq = RATE;
+    RecSpec.format = AUDIO_S16SYS;
+    RecSpec.samples = chunk;
+    RecSpec.callback = RecCallback; // Callback for recording
+    RecSpec.channels = 1;
+
+    PlaySpec = RecSpec;
+    PlaySpec.callback = PlayCallback;
+
+    RecDevice = SDL_OpenAudioDevice(NULL, 1, &RecSpec, NULL, 0);
+    PlayDevice = SDL_OpenAudioDevice(NULL, 0, &PlaySpec, NULL, 0);
+
+    if (PlayDevice <= 0)
+    {
+        logMessage("Failed to open playback device: " + std::string(SDL_GetError()), "ERROR");
+        throw std::runtime_error("Failed to open playback device: " + std::string(SDL_GetError()));
+    }
+    if (RecDevice <= 0)
+    {
+        logMessage("Failed to open recording device: " + std::string(SDL_GetError()), "ERROR");
+        throw std::runtime_error("Failed to open recording device: " + std::string(SDL_GetError()));
+    }
+
+    deviceChunk = chunk;
+    RecMonitor.reset();
+    PlayMonitor.reset();
+}
+
+/**
+ * @brief Closes both devices and reopens them with a new buffer size, then restarts them.
+ *
+ * The queued audio is kept, so playback resumes without another prefill.
+ * @param RecDevice Reference to the recording audio device ID.
+ * @param PlayDevice Reference to the playback audio device ID.
+ * @param chunk New device buffer size in samples.
+ */
+void ReopenAudio(SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice, int chunk)
+{
+    SDL_CloseAudioDevice(RecDevice);
+    SDL_CloseAudioDevice(PlayDevice);
+    OpenAudioDevices(RecDevice, PlayDevice, chunk);
+    SDL_PauseAudioDevice(RecDevice, 0);
+    SDL_PauseAudioDevice(PlayDevice, 0);
+}
+
+/**
+ * @brief Feeds one window of callback statistics to the controller and applies its decision.
+ *
+ * @param controller The buffer size controller.
+ * @param RecDevice Reference to the recording audio device ID.
+ * @param PlayDevice Reference to the playback audio device ID.
+ * @return true if the devices were reopened with a new buffer size.
+ */
+bool AdaptBufferSize(BufferSizeController &controller, SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice)
+{
+    double ticksPerMs = SDL_GetPerformanceFrequency() / 1000.0;
+    CallbackStats rec = RecMonitor.collect(ticksPerMs), play = PlayMonitor.collect(ticksPerMs);
+
+    CallbackStats stats;
+    stats.callbacks = rec.callbacks + play.callbacks;
+    stats.xruns = rec.xruns + play.xruns;
+    stats.maxIntervalMs = std::max(rec.maxIntervalMs, play.maxIntervalMs);
+    stats.maxDurationMs = std::max(rec.maxDurationMs, play.maxDurationMs);
+
+    int monitorUnderruns = MonitorBuffer.stats().underruns;
+    stats.xruns += monitorUnderruns - lastMonitorUnderruns;
+    lastMonitorUnderruns = monitorUnderruns;
+
+    std::string reason;
+    int chunk = controller.evaluate(stats, &reason);
+    if (chunk == deviceChunk)
+        return false;
+
+    logMessage("Device buffer size changed from " + std::to_string(deviceChunk) + " to " + std::to_string(chunk) + " samples (" + reason + ")", "INFO");
+    ReopenAudio(RecDevice, PlayDevice, chunk);
+    return true;
+}
+
+#ifdef AUDIO_TEST_HOOKS
+/**
+ * @brief Delays every callback by the given time, to simulate a loaded machine in tests.
+ *
+ * @param milliseconds Delay per callback; 0 disables it.
+ */
+void SetCallbackDelay(int milliseconds)
+{
+    callbackDelayMs.store(milliseconds);
+}
+#endif
+
+/**
+ * @brief Initializes SDL audio devices for recording and playback.
+ *
+ * Sets up the SDL audio system, configures recording and playback devices, and starts audio processing.
+ * Normally playback starts after a 2 second prefill, so the echo lags by that much. In monitoring
+ * mode playback starts immediately and follows capture through MonitorBuffer; only the analysis
+ * waits for a full FFT frame.
+ * @param RecDevice Reference to the recording audio device ID.
+ * @param PlayDevice Reference to the playback audio device ID.
+ * @param monitoring Whether to use the low-latency monitoring path.
+ * @throws std::runtime_error if initialization fails for either recording or playback device.
+ */
+void InitializeAudio(SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice, bool monitoring)
+{
+    SDL_Init(SDL_INIT_AUDIO); // Initialize SDL audio
+    logMessage("Initializing SDL audio", "INFO");
+
+    OpenAudioDevices(RecDevice, PlayDevice, CHUNK);
+
+    monitoringMode = monitoring;
+    if (monitoring)
+    {
+        SDL_PauseAudioDevice(RecDevice, 0);  // Start recording
+        SDL_PauseAudioDevice(PlayDevice, 0); // Start playback right away
+        for (int i = 0; i < 300 && !MainAudioQueue.data_available(FFTLEN); i++)
+            SDL_Delay(10); // Wait for one analysis frame
+        logMessage("Low-latency monitoring enabled", "INFO");
+    }
+    else
+    {
+        SDL_PauseAudioDevice(RecDevice, 0);  // Start recording
+        SDL_Delay(2000);                     // Fill audio buffer
+        SDL_PauseAudioDevice(PlayDevice, 0); // Start playback
+    }
+
+    logMessage("Audio devices initialized successfully", "INFO");
+}
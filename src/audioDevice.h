@@ -0,0 +1,50 @@
+#ifndef AUDIO_DEVICE_H
+#define AUDIO_DEVICE_H
+
+#include "audioProcessor.h"
+#include "jitterBuffer.h"
+#include "bufferController.h"
+#include "scheduling.h"
+#include "sampleNotifier.h"
+#include "captureHistory.h"
+#include "captureSource.h"
+#include "mappedHistory.h"
+#include "octaveFilterbank.h"
+#include <SDL2/SDL.h>
+
+extern float echoVolume;            /// Echo playback volume
+extern AudioQueue MainAudioQueue;   /// Main AudioQueue for recording and playback
+extern bool monitoringMode;         /// Low-latency monitoring: playback follows capture via MonitorBuffer
+extern JitterBuffer MonitorBuffer;  /// Adaptive jitter buffer used in monitoring mode
+extern int deviceChunk;             /// Current device buffer size in samples
+extern SampleNotifier AnalysisNotifier; /// Signalled by RecCallback every analysis hop
+extern CaptureHistory *History;         /// Long lookback history fed by RecCallback; nullptr when disabled
+extern MappedHistory *FileHistory;      /// File-backed lookback history fed by RecCallback; nullptr when disabled
+extern std::atomic<OctaveFilterbank *> OctaveBank; /// Time-domain band levels fed by RecCallback; nullptr when not displayed
+extern std::atomic<CaptureSource *> DefaultCapture; /// Capture engine source shared with RecDevice; nullptr without extra devices
+extern AudioThreadPolicy RecThreadPolicy, PlayThreadPolicy; /// Scheduling outcome reported by each audio thread
+
+/// SDL callback for the recording device. Real-time safe.
+void RecCallback(void *userdata, Uint8 *stream, int streamLength);
+
+/// SDL callback for the playback device. Real-time safe.
+void PlayCallback(void *userdata, Uint8 *stream, int streamLength);
+
+/// Opens and starts the recording and playback devices.
+void InitializeAudio(SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice, bool monitoring = false);
+
+/// Opens both devices paused with the given buffer size.
+void OpenAudioDevices(SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice, int chunk);
+
+/// Reopens and restarts both devices with a new buffer size.
+void ReopenAudio(SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice, int chunk);
+
+/// Runs one buffer size controller step; returns true if the devices were reopened.
+bool AdaptBufferSize(BufferSizeController &controller, SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice);
+
+#ifdef AUDIO_TEST_HOOKS
+/// Test hook: delays every callback by the given milliseconds. Only in builds with AUDIO_TEST_HOOKS.
+void SetCallbackDelay(int milliseconds);
+#endif
+
+#endif // AUDIO_DEVICE_H
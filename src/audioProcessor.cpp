@@ -1,5 +1,6 @@
 #include "audioProcessor.h"
 #include "logger.h"
+#include "fftPlan.h"
 #include <iostream>
 #include <stdexcept>
 #include <vector>
@@ -154,9 +155,21 @@ void AudioQueue::peekFreshData(sample *output, int n_samples, float volume) cons
     }
 }
 
+/**
+ * @brief Drops the oldest audio samples from the queue without copying them.
+ *
+ * @param n_samples Number of samples to drop.
+ */
+void AudioQueue::discard(int n_samples)
+{
+    validate_data(n_samples);
+    outpos = (outpos + n_samples) % len;
+}
+
 /**
  * @brief Computes the Fast Fourier Transform (FFT) for a given input.
  *
+ * Output may alias input for an in-place transform.
  * @param output Array to store the FFT result.
  * @param input Array of complex input samples.
  * @param n Number of samples, must be a power of two.
@@ -177,29 +190,8 @@ void fft(cmplx *output, const cmplx *input, int n)
         throw std::invalid_argument("Input size for FFT must be a power of two and greater than zero.");
     }
 
-    if (n == 1)
-    {
-        output[0] = input[0];
-        return;
-    }
-
-    std::vector<cmplx> even(n / 2), odd(n / 2);
-    for (int i = 0; i < n / 2; i++)
-    {
-        even[i] = input[2 * i];
-        odd[i] = input[2 * i + 1];
-    }
-
-    std::vector<cmplx> evenOut(n / 2), oddOut(n / 2);
-    fft(evenOut.data(), even.data(), n / 2);
-    fft(oddOut.data(), odd.data(), n / 2);
-
-    for (int i = 0; i < n / 2; i++)
-    {
-        cmplx t = std::polar(1.0, -2 * M_PI * i / n) * oddOut[i];
-        output[i] = evenOut[i] + t;
-        output[i + n / 2] = evenOut[i] - t;
-    }
+    // Shared plan: twiddles and bit-reversal table are computed once per size, no allocation after that
+    FFTPlan::get(n).forward(output, input);
 }
 
 /**
@@ -219,20 +211,29 @@ void FindFrequencyContent(sample *output, const sample *input, int n, bool logOn
         logMessage("Input size for FFT must be a power of two and greater than zero.", "ERROR");
         throw std::invalid_argument("Input size for FFT must be a power of two and greater than zero.");
     }
-    logMessage("Starting Frequency Content computation for " + std::to_string(n) + " samples.", "INFO", logOnce);
+    if (logOnce)
+        logMessage("Starting Frequency Content computation for " + std::to_string(n) + " samples.", "INFO");
+
+    // Scratch buffers grow once and are reused so repeated calls do not allocate
+    static thread_local std::vector<cmplx> fftin, fftout;
+    if (static_cast<int>(fftin.size()) < n)
+    {
+        fftin.resize(n);
+        fftout.resize(n);
+    }
 
-    std::vector<cmplx> fftin(n), fftout(n);
     for (int i = 0; i < n; i++)
     {
         fftin[i] = static_cast<cmplx>(input[i]);
     }
 
-    fft(fftout.data(), fftin.data(), n); // Call FFT recursively
+    fft(fftout.data(), fftin.data(), n);
 
     for (int i = 0; i < n; i++)
     {
         double magnitude = abs(fftout[i]) * vScale;
         output[i] = static_cast<sample>(std::min(magnitude, static_cast<double>(MAX_SAMPLE_VALUE)));
     }
-    logMessage("Frequency Content computation completed for " + std::to_string(n) + " samples.", "INFO", logOnce);
+    if (logOnce)
+        logMessage("Frequency Content computation completed for " + std::to_string(n) + " samples.", "INFO");
 }
@@ -45,6 +45,7 @@ public:
   void pop(sample *output, int n_samples, float volume = 1);                 /// Pop n_samples from the queue.
   void peek(sample *output, int n_samples, float volume = 1) const;          /// Peek at n_samples to be popped.
   void peekFreshData(sample *output, int n_samples, float volume = 1) const; /// Peek freshest n_samples.
+  void discard(int n_samples);                                               /// Drop the oldest n_samples.
 };
 
 /**
@@ -0,0 +1,86 @@
+#ifndef BIT_STREAM_H
+#define BIT_STREAM_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/// MSB-first bit packer appending to a byte vector
+struct BitWriter
+{
+    std::vector<uint8_t> &out;
+    uint64_t acc = 0;
+    int bits = 0;
+
+    explicit BitWriter(std::vector<uint8_t> &out) : out(out) {}
+
+    void put(uint32_t value, int count) // count <= 32
+    {
+        acc = (acc << count) | value;
+        bits += count;
+        while (bits >= 8)
+        {
+            bits -= 8;
+            out.push_back(static_cast<uint8_t>(acc >> bits));
+        }
+    }
+
+    void flush()
+    {
+        if (bits > 0)
+            out.push_back(static_cast<uint8_t>(acc << (8 - bits)));
+        bits = 0;
+    }
+};
+
+/// MSB-first bit reader over a byte array; reads past the end return zeros
+struct BitReader
+{
+    const uint8_t *data;
+    size_t size, pos = 0;
+    uint64_t acc = 0; /// Unread bits, left aligned
+    int bits = 0;
+
+    BitReader(const uint8_t *data, size_t size) : data(data), size(size) {}
+
+    void refill()
+    {
+        while (bits <= 56)
+        {
+            uint64_t byte = pos < size ? data[pos] : 0;
+            acc |= byte << (56 - bits);
+            pos++;
+            bits += 8;
+        }
+    }
+
+    uint32_t get(int count) // count <= 32
+    {
+        if (count == 0)
+            return 0;
+        refill();
+        uint32_t value = static_cast<uint32_t>(acc >> (64 - count));
+        acc <<= count;
+        bits -= count;
+        return value;
+    }
+
+    int zeros(int limit) // Counts and consumes zeros up to and including the next one bit; stops after limit zeros
+    {
+        refill();
+        int n = acc ? __builtin_clzll(acc) : 64;
+        n = std::min(n, limit);
+        int consumed = n < limit ? n + 1 : n;
+        acc <<= consumed;
+        bits -= consumed;
+        return n;
+    }
+};
+
+/// Maps signed residuals onto unsigned values: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+inline uint32_t zigzag(int32_t r) { return (static_cast<uint32_t>(r) << 1) ^ static_cast<uint32_t>(r >> 31); }
+inline int32_t unzigzag(uint32_t u) { return static_cast<int32_t>(u >> 1) ^ -static_cast<int32_t>(u & 1); }
+inline uint64_t zigzag(int64_t r) { return (static_cast<uint64_t>(r) << 1) ^ static_cast<uint64_t>(r >> 63); }
+inline int64_t unzigzag(uint64_t u) { return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1); }
+
+#endif // BIT_STREAM_H
@@ -0,0 +1,135 @@
+#include "bufferController.h"
+#include "logger.h"
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+/**
+ * @brief Converts a buffer size to its period in milliseconds.
+ *
+ * @param chunk Buffer size in samples.
+ * @return The time one buffer lasts at RATE.
+ */
+double chunkPeriodMs(int chunk)
+{
+    return 1000.0 * chunk / RATE;
+}
+
+/**
+ * @brief Atomically raises target to value if value is larger.
+ */
+static void atomicMax(std::atomic<unsigned long long> &target, unsigned long long value)
+{
+    unsigned long long current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed))
+        ;
+}
+
+/**
+ * @brief Records the timing of one callback. Real-time safe.
+ *
+ * @param start Clock ticks at callback entry.
+ * @param end Clock ticks at callback exit.
+ */
+void CallbackMonitor::record(unsigned long long start, unsigned long long end)
+{
+    unsigned long long previous = lastStart.exchange(start, std::memory_order_relaxed);
+    if (previous != 0 && start > previous)
+        atomicMax(maxInterval, start - previous);
+    atomicMax(maxDuration, end - start);
+    callbacks.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Counts an overflow or underflow. Real-time safe.
+ */
+void CallbackMonitor::xrun()
+{
+    xrunCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the statistics of the current window and starts a new one.
+ *
+ * @param ticksPerMs Clock ticks per millisecond.
+ * @return CallbackStats The window's statistics.
+ */
+CallbackStats CallbackMonitor::collect(double ticksPerMs)
+{
+    CallbackStats stats;
+    stats.callbacks = callbacks.exchange(0);
+    stats.xruns = xrunCount.exchange(0);
+    stats.maxIntervalMs = maxInterval.exchange(0) / ticksPerMs;
+    stats.maxDurationMs = maxDuration.exchange(0) / ticksPerMs;
+    return stats;
+}
+
+/**
+ * @brief Clears the window, including the last start time, e.g. after reopening a device.
+ */
+void CallbackMonitor::reset()
+{
+    lastStart.store(0);
+    collect(1.0);
+}
+
+/**
+ * @brief Constructs a BufferSizeController.
+ *
+ * @param latencyCeilingMs Maximum round-trip buffering (capture plus playback buffer) in milliseconds.
+ * @param minChunk Smallest buffer size; must be a power of two.
+ * @param windowsToShrink Quiet windows required before halving the buffer.
+ * @throws std::invalid_argument if minChunk is not a power of two or already exceeds the ceiling.
+ */
+BufferSizeController::BufferSizeController(int latencyCeilingMs, int minChunk, int windowsToShrink)
+    : minChunk(minChunk), maxChunk(minChunk), chunk(minChunk), windowsToShrink(windowsToShrink), quietWindows(0)
+{
+    if (minChunk <= 0 || (minChunk & (minChunk - 1)) != 0 || 2 * chunkPeriodMs(minChunk) > latencyCeilingMs)
+    {
+        logMessage("Invalid buffer size controller limits.", "ERROR");
+        throw std::invalid_argument("Minimum buffer size must be a power of two within the latency ceiling.");
+    }
+    while (2 * chunkPeriodMs(maxChunk * 2) <= latencyCeilingMs)
+        maxChunk *= 2;
+    logMessage("Buffer size controller range: " + std::to_string(minChunk) + "-" + std::to_string(maxChunk) + " samples", "INFO");
+}
+
+/**
+ * @brief Decides the buffer size for the next window.
+ *
+ * @param stats Callback statistics of the window that just ended.
+ * @param reason Optional output describing why the size changed.
+ * @return The buffer size to use; equal to currentChunk() if unchanged.
+ */
+int BufferSizeController::evaluate(const CallbackStats &stats, std::string *reason)
+{
+    double period = chunkPeriodMs(chunk);
+    bool late = stats.maxIntervalMs > 2 * period;
+    bool busy = stats.maxDurationMs > 0.75 * period;
+    std::ostringstream why;
+
+    if ((stats.xruns > 0 || late || busy) && chunk < maxChunk)
+    {
+        why << stats.xruns << " xruns, max gap " << stats.maxIntervalMs << " ms, max callback " << stats.maxDurationMs
+            << " ms at period " << period << " ms";
+        chunk *= 2;
+        quietWindows = 0;
+    }
+    else if (stats.xruns == 0 && stats.maxDurationMs < 0.4 * chunkPeriodMs(chunk / 2) && chunk > minChunk)
+    {
+        if (++quietWindows >= windowsToShrink)
+        {
+            why << quietWindows << " quiet windows, max callback " << stats.maxDurationMs << " ms";
+            chunk /= 2;
+            quietWindows = 0;
+        }
+    }
+    else
+    {
+        quietWindows = 0;
+    }
+
+    if (reason)
+        *reason = why.str();
+    return chunk;
+}
@@ -0,0 +1,66 @@
+#ifndef BUFFER_CONTROLLER_H
+#define BUFFER_CONTROLLER_H
+
+#include "audioProcessor.h"
+#include <atomic>
+#include <string>
+
+/// Callback health over one evaluation window
+struct CallbackStats
+{
+    int callbacks;        /// Callbacks seen in the window
+    int xruns;            /// Overflows and underflows in the window
+    double maxIntervalMs; /// Longest gap between the starts of consecutive callbacks
+    double maxDurationMs; /// Longest time spent inside a callback
+};
+
+/**
+ * ---------------------------
+ * ----class CallbackMonitor---
+ * ---------------------------
+ * Records callback timing and xruns from an audio callback without locking or allocating.
+ * The control thread drains it once per window with collect().
+ */
+class CallbackMonitor
+{
+private:
+    std::atomic<unsigned long long> lastStart{0}, maxInterval{0}, maxDuration{0}; /// In clock ticks
+    std::atomic<int> callbacks{0}, xrunCount{0};
+
+public:
+    void record(unsigned long long start, unsigned long long end); /// Called at the end of each callback
+    void xrun();                                                   /// Called when a callback over/underflows
+    CallbackStats collect(double ticksPerMs);                      /// Returns and clears the window
+    void reset();                                                  /// Forgets the window and the last start time
+};
+
+/**
+ * --------------------------------
+ * ----class BufferSizeController---
+ * --------------------------------
+ * Chooses the device buffer size (a power of two, in samples) from callback health.
+ * Grows on xruns, late callbacks, or callbacks that use most of their period. Shrinks
+ * after a number of quiet windows if the work would still fit at half the size.
+ * Never exceeds the configured round-trip latency ceiling.
+ */
+class BufferSizeController
+{
+private:
+    int minChunk;        /// Smallest buffer size
+    int maxChunk;        /// Largest buffer size under the latency ceiling
+    int chunk;           /// Current buffer size
+    int windowsToShrink; /// Quiet windows required before shrinking
+    int quietWindows;    /// Consecutive quiet windows seen
+
+public:
+    BufferSizeController(int latencyCeilingMs, int minChunk = CHUNK, int windowsToShrink = 10); /// Constructor
+
+    int evaluate(const CallbackStats &stats, std::string *reason = nullptr); /// Returns the buffer size to use next
+    int currentChunk() const { return chunk; }
+    int maxChunkSize() const { return maxChunk; }
+};
+
+/// Period of one device buffer in milliseconds
+double chunkPeriodMs(int chunk);
+
+#endif // BUFFER_CONTROLLER_H
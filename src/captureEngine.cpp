@@ -0,0 +1,246 @@
+#include "captureEngine.h"
+#include "logger.h"
+#include "rtSafety.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Current time on the common capture timeline.
+ *
+ * All sources share the performance counter, so their block timestamps are directly comparable.
+ * @return Seconds since an arbitrary fixed point.
+ */
+double captureClock()
+{
+    return static_cast<double>(SDL_GetPerformanceCounter()) / SDL_GetPerformanceFrequency();
+}
+
+/**
+ * @brief SDL callback shared by every engine device; userdata is the device's CaptureSource.
+ */
+static void EngineCallback(void *userdata, Uint8 *stream, int streamLength)
+{
+    RealtimeScope realtime;
+    double deliveredAt = captureClock();
+    static_cast<CaptureSource *>(userdata)->write(reinterpret_cast<sample *>(stream), streamLength / sizeof(sample), deliveredAt);
+}
+
+/**
+ * @brief Constructor for CaptureEngine.
+ *
+ * @param capacity Ring size in samples for each source.
+ */
+CaptureEngine::CaptureEngine(int capacity) : ringCapacity(capacity)
+{
+    frame.time = 0;
+    frame.length = 0;
+}
+
+/**
+ * @brief Destructor for CaptureEngine. Closes every device before the sources go away.
+ */
+CaptureEngine::~CaptureEngine()
+{
+    for (SDL_AudioDeviceID device : devices)
+        SDL_CloseAudioDevice(device);
+}
+
+/**
+ * @brief Adds a source that the caller feeds through CaptureSource::write().
+ *
+ * @param name Name of the source.
+ * @return Index of the new source.
+ * @throws std::logic_error if the engine is already running.
+ */
+int CaptureEngine::addSource(const std::string &name)
+{
+    if (running)
+    {
+        logMessage("Capture sources cannot be added while the engine is running.", "ERROR");
+        throw std::logic_error("Capture sources cannot be added while the engine is running.");
+    }
+    sources.push_back(std::unique_ptr<CaptureSource>(new CaptureSource(name, ringCapacity)));
+    return sourceCount() - 1;
+}
+
+/**
+ * @brief Opens a capture device, paused, as a new source.
+ *
+ * @param deviceName SDL device name, or nullptr for the default capture device.
+ * @param chunk Device buffer size in samples.
+ * @return Index of the new source.
+ * @throws std::runtime_error if the device fails to open.
+ */
+int CaptureEngine::openDevice(const char *deviceName, int chunk)
+{
+    int index = addSource(deviceName ? deviceName : "default");
+
+    SDL_AudioSpec spec{};
+    spec.freq = RATE;
+    spec.format = AUDIO_S16SYS;
+    spec.samples = chunk;
+    spec.channels = 1;
+    spec.callback = EngineCallback;
+    spec.userdata = sources[index].get();
+
+    SDL_AudioDeviceID device = SDL_OpenAudioDevice(deviceName, 1, &spec, NULL, 0);
+    if (device <= 0)
+    {
+        sources.pop_back();
+        logMessage("Failed to open capture device: " + std::string(SDL_GetError()), "ERROR");
+        throw std::runtime_error("Failed to open capture device: " + std::string(SDL_GetError()));
+    }
+    devices.push_back(device);
+    logMessage("Capture source " + std::to_string(index) + " opened: " + sources[index]->getName(), "INFO");
+    return index;
+}
+
+/**
+ * @brief Opens every available capture device, up to a limit.
+ *
+ * A device that fails to open is logged and skipped, so one busy microphone does not keep the
+ * others from being captured.
+ * @param maxDevices Maximum number of devices to open.
+ * @param skipDefault Leaves out the default capture device, e.g. because it is already held open.
+ * @return Number of devices actually opened.
+ */
+int CaptureEngine::openAllDevices(int maxDevices, bool skipDefault)
+{
+    std::string defaultName;
+    if (skipDefault)
+    {
+        char *name = nullptr;
+        SDL_AudioSpec spec{};
+        if (SDL_GetDefaultAudioInfo(&name, &spec, 1) == 0 && name)
+        {
+            defaultName = name;
+            SDL_free(name);
+        }
+        else
+            logMessage("Could not identify the default capture device: " + std::string(SDL_GetError()), "WARNING");
+    }
+
+    int available = SDL_GetNumAudioDevices(1);
+    int opened = 0;
+    for (int i = 0; i < available && opened < maxDevices; i++)
+    {
+        const char *deviceName = SDL_GetAudioDeviceName(i, 1);
+        if (!deviceName || (!defaultName.empty() && defaultName == deviceName))
+            continue;
+        try
+        {
+            openDevice(deviceName);
+            opened++;
+        }
+        catch (const std::runtime_error &e)
+        {
+            logMessage("Skipping capture device " + std::string(deviceName) + ": " + e.what(), "WARNING");
+        }
+    }
+    if (opened < maxDevices)
+        logMessage("Requested " + std::to_string(maxDevices) + " capture devices, opened " + std::to_string(opened), "WARNING");
+    return opened;
+}
+
+/**
+ * @brief Starts every device. Sources are fixed from now on.
+ */
+void CaptureEngine::start()
+{
+    running = true;
+    for (SDL_AudioDeviceID device : devices)
+        SDL_PauseAudioDevice(device, 0);
+}
+
+/**
+ * @brief Pauses every device.
+ */
+void CaptureEngine::stop()
+{
+    for (SDL_AudioDeviceID device : devices)
+        SDL_PauseAudioDevice(device, 1);
+    running = false;
+}
+
+/**
+ * @brief Accesses a source by index.
+ *
+ * @throws std::out_of_range if the index is invalid.
+ */
+CaptureSource &CaptureEngine::source(int index)
+{
+    if (index < 0 || index >= sourceCount())
+    {
+        logMessage("Capture source index out of range.", "ERROR");
+        throw std::out_of_range("Capture source index out of range.");
+    }
+    return *sources[index];
+}
+
+/**
+ * @brief Registers a node that process() runs on every aligned frame.
+ */
+void CaptureEngine::addNode(AlignedNode node)
+{
+    nodes.push_back(node);
+}
+
+/**
+ * @brief Cuts the newest stretch of timeline that every source has captured.
+ *
+ * The frame ends at the earliest end time among the sources; each source is then read from the
+ * stream position that its own clock maps to the frame start.
+ * @param length Samples per channel.
+ * @param out Set to the engine's frame on success; valid until the next call.
+ * @return false if some source has not captured the stretch yet or has already overwritten it.
+ */
+bool CaptureEngine::alignedFrame(int length, const AlignedFrame *&out)
+{
+    if (sources.empty() || length <= 0)
+        return false;
+
+    double end = sources[0]->endTime();
+    for (const auto &source : sources)
+    {
+        if (source->samplesWritten() == 0)
+            return false;
+        end = std::min(end, source->endTime());
+    }
+    double start = end - static_cast<double>(length) / RATE;
+
+    if (scratch.size() != sources.size() || frame.length != length)
+    {
+        scratch.assign(sources.size(), std::vector<sample>(length));
+        frame.channels.resize(sources.size());
+        for (size_t i = 0; i < sources.size(); i++)
+            frame.channels[i] = scratch[i].data();
+        frame.length = length;
+    }
+
+    for (size_t i = 0; i < sources.size(); i++)
+    {
+        long long position = std::llround((start - sources[i]->clockOrigin()) * RATE);
+        if (position < 0 || !sources[i]->read(static_cast<uint64_t>(position), scratch[i].data(), length))
+            return false;
+    }
+    frame.time = start;
+    out = &frame;
+    return true;
+}
+
+/**
+ * @brief Runs every registered node on the newest aligned frame.
+ *
+ * @param length Samples per channel.
+ * @return true if a frame was available and processed.
+ */
+bool CaptureEngine::process(int length)
+{
+    const AlignedFrame *aligned;
+    if (!alignedFrame(length, aligned))
+        return false;
+    for (AlignedNode &node : nodes)
+        node(*aligned);
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef CAPTURE_ENGINE_H
+#define CAPTURE_ENGINE_H
+
+#include "captureSource.h"
+#include <SDL2/SDL.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// One frame of every source covering the same stretch of the common timeline
+struct AlignedFrame
+{
+    double time;                           /// Timeline time of the first sample, in seconds
+    int length;                            /// Samples per channel
+    std::vector<const sample *> channels;  /// One pointer per source, in source order
+};
+
+/// An analysis node that consumes aligned multi-source frames
+typedef std::function<void(const AlignedFrame &)> AlignedNode;
+
+/**
+ * --------------------------
+ * ----class CaptureEngine----
+ * --------------------------
+ * Owns all capture sources and the SDL devices feeding them, so one process and one analysis
+ * thread handle every microphone. Sources are fixed once the engine starts; each device callback
+ * only writes into its own source ring. process() cuts the newest stretch of timeline covered by
+ * every source and hands it to the registered nodes.
+ */
+class CaptureEngine
+{
+private:
+    std::vector<std::unique_ptr<CaptureSource>> sources;
+    std::vector<SDL_AudioDeviceID> devices;
+    std::vector<AlignedNode> nodes;
+    std::vector<std::vector<sample>> scratch; /// Channel buffers behind AlignedFrame::channels
+    AlignedFrame frame;
+    int ringCapacity;
+    bool running = false;
+
+public:
+    CaptureEngine(int capacity = CAPTURE_RING); /// Constructor
+    ~CaptureEngine();                           /// Destructor, closes all devices
+    CaptureEngine(const CaptureEngine &) = delete;
+    CaptureEngine &operator=(const CaptureEngine &) = delete;
+
+    int addSource(const std::string &name);                       /// Adds a source fed by the caller; returns its index
+    int openDevice(const char *deviceName, int chunk = CHUNK);   /// Opens an SDL capture device as a new source; nullptr for the default
+    int openAllDevices(int maxDevices, bool skipDefault = false); /// Opens up to maxDevices capture devices; returns how many
+    void start();                                                 /// Starts every device
+    void stop();                                                  /// Pauses every device
+
+    int sourceCount() const { return static_cast<int>(sources.size()); }
+    CaptureSource &source(int index);
+
+    void addNode(AlignedNode node);                       /// Registers an analysis node
+    bool alignedFrame(int length, const AlignedFrame *&out); /// Newest frame covered by all sources
+    bool process(int length);                             /// Runs every node on the newest aligned frame
+};
+
+/// Current time on the common capture timeline, in seconds
+double captureClock();
+
+#endif // CAPTURE_ENGINE_H
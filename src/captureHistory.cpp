@@ -0,0 +1,260 @@
+#include "captureHistory.h"
+#include "bitStream.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief Losslessly compresses one block of samples.
+ *
+ * Picks the fixed predictor (order 0, 1 or 2) with the smallest residuals, then Rice codes the
+ * zigzagged residuals with one parameter for the block. The prediction and zigzag passes are
+ * plain loops over arrays so the compiler can vectorize them; only the bit packing is serial.
+ *
+ * Layout, most significant bit first:
+ * - 2 bits predictor order, 5 bits Rice parameter k;
+ * - the first `order` samples verbatim, 16 bits each, to seed the predictor;
+ * - per remaining sample, the zigzagged residual r split into q = r >> k and its low k bits:
+ *   q zeros, a one, then the k low bits. A quotient of HISTORY_ESCAPE or more is written as
+ *   HISTORY_ESCAPE zeros followed by r in 20 bits instead, which bounds the cost of a click.
+ * The last byte is padded with zeros.
+ * @param input Samples to compress.
+ * @param n Number of samples.
+ * @param output Receives the encoded bytes (appended).
+ * @return Number of bytes appended.
+ */
+size_t compressBlock(const sample *input, int n, std::vector<uint8_t> &output)
+{
+    size_t before = output.size();
+    static thread_local std::vector<uint32_t> residuals[HISTORY_MAX_ORDER + 1];
+
+    // Residuals of every fixed predictor; each loop is independent and vectorizable
+    uint64_t cost[HISTORY_MAX_ORDER + 1] = {0};
+    for (int order = 0; order <= HISTORY_MAX_ORDER; order++)
+    {
+        std::vector<uint32_t> &r = residuals[order];
+        r.resize(n);
+        for (int i = order; i < n; i++)
+        {
+            int32_t prediction = order == 0 ? 0 : order == 1 ? input[i - 1] : 2 * input[i - 1] - input[i - 2];
+            r[i] = zigzag(input[i] - prediction);
+            cost[order] += r[i];
+        }
+    }
+    int order = static_cast<int>(std::min_element(cost, cost + HISTORY_MAX_ORDER + 1) - cost);
+    int coded = std::max(1, n - order);
+
+    // Rice parameter close to log2 of the mean residual
+    uint64_t mean = cost[order] / coded;
+    int k = 0;
+    while (k < 24 && (mean >> (k + 1)) > 0)
+        k++;
+
+    BitWriter writer(output);
+    writer.put(order, 2);
+    writer.put(k, 5);
+    for (int i = 0; i < order && i < n; i++)
+        writer.put(static_cast<uint16_t>(input[i]), 16);
+
+    const std::vector<uint32_t> &r = residuals[order];
+    for (int i = order; i < n; i++)
+    {
+        uint32_t q = r[i] >> k;
+        if (q < HISTORY_ESCAPE)
+        {
+            writer.put(1, q + 1); // q zeros then a one
+            writer.put(r[i] & ((1u << k) - 1), k);
+        }
+        else
+        {
+            writer.put(0, HISTORY_ESCAPE);
+            writer.put(r[i], 20); // Order-2 residuals of 16-bit audio fit in 19 bits, zigzagged in 20
+        }
+    }
+    writer.flush();
+    return output.size() - before;
+}
+
+/**
+ * @brief Decodes a block written by compressBlock().
+ *
+ * Reads the predictor order and Rice parameter, the verbatim seed samples, then one residual
+ * per remaining sample: a run of zeros shorter than HISTORY_ESCAPE is the quotient, followed by
+ * the k low bits; a full run of HISTORY_ESCAPE zeros is followed by the 20-bit residual.
+ * @param data Encoded bytes.
+ * @param size Number of encoded bytes.
+ * @param n Number of samples in the block.
+ * @param output Array of n samples.
+ */
+void decompressBlock(const uint8_t *data, size_t size, int n, sample *output)
+{
+    BitReader reader(data, size);
+    int order = static_cast<int>(reader.get(2));
+    int k = static_cast<int>(reader.get(5));
+    for (int i = 0; i < order && i < n; i++)
+        output[i] = static_cast<sample>(reader.get(16));
+
+    for (int i = order; i < n; i++)
+    {
+        int q = reader.zeros(HISTORY_ESCAPE);
+        uint32_t u = q < HISTORY_ESCAPE ? (static_cast<uint32_t>(q) << k) | reader.get(k) : reader.get(20);
+        int32_t prediction = order == 0 ? 0 : order == 1 ? output[i - 1] : 2 * output[i - 1] - output[i - 2];
+        output[i] = static_cast<sample>(prediction + unzigzag(u));
+    }
+}
+
+/**
+ * @brief Constructor for CaptureHistory.
+ *
+ * @param budgetBytes Memory budget for the compressed chunk store.
+ * @param rawCapacity Samples kept raw in the ring (a power of two, at least one block).
+ * @throws std::invalid_argument if the raw ring cannot hold a block.
+ */
+CaptureHistory::CaptureHistory(size_t budgetBytes, int rawCapacity)
+    : ring("history", rawCapacity), budget(budgetBytes), scratch(HISTORY_BLOCK)
+{
+    if (rawCapacity < 2 * HISTORY_BLOCK)
+    {
+        logMessage("History ring must hold at least two blocks.", "ERROR");
+        throw std::invalid_argument("History ring must hold at least two blocks.");
+    }
+}
+
+/**
+ * @brief Appends captured samples to the raw ring. Safe to call from the audio callback.
+ */
+void CaptureHistory::write(const sample *data, int n, double deliveredAt)
+{
+    ring.write(data, n, deliveredAt);
+}
+
+/**
+ * @brief Compresses every completed block that is not in the chunk store yet.
+ *
+ * Blocks the ring already overwrote are counted as lost and leave a gap. The oldest chunks are
+ * evicted while the store is over budget.
+ * @return Number of blocks compressed.
+ */
+int CaptureHistory::compressPending()
+{
+    int compressed = 0;
+    while (ring.samplesWritten() >= compressedUpTo + HISTORY_BLOCK)
+    {
+        if (!ring.read(compressedUpTo, scratch.data(), HISTORY_BLOCK))
+        {
+            uint64_t oldest = ring.samplesWritten() - ring.capacity() + HISTORY_BLOCK;
+            oldest -= oldest % HISTORY_BLOCK;
+            lostSamples += oldest - compressedUpTo;
+            compressedUpTo = oldest;
+            continue;
+        }
+
+        Chunk chunk;
+        chunk.position = compressedUpTo;
+        compressBlock(scratch.data(), HISTORY_BLOCK, chunk.bytes);
+        chunk.bytes.shrink_to_fit();
+        storedBytes += chunk.bytes.size() + sizeof(Chunk);
+        chunks.push_back(std::move(chunk));
+        compressedUpTo += HISTORY_BLOCK;
+        compressed++;
+
+        while (storedBytes > budget && !chunks.empty())
+        {
+            storedBytes -= chunks.front().bytes.size() + sizeof(Chunk);
+            chunks.pop_front();
+        }
+    }
+    return compressed;
+}
+
+/**
+ * @brief Oldest stream position that can still be read.
+ */
+uint64_t CaptureHistory::oldestPosition() const
+{
+    uint64_t written = ring.samplesWritten();
+    uint64_t rawStart = written > static_cast<uint64_t>(ring.capacity()) ? written - ring.capacity() : 0;
+    return chunks.empty() ? rawStart : std::min(rawStart, chunks.front().position);
+}
+
+/**
+ * @brief Converts a timeline time to the stream position captured at that time.
+ *
+ * @param time Timeline time in seconds (see captureClock()).
+ * @return The position, clamped to 0 for times before capture started.
+ */
+uint64_t CaptureHistory::positionAt(double time) const
+{
+    double position = (time - ring.clockOrigin()) * RATE;
+    return position > 0 ? static_cast<uint64_t>(position + 0.5) : 0;
+}
+
+/**
+ * @brief Binary search of the chunk index for the block holding a position.
+ *
+ * @return The chunk, or nullptr if that block was evicted or lost.
+ */
+const CaptureHistory::Chunk *CaptureHistory::findChunk(uint64_t position) const
+{
+    auto it = std::upper_bound(chunks.begin(), chunks.end(), position, [](uint64_t p, const Chunk &c)
+                               { return p < c.position; });
+    if (it == chunks.begin())
+        return nullptr;
+    --it;
+    return position < it->position + HISTORY_BLOCK ? &*it : nullptr;
+}
+
+/**
+ * @brief Copies a past range of samples, decoding compressed blocks as needed.
+ *
+ * The part still in the raw ring is copied directly; older parts are decoded block by block.
+ * @param position Stream position of the first sample.
+ * @param output Array to store the samples.
+ * @param n Number of samples.
+ * @return false if any part of the range is not held (evicted, lost or not captured yet).
+ */
+bool CaptureHistory::read(uint64_t position, sample *output, int n)
+{
+    if (n < 0 || position + n > ring.samplesWritten())
+        return false;
+
+    while (n > 0)
+    {
+        uint64_t written = ring.samplesWritten();
+        uint64_t rawStart = written > static_cast<uint64_t>(ring.capacity()) ? written - ring.capacity() : 0;
+        // Leave a block of slack so the recording callback cannot overwrite the range mid-copy
+        if (position >= rawStart + HISTORY_BLOCK && ring.read(position, output, n))
+            return true;
+
+        const Chunk *chunk = findChunk(position);
+        if (!chunk)
+            return false;
+        decompressBlock(chunk->bytes.data(), chunk->bytes.size(), HISTORY_BLOCK, scratch.data());
+        int offset = static_cast<int>(position - chunk->position);
+        int count = std::min(n, HISTORY_BLOCK - offset);
+        std::memcpy(output, scratch.data() + offset, count * sizeof(sample));
+        output += count;
+        position += count;
+        n -= count;
+    }
+    return true;
+}
+
+/**
+ * @brief Raw bytes per compressed byte over the chunk store, or 0 when it is empty.
+ */
+double CaptureHistory::compressionRatio() const
+{
+    if (storedBytes == 0)
+        return 0;
+    return static_cast<double>(chunks.size()) * HISTORY_BLOCK * sizeof(sample) / storedBytes;
+}
+
+/**
+ * @brief Seconds of audio between the oldest readable sample and the newest.
+ */
+double CaptureHistory::secondsHeld() const
+{
+    return static_cast<double>(newestPosition() - oldestPosition()) / RATE;
+}
@@ -0,0 +1,66 @@
+#ifndef CAPTURE_HISTORY_H
+#define CAPTURE_HISTORY_H
+
+#include "captureSource.h"
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#define HISTORY_BLOCK 4096     /// Samples per compressed block
+#define HISTORY_RAW 1048576    /// Samples kept uncompressed in the ring (~24 s at RATE)
+#define HISTORY_MAX_ORDER 2    /// Highest fixed predictor order tried per block
+#define HISTORY_ESCAPE 32      /// Rice quotients from here on are escaped to a raw value
+
+size_t compressBlock(const sample *input, int n, std::vector<uint8_t> &output); /// Losslessly compresses one block; returns bytes appended
+void decompressBlock(const uint8_t *data, size_t size, int n, sample *output);   /// Decodes a block written by compressBlock()
+
+/**
+ * ---------------------------
+ * ----class CaptureHistory----
+ * ---------------------------
+ * Tiered capture history. The newest HISTORY_RAW samples stay raw in a lock-free ring that the
+ * recording callback writes; compressPending(), called from the analysis thread, compresses
+ * every completed block into the chunk store. Chunks are indexed by stream position, so any
+ * past range decodes on demand, and the oldest chunks are evicted to stay within the memory
+ * budget. Reads and compression must happen on the same thread.
+ */
+class CaptureHistory
+{
+private:
+    /// One compressed block
+    struct Chunk
+    {
+        uint64_t position;          /// Stream position of the first sample
+        std::vector<uint8_t> bytes; /// Encoded block
+    };
+
+    CaptureSource ring;
+    std::deque<Chunk> chunks;     /// Ordered by position; gaps only where the compressor fell behind
+    size_t budget;                /// Maximum bytes held by the chunk store
+    size_t storedBytes = 0;       /// Bytes currently held by the chunk store
+    uint64_t compressedUpTo = 0;  /// Stream position of the next block to compress
+    uint64_t lostSamples = 0;     /// Samples overwritten in the ring before they were compressed
+    std::vector<sample> scratch;  /// One decoded or pending block
+
+    const Chunk *findChunk(uint64_t position) const;
+
+public:
+    CaptureHistory(size_t budgetBytes, int rawCapacity = HISTORY_RAW); /// Constructor
+
+    void write(const sample *data, int n, double deliveredAt); /// Recording side. Real-time safe.
+    int compressPending();                                     /// Compresses completed blocks; returns how many
+
+    uint64_t newestPosition() const { return ring.samplesWritten(); }
+    uint64_t oldestPosition() const; /// Oldest stream position still held, raw or compressed
+    double timeOf(uint64_t position) const { return ring.clockOrigin() + static_cast<double>(position) / RATE; }
+    uint64_t positionAt(double time) const; /// Stream position captured at a timeline time
+
+    bool read(uint64_t position, sample *output, int n); /// Copies a past range; false if any part is gone
+
+    size_t compressedBytes() const { return storedBytes; }
+    double compressionRatio() const; /// Raw bytes per compressed byte in the chunk store
+    double secondsHeld() const;      /// Length of history currently available
+    uint64_t getLostSamples() const { return lostSamples; }
+};
+
+#endif // CAPTURE_HISTORY_H
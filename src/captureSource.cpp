@@ -0,0 +1,91 @@
+#include "captureSource.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief Constructor for CaptureSource.
+ *
+ * @param name Name used in logs, usually the device name.
+ * @param capacity Ring size in samples; must be a power of two.
+ * @throws std::invalid_argument if capacity is not a positive power of two.
+ */
+CaptureSource::CaptureSource(const std::string &name, int capacity) : name(name)
+{
+    if (capacity <= 0 || (capacity & (capacity - 1)) != 0)
+    {
+        logMessage("Capture ring capacity must be a power of two.", "ERROR");
+        throw std::invalid_argument("Capture ring capacity must be a power of two.");
+    }
+    ring.assign(capacity, 0);
+    mask = static_cast<uint64_t>(capacity) - 1;
+}
+
+/**
+ * @brief Appends a block to the ring and updates the stream clock.
+ *
+ * Called from the device callback, so it neither allocates nor locks. The block's first sample
+ * was captured about n / RATE seconds before delivery; delivery jitter only makes blocks late,
+ * so the clock keeps the earliest estimate per window.
+ * @param data Samples to append.
+ * @param n Number of samples; at most the ring capacity.
+ * @param deliveredAt Timeline time at which the block was delivered, in seconds.
+ */
+void CaptureSource::write(const sample *data, int n, double deliveredAt)
+{
+    uint64_t position = written.load(std::memory_order_relaxed);
+    claimed.store(position + n, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release); // Readers that see any of the new samples also see the claim
+    uint64_t index = position & mask;
+    uint64_t first = std::min<uint64_t>(n, ring.size() - index);
+    std::memcpy(&ring[index], data, first * sizeof(sample));
+    std::memcpy(&ring[0], data + first, (n - first) * sizeof(sample));
+
+    double estimate = deliveredAt - static_cast<double>(position + n) / RATE;
+    if (windowBlocks == 0 || estimate < windowOrigin)
+        windowOrigin = estimate;
+    if (position == 0)
+        origin.store(windowOrigin, std::memory_order_relaxed);
+    if (++windowBlocks == CLOCK_WINDOW_BLOCKS)
+    {
+        origin.store(windowOrigin, std::memory_order_relaxed);
+        windowBlocks = 0;
+    }
+    written.store(position + n, std::memory_order_release);
+}
+
+/**
+ * @brief Copies samples out of the ring without blocking the producer.
+ *
+ * If the producer overwrites the range while it is being copied, the read fails instead of
+ * returning torn data. The check after the copy uses the producer's claim rather than the
+ * published count, so a block still being filled counts as overwriting its slots.
+ * @param position Stream position of the first sample.
+ * @param output Array to store the samples.
+ * @param n Number of samples.
+ * @return true if all samples were available and intact.
+ */
+bool CaptureSource::read(uint64_t position, sample *output, int n) const
+{
+    uint64_t end = samplesWritten();
+    if (n > capacity() || position + n > end || end - position > ring.size())
+        return false;
+
+    uint64_t index = position & mask;
+    uint64_t first = std::min<uint64_t>(n, ring.size() - index);
+    std::memcpy(output, &ring[index], first * sizeof(sample));
+    std::memcpy(output + first, &ring[0], (n - first) * sizeof(sample));
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return claimed.load(std::memory_order_relaxed) - position <= ring.size();
+}
+
+/**
+ * @brief Timeline time just after the newest sample in the ring.
+ */
+double CaptureSource::endTime() const
+{
+    uint64_t end = samplesWritten();
+    return clockOrigin() + static_cast<double>(end) / RATE;
+}
@@ -0,0 +1,48 @@
+#ifndef CAPTURE_SOURCE_H
+#define CAPTURE_SOURCE_H
+
+#include "audioProcessor.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#define CAPTURE_RING 262144       /// Samples kept per capture source (power of two, ~6 s at RATE)
+#define CLOCK_WINDOW_BLOCKS 64    /// Blocks per clock estimation window
+
+/**
+ * --------------------------
+ * ----class CaptureSource----
+ * --------------------------
+ * One capture stream: a lock-free single-producer ring indexed by stream position, plus a
+ * stream clock that maps positions onto the common timeline. Every block arrives with the
+ * time it was delivered; since delivery can only be late, the earliest implied start time
+ * within a window is the best estimate of when sample 0 was captured. Re-estimating each
+ * window follows slow drift between device clocks.
+ */
+class CaptureSource
+{
+private:
+    std::string name;
+    std::vector<sample> ring;
+    uint64_t mask;
+    std::atomic<uint64_t> written{0}; /// Samples written so far (stream position of the next sample)
+    std::atomic<uint64_t> claimed{0}; /// End of the block being written; its slots may be torn until written catches up
+    std::atomic<double> origin{0};    /// Timeline time of stream position 0, in seconds
+    double windowOrigin = 0;          /// Producer only: earliest origin seen in the current window
+    int windowBlocks = 0;             /// Producer only: blocks in the current window
+
+public:
+    CaptureSource(const std::string &name, int capacity = CAPTURE_RING); /// Constructor
+
+    void write(const sample *data, int n, double deliveredAt); /// Producer: append a block delivered at the given time. Real-time safe.
+    bool read(uint64_t position, sample *output, int n) const; /// Consumer: copy n samples; false if not yet written or overwritten
+
+    const std::string &getName() const { return name; }
+    int capacity() const { return static_cast<int>(ring.size()); }
+    uint64_t samplesWritten() const { return written.load(std::memory_order_acquire); }
+    double clockOrigin() const { return origin.load(std::memory_order_acquire); }
+    double endTime() const; /// Timeline time just after the newest sample
+};
+
+#endif // CAPTURE_SOURCE_H
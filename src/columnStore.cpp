@@ -0,0 +1,665 @@
+#include "columnStore.h"
+#include "bitStream.h"
+#include "logger.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+static const char columnMagic[8] = {'A', 'D', 'S', 'P', 'C', 'O', 'L', '1'};
+
+/// Layout of the start of a .col file; the compressed blocks follow
+struct ColumnFileHeader
+{
+    char magic[8];
+    uint32_t type;
+    uint32_t reserved;
+};
+
+namespace
+{
+    uint32_t lowBits(uint64_t value, int count) // count <= 32
+    {
+        return static_cast<uint32_t>(value & (count == 32 ? 0xffffffffu : (1u << count) - 1));
+    }
+
+    void putWide(BitWriter &writer, uint64_t value, int count) // count <= 64; bits above count are dropped
+    {
+        if (count > 32)
+        {
+            writer.put(lowBits(value >> 32, count - 32), count - 32);
+            count = 32;
+        }
+        writer.put(lowBits(value, count), count);
+    }
+
+    uint64_t getWide(BitReader &reader, int count) // count <= 64
+    {
+        if (count <= 32)
+            return reader.get(count);
+        uint64_t high = reader.get(count - 32);
+        return (high << 32) | reader.get(32);
+    }
+
+    /// Order-preserving integer for the bits of a float, so close values give small deltas
+    inline int64_t floatKey(float value)
+    {
+        int32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits < 0 ? bits ^ 0x7fffffff : bits;
+    }
+
+    inline float keyFloat(int64_t key)
+    {
+        int32_t bits = static_cast<int32_t>(key);
+        bits = bits < 0 ? bits ^ 0x7fffffff : bits;
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    /**
+     * @brief Compresses stored values with the better of no prediction or a delta, then Rice codes.
+     *
+     * The predictor and Rice parameter are chosen from a histogram of residual bit lengths, which
+     * handles blocks of mostly repeated values with rare jumps better than the mean residual.
+     */
+    void compressColumn(const int64_t *values, int n, std::vector<uint8_t> &output)
+    {
+        static thread_local std::vector<uint64_t> residuals[2];
+        uint64_t lengths[2][65] = {{0}};
+        for (int order = 0; order < 2; order++)
+        {
+            std::vector<uint64_t> &r = residuals[order];
+            r.resize(n);
+            for (int i = order; i < n; i++)
+            {
+                int64_t prediction = order == 0 ? 0 : values[i - 1];
+                r[i] = zigzag(static_cast<int64_t>(static_cast<uint64_t>(values[i]) - static_cast<uint64_t>(prediction)));
+                lengths[order][r[i] ? 64 - __builtin_clzll(r[i]) : 0]++;
+            }
+        }
+
+        int order = 0, k = 0;
+        double best = std::numeric_limits<double>::max();
+        for (int o = 0; o < 2; o++)
+        {
+            for (int bits = 0; bits < 64; bits++)
+            {
+                double cost = o * 64;
+                for (int length = 0; length <= 64; length++)
+                {
+                    double q = length > bits ? std::ldexp(1.0, length - 1 - bits) : 0; // Smallest quotient of the length
+                    cost += lengths[o][length] * (q < COLUMN_ESCAPE ? q + 1 + bits : COLUMN_ESCAPE + 64);
+                }
+                if (cost < best)
+                {
+                    best = cost;
+                    order = o;
+                    k = bits;
+                }
+            }
+        }
+
+        BitWriter writer(output);
+        writer.put(order, 1);
+        writer.put(k, 6);
+        if (order == 1 && n > 0)
+            putWide(writer, static_cast<uint64_t>(values[0]), 64);
+        const std::vector<uint64_t> &r = residuals[order];
+        for (int i = order; i < n; i++)
+        {
+            uint64_t q = r[i] >> k;
+            if (q < COLUMN_ESCAPE)
+            {
+                writer.put(1, static_cast<int>(q) + 1); // q zeros then a one
+                putWide(writer, r[i], k);
+            }
+            else
+            {
+                writer.put(0, COLUMN_ESCAPE);
+                putWide(writer, r[i], 64);
+            }
+        }
+        writer.flush();
+    }
+
+    void decompressColumn(const uint8_t *data, size_t size, int n, int64_t *output)
+    {
+        BitReader reader(data, size);
+        int order = static_cast<int>(reader.get(1));
+        int k = static_cast<int>(reader.get(6));
+        if (order == 1 && n > 0)
+            output[0] = static_cast<int64_t>(getWide(reader, 64));
+        for (int i = order; i < n; i++)
+        {
+            int q = reader.zeros(COLUMN_ESCAPE);
+            uint64_t u = q < COLUMN_ESCAPE ? (static_cast<uint64_t>(q) << k) | getWide(reader, k) : getWide(reader, 64);
+            uint64_t prediction = order == 0 ? 0 : static_cast<uint64_t>(output[i - 1]);
+            output[i] = static_cast<int64_t>(prediction + static_cast<uint64_t>(unzigzag(u)));
+        }
+    }
+}
+
+/**
+ * @brief Constructor for ColumnStore. Opens the store in a directory, creating it if needed.
+ *
+ * @param directory Directory holding one .col and one .idx file per column.
+ * @param columns Columns besides the time; an existing store must have each of them.
+ * @throws std::invalid_argument if a column name is not a plain file name or is repeated.
+ * @throws std::runtime_error if the files cannot be created or do not match the columns.
+ */
+ColumnStore::ColumnStore(const std::string &directory, const std::vector<ColumnSpec> &specs)
+    : directory(directory), columns(specs.size() + 1)
+{
+    columns[0].spec = {"time", ColumnType::Int};
+    for (size_t c = 0; c < specs.size(); c++)
+    {
+        const std::string &name = specs[c].name;
+        bool plain = !name.empty() && std::all_of(name.begin(), name.end(), [](char ch)
+                                                  { return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || ch == '-'; });
+        for (size_t other = 0; other <= c; other++)
+            plain = plain && columns[other].spec.name != name;
+        if (!plain)
+        {
+            logMessage("Column name '" + name + "' is empty, repeated or not a plain file name.", "ERROR");
+            throw std::invalid_argument("Column name '" + name + "' is empty, repeated or not a plain file name.");
+        }
+        columns[c + 1].spec = specs[c];
+    }
+
+    std::filesystem::create_directories(directory);
+    bool fresh = !std::filesystem::exists(pathOf(columns[0], "col"));
+    for (Column &column : columns)
+        open(column, fresh);
+
+    // A crash between columns can leave some with a block the others lack; drop it everywhere
+    size_t blocks = columns[0].blocks.size();
+    for (const Column &column : columns)
+        blocks = std::min(blocks, column.blocks.size());
+    for (Column &column : columns)
+    {
+        for (size_t b = 0; b < blocks; b++)
+        {
+            if (column.blocks[b].rows != columns[0].blocks[b].rows)
+            {
+                logMessage("Column " + column.spec.name + " in " + directory + " is out of step with the time.", "ERROR");
+                throw std::runtime_error("Column " + column.spec.name + " in " + directory + " is out of step with the time.");
+            }
+        }
+        if (column.blocks.size() > blocks)
+        {
+            column.blocks.resize(blocks);
+            column.fileBytes = blocks > 0 ? column.blocks.back().offset + column.blocks.back().bytes : sizeof(ColumnFileHeader);
+        }
+        std::filesystem::resize_file(pathOf(column, "col"), column.fileBytes);
+        std::filesystem::resize_file(pathOf(column, "idx"), blocks * sizeof(BlockEntry));
+    }
+    for (size_t b = 0; b < blocks; b++)
+        rowCount += columns[0].blocks[b].rows;
+    logMessage("Opened column store " + directory + " with " + std::to_string(rowCount) + " rows.", "INFO");
+}
+
+/**
+ * @brief Destructor for ColumnStore. Writes the rows still in memory.
+ */
+ColumnStore::~ColumnStore()
+{
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &e)
+    {
+        logMessage(std::string("Column store rows lost on close: ") + e.what(), "ERROR");
+    }
+}
+
+std::string ColumnStore::pathOf(const Column &column, const char *extension) const
+{
+    return (std::filesystem::path(directory) / (column.spec.name + "." + extension)).string();
+}
+
+/**
+ * @brief Creates a column's files, or reads its index and dictionary.
+ *
+ * Index entries are accepted while they describe consecutive blocks inside the .col file, so a
+ * block cut short by a crash ends the column.
+ * @param column The column to open.
+ * @param fresh Whether the store is new, so missing files are created rather than an error.
+ * @throws std::runtime_error if the column is missing from an existing store, has another type or
+ *         is damaged.
+ */
+void ColumnStore::open(Column &column, bool fresh)
+{
+    std::string colPath = pathOf(column, "col");
+    if (!std::filesystem::exists(colPath))
+    {
+        if (!fresh)
+        {
+            logMessage("Column store " + directory + " has no column " + column.spec.name, "ERROR");
+            throw std::runtime_error("Column store " + directory + " has no column " + column.spec.name);
+        }
+        ColumnFileHeader header = {};
+        std::memcpy(header.magic, columnMagic, sizeof(columnMagic));
+        header.type = static_cast<uint32_t>(column.spec.type);
+        std::ofstream out(colPath, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        std::ofstream index(pathOf(column, "idx"), std::ios::binary);
+        if (!out || !index)
+        {
+            logMessage("Cannot create column " + colPath, "ERROR");
+            throw std::runtime_error("Cannot create column " + colPath);
+        }
+        column.fileBytes = sizeof(header);
+        return;
+    }
+
+    std::ifstream in(colPath, std::ios::binary);
+    ColumnFileHeader header = {};
+    in.read(reinterpret_cast<char *>(&header), sizeof(header));
+    if (!in || std::memcmp(header.magic, columnMagic, sizeof(columnMagic)) != 0 || header.type != static_cast<uint32_t>(column.spec.type))
+    {
+        logMessage("Column " + colPath + " is damaged or has another type.", "ERROR");
+        throw std::runtime_error("Column " + colPath + " is damaged or has another type.");
+    }
+    uint64_t size = std::filesystem::file_size(colPath);
+
+    std::ifstream index(pathOf(column, "idx"), std::ios::binary);
+    BlockEntry entry;
+    column.fileBytes = sizeof(header);
+    while (index.read(reinterpret_cast<char *>(&entry), sizeof(entry)))
+    {
+        if (entry.offset != column.fileBytes || entry.rows == 0 || entry.offset + entry.bytes > size)
+            break;
+        column.blocks.push_back(entry);
+        column.fileBytes += entry.bytes;
+    }
+
+    if (column.spec.type == ColumnType::Text)
+    {
+        std::ifstream dictionary(pathOf(column, "dict"));
+        std::string line;
+        while (std::getline(dictionary, line))
+        {
+            column.codes.emplace(line, static_cast<int>(column.dictionary.size()));
+            column.dictionary.push_back(line);
+        }
+        column.dictionarySaved = column.dictionary.size();
+    }
+}
+
+/**
+ * @brief Index of a column by name; "time" is column 0.
+ *
+ * @throws std::invalid_argument if the store has no such column.
+ */
+int ColumnStore::column(const std::string &name) const
+{
+    for (size_t c = 0; c < columns.size(); c++)
+        if (columns[c].spec.name == name)
+            return static_cast<int>(c);
+    logMessage("Column store " + directory + " has no column " + name, "ERROR");
+    throw std::invalid_argument("Column store " + directory + " has no column " + name);
+}
+
+/**
+ * @brief Code of a string in a Text column's dictionary, adding it if it is new.
+ *
+ * @param column A Text column.
+ * @param text The string; may not contain a line break.
+ * @throws std::invalid_argument if the column is not Text or the string has a line break.
+ */
+int ColumnStore::textCode(int column, const std::string &text)
+{
+    if (column < 0 || column >= static_cast<int>(columns.size()) || columns[column].spec.type != ColumnType::Text ||
+        text.find('\n') != std::string::npos)
+    {
+        logMessage("Text codes need a Text column and a single line.", "ERROR");
+        throw std::invalid_argument("Text codes need a Text column and a single line.");
+    }
+    Column &target = columns[column];
+    auto found = target.codes.find(text);
+    if (found != target.codes.end())
+        return found->second;
+    target.codes.emplace(text, static_cast<int>(target.dictionary.size()));
+    target.dictionary.push_back(text);
+    return static_cast<int>(target.dictionary.size()) - 1;
+}
+
+/**
+ * @brief The string behind a code of a Text column.
+ *
+ * @throws std::out_of_range if the column or code is unknown.
+ */
+const std::string &ColumnStore::text(int column, int code) const
+{
+    return columns.at(column).dictionary.at(code);
+}
+
+/**
+ * @brief Appends one row; every COLUMN_BLOCK_ROWS rows the block is compressed and written.
+ *
+ * @param timeMs Time of the row in milliseconds; earlier than the last row counts as the last row's time.
+ * @param values One value per column given to the constructor, in order. Int columns round,
+ *        Text columns take codes from textCode().
+ * @throws std::invalid_argument if a Text value is not a known code.
+ * @throws std::runtime_error if a completed block cannot be written.
+ */
+void ColumnStore::append(int64_t timeMs, const double *values)
+{
+    if (rowCount > 0)
+        timeMs = std::max(timeMs, lastTime());
+    for (size_t c = 1; c < columns.size(); c++)
+    {
+        const Column &target = columns[c];
+        double value = values[c - 1];
+        if (target.spec.type == ColumnType::Text && !(value >= 0 && value < static_cast<double>(target.dictionary.size())))
+        {
+            logMessage("Value for column " + target.spec.name + " is not a text code.", "ERROR");
+            throw std::invalid_argument("Value for column " + target.spec.name + " is not a text code.");
+        }
+    }
+
+    columns[0].pending.push_back(timeMs);
+    for (size_t c = 1; c < columns.size(); c++)
+    {
+        Column &target = columns[c];
+        double value = values[c - 1];
+        target.pending.push_back(target.spec.type == ColumnType::Float ? floatKey(static_cast<float>(value)) : std::llround(value));
+    }
+    rowCount++;
+    if (columns[0].pending.size() >= COLUMN_BLOCK_ROWS)
+        flush();
+}
+
+/**
+ * @brief Writes the rows kept in memory as a block of every column, even if it is short.
+ *
+ * @throws std::runtime_error if a column cannot be written.
+ */
+void ColumnStore::flush()
+{
+    if (columns[0].pending.empty())
+        return;
+    for (Column &column : columns)
+        writeBlock(column);
+}
+
+/**
+ * @brief Compresses a column's pending rows and appends them and their index entry to its files.
+ *
+ * The block goes to the .col file before its entry goes to the .idx file, so an entry never
+ * points at bytes that were not written.
+ */
+void ColumnStore::writeBlock(Column &column)
+{
+    static thread_local std::vector<uint8_t> bytes;
+    bytes.clear();
+    int n = static_cast<int>(column.pending.size());
+    compressColumn(column.pending.data(), n, bytes);
+
+    BlockEntry entry = {column.fileBytes, static_cast<uint32_t>(bytes.size()), static_cast<uint32_t>(n), 0, 0, 0, 0};
+    entry.min = std::numeric_limits<double>::infinity();
+    entry.max = -std::numeric_limits<double>::infinity();
+    for (int i = 0; i < n; i++)
+    {
+        double value = toValue(column, column.pending[i]);
+        entry.min = std::min(entry.min, value);
+        entry.max = std::max(entry.max, value);
+        entry.sum += std::isnan(value) ? 0 : value;
+    }
+    if (&column == &columns[0])
+    {
+        for (int i = 1; i < n; i++)
+            entry.coveredMs += static_cast<double>(std::min<int64_t>(column.pending[i] - column.pending[i - 1], COLUMN_MAX_GAP_MS));
+    }
+
+    if (column.dictionary.size() > column.dictionarySaved)
+    {
+        std::ofstream dictionary(pathOf(column, "dict"), std::ios::app);
+        for (size_t d = column.dictionarySaved; d < column.dictionary.size(); d++)
+            dictionary << column.dictionary[d] << '\n';
+        column.dictionarySaved = column.dictionary.size();
+    }
+    std::ofstream data(pathOf(column, "col"), std::ios::binary | std::ios::app);
+    data.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    data.close();
+    std::ofstream index(pathOf(column, "idx"), std::ios::binary | std::ios::app);
+    if (data)
+        index.write(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    if (!data || !index)
+    {
+        logMessage("Cannot write column " + pathOf(column, "col"), "ERROR");
+        throw std::runtime_error("Cannot write column " + pathOf(column, "col"));
+    }
+    column.blocks.push_back(entry);
+    column.fileBytes += bytes.size();
+    column.pending.clear();
+}
+
+/**
+ * @brief Reads and decompresses one written block of a column.
+ */
+void ColumnStore::decodeBlock(const Column &column, size_t block, std::vector<int64_t> &out) const
+{
+    const BlockEntry &entry = column.blocks[block];
+    std::ifstream in(pathOf(column, "col"), std::ios::binary);
+    std::vector<uint8_t> bytes(entry.bytes);
+    in.seekg(static_cast<std::streamoff>(entry.offset));
+    in.read(reinterpret_cast<char *>(bytes.data()), entry.bytes);
+    if (!in)
+    {
+        logMessage("Cannot read column " + pathOf(column, "col"), "ERROR");
+        throw std::runtime_error("Cannot read column " + pathOf(column, "col"));
+    }
+    out.resize(entry.rows);
+    decompressColumn(bytes.data(), bytes.size(), static_cast<int>(entry.rows), out.data());
+    decoded++;
+}
+
+/**
+ * @brief Stored values of a block; the block after the last written one is the rows in memory.
+ */
+void ColumnStore::blockValues(const Column &column, size_t block, std::vector<int64_t> &out) const
+{
+    if (block < column.blocks.size())
+        decodeBlock(column, block, out);
+    else
+        out = column.pending;
+}
+
+/**
+ * @brief First block whose last row is at or after a time; the pending rows count as a block.
+ */
+size_t ColumnStore::firstBlockEndingAfter(int64_t timeMs) const
+{
+    const std::vector<BlockEntry> &blocks = columns[0].blocks;
+    return std::partition_point(blocks.begin(), blocks.end(), [timeMs](const BlockEntry &entry)
+                                { return entry.max < static_cast<double>(timeMs); }) -
+           blocks.begin();
+}
+
+/**
+ * @brief Written blocks, plus one for the rows in memory if there are any.
+ */
+size_t ColumnStore::blockCount() const
+{
+    return columns[0].blocks.size() + (columns[0].pending.empty() ? 0 : 1);
+}
+
+int64_t ColumnStore::blockFirstTime(size_t block) const
+{
+    const Column &time = columns[0];
+    return block < time.blocks.size() ? static_cast<int64_t>(time.blocks[block].min) : time.pending.front();
+}
+
+int64_t ColumnStore::blockLastTime(size_t block) const
+{
+    const Column &time = columns[0];
+    return block < time.blocks.size() ? static_cast<int64_t>(time.blocks[block].max) : time.pending.back();
+}
+
+double ColumnStore::toValue(const Column &column, int64_t stored) const
+{
+    return column.spec.type == ColumnType::Float ? keyFloat(stored) : static_cast<double>(stored);
+}
+
+/**
+ * @brief Time of the newest row in milliseconds, or 0 if the store is empty.
+ */
+int64_t ColumnStore::lastTime() const
+{
+    const Column &time = columns[0];
+    if (!time.pending.empty())
+        return time.pending.back();
+    return time.blocks.empty() ? 0 : static_cast<int64_t>(time.blocks.back().max);
+}
+
+/**
+ * @brief Copies out the rows of a column within a time range.
+ *
+ * Only the blocks that overlap the range are read, from this column and the time column.
+ * @param column Column index from column().
+ * @param fromMs Start of the range, inclusive.
+ * @param toMs End of the range, exclusive.
+ * @param timesMs Receives the time of each row.
+ * @param values Receives the value of each row; codes for Text columns.
+ * @return Rows copied.
+ */
+size_t ColumnStore::scan(int column, int64_t fromMs, int64_t toMs, std::vector<int64_t> &timesMs, std::vector<double> &values) const
+{
+    const Column &target = columns.at(column), &time = columns[0];
+    timesMs.clear();
+    values.clear();
+    std::vector<int64_t> times, stored;
+    for (size_t b = firstBlockEndingAfter(fromMs); b < blockCount() && blockFirstTime(b) < toMs; b++)
+    {
+        blockValues(time, b, times);
+        blockValues(target, b, stored);
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            if (times[i] >= fromMs && times[i] < toMs)
+            {
+                timesMs.push_back(times[i]);
+                values.push_back(toValue(target, stored[i]));
+            }
+        }
+    }
+    return timesMs.size();
+}
+
+/**
+ * @brief Count, sum, minimum and maximum of a column within a time range.
+ *
+ * Blocks that lie wholly inside the range are summarized from their index entries; only the
+ * blocks at the ends of the range are decoded. Not-a-number values count as rows but are left out
+ * of the sum and range.
+ * @param column Column index from column().
+ * @param fromMs Start of the range, inclusive.
+ * @param toMs End of the range, exclusive.
+ * @return The summary; min and max are 0 if there are no rows.
+ */
+ColumnSummary ColumnStore::summarize(int column, int64_t fromMs, int64_t toMs) const
+{
+    const Column &target = columns.at(column), &time = columns[0];
+    ColumnSummary summary;
+    summary.min = std::numeric_limits<double>::infinity();
+    summary.max = -std::numeric_limits<double>::infinity();
+    std::vector<int64_t> times, stored;
+    for (size_t b = firstBlockEndingAfter(fromMs); b < blockCount() && blockFirstTime(b) < toMs; b++)
+    {
+        if (b < time.blocks.size() && blockFirstTime(b) >= fromMs && blockLastTime(b) < toMs)
+        {
+            const BlockEntry &entry = target.blocks[b];
+            summary.rows += entry.rows;
+            summary.sum += entry.sum;
+            summary.min = std::min(summary.min, entry.min);
+            summary.max = std::max(summary.max, entry.max);
+            continue;
+        }
+        blockValues(time, b, times);
+        blockValues(target, b, stored);
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            if (times[i] < fromMs || times[i] >= toMs)
+                continue;
+            double value = toValue(target, stored[i]);
+            summary.rows++;
+            if (!std::isnan(value))
+            {
+                summary.sum += value;
+                summary.min = std::min(summary.min, value);
+                summary.max = std::max(summary.max, value);
+            }
+        }
+    }
+    if (!(summary.min <= summary.max))
+        summary.min = summary.max = 0;
+    return summary;
+}
+
+/**
+ * @brief Seconds covered by the rows within a time range whose value lies in [low, high].
+ *
+ * A row lasts until the next row, or COLUMN_MAX_GAP_MS if the next row is later than that; the
+ * newest row lasts nothing yet. Blocks whose value range misses [low, high] are skipped and
+ * blocks that lie inside it and inside the time range are counted from the time index, so only
+ * blocks that straddle the threshold or the ends of the range are decoded. For example, time out
+ * of tune by more than 10 cents is secondsWithin(cents, 10, inf) plus secondsWithin(cents, -inf, -10).
+ * @param column Column index from column().
+ * @param low Lowest value counted.
+ * @param high Highest value counted.
+ * @param fromMs Start of the range, inclusive.
+ * @param toMs End of the range, exclusive.
+ */
+double ColumnStore::secondsWithin(int column, double low, double high, int64_t fromMs, int64_t toMs) const
+{
+    const Column &target = columns.at(column), &time = columns[0];
+    double covered = 0;
+    std::vector<int64_t> times, stored;
+    for (size_t b = firstBlockEndingAfter(fromMs); b < blockCount() && blockFirstTime(b) < toMs; b++)
+    {
+        int64_t tail = b + 1 < blockCount() ? std::min<int64_t>(blockFirstTime(b + 1) - blockLastTime(b), COLUMN_MAX_GAP_MS) : 0;
+        if (b < time.blocks.size())
+        {
+            const BlockEntry &entry = target.blocks[b];
+            if (entry.max < low || entry.min > high)
+                continue;
+            if (entry.min >= low && entry.max <= high && blockFirstTime(b) >= fromMs && blockLastTime(b) < toMs)
+            {
+                covered += time.blocks[b].coveredMs + static_cast<double>(tail);
+                continue;
+            }
+        }
+        blockValues(time, b, times);
+        blockValues(target, b, stored);
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            double value = toValue(target, stored[i]);
+            if (times[i] < fromMs || times[i] >= toMs || !(value >= low && value <= high))
+                continue;
+            covered += static_cast<double>(i + 1 < times.size() ? std::min<int64_t>(times[i + 1] - times[i], COLUMN_MAX_GAP_MS) : tail);
+        }
+    }
+    return covered / 1000;
+}
+
+/**
+ * @brief Bytes of all column, index and dictionary files.
+ */
+uint64_t ColumnStore::bytesOnDisk() const
+{
+    uint64_t total = 0;
+    for (const Column &column : columns)
+    {
+        total += column.fileBytes + column.blocks.size() * sizeof(BlockEntry);
+        if (column.spec.type == ColumnType::Text && std::filesystem::exists(pathOf(column, "dict")))
+            total += std::filesystem::file_size(pathOf(column, "dict"));
+    }
+    return total;
+}
@@ -0,0 +1,117 @@
+#ifndef COLUMN_STORE_H
+#define COLUMN_STORE_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#define COLUMN_BLOCK_ROWS 4096 /// Rows per compressed block, about 47 s at a 512-sample hop
+#define COLUMN_ESCAPE 32       /// Rice quotients from here on are escaped to a raw 64-bit value
+#define COLUMN_MAX_GAP_MS 1000 /// A longer gap between rows is a pause; the row before it lasts this long
+
+/// How a column stores its values
+enum class ColumnType : uint32_t
+{
+    Int,   /// 64-bit integers; appended values are rounded
+    Float, /// 32-bit floats, kept exactly
+    Text   /// Codes into a dictionary of strings kept next to the column
+};
+
+/// Name and type of one column of a store
+struct ColumnSpec
+{
+    std::string name;
+    ColumnType type;
+};
+
+/// Count, sum and range of the values of a column over a time range
+struct ColumnSummary
+{
+    uint64_t rows = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+};
+
+/**
+ * -------------------------
+ * ----class ColumnStore----
+ * -------------------------
+ * An append-only store of per-frame analysis results, one file per column in a directory. Every
+ * row has a time in milliseconds, kept as the column "time"; rows are appended in time order and
+ * grouped into blocks of COLUMN_BLOCK_ROWS that line up across columns. Each block is compressed
+ * on its own with the better of no prediction or a delta from the previous value followed by Rice
+ * codes, so repeated or slowly changing values cost a few bits. An index file per column holds
+ * the offset, row count, minimum, maximum and sum of every block, and for the time column the
+ * time its rows cover: that index is the time index that turns a range into a run of blocks, and
+ * the other indexes let summaries and threshold queries skip or settle whole blocks without
+ * decoding them. A query opens only the column it asks about and the time column. Rows not yet
+ * in a complete block are kept in memory and written by flush(); a block whose index entry never
+ * made it to disk is dropped on open.
+ */
+class ColumnStore
+{
+private:
+    /// Index entry of one block, as stored in the .idx file
+    struct BlockEntry
+    {
+        uint64_t offset; /// Byte offset in the .col file
+        uint32_t bytes;
+        uint32_t rows;
+        double min;
+        double max;
+        double sum;
+        double coveredMs; /// Time column only: milliseconds its rows cover up to the last one
+    };
+
+    struct Column
+    {
+        ColumnSpec spec;
+        std::vector<BlockEntry> blocks;
+        std::vector<int64_t> pending;  /// Stored values of rows not written yet
+        uint64_t fileBytes = 0;        /// End of the last indexed block
+        std::vector<std::string> dictionary;
+        std::unordered_map<std::string, int> codes;
+        size_t dictionarySaved = 0;    /// Dictionary entries already in the .dict file
+    };
+
+    std::string directory;
+    std::vector<Column> columns; /// columns[0] is the time
+    uint64_t rowCount = 0;
+    mutable uint64_t decoded = 0;
+
+    std::string pathOf(const Column &column, const char *extension) const;
+    void open(Column &column, bool fresh);
+    void writeBlock(Column &column);
+    void decodeBlock(const Column &column, size_t block, std::vector<int64_t> &out) const;
+    void blockValues(const Column &column, size_t block, std::vector<int64_t> &out) const;
+    size_t firstBlockEndingAfter(int64_t timeMs) const;
+    size_t blockCount() const;
+    int64_t blockFirstTime(size_t block) const;
+    int64_t blockLastTime(size_t block) const;
+    double toValue(const Column &column, int64_t stored) const;
+
+public:
+    ColumnStore(const std::string &directory, const std::vector<ColumnSpec> &columns);
+    ~ColumnStore();
+    ColumnStore(const ColumnStore &) = delete;
+    ColumnStore &operator=(const ColumnStore &) = delete;
+
+    int column(const std::string &name) const;
+    int textCode(int column, const std::string &text);
+    const std::string &text(int column, int code) const;
+    void append(int64_t timeMs, const double *values); /// One value per column given to the constructor; Text takes codes
+    void flush();
+
+    size_t scan(int column, int64_t fromMs, int64_t toMs, std::vector<int64_t> &timesMs, std::vector<double> &values) const;
+    ColumnSummary summarize(int column, int64_t fromMs, int64_t toMs) const;
+    double secondsWithin(int column, double low, double high, int64_t fromMs, int64_t toMs) const;
+
+    uint64_t rows() const { return rowCount; }
+    int64_t lastTime() const;
+    uint64_t blocksDecoded() const { return decoded; } /// Blocks decompressed by queries so far
+    uint64_t bytesOnDisk() const;
+};
+
+#endif // COLUMN_STORE_H
@@ -0,0 +1,100 @@
+#include "delayEstimator.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief Constructor for DelayEstimator.
+ *
+ * @param frameSize Samples per channel in each frame.
+ * @param maxLag Largest delay searched, in samples.
+ * @throws std::invalid_argument if maxLag does not fit well inside the frame.
+ */
+DelayEstimator::DelayEstimator(int frameSize, int maxLag)
+    : frameSize(frameSize), maxLag(maxLag), plan(FFTPlan::get(frameSize)), window(frameSize), framed(2 * static_cast<size_t>(frameSize)),
+      spectrumA(frameSize / 2 + 1), spectrumB(frameSize / 2 + 1), cross(frameSize / 2 + 1), correlation(frameSize)
+{
+    if (maxLag < 1 || maxLag >= frameSize / 4)
+    {
+        logMessage("GCC-PHAT search range must be between 1 and a quarter of the frame.", "ERROR");
+        throw std::invalid_argument("GCC-PHAT search range must be between 1 and a quarter of the frame.");
+    }
+    for (int i = 0; i < frameSize; i++)
+    {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * M_PI * i / frameSize));
+    }
+}
+
+/**
+ * @brief Updates the delay estimate with one frame from each input.
+ *
+ * @param a frameSize samples of the reference input.
+ * @param b frameSize samples of the second input, covering the same time.
+ * @return The new estimate; positive when b hears the source later than a.
+ */
+const DelayEstimate &DelayEstimator::update(const sample *a, const sample *b)
+{
+    float *first = framed.data(), *second = framed.data() + frameSize;
+    for (int i = 0; i < frameSize; i++)
+    {
+        first[i] = a[i] * window[i];
+        second[i] = b[i] * window[i];
+    }
+    plan.forwardRealPair(first, second, spectrumA.data(), spectrumB.data(), correlation.data());
+
+    // Whitened cross spectrum conj(A) * B, averaged over recent frames
+    float keep = primed ? GCC_SMOOTHING : 0.0f;
+    for (int k = 0; k <= frameSize / 2; k++)
+    {
+        cmplx product = std::conj(spectrumA[k]) * spectrumB[k];
+        double magnitude = std::abs(product);
+        cmplx whitened = magnitude > 1e-9 ? product / magnitude : cmplx(0, 0);
+        cross[k] = static_cast<double>(keep) * cross[k] + static_cast<double>(1 - keep) * whitened;
+    }
+    primed = true;
+
+    // Inverse transform of the Hermitian spectrum: conj(FFT(conj(X))) / n, whose result is real
+    for (int k = 0; k <= frameSize / 2; k++)
+    {
+        correlation[k] = std::conj(cross[k]);
+        if (k > 0 && k < frameSize / 2)
+            correlation[frameSize - k] = cross[k];
+    }
+    plan.forward(correlation.data(), correlation.data());
+
+    auto valueAt = [&](int lag)
+    { return correlation[(lag + frameSize) & (frameSize - 1)].real() / frameSize; };
+
+    int best = 0;
+    double bestValue = valueAt(0);
+    for (int lag = -maxLag; lag <= maxLag; lag++)
+    {
+        double value = valueAt(lag);
+        if (value > bestValue)
+        {
+            bestValue = value;
+            best = lag;
+        }
+    }
+
+    double left = valueAt(best - 1), right = valueAt(best + 1);
+    double curvature = left - 2 * bestValue + right;
+    double offset = curvature < 0 ? 0.5 * (left - right) / curvature : 0.0;
+    latest.samples = best + offset;
+    latest.seconds = latest.samples / RATE;
+    latest.confidence = static_cast<float>(std::max(0.0, std::min(1.0, bestValue)));
+    return latest;
+}
+
+/**
+ * @brief Forgets the averaged cross spectrum and the last estimate.
+ */
+void DelayEstimator::reset()
+{
+    primed = false;
+    latest = DelayEstimate();
+}
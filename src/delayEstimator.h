@@ -0,0 +1,53 @@
+#ifndef DELAY_ESTIMATOR_H
+#define DELAY_ESTIMATOR_H
+
+#include "fftPlan.h"
+#include <vector>
+
+#define GCC_FRAME 4096     /// Samples per channel in each GCC-PHAT frame
+#define GCC_MAX_LAG 441    /// Largest delay searched, in samples (10 ms, about 3.4 m of path difference)
+#define GCC_SMOOTHING 0.7f /// Weight of the previous frames in the averaged cross spectrum
+
+/// Result of one delay update
+struct DelayEstimate
+{
+    double samples = 0;    /// Delay of the second input behind the first; negative if it leads
+    double seconds = 0;
+    float confidence = 0;  /// Height of the PHAT correlation peak, 0 to 1
+};
+
+/**
+ * ----------------------------
+ * ----class DelayEstimator----
+ * ----------------------------
+ * Arrival delay between two microphones by generalized cross-correlation with phase transform
+ * (GCC-PHAT). Both frames go through one packed transform of the shared FFTPlan; their cross
+ * spectrum is whitened to unit magnitude, so every frequency votes equally and reverberant or
+ * coloured sources still give a sharp peak, then averaged over recent frames and transformed
+ * back. Only lags within the search range are scanned, and a parabola through the peak gives the
+ * sub-sample delay. Every update costs two transforms of a fixed size.
+ */
+class DelayEstimator
+{
+private:
+    int frameSize;
+    int maxLag;
+    const FFTPlan &plan;
+    std::vector<float> window;
+    std::vector<float> framed;      /// Both windowed frames
+    std::vector<cmplx> spectrumA, spectrumB;
+    std::vector<cmplx> cross;       /// Averaged whitened cross spectrum, frameSize / 2 + 1 bins
+    std::vector<cmplx> correlation; /// Full-length transform buffer
+    bool primed = false;
+    DelayEstimate latest;
+
+public:
+    explicit DelayEstimator(int frameSize = GCC_FRAME, int maxLag = GCC_MAX_LAG); /// frameSize must be a power of two
+
+    int getFrameSize() const { return frameSize; }
+    const DelayEstimate &update(const sample *a, const sample *b); /// Reads frameSize samples of each input
+    const DelayEstimate &estimate() const { return latest; }
+    void reset();
+};
+
+#endif // DELAY_ESTIMATOR_H
@@ -0,0 +1,338 @@
+#include "featureMatrix.h"
+#include "fftPlan.h"
+#include "helper.h"
+#include "logger.h"
+#include "mfccExtractor.h"
+#include "wavFile.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+static const char matrixMagic[8] = {'A', 'D', 'S', 'P', 'F', 'M', '0', '1'};
+static const float chromaLowest = 55.0f;   // A1; lower bins are too coarse to tell pitch classes apart
+static const float chromaHighest = 5000.0f;
+static const double pitchC0 = 16.351597831287414;
+
+/// Layout of the start of a feature matrix file; the name blob, file starts and rows follow
+struct MatrixFileHeader
+{
+    char magic[8];
+    uint32_t dims;
+    uint32_t hop;
+    uint32_t fileCount;
+    uint32_t namesBytes; /// Null-terminated names, padded to a multiple of 8 bytes
+    uint64_t rows;
+};
+
+/**
+ * @brief Number of feature rows taken from n samples.
+ */
+static size_t rowsOf(size_t n)
+{
+    return n < SIMILARITY_FRAME ? 0 : (n - SIMILARITY_FRAME) / SIMILARITY_HOP + 1;
+}
+
+/**
+ * @brief Chroma and MFCC of successive frames of a stretch of audio.
+ *
+ * Frames are transformed two at a time with Stft::magnitudePair(), and both features come from
+ * the same power spectra. Chroma: the power of every bin between 55 Hz and 5 kHz is added to the
+ * pitch class nearest its frequency, and the twelve sums are scaled to unit length, so the
+ * profile follows harmony and not level. MFCC: MfccExtractor::cepstrum() of the spectra, keeping
+ * c1 to c12 scaled by SIMILARITY_MFCC_WEIGHT.
+ * @param audio Samples at RATE.
+ * @param n Number of samples.
+ * @param out Receives SIMILARITY_DIMS floats per row.
+ */
+void extractSimilarityFeatures(const sample *audio, size_t n, std::vector<float> &out)
+{
+    size_t rows = rowsOf(n);
+    out.assign(rows * SIMILARITY_DIMS, 0.0f);
+    if (rows == 0)
+        return;
+
+    Stft stft(SIMILARITY_FRAME);
+    MfccExtractor mfcc(SIMILARITY_FRAME, SIMILARITY_HOP, SIMILARITY_MFCC + 1, SIMILARITY_MEL_BANDS, 20.0f, 8000.0f);
+    int firstBin = static_cast<int>(std::ceil(chromaLowest * SIMILARITY_FRAME / RATE));
+    int lastBin = static_cast<int>(chromaHighest * SIMILARITY_FRAME / RATE);
+    std::vector<int> pitchClass(lastBin + 1, 0);
+    for (int k = firstBin; k <= lastBin; k++)
+        pitchClass[k] = static_cast<int>(std::lround(12.0 * std::log2(stft.binFrequency(k) / pitchC0))) % 12;
+
+    const int bins = stft.bins();
+    std::vector<float> power(2 * static_cast<size_t>(bins));
+    float cepstra[2 * (SIMILARITY_MFCC + 1)];
+    for (size_t r = 0; r < rows; r += 2)
+    {
+        int count = r + 1 < rows ? 2 : 1;
+        if (count == 2)
+            stft.magnitudePair(audio + r * SIMILARITY_HOP, audio + (r + 1) * SIMILARITY_HOP, power.data(), power.data() + bins);
+        else
+            stft.magnitude(audio + r * SIMILARITY_HOP, power.data());
+        for (int k = 0; k < count * bins; k++)
+            power[k] *= power[k];
+        mfcc.cepstrum(power.data(), count, cepstra);
+
+        for (int f = 0; f < count; f++)
+        {
+            const float *spectrum = power.data() + f * bins;
+            float *row = out.data() + (r + f) * SIMILARITY_DIMS;
+            for (int k = firstBin; k <= lastBin; k++)
+                row[pitchClass[k]] += spectrum[k];
+            float norm = 0;
+            for (int c = 0; c < SIMILARITY_CHROMA; c++)
+                norm += row[c] * row[c];
+            norm = norm > 1e-20f ? 1.0f / std::sqrt(norm) : 0.0f;
+            for (int c = 0; c < SIMILARITY_CHROMA; c++)
+                row[c] *= norm;
+
+            for (int c = 0; c < SIMILARITY_MFCC; c++)
+                row[SIMILARITY_CHROMA + c] = cepstra[f * (SIMILARITY_MFCC + 1) + c + 1] * SIMILARITY_MFCC_WEIGHT;
+        }
+    }
+}
+
+/**
+ * @brief Chroma and MFCC of a long stretch of audio, on several threads.
+ *
+ * Rows depend only on their own frame, so the audio is cut into runs of whole rows that workers
+ * extract in turn; the result equals the single-threaded one.
+ * @param audio Samples at RATE.
+ * @param n Number of samples.
+ * @param out Receives SIMILARITY_DIMS floats per row.
+ * @param threads Worker threads.
+ */
+void extractSimilarityFeatures(const sample *audio, size_t n, std::vector<float> &out, int threads)
+{
+    const size_t rows = rowsOf(n), run = 256;
+    out.assign(rows * SIMILARITY_DIMS, 0.0f);
+    std::atomic<size_t> next{0};
+    runWorkers(threads, [&]()
+               {
+                   std::vector<float> part;
+                   for (size_t first; (first = next.fetch_add(run)) < rows;)
+                   {
+                       size_t last = std::min(rows, first + run);
+                       extractSimilarityFeatures(audio + first * SIMILARITY_HOP, (last - 1 - first) * SIMILARITY_HOP + SIMILARITY_FRAME, part);
+                       std::copy(part.begin(), part.end(), out.begin() + first * SIMILARITY_DIMS);
+                   } });
+}
+
+/**
+ * @brief Converts feature rows to half floats and appends them, file after file.
+ *
+ * @param features SIMILARITY_DIMS floats per row for each file.
+ * @param starts Receives the first row of each file and then the total.
+ * @param rows Receives the half rows.
+ */
+static void packRows(const std::vector<std::vector<float>> &features, std::vector<uint64_t> &starts, std::vector<uint16_t> &rows)
+{
+    size_t total = 0;
+    for (const std::vector<float> &file : features)
+        total += file.size();
+    rows.resize(total);
+    starts.assign(1, 0);
+    size_t at = 0;
+    for (const std::vector<float> &file : features)
+    {
+        for (float value : file)
+            rows[at++] = floatToHalf(value);
+        starts.push_back(at / SIMILARITY_DIMS);
+    }
+}
+
+/**
+ * @brief Builds the matrix from WAV files, reading and analyzing them on several threads.
+ *
+ * Files that cannot be read are logged and kept as empty entries so file numbers match paths.
+ * @param paths WAV files; each is named after its file name.
+ * @param threads Worker threads; files are handed out one at a time.
+ */
+void FeatureMatrix::build(const std::vector<std::string> &paths, int threads)
+{
+    std::vector<std::vector<float>> features(paths.size());
+    std::atomic<size_t> next{0};
+    runWorkers(threads, [&]()
+               {
+                   for (size_t i; (i = next++) < paths.size();)
+                   {
+                       try
+                       {
+                           WavAudio audio = readWav(paths[i]);
+                           extractSimilarityFeatures(audio.samples.data(), audio.samples.size(), features[i]);
+                       }
+                       catch (const std::exception &e)
+                       {
+                           logMessage(std::string("Skipping file: ") + e.what(), "WARNING");
+                       }
+                   } });
+
+    std::vector<std::string> fileNames;
+    for (const std::string &path : paths)
+        fileNames.push_back(std::filesystem::path(path).filename().string());
+    setFeatures(fileNames, features);
+}
+
+/**
+ * @brief Fills the matrix with rows already extracted, one block per file.
+ *
+ * @param fileNames Name reported for each file.
+ * @param features SIMILARITY_DIMS floats per row for each file.
+ * @throws std::invalid_argument if the counts differ or a block is not a whole number of rows.
+ */
+void FeatureMatrix::setFeatures(const std::vector<std::string> &fileNames, const std::vector<std::vector<float>> &features)
+{
+    bool valid = fileNames.size() == features.size();
+    for (const std::vector<float> &file : features)
+        valid = valid && file.size() % SIMILARITY_DIMS == 0;
+    if (!valid)
+    {
+        logMessage("Feature matrix needs one name and whole rows of " + std::to_string(SIMILARITY_DIMS) + " features per file.", "ERROR");
+        throw std::invalid_argument("Feature matrix needs one name and whole rows of " + std::to_string(SIMILARITY_DIMS) + " features per file.");
+    }
+
+    mapped.reset();
+    names = fileNames;
+    packRows(features, fileStarts, ownedRows);
+    rows = ownedRows.data();
+    logMessage("Feature matrix holds " + std::to_string(rowCount()) + " rows of " + std::to_string(names.size()) + " files in " +
+                   std::to_string(bytes() >> 10) + " KiB.",
+               "INFO");
+}
+
+/**
+ * @brief Writes the matrix so load() can map it.
+ *
+ * @param path File to create or truncate.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void FeatureMatrix::save(const std::string &path) const
+{
+    std::string blob;
+    for (const std::string &name : names)
+        blob += name + '\0';
+    blob.resize((blob.size() + 7) & ~size_t(7), '\0');
+
+    MatrixFileHeader header = {};
+    std::memcpy(header.magic, matrixMagic, sizeof(matrixMagic));
+    header.dims = SIMILARITY_DIMS;
+    header.hop = SIMILARITY_HOP;
+    header.fileCount = static_cast<uint32_t>(names.size());
+    header.namesBytes = static_cast<uint32_t>(blob.size());
+    header.rows = rowCount();
+
+    std::vector<uint64_t> starts(fileStarts);
+    starts.resize(names.size() + 1, 0);
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+    out.write(reinterpret_cast<const char *>(starts.data()), static_cast<std::streamsize>(starts.size() * sizeof(uint64_t)));
+    if (rows)
+        out.write(reinterpret_cast<const char *>(rows), static_cast<std::streamsize>(bytes()));
+    if (!out)
+    {
+        logMessage("Cannot write feature matrix " + path, "ERROR");
+        throw std::runtime_error("Cannot write feature matrix " + path);
+    }
+}
+
+/**
+ * @brief Checks that a mapped matrix file is complete and self-consistent.
+ *
+ * Every name must end inside the names block and the file starts must rise from 0 to the row
+ * count, so fileOf() and the row accessors can trust the mapping.
+ * @param base Start of the mapped file.
+ * @param size Size of the file in bytes.
+ * @param header Receives the file header.
+ * @param fileNames Receives the file names.
+ * @return true if the file can be served as is.
+ */
+static bool parseMatrixFile(const uint8_t *base, size_t size, MatrixFileHeader &header, std::vector<std::string> &fileNames)
+{
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, base, sizeof(header));
+    size_t rest = size - sizeof(header);
+    if (std::memcmp(header.magic, matrixMagic, sizeof(matrixMagic)) != 0 || header.dims != SIMILARITY_DIMS || header.hop != SIMILARITY_HOP ||
+        header.namesBytes % sizeof(uint64_t) != 0 || header.namesBytes > rest ||
+        (uint64_t(header.fileCount) + 1) * sizeof(uint64_t) > rest - header.namesBytes ||
+        header.rows > (rest - header.namesBytes) / (SIMILARITY_DIMS * sizeof(uint16_t)) ||
+        rest != header.namesBytes + (uint64_t(header.fileCount) + 1) * sizeof(uint64_t) + header.rows * SIMILARITY_DIMS * sizeof(uint16_t))
+        return false;
+
+    const char *name = reinterpret_cast<const char *>(base + sizeof(header));
+    const char *namesEnd = name + header.namesBytes;
+    fileNames.clear();
+    for (uint32_t f = 0; f < header.fileCount; f++)
+    {
+        const char *terminator = static_cast<const char *>(std::memchr(name, '\0', namesEnd - name));
+        if (!terminator)
+            return false;
+        fileNames.emplace_back(name, terminator);
+        name = terminator + 1;
+    }
+
+    const uint64_t *starts = reinterpret_cast<const uint64_t *>(namesEnd);
+    if (starts[0] != 0 || starts[header.fileCount] != header.rows)
+        return false;
+    for (uint32_t f = 0; f < header.fileCount; f++)
+    {
+        if (starts[f] > starts[f + 1])
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Maps a matrix file written by save(); only the header and file table are read.
+ *
+ * The header, names and file starts are validated once before the mapping is accepted.
+ * @param path Matrix file.
+ * @throws std::runtime_error if the file cannot be mapped, is damaged or was written with other parameters.
+ */
+void FeatureMatrix::load(const std::string &path)
+{
+    std::unique_ptr<MappedFile> file(new MappedFile(path));
+    const uint8_t *base = file->data();
+    MatrixFileHeader header;
+    std::vector<std::string> fileNames;
+    if (!parseMatrixFile(base, file->size(), header, fileNames))
+    {
+        logMessage("Feature matrix " + path + " is damaged or was built with other parameters.", "ERROR");
+        throw std::runtime_error("Feature matrix " + path + " is damaged or was built with other parameters.");
+    }
+
+    mapped = std::move(file);
+    names = std::move(fileNames);
+    const uint64_t *starts = reinterpret_cast<const uint64_t *>(base + sizeof(header) + header.namesBytes);
+    fileStarts.assign(starts, starts + header.fileCount + 1);
+    rows = reinterpret_cast<const uint16_t *>(starts + header.fileCount + 1);
+    std::vector<uint16_t>().swap(ownedRows);
+    logMessage("Mapped feature matrix of " + std::to_string(names.size()) + " files from " + path, "INFO");
+}
+
+/**
+ * @brief File a row belongs to, by binary search of the file starts.
+ */
+int FeatureMatrix::fileOf(size_t r) const
+{
+    return static_cast<int>(std::upper_bound(fileStarts.begin(), fileStarts.end() - 1, static_cast<uint64_t>(r)) - fileStarts.begin()) - 1;
+}
+
+/**
+ * @brief Start of a row's frame in seconds from the start of its file.
+ */
+double FeatureMatrix::timeOf(size_t r) const
+{
+    return static_cast<double>(r - fileStarts[fileOf(r)]) * SIMILARITY_HOP / RATE;
+}
+
+/**
+ * @brief Hours of audio the rows cover.
+ */
+double FeatureMatrix::audioHours() const
+{
+    return static_cast<double>(rowCount()) * SIMILARITY_HOP / RATE / 3600;
+}
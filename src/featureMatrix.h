@@ -0,0 +1,95 @@
+#ifndef FEATURE_MATRIX_H
+#define FEATURE_MATRIX_H
+
+#include "audioProcessor.h"
+#include "mappedFile.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define SIMILARITY_FRAME 4096       /// STFT frame for chroma and MFCC (93 ms)
+#define SIMILARITY_HOP 4096         /// Samples between feature rows (10.8 rows per second)
+#define SIMILARITY_CHROMA 12        /// Pitch classes, C first
+#define SIMILARITY_MFCC 12          /// Cepstral coefficients c1 to c12; c0 follows the level and is left out
+#define SIMILARITY_DIMS 24          /// Chroma followed by MFCC
+#define SIMILARITY_MEL_BANDS 26     /// Mel bands under the cepstrum
+#define SIMILARITY_MFCC_WEIGHT 0.02f /// Scales dB cepstra to about the spread of the unit-length chroma
+
+/**
+ * @brief Converts a float to IEEE half precision, rounding to nearest even.
+ *
+ * Rebiases the exponent with one multiplication so normal and subnormal halves come out of the
+ * same shift. Values beyond the half range are clamped; NaN is not preserved.
+ */
+inline uint16_t floatToHalf(float value)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000u);
+    float magnitude = std::fmin(std::fabs(value), 65504.0f) * 1.92592994e-34f; // 2^-112
+    std::memcpy(&bits, &magnitude, sizeof(bits));
+    bits += 0x0FFFu + ((bits >> 13) & 1u);
+    return static_cast<uint16_t>(sign | (bits >> 13));
+}
+
+/**
+ * @brief Converts an IEEE half to float; exact for every finite half, and branch-free so loops over
+ * half rows vectorize.
+ */
+inline float halfToFloat(uint16_t half)
+{
+    uint32_t bits = static_cast<uint32_t>(half & 0x7FFFu) << 13;
+    float magnitude;
+    std::memcpy(&magnitude, &bits, sizeof(magnitude));
+    magnitude *= 5.19229686e33f; // 2^112
+    std::memcpy(&bits, &magnitude, sizeof(bits));
+    bits |= static_cast<uint32_t>(half & 0x8000u) << 16;
+    std::memcpy(&magnitude, &bits, sizeof(magnitude));
+    return magnitude;
+}
+
+void extractSimilarityFeatures(const sample *audio, size_t n, std::vector<float> &out); /// SIMILARITY_DIMS floats per row
+void extractSimilarityFeatures(const sample *audio, size_t n, std::vector<float> &out, int threads);
+
+/**
+ * ---------------------------
+ * ----class FeatureMatrix----
+ * ---------------------------
+ * Per-frame chroma and MFCC of a library of recordings, one row of SIMILARITY_DIMS half floats
+ * every SIMILARITY_HOP samples, all files back to back. The file written by save() is the matrix
+ * itself behind a short header and the file table, so load() maps it and hundreds of hours of
+ * audio are searchable without reading them in.
+ */
+class FeatureMatrix
+{
+private:
+    std::vector<std::string> names;
+    std::vector<uint64_t> fileStarts;  /// First row of each file, then the row count
+    std::vector<uint16_t> ownedRows;
+    const uint16_t *rows = nullptr;
+    std::unique_ptr<MappedFile> mapped; /// Holds rows after load()
+
+public:
+    FeatureMatrix() = default;
+    FeatureMatrix(const FeatureMatrix &) = delete;
+    FeatureMatrix &operator=(const FeatureMatrix &) = delete;
+
+    void build(const std::vector<std::string> &paths, int threads);                                    /// From WAV files
+    void setFeatures(const std::vector<std::string> &fileNames, const std::vector<std::vector<float>> &features); /// Rows already extracted
+    void save(const std::string &path) const;
+    void load(const std::string &path);
+
+    size_t rowCount() const { return fileStarts.empty() ? 0 : static_cast<size_t>(fileStarts.back()); }
+    const uint16_t *row(size_t r) const { return rows + r * SIMILARITY_DIMS; }
+    int fileCount() const { return static_cast<int>(names.size()); }
+    const std::string &fileName(int file) const { return names[file]; }
+    int fileOf(size_t r) const;        /// File a row belongs to
+    double timeOf(size_t r) const;     /// Seconds from the start of its file
+    double audioHours() const;
+    size_t bytes() const { return rowCount() * SIMILARITY_DIMS * sizeof(uint16_t); }
+};
+
+#endif // FEATURE_MATRIX_H
@@ -0,0 +1,269 @@
+#include "fftPlan.h"
+#include "logger.h"
+#include "sampleNotifier.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <stdexcept>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief Builds the bit-reversal table and twiddle factors for an n-point transform.
+ *
+ * @param n Transform size.
+ * @throws std::invalid_argument if n is not a power of two or exceeds 2^FFT_MAX_LOG2.
+ */
+FFTPlan::FFTPlan(int n) : n(n)
+{
+    if (n <= 0 || (n & (n - 1)) != 0 || n > (1 << FFT_MAX_LOG2))
+    {
+        logMessage("FFT plan size must be a power of two no larger than 2^" + std::to_string(FFT_MAX_LOG2) + ".", "ERROR");
+        throw std::invalid_argument("FFT plan size must be a power of two no larger than 2^" + std::to_string(FFT_MAX_LOG2) + ".");
+    }
+
+    bitReverse.resize(n);
+    for (int i = 0, j = 0; i < n; i++)
+    {
+        bitReverse[i] = j;
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+    }
+
+    twiddles.resize(n / 2 > 0 ? n / 2 : 1);
+    for (int k = 0; k < n / 2; k++)
+    {
+        twiddles[k] = std::polar(1.0, -2 * M_PI * k / n);
+    }
+}
+
+/**
+ * @brief Returns the shared plan for an n-point transform, building it on first use.
+ *
+ * Lookups are a single atomic load; only the first request for a size takes the lock.
+ * Plans live until the process exits.
+ * @param n Transform size.
+ * @return const FFTPlan& The shared plan.
+ * @throws std::invalid_argument if n is not a valid plan size.
+ */
+const FFTPlan &FFTPlan::get(int n)
+{
+    static std::atomic<const FFTPlan *> plans[FFT_MAX_LOG2 + 1];
+    static std::mutex buildMutex;
+
+    if (n <= 0 || (n & (n - 1)) != 0 || n > (1 << FFT_MAX_LOG2))
+    {
+        logMessage("FFT plan size must be a power of two no larger than 2^" + std::to_string(FFT_MAX_LOG2) + ".", "ERROR");
+        throw std::invalid_argument("FFT plan size must be a power of two no larger than 2^" + std::to_string(FFT_MAX_LOG2) + ".");
+    }
+
+    int log2n = 0;
+    while ((1 << log2n) < n)
+        log2n++;
+
+    const FFTPlan *plan = plans[log2n].load(std::memory_order_acquire);
+    if (plan)
+        return *plan;
+
+    std::lock_guard<std::mutex> lock(buildMutex);
+    plan = plans[log2n].load(std::memory_order_relaxed);
+    if (!plan)
+    {
+        plan = new FFTPlan(n);
+        plans[log2n].store(plan, std::memory_order_release);
+        logMessage("Built FFT plan for " + std::to_string(n) + " points.", "INFO");
+    }
+    return *plan;
+}
+
+/**
+ * @brief Runs the transform.
+ *
+ * @param output Array to store the result.
+ * @param input Input array; may be the same as output for an in-place transform.
+ */
+void FFTPlan::forward(cmplx *output, const cmplx *input) const
+{
+    // Bit-reversal permutation; swaps in place when output aliases input
+    for (int i = 0; i < n; i++)
+    {
+        int j = bitReverse[i];
+        if (output == input)
+        {
+            if (i < j)
+                std::swap(output[i], output[j]);
+        }
+        else
+        {
+            output[j] = input[i];
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1)
+    {
+        int half = len / 2, stride = n / len;
+        for (int k = 0; k < half; k++)
+        {
+            cmplx w = twiddles[k * stride];
+            for (int i = k; i < n; i += len)
+            {
+                cmplx t = w * output[i + half];
+                output[i + half] = output[i] - t;
+                output[i] += t;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Transforms two real sequences with one complex transform.
+ *
+ * Packs a into the real part and b into the imaginary part. Since the spectrum of a real
+ * sequence is conjugate symmetric, A(k) = (Z(k) + conj(Z(n - k))) / 2 and
+ * B(k) = (Z(k) - conj(Z(n - k))) / 2i separate the two again.
+ * @param a First real sequence of size() values.
+ * @param b Second real sequence of size() values.
+ * @param outputA Receives size() / 2 + 1 bins of the first spectrum.
+ * @param outputB Receives size() / 2 + 1 bins of the second spectrum.
+ * @param scratch Work array of size() values; may not alias either output.
+ */
+void FFTPlan::forwardRealPair(const float *a, const float *b, cmplx *outputA, cmplx *outputB, cmplx *scratch) const
+{
+    for (int i = 0; i < n; i++)
+    {
+        scratch[i] = cmplx(a[i], b[i]);
+    }
+    forward(scratch, scratch);
+
+    for (int k = 0; k <= n / 2; k++)
+    {
+        cmplx z = scratch[k], mirror = std::conj(scratch[(n - k) & (n - 1)]);
+        outputA[k] = 0.5 * (z + mirror);
+        outputB[k] = cmplx(0, -0.5) * (z - mirror);
+    }
+}
+
+/**
+ * @brief Memory held by the plan's tables, in bytes.
+ */
+size_t FFTPlan::memoryBytes() const
+{
+    return sizeof(*this) + bitReverse.capacity() * sizeof(int) + twiddles.capacity() * sizeof(cmplx);
+}
+
+/**
+ * @brief Constructor for Stft.
+ *
+ * @param frameSize Samples per frame.
+ * @throws std::invalid_argument if frameSize is not a power of two.
+ */
+Stft::Stft(int frameSize) : frameSize(frameSize), plan(FFTPlan::get(frameSize)), window(frameSize), buffer(frameSize)
+{
+    for (int i = 0; i < frameSize; i++)
+    {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * M_PI * i / frameSize));
+    }
+}
+
+/**
+ * @brief Computes the windowed magnitude spectrum of one frame.
+ *
+ * @param frame frameSize input samples.
+ * @param output Array of bins() magnitudes, normalized so a full-scale sine peaks near 1.
+ */
+void Stft::magnitude(const sample *frame, float *output)
+{
+    for (int i = 0; i < frameSize; i++)
+    {
+        buffer[i] = cmplx(frame[i] * window[i], 0);
+    }
+    plan.forward(buffer.data(), buffer.data());
+
+    const double scale = 4.0 / (static_cast<double>(frameSize) * (MAX_SAMPLE_VALUE + 1));
+    for (int i = 0; i < bins(); i++)
+    {
+        output[i] = static_cast<float>(std::abs(buffer[i]) * scale);
+    }
+}
+
+/**
+ * @brief Computes the windowed magnitude spectra of two frames, such as a stereo pair, with one transform.
+ *
+ * @param left frameSize input samples.
+ * @param right frameSize input samples.
+ * @param leftOutput Array of bins() magnitudes for left, normalized like magnitude().
+ * @param rightOutput Array of bins() magnitudes for right.
+ */
+void Stft::magnitudePair(const sample *left, const sample *right, float *leftOutput, float *rightOutput)
+{
+    if (pairInput.empty())
+    {
+        pairInput.resize(2 * static_cast<size_t>(frameSize));
+        pairSpectrum.resize(2 * static_cast<size_t>(bins()));
+    }
+    float *windowedLeft = pairInput.data(), *windowedRight = pairInput.data() + frameSize;
+    for (int i = 0; i < frameSize; i++)
+    {
+        windowedLeft[i] = left[i] * window[i];
+        windowedRight[i] = right[i] * window[i];
+    }
+    cmplx *leftSpectrum = pairSpectrum.data(), *rightSpectrum = pairSpectrum.data() + bins();
+    plan.forwardRealPair(windowedLeft, windowedRight, leftSpectrum, rightSpectrum, buffer.data());
+
+    const double scale = 4.0 / (static_cast<double>(frameSize) * (MAX_SAMPLE_VALUE + 1));
+    for (int i = 0; i < bins(); i++)
+    {
+        leftOutput[i] = static_cast<float>(std::abs(leftSpectrum[i]) * scale);
+        rightOutput[i] = static_cast<float>(std::abs(rightSpectrum[i]) * scale);
+    }
+}
+
+/**
+ * @brief Memory held by this instance, in bytes. The shared plan is not included.
+ */
+size_t Stft::memoryBytes() const
+{
+    return sizeof(*this) + (window.capacity() + pairInput.capacity()) * sizeof(float) + (buffer.capacity() + pairSpectrum.capacity()) * sizeof(cmplx);
+}
+
+/**
+ * @brief Picks the smallest frame that resolves every display column.
+ *
+ * The narrowest column sets the bin width needed: the first one for logarithmic spacing, any one
+ * for linear spacing. The frame is rounded up to a power of two, then capped by the latency
+ * budget and FFTLEN. Frames overlap by at least half, and the hop never exceeds ANALYSIS_HOP so a
+ * smaller frame also refreshes the display sooner.
+ * @param minFreq Lowest displayed frequency in Hz.
+ * @param maxFreq Highest displayed frequency in Hz.
+ * @param columns Display columns the range is spread over.
+ * @param logSpacing Whether columns are spaced logarithmically.
+ * @param latencyBudgetMs Longest frame allowed, in milliseconds.
+ * @return The frame size and hop.
+ * @throws std::invalid_argument if the range or column count is invalid.
+ */
+AnalysisPlan chooseAnalysisPlan(float minFreq, float maxFreq, int columns, bool logSpacing, float latencyBudgetMs)
+{
+    if (minFreq <= 0 || maxFreq <= minFreq || columns <= 0)
+    {
+        logMessage("Invalid display range for analysis plan.", "ERROR");
+        throw std::invalid_argument("Invalid display range for analysis plan.");
+    }
+
+    double columnHz = logSpacing ? minFreq * (std::pow(static_cast<double>(maxFreq) / minFreq, 1.0 / columns) - 1)
+                                 : (static_cast<double>(maxFreq) - minFreq) / columns;
+    double needed = RATE / columnHz;
+    double budget = latencyBudgetMs * RATE / 1000.0;
+
+    int size = FFT_MIN_DISPLAY;
+    while (size < needed && size < FFTLEN)
+        size *= 2;
+    while (size > budget && size > FFT_MIN_DISPLAY)
+        size /= 2;
+
+    AnalysisPlan plan = {size, std::min(size / 2, ANALYSIS_HOP)};
+    return plan;
+}
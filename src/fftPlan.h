@@ -0,0 +1,85 @@
+#ifndef FFT_PLAN_H
+#define FFT_PLAN_H
+
+#include "audioProcessor.h"
+#include <vector>
+
+#define FFT_MAX_LOG2 24           /// Largest cached transform is 2^FFT_MAX_LOG2 points
+#define FFT_MIN_DISPLAY 1024      /// Smallest frame chooseAnalysisPlan() returns
+#define FFT_LATENCY_BUDGET 1500   /// Default frame length budget in milliseconds; FFTLEN fits
+
+/**
+ * --------------------
+ * ----class FFTPlan----
+ * --------------------
+ * Precomputed bit-reversal table and twiddle factors for one transform size.
+ * Plans are immutable once built and shared by every thread through get(); looking up an
+ * existing plan is lock-free, so the steady-state analysis loop stays real-time safe.
+ */
+class FFTPlan
+{
+private:
+    int n;
+    std::vector<int> bitReverse; /// Destination index of each input sample
+    std::vector<cmplx> twiddles; /// exp(-2*pi*i*k/n) for k < n/2
+
+public:
+    explicit FFTPlan(int n); /// Builds a plan; n must be a power of two
+
+    static const FFTPlan &get(int n); /// Shared plan for size n, built on first use
+
+    int size() const { return n; }
+    void forward(cmplx *output, const cmplx *input) const; /// Output may alias input
+    void forwardRealPair(const float *a, const float *b, cmplx *outputA, cmplx *outputB, cmplx *scratch) const; /// Two real transforms in one
+    size_t memoryBytes() const;
+};
+
+/**
+ * -----------------
+ * ----class Stft----
+ * -----------------
+ * Windowed magnitude spectrum of successive frames. Holds the Hann window and scratch buffer for
+ * one frame size and borrows the shared FFTPlan, so one instance per analysis thread suffices.
+ */
+class Stft
+{
+private:
+    int frameSize;
+    const FFTPlan &plan;
+    std::vector<float> window;
+    std::vector<cmplx> buffer;
+    std::vector<float> pairInput;    /// Windowed left and right frames for magnitudePair()
+    std::vector<cmplx> pairSpectrum; /// Separated spectra for magnitudePair()
+
+public:
+    explicit Stft(int frameSize); /// frameSize must be a power of two
+
+    int getFrameSize() const { return frameSize; }
+    int bins() const { return frameSize / 2 + 1; }
+    float binFrequency(int bin) const { return static_cast<float>(bin) * RATE / frameSize; }
+
+    void magnitude(const sample *frame, float *output); /// Writes bins() magnitudes
+    void magnitudePair(const sample *left, const sample *right, float *leftOutput, float *rightOutput); /// Two frames for one transform
+    size_t memoryBytes() const;                          /// Per-instance memory, excluding the shared plan
+};
+
+/// Frame size and hop chosen for a display
+struct AnalysisPlan
+{
+    int fftSize; /// Power of two between FFT_MIN_DISPLAY and FFTLEN
+    int hop;     /// New samples between frames
+};
+
+/**
+ * chooseAnalysisPlan()
+ * Picks the smallest frame that gives every display column at least one bin across a range.
+ * @param minFreq: Lowest displayed frequency in Hz.
+ * @param maxFreq: Highest displayed frequency in Hz.
+ * @param columns: Display columns the range is spread over.
+ * @param logSpacing: Whether columns are spaced logarithmically (narrowest at minFreq) or linearly.
+ * @param latencyBudgetMs: Longest frame allowed, in milliseconds.
+ * @return The plan; its FFTPlan is built and cached by the first transform of that size.
+ */
+AnalysisPlan chooseAnalysisPlan(float minFreq, float maxFreq, int columns, bool logSpacing, float latencyBudgetMs = FFT_LATENCY_BUDGET);
+
+#endif // FFT_PLAN_H
@@ -0,0 +1,165 @@
+#include "filterbank.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Converts a frequency to the mel scale (O'Shaughnessy's formula).
+ *
+ * @param hz Frequency in Hz.
+ * @return float Pitch in mel.
+ */
+float hzToMel(float hz)
+{
+    return 2595.0f * std::log10(1.0f + hz / 700.0f);
+}
+
+/**
+ * @brief Converts mel back to a frequency; the inverse of hzToMel().
+ *
+ * @param mel Pitch in mel.
+ * @return float Frequency in Hz.
+ */
+float melToHz(float mel)
+{
+    return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+/**
+ * @brief Converts a frequency to the Bark scale (Traunmueller's formula).
+ *
+ * @param hz Frequency in Hz.
+ * @return float Critical-band rate in Bark.
+ */
+float hzToBark(float hz)
+{
+    return 26.81f * hz / (1960.0f + hz) - 0.53f;
+}
+
+/**
+ * @brief Converts Bark back to a frequency with Traunmueller's published inverse of hzToBark().
+ *
+ * @param bark Critical-band rate in Bark.
+ * @return float Frequency in Hz.
+ */
+float barkToHz(float bark)
+{
+    return 1960.0f * (bark + 0.53f) / (26.28f - bark);
+}
+
+/**
+ * @brief Builds the filterbank once; apply() then only reads it.
+ *
+ * Band edges are spaced evenly on the chosen scale between minFreq and maxFreq. A band too
+ * narrow to contain a bin falls back to the single nearest bin, so every band responds.
+ * @param numBands Number of bands.
+ * @param fftSize Frame size of the spectra that will be filtered; they have fftSize / 2 + 1 bins.
+ * @param minFreq Lower edge of the first band in Hz.
+ * @param maxFreq Upper edge of the last band in Hz.
+ * @param scale Mel or Bark spacing.
+ * @param rate Sample rate in Hz.
+ * @throws std::invalid_argument if the configuration is out of range.
+ */
+Filterbank::Filterbank(int numBands, int fftSize, float minFreq, float maxFreq, BandScale scale, int rate)
+    : bins(fftSize / 2 + 1)
+{
+    if (numBands <= 0 || fftSize <= 0 || minFreq < 0 || maxFreq <= minFreq || maxFreq > rate / 2.0f)
+    {
+        logMessage("Invalid filterbank configuration.", "ERROR");
+        throw std::invalid_argument("Invalid filterbank configuration.");
+    }
+
+    auto toScale = scale == BandScale::Mel ? hzToMel : hzToBark;
+    auto fromScale = scale == BandScale::Mel ? melToHz : barkToHz;
+    float lo = toScale(minFreq), hi = toScale(maxFreq);
+    float binWidth = static_cast<float>(rate) / fftSize;
+
+    std::vector<float> edges(numBands + 2);
+    for (int i = 0; i < numBands + 2; i++)
+        edges[i] = fromScale(lo + (hi - lo) * i / (numBands + 1));
+
+    bands.resize(numBands);
+    centers.resize(numBands);
+    for (int b = 0; b < numBands; b++)
+    {
+        float left = edges[b], center = edges[b + 1], right = edges[b + 2];
+        centers[b] = center;
+
+        int first = std::max(0, static_cast<int>(std::ceil(left / binWidth)));
+        int last = std::min(bins - 1, static_cast<int>(std::floor(right / binWidth)));
+        Band &band = bands[b];
+        band.offset = static_cast<int>(weights.size());
+        band.start = first;
+        for (int k = first; k <= last; k++)
+        {
+            float f = k * binWidth;
+            float w = f <= center ? (f - left) / (center - left) : (right - f) / (right - center);
+            weights.push_back(std::max(0.0f, w));
+        }
+        band.count = static_cast<int>(weights.size()) - band.offset;
+
+        float peak = 0;
+        for (int i = 0; i < band.count; i++)
+            peak = std::max(peak, weights[band.offset + i]);
+        if (peak == 0)
+        {
+            weights.resize(band.offset);
+            band.start = std::min(bins - 1, static_cast<int>(std::lround(center / binWidth)));
+            band.count = 1;
+            weights.push_back(1.0f);
+        }
+    }
+    weights.shrink_to_fit();
+}
+
+/**
+ * @brief Computes the energy in each band.
+ *
+ * Four independent accumulators keep the dot products free of a serial dependency, so the
+ * compiler can vectorize them without reassociating floating point sums on its own.
+ * @param power Power spectrum with inputBins() bins.
+ * @param output Array of size() band energies.
+ */
+void Filterbank::apply(const float *power, float *output) const
+{
+    const float *w = weights.data();
+    for (const Band &band : bands)
+    {
+        const float *p = power + band.start;
+        const float *bw = w + band.offset;
+        float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        int i = 0;
+        for (; i + 4 <= band.count; i += 4)
+        {
+            s0 += p[i] * bw[i];
+            s1 += p[i + 1] * bw[i + 1];
+            s2 += p[i + 2] * bw[i + 2];
+            s3 += p[i + 3] * bw[i + 3];
+        }
+        for (; i < band.count; i++)
+            s0 += p[i] * bw[i];
+        *output++ = (s0 + s1) + (s2 + s3);
+    }
+}
+
+/**
+ * @brief Computes the band energies in decibels, for display or as log-mel features.
+ *
+ * @param power Power spectrum with inputBins() bins.
+ * @param output Array of size() values in dB, at least -120.
+ */
+void Filterbank::applyLog(const float *power, float *output) const
+{
+    apply(power, output);
+    for (int b = 0; b < size(); b++)
+        output[b] = 10.0f * std::log10(std::max(output[b], 1e-12f));
+}
+
+/**
+ * @brief Memory held by the sparse filters, in bytes.
+ */
+size_t Filterbank::memoryBytes() const
+{
+    return sizeof(*this) + bands.capacity() * sizeof(Band) + weights.capacity() * sizeof(float) + centers.capacity() * sizeof(float);
+}
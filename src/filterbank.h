@@ -0,0 +1,60 @@
+#ifndef FILTERBANK_H
+#define FILTERBANK_H
+
+#include <cstddef>
+#include <vector>
+
+#define FILTERBANK_MIN_BANDS 24  /// Fewest bands the visualizer uses
+#define FILTERBANK_MAX_BANDS 128 /// Most bands the visualizer uses
+#define FILTERBANK_FFT 4096      /// Frame size of the filterbank visualizer
+#define FILTERBANK_RANGE_DB 60   /// Dynamic range shown by the filterbank visualizer
+
+/// Perceptual frequency scales
+enum class BandScale
+{
+    Mel,
+    Bark
+};
+
+float hzToMel(float hz);    /// O'Shaughnessy mel scale
+float melToHz(float mel);   /// Inverse of hzToMel
+float hzToBark(float hz);   /// Traunmueller Bark scale
+float barkToHz(float bark); /// Inverse of hzToBark
+
+/**
+ * ------------------------
+ * ----class Filterbank----
+ * ------------------------
+ * Triangular filters spaced evenly on the mel or Bark scale. Each band stores only the bins it
+ * covers (a start bin and a run of weights in one shared array), so applying the bank costs one
+ * short dot product per band instead of a dense bands-by-bins matrix product.
+ */
+class Filterbank
+{
+private:
+    /// The nonzero part of one triangular filter
+    struct Band
+    {
+        int start;  /// First bin with a nonzero weight
+        int count;  /// Number of weights
+        int offset; /// Index of the first weight in weights
+    };
+
+    std::vector<Band> bands;
+    std::vector<float> weights;
+    std::vector<float> centers; /// Centre frequency of each band in Hz
+    int bins;
+
+public:
+    Filterbank(int numBands, int fftSize, float minFreq, float maxFreq, BandScale scale = BandScale::Mel, int rate = 44100); /// Constructor
+
+    int size() const { return static_cast<int>(bands.size()); }
+    int inputBins() const { return bins; }
+    float centerFrequency(int band) const { return centers[band]; }
+
+    void apply(const float *power, float *output) const;    /// Band energies from a power spectrum of inputBins() bins
+    void applyLog(const float *power, float *output) const; /// Band energies in dB, floored at -120 dB
+    size_t memoryBytes() const;
+};
+
+#endif // FILTERBANK_H
@@ -0,0 +1,454 @@
+#include "fingerprint.h"
+#include "fftPlan.h"
+#include "helper.h"
+#include "logger.h"
+#include "wavFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+static const char indexMagic[8] = {'A', 'D', 'S', 'P', 'F', 'P', 'I', '1'};
+static const uint32_t frameBits = 32 - FINGERPRINT_TRACK_BITS;
+static const uint32_t frameMask = (1u << frameBits) - 1;
+static const size_t bucketCount = size_t(1) << FINGERPRINT_HASH_BITS;
+
+/// Layout of the start of an index file; the name blob, bucket table and postings follow
+struct IndexFileHeader
+{
+    char magic[8];
+    uint32_t hashBits;
+    uint32_t trackBits;
+    uint32_t trackCount;
+    uint32_t namesBytes; /// Null-terminated names, padded to a multiple of 8 bytes
+    uint64_t postingCount;
+    uint64_t audioFrames;
+};
+
+/**
+ * @brief Number of STFT frames landmark extraction takes from n samples.
+ */
+static uint64_t frameCount(size_t n)
+{
+    return n < FINGERPRINT_FRAME ? 0 : (n - FINGERPRINT_FRAME) / FINGERPRINT_HOP + 1;
+}
+
+/**
+ * @brief Extracts the landmarks of a stretch of audio.
+ *
+ * Peaks: in every frame, each of FINGERPRINT_BANDS log-spaced bands offers its strongest bin if
+ * it is a local maximum above the floor and above the band's threshold, which jumps to
+ * FINGERPRINT_MASK times each accepted peak and then decays, so a sustained tone is sampled
+ * now and then rather than in every frame. Landmarks: each peak is paired with up to
+ * FINGERPRINT_FANOUT later peaks inside its target zone.
+ * @param audio Samples at RATE.
+ * @param n Number of samples.
+ * @param out Receives the landmarks, ordered by anchor frame.
+ */
+void extractLandmarks(const sample *audio, size_t n, std::vector<Landmark> &out)
+{
+    out.clear();
+    uint64_t frames = frameCount(n);
+    if (frames == 0)
+        return;
+
+    Stft stft(FINGERPRINT_FRAME);
+    std::vector<float> magnitude(stft.bins());
+    int edges[FINGERPRINT_BANDS + 1];
+    for (int b = 0; b <= FINGERPRINT_BANDS; b++)
+        edges[b] = static_cast<int>(std::lround(FINGERPRINT_MIN_BIN * std::pow((FINGERPRINT_MAX_BIN + 1.0) / FINGERPRINT_MIN_BIN, static_cast<double>(b) / FINGERPRINT_BANDS)));
+    float threshold[FINGERPRINT_BANDS] = {0};
+
+    struct Peak
+    {
+        uint32_t frame;
+        int bin;
+    };
+    std::vector<Peak> peaks;
+    peaks.reserve(frames * 2);
+    for (uint64_t t = 0; t < frames; t++)
+    {
+        stft.magnitude(audio + t * FINGERPRINT_HOP, magnitude.data());
+        for (int b = 0; b < FINGERPRINT_BANDS; b++)
+        {
+            int best = edges[b];
+            for (int k = edges[b] + 1; k < edges[b + 1]; k++)
+            {
+                if (magnitude[k] > magnitude[best])
+                    best = k;
+            }
+            float m = magnitude[best];
+            threshold[b] *= FINGERPRINT_DECAY;
+            if (m > threshold[b] && m > FINGERPRINT_FLOOR && m >= magnitude[best - 1] && m >= magnitude[best + 1])
+            {
+                peaks.push_back({static_cast<uint32_t>(t), best});
+                threshold[b] = m * FINGERPRINT_MASK;
+            }
+        }
+    }
+
+    out.reserve(peaks.size() * FINGERPRINT_FANOUT);
+    for (size_t i = 0; i < peaks.size(); i++)
+    {
+        int made = 0;
+        for (size_t j = i + 1; j < peaks.size() && made < FINGERPRINT_FANOUT; j++)
+        {
+            uint32_t dt = peaks[j].frame - peaks[i].frame;
+            if (dt > FINGERPRINT_ZONE_FRAMES)
+                break;
+            int df = peaks[j].bin - peaks[i].bin;
+            if (dt == 0 || std::abs(df) > FINGERPRINT_ZONE_BINS)
+                continue;
+            uint32_t hash = static_cast<uint32_t>(peaks[i].bin) << 12 | static_cast<uint32_t>(df + 32) << 6 | dt;
+            out.push_back({hash, peaks[i].frame});
+            made++;
+        }
+    }
+}
+
+/**
+ * @brief Sorts the landmarks of every track into the bucket table and postings.
+ *
+ * A counting sort: one pass counts each bucket, a prefix sum turns the counts into offsets, and
+ * a second pass places the postings, so each bucket lists its tracks in order.
+ * @param tracks Landmarks of each track; released as they are placed.
+ */
+void FingerprintIndex::assemble(std::vector<std::vector<Landmark>> &tracks)
+{
+    mapped.reset();
+    ownedOffsets.assign(bucketCount + 1, 0);
+    for (const std::vector<Landmark> &track : tracks)
+        for (const Landmark &landmark : track)
+            ownedOffsets[landmark.hash + 1]++;
+    for (size_t b = 0; b < bucketCount; b++)
+        ownedOffsets[b + 1] += ownedOffsets[b];
+
+    ownedPostings.assign(ownedOffsets[bucketCount], 0);
+    std::vector<uint32_t> cursor(ownedOffsets.begin(), ownedOffsets.end() - 1);
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        for (const Landmark &landmark : tracks[t])
+            ownedPostings[cursor[landmark.hash]++] = static_cast<uint32_t>(t) << frameBits | landmark.frame;
+        std::vector<Landmark>().swap(tracks[t]);
+    }
+
+    offsets = ownedOffsets.data();
+    postings = ownedPostings.data();
+    postingCount = ownedPostings.size();
+    logMessage("Fingerprint index holds " + std::to_string(postingCount) + " landmarks of " + std::to_string(names.size()) + " tracks in " +
+                   std::to_string(indexBytes() >> 10) + " KiB (" + std::to_string(static_cast<size_t>(indexBytes() / std::max(audioHours(), 1e-9)) >> 20) + " MiB per hour).",
+               "INFO");
+}
+
+/**
+ * @brief Builds the index from tracks already in memory.
+ *
+ * @param trackNames Name reported for each track.
+ * @param tracks Mono samples of each track at RATE.
+ * @param threads Threads extracting landmarks; tracks are handed out one at a time.
+ * @throws std::invalid_argument if there are more tracks than postings can address.
+ */
+void FingerprintIndex::build(const std::vector<std::string> &trackNames, const std::vector<std::vector<sample>> &tracks, int threads)
+{
+    if (tracks.size() > (size_t(1) << FINGERPRINT_TRACK_BITS) || trackNames.size() != tracks.size())
+    {
+        logMessage("Fingerprint index needs one name per track and at most " + std::to_string(1 << FINGERPRINT_TRACK_BITS) + " tracks.", "ERROR");
+        throw std::invalid_argument("Fingerprint index needs one name per track and at most " + std::to_string(1 << FINGERPRINT_TRACK_BITS) + " tracks.");
+    }
+
+    std::vector<std::vector<Landmark>> landmarks(tracks.size());
+    std::atomic<size_t> next{0};
+    runWorkers(threads, [&]()
+               {
+                   for (size_t i; (i = next++) < tracks.size();)
+                       extractLandmarks(tracks[i].data(), tracks[i].size(), landmarks[i]); });
+
+    names = trackNames;
+    audioFrames = 0;
+    for (size_t t = 0; t < tracks.size(); t++)
+    {
+        audioFrames += frameCount(tracks[t].size());
+        if (frameCount(tracks[t].size()) > frameMask)
+            logMessage("Track " + names[t] + " is too long to index completely.", "WARNING");
+        landmarks[t].erase(std::remove_if(landmarks[t].begin(), landmarks[t].end(), [](const Landmark &l)
+                                          { return l.frame > frameMask; }),
+                           landmarks[t].end());
+    }
+    assemble(landmarks);
+}
+
+/**
+ * @brief Builds the index from WAV files, reading and analyzing them on several threads.
+ *
+ * Each worker reads one file, extracts its landmarks and drops the audio before taking the next,
+ * so only one file per thread is held in memory. Files that cannot be read are logged and
+ * indexed as empty.
+ * @param paths WAV files; each is named after its file name.
+ * @param threads Worker threads.
+ * @throws std::invalid_argument if there are more files than postings can address.
+ */
+void FingerprintIndex::buildFromFiles(const std::vector<std::string> &paths, int threads)
+{
+    if (paths.size() > (size_t(1) << FINGERPRINT_TRACK_BITS))
+    {
+        logMessage("Fingerprint index holds at most " + std::to_string(1 << FINGERPRINT_TRACK_BITS) + " tracks.", "ERROR");
+        throw std::invalid_argument("Fingerprint index holds at most " + std::to_string(1 << FINGERPRINT_TRACK_BITS) + " tracks.");
+    }
+
+    std::vector<std::vector<Landmark>> landmarks(paths.size());
+    std::vector<uint64_t> frames(paths.size(), 0);
+    std::atomic<size_t> next{0};
+    runWorkers(threads, [&]()
+               {
+                   for (size_t i; (i = next++) < paths.size();)
+                   {
+                       try
+                       {
+                           WavAudio audio = readWav(paths[i]);
+                           extractLandmarks(audio.samples.data(), audio.samples.size(), landmarks[i]);
+                           frames[i] = frameCount(audio.samples.size());
+                       }
+                       catch (const std::exception &e)
+                       {
+                           logMessage(std::string("Skipping track: ") + e.what(), "WARNING");
+                       }
+                   } });
+
+    names.clear();
+    audioFrames = 0;
+    for (size_t t = 0; t < paths.size(); t++)
+    {
+        names.push_back(std::filesystem::path(paths[t]).filename().string());
+        audioFrames += frames[t];
+        landmarks[t].erase(std::remove_if(landmarks[t].begin(), landmarks[t].end(), [](const Landmark &l)
+                                          { return l.frame > frameMask; }),
+                           landmarks[t].end());
+    }
+    assemble(landmarks);
+}
+
+/**
+ * @brief Writes the index so load() can map it.
+ *
+ * @param path File to create or truncate.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void FingerprintIndex::save(const std::string &path) const
+{
+    std::string blob;
+    for (const std::string &name : names)
+        blob += name + '\0';
+    blob.resize((blob.size() + 7) & ~size_t(7), '\0');
+
+    IndexFileHeader header = {};
+    std::memcpy(header.magic, indexMagic, sizeof(indexMagic));
+    header.hashBits = FINGERPRINT_HASH_BITS;
+    header.trackBits = FINGERPRINT_TRACK_BITS;
+    header.trackCount = static_cast<uint32_t>(names.size());
+    header.namesBytes = static_cast<uint32_t>(blob.size());
+    header.postingCount = postingCount;
+    header.audioFrames = audioFrames;
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+    if (offsets)
+    {
+        out.write(reinterpret_cast<const char *>(offsets), static_cast<std::streamsize>((bucketCount + 1) * sizeof(uint32_t)));
+        out.write(reinterpret_cast<const char *>(postings), static_cast<std::streamsize>(postingCount * sizeof(uint32_t)));
+    }
+    if (!out)
+    {
+        logMessage("Cannot write fingerprint index " + path, "ERROR");
+        throw std::runtime_error("Cannot write fingerprint index " + path);
+    }
+}
+
+/**
+ * @brief Checks that a mapped index file is complete and self-consistent.
+ *
+ * Every name must end inside the names block, the bucket offsets must rise from 0 to the posting
+ * count, and every posting must name an existing track, so query() can trust the mapping.
+ * @param base Start of the mapped file.
+ * @param size Size of the file in bytes.
+ * @param header Receives the file header.
+ * @param trackNames Receives the track names.
+ * @return true if the file can be served as is.
+ */
+static bool parseIndexFile(const uint8_t *base, size_t size, IndexFileHeader &header, std::vector<std::string> &trackNames)
+{
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, base, sizeof(header));
+    size_t words = (size - sizeof(header)) / sizeof(uint32_t);
+    if (std::memcmp(header.magic, indexMagic, sizeof(indexMagic)) != 0 || header.hashBits != FINGERPRINT_HASH_BITS ||
+        header.trackBits != FINGERPRINT_TRACK_BITS || header.trackCount > (uint64_t(1) << FINGERPRINT_TRACK_BITS) ||
+        header.postingCount > words || header.namesBytes > size - sizeof(header) ||
+        size != sizeof(header) + header.namesBytes + (bucketCount + 1 + header.postingCount) * sizeof(uint32_t))
+        return false;
+
+    const char *name = reinterpret_cast<const char *>(base + sizeof(header));
+    const char *namesEnd = name + header.namesBytes;
+    trackNames.clear();
+    for (uint32_t t = 0; t < header.trackCount; t++)
+    {
+        const char *terminator = static_cast<const char *>(std::memchr(name, '\0', namesEnd - name));
+        if (!terminator)
+            return false;
+        trackNames.emplace_back(name, terminator);
+        name = terminator + 1;
+    }
+
+    const uint32_t *offsets = reinterpret_cast<const uint32_t *>(namesEnd);
+    if (offsets[0] != 0 || offsets[bucketCount] != header.postingCount)
+        return false;
+    for (size_t b = 0; b < bucketCount; b++)
+    {
+        if (offsets[b] > offsets[b + 1])
+            return false;
+    }
+    const uint32_t *postings = offsets + bucketCount + 1;
+    for (uint64_t p = 0; p < header.postingCount; p++)
+    {
+        if ((postings[p] >> frameBits) >= header.trackCount)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Maps an index file written by save() and serves queries straight from the mapping.
+ *
+ * The header, track names, bucket table and postings are validated once before the mapping is
+ * accepted; after that queries read it without further checks.
+ * @param path Index file.
+ * @throws std::runtime_error if the file cannot be mapped, is damaged or was written with other parameters.
+ */
+void FingerprintIndex::load(const std::string &path)
+{
+    std::unique_ptr<MappedFile> file(new MappedFile(path));
+    const uint8_t *base = file->data();
+    IndexFileHeader header;
+    std::vector<std::string> trackNames;
+    if (!parseIndexFile(base, file->size(), header, trackNames))
+    {
+        logMessage("Fingerprint index " + path + " is damaged or was built with other parameters.", "ERROR");
+        throw std::runtime_error("Fingerprint index " + path + " is damaged or was built with other parameters.");
+    }
+
+    mapped = std::move(file);
+    names = std::move(trackNames);
+    audioFrames = header.audioFrames;
+    offsets = reinterpret_cast<const uint32_t *>(base + sizeof(header) + header.namesBytes);
+    postings = offsets + bucketCount + 1;
+    postingCount = static_cast<size_t>(header.postingCount);
+    std::vector<uint32_t>().swap(ownedOffsets);
+    std::vector<uint32_t>().swap(ownedPostings);
+    logMessage("Mapped fingerprint index of " + std::to_string(names.size()) + " tracks from " + path, "INFO");
+}
+
+/**
+ * @brief Finds the track and position a clip was taken from.
+ *
+ * Every posting that shares a hash with a query landmark votes for its track at the offset
+ * between the two anchor frames. The votes are sorted, and each (track, offset) is scored with
+ * the votes of its two neighbouring offsets as well, since a query rarely starts on the same
+ * hop grid as the reference.
+ * @param audio Samples at RATE.
+ * @param n Number of samples; a few seconds is plenty.
+ * @return The best match, or track -1 if none has FINGERPRINT_MIN_VOTES votes.
+ */
+FingerprintMatch FingerprintIndex::query(const sample *audio, size_t n) const
+{
+    FingerprintMatch match;
+    std::vector<Landmark> landmarks;
+    extractLandmarks(audio, n, landmarks);
+    match.landmarks = static_cast<int>(landmarks.size());
+    if (!offsets)
+        return match;
+
+    const int64_t bias = int64_t(1) << frameBits;
+    std::vector<uint64_t> votes;
+    for (const Landmark &landmark : landmarks)
+    {
+        for (uint32_t p = offsets[landmark.hash]; p < offsets[landmark.hash + 1]; p++)
+        {
+            uint64_t track = postings[p] >> frameBits;
+            int64_t offset = static_cast<int64_t>(postings[p] & frameMask) - landmark.frame;
+            votes.push_back(track << 32 | static_cast<uint64_t>(offset + bias));
+        }
+    }
+    std::sort(votes.begin(), votes.end());
+
+    struct Run
+    {
+        uint64_t key;
+        int count;
+    };
+    std::vector<Run> runs;
+    for (size_t i = 0; i < votes.size();)
+    {
+        size_t j = i;
+        while (j < votes.size() && votes[j] == votes[i])
+            j++;
+        runs.push_back({votes[i], static_cast<int>(j - i)});
+        i = j;
+    }
+    for (size_t r = 0; r < runs.size(); r++)
+    {
+        int score = runs[r].count;
+        if (r > 0 && runs[r - 1].key + 1 == runs[r].key)
+            score += runs[r - 1].count;
+        if (r + 1 < runs.size() && runs[r + 1].key == runs[r].key + 1)
+            score += runs[r + 1].count;
+        if (score > match.votes)
+        {
+            match.votes = score;
+            match.track = static_cast<int>(runs[r].key >> 32);
+            match.offsetSeconds = static_cast<double>(static_cast<int64_t>(runs[r].key & 0xFFFFFFFFu) - bias) * FINGERPRINT_HOP / RATE;
+        }
+    }
+
+    if (match.votes < FINGERPRINT_MIN_VOTES)
+        match.track = -1;
+    else
+        match.name = names[match.track];
+    return match;
+}
+
+/**
+ * @brief Answers many queries on several threads.
+ *
+ * @param clips Audio of each query.
+ * @param threads Worker threads; clips are handed out one at a time.
+ * @return One match per clip, in order.
+ */
+std::vector<FingerprintMatch> FingerprintIndex::queryBatch(const std::vector<std::vector<sample>> &clips, int threads) const
+{
+    std::vector<FingerprintMatch> matches(clips.size());
+    std::atomic<size_t> next{0};
+    runWorkers(threads, [&]()
+               {
+                   for (size_t i; (i = next++) < clips.size();)
+                       matches[i] = query(clips[i].data(), clips[i].size()); });
+    return matches;
+}
+
+/**
+ * @brief Bytes of the bucket table and postings, in memory or mapped.
+ */
+size_t FingerprintIndex::indexBytes() const
+{
+    return offsets ? (bucketCount + 1 + postingCount) * sizeof(uint32_t) : 0;
+}
+
+/**
+ * @brief Hours of reference audio in the index.
+ */
+double FingerprintIndex::audioHours() const
+{
+    return static_cast<double>(audioFrames) * FINGERPRINT_HOP / RATE / 3600;
+}
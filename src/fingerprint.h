@@ -0,0 +1,92 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include "audioProcessor.h"
+#include "mappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FINGERPRINT_FRAME 2048       /// STFT frame for peak extraction (46 ms)
+#define FINGERPRINT_HOP 512          /// Samples between frames (11.6 ms)
+#define FINGERPRINT_MIN_BIN 6        /// Lowest peak bin (130 Hz)
+#define FINGERPRINT_MAX_BIN 255      /// Highest peak bin (5.5 kHz); anchor bins fill 8 bits of the hash
+#define FINGERPRINT_BANDS 6          /// Log-spaced bands that each give at most one peak per frame
+#define FINGERPRINT_MASK 1.5f        /// A peak raises its band's threshold to this multiple of itself
+#define FINGERPRINT_DECAY 0.97f      /// Per-frame decay of the band thresholds
+#define FINGERPRINT_FLOOR 1e-4f      /// Quietest peak kept (-80 dB, Stft magnitude units)
+#define FINGERPRINT_FANOUT 5         /// Landmarks formed by each anchor peak
+#define FINGERPRINT_ZONE_FRAMES 63   /// Furthest target frame after the anchor (6 bits of the hash)
+#define FINGERPRINT_ZONE_BINS 31     /// Furthest target bin above or below the anchor (6 bits of the hash)
+#define FINGERPRINT_HASH_BITS 20     /// Bits of a landmark hash, and log2 of the index's bucket count
+#define FINGERPRINT_TRACK_BITS 12    /// Bits of a posting that store the track (up to 4096 tracks)
+#define FINGERPRINT_MIN_VOTES 8      /// Aligned landmarks needed to report a match
+#define FINGERPRINT_QUERY FFTLEN     /// Samples of live audio in each identification query
+
+/// A pair of spectral peaks reduced to a hash, and the frame of its anchor
+struct Landmark
+{
+    uint32_t hash;
+    uint32_t frame;
+};
+
+/// Best track for a query
+struct FingerprintMatch
+{
+    int track = -1;          /// -1 if no track reached FINGERPRINT_MIN_VOTES
+    std::string name;
+    double offsetSeconds = 0; /// Position in the track where the query starts
+    int votes = 0;           /// Landmarks agreeing on that track and offset
+    int landmarks = 0;       /// Landmarks extracted from the query
+};
+
+void extractLandmarks(const sample *audio, size_t n, std::vector<Landmark> &out); /// Peak constellation to landmark hashes
+
+/**
+ * ------------------------------
+ * ----class FingerprintIndex----
+ * ------------------------------
+ * Identifies which reference track a clip comes from. Each track is reduced to landmarks: pairs
+ * of prominent spectral peaks hashed from the anchor's bin, the bin difference and the frame
+ * difference, which survive noise, equalization and level changes. The index is an inverted
+ * file in compressed sparse row form: a table of 2^FINGERPRINT_HASH_BITS bucket offsets and one
+ * packed 32-bit posting (track, anchor frame) per landmark, sorted by hash. A query looks up
+ * each of its landmarks and votes for (track, track frame - query frame); a true match piles its
+ * votes onto a single offset. The two tables are written to disk as they sit in memory, so
+ * load() maps the file instead of rebuilding or parsing it.
+ */
+class FingerprintIndex
+{
+private:
+    std::vector<std::string> names;
+    uint64_t audioFrames = 0;      /// STFT frames of reference audio indexed
+    std::vector<uint32_t> ownedOffsets, ownedPostings;
+    const uint32_t *offsets = nullptr;  /// Bucket starts, 2^FINGERPRINT_HASH_BITS + 1 entries
+    const uint32_t *postings = nullptr; /// Track in the top FINGERPRINT_TRACK_BITS, anchor frame below
+    size_t postingCount = 0;
+    std::unique_ptr<MappedFile> mapped; /// Holds offsets and postings after load()
+
+    void assemble(std::vector<std::vector<Landmark>> &tracks);
+
+public:
+    FingerprintIndex() = default;
+    FingerprintIndex(const FingerprintIndex &) = delete;
+    FingerprintIndex &operator=(const FingerprintIndex &) = delete;
+
+    void build(const std::vector<std::string> &trackNames, const std::vector<std::vector<sample>> &tracks, int threads); /// From audio in memory
+    void buildFromFiles(const std::vector<std::string> &paths, int threads);                                             /// From WAV files
+    void save(const std::string &path) const;
+    void load(const std::string &path); /// Maps a file written by save()
+
+    FingerprintMatch query(const sample *audio, size_t n) const;
+    std::vector<FingerprintMatch> queryBatch(const std::vector<std::vector<sample>> &clips, int threads) const;
+
+    int trackCount() const { return static_cast<int>(names.size()); }
+    const std::string &trackName(int track) const { return names[track]; }
+    size_t landmarkCount() const { return postingCount; }
+    size_t indexBytes() const;   /// Size of the bucket table and postings
+    double audioHours() const;   /// Reference audio indexed
+};
+
+#endif // FINGERPRINT_H
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <thread>
 
 /**
  * @brief Validates the size of an input against a threshold.
@@ -257,3 +258,30 @@ int pitchName(char *name, int pitch_num, bool logOnce)
     logMessage("Computed pitch name: " + pitch + " for pitch number: " + std::to_string(pitch_num), "INFO", logOnce);
     return pitch.size();
 }
+
+/**
+ * @brief Runs a job on several threads, the calling thread included, and waits for all of them.
+ *
+ * The job is expected to take work items from a shared atomic counter until none are left.
+ * @param threads Total number of threads running the job.
+ * @param job The work loop.
+ * @throws Whatever job() throws on the calling thread, once the other threads have finished.
+ */
+void runWorkers(int threads, const std::function<void()> &job)
+{
+    std::vector<std::thread> workers;
+    try
+    {
+        for (int i = 1; i < threads; i++)
+            workers.emplace_back(job);
+        job();
+    }
+    catch (...)
+    {
+        for (std::thread &worker : workers) // A joinable thread destroyed on unwind would terminate
+            worker.join();
+        throw;
+    }
+    for (std::thread &worker : workers)
+        worker.join();
+}
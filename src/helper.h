@@ -2,6 +2,7 @@
 #define HELPER_H
 
 #include <cmath>
+#include <functional>
 #include <stdexcept>
 #include "audioProcessor.h"
 
@@ -16,5 +17,6 @@ float approx_hcf(float inputs[], int num_inputs, bool logOnce, int max_iter = 5,
 void Find_n_Largest(int *output, sample *input, int n_out, int n_in, bool logOnce, bool ignore_clumped = true);
 int pitchNumber(float freq, bool logOnce, float *centsSharp = nullptr);
 int pitchName(char *name, int pitch_num, bool logOnce);
+void runWorkers(int threads, const std::function<void()> &job);
 
 #endif
@@ -0,0 +1,181 @@
+#include "jitterBuffer.h"
+#include "logger.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+/**
+ * @brief Constructs a JitterBuffer.
+ *
+ * @param capacity Ring capacity in samples.
+ * @param minTarget Smallest target distance between write and read pointers.
+ * @param maxTarget Largest target distance; caps the monitoring latency.
+ * @throws std::invalid_argument if the bounds are inconsistent or do not fit in the ring.
+ */
+JitterBuffer::JitterBuffer(int capacity, int minTarget, int maxTarget)
+    : len(capacity), written(0), readPos(0), anchored(false), minTarget(minTarget), maxTarget(maxTarget), target(minTarget),
+      smoothedDistance(minTarget), windowMin(INT_MAX), windowMax(0), windowCallbacks(0), stableWindows(0), underrunInWindow(false),
+      publishedTarget(minTarget), publishedDistance(minTarget), underruns(0), drops(0), inserts(0)
+{
+    if (minTarget <= 0 || maxTarget < minTarget || capacity < 4 * maxTarget)
+    {
+        logMessage("Invalid jitter buffer bounds.", "ERROR");
+        throw std::invalid_argument("Jitter buffer needs 0 < minTarget <= maxTarget <= capacity / 4.");
+    }
+    audio = new sample[len]();
+    logMessage("JitterBuffer created with capacity: " + std::to_string(capacity) + ", target range: " + std::to_string(minTarget) + "-" + std::to_string(maxTarget), "INFO");
+}
+
+/**
+ * @brief Destructor for JitterBuffer.
+ */
+JitterBuffer::~JitterBuffer()
+{
+    delete[] audio;
+}
+
+/**
+ * @brief Appends captured samples. Called from the recording callback.
+ *
+ * @param input Array of input samples.
+ * @param n_samples Number of samples to write.
+ */
+void JitterBuffer::write(const sample *input, int n_samples)
+{
+    long long pos = written.load(std::memory_order_relaxed);
+    for (int i = 0; i < n_samples; i++)
+    {
+        audio[(pos + i) % len] = input[i];
+    }
+    written.store(pos + n_samples, std::memory_order_release);
+}
+
+/**
+ * @brief Raises the target distance, bounded by maxTarget.
+ *
+ * @param amount Number of samples to add.
+ */
+void JitterBuffer::widen(int amount)
+{
+    target = std::min(target + amount, maxTarget);
+    stableWindows = 0;
+    publishedTarget.store(target, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Adapts the target to the jitter measured over the last window.
+ *
+ * The target must cover one callback plus the observed spread of distances. It widens
+ * immediately when the spread grows and narrows by an eighth of the excess per window
+ * once enough windows passed without an underrun.
+ * @param callbackSamples Size of the playback callback.
+ */
+void JitterBuffer::endWindow(int callbackSamples)
+{
+    int jitter = windowMax - windowMin;
+    int desired = std::clamp(callbackSamples + jitter, minTarget, maxTarget);
+
+    stableWindows = underrunInWindow ? 0 : stableWindows + 1;
+    if (desired > target)
+        widen(desired - target);
+    else if (desired < target && stableWindows >= MONITOR_STABLE_WINDOWS)
+        target -= std::max(1, (target - desired) / 8);
+
+    publishedTarget.store(target, std::memory_order_relaxed);
+    windowMin = INT_MAX;
+    windowMax = 0;
+    windowCallbacks = 0;
+    underrunInWindow = false;
+}
+
+/**
+ * @brief Produces playback samples. Called from the playback callback.
+ *
+ * Plays silence until the writer is target samples ahead. On underrun it plays silence
+ * without advancing, which lets the distance grow, and widens the target. When the
+ * smoothed distance strays more than half a CHUNK from the target, one sample is dropped
+ * or repeated and the jump is hidden by a MONITOR_CROSSFADE-sample crossfade.
+ * @param output Array to store the output samples.
+ * @param n_samples Number of samples to produce.
+ * @param volume Volume multiplier to apply to the output samples.
+ */
+void JitterBuffer::read(sample *output, int n_samples, float volume)
+{
+    long long pos = written.load(std::memory_order_acquire);
+    if (!anchored)
+    {
+        if (pos < target + n_samples)
+        {
+            std::memset(output, 0, n_samples * sizeof(sample));
+            return;
+        }
+        readPos = pos - target;
+        smoothedDistance = target;
+        anchored = true;
+    }
+
+    long long distance = pos - readPos;
+    if (distance > len - n_samples) // Writer lapped us; start over behind it
+    {
+        readPos = pos - target;
+        distance = target;
+    }
+    if (distance < n_samples)
+    {
+        std::memset(output, 0, n_samples * sizeof(sample));
+        underruns.fetch_add(1, std::memory_order_relaxed);
+        underrunInWindow = true;
+        widen(CHUNK);
+        return;
+    }
+
+    windowMin = std::min(windowMin, static_cast<int>(distance));
+    windowMax = std::max(windowMax, static_cast<int>(distance));
+    smoothedDistance += (distance - smoothedDistance) / 64;
+
+    int step = 0; // +1 drops a sample, -1 repeats one
+    if (smoothedDistance > target + CHUNK / 2 && distance > n_samples)
+        step = 1;
+    else if (smoothedDistance < target - CHUNK / 2)
+        step = -1;
+
+    int fade = std::min(n_samples, MONITOR_CROSSFADE);
+    for (int i = 0; i < n_samples; i++)
+    {
+        float value = audio[(readPos + i + step) % len];
+        if (step != 0 && i < fade)
+        {
+            float a = (i + 1.0f) / (fade + 1);
+            value = (1 - a) * audio[(readPos + i) % len] + a * value;
+        }
+        output[i] = value * volume;
+    }
+    readPos += n_samples + step;
+
+    if (step > 0)
+        drops.fetch_add(1, std::memory_order_relaxed);
+    else if (step < 0)
+        inserts.fetch_add(1, std::memory_order_relaxed);
+
+    publishedDistance.store(static_cast<int>(smoothedDistance), std::memory_order_relaxed);
+    if (++windowCallbacks >= MONITOR_WINDOW)
+        endWindow(n_samples);
+}
+
+/**
+ * @brief Returns the current monitoring statistics.
+ *
+ * Latency counts the buffered distance plus one CHUNK in each device buffer.
+ * @return MonitorStats A snapshot of the statistics.
+ */
+MonitorStats JitterBuffer::stats() const
+{
+    MonitorStats s;
+    s.targetSamples = publishedTarget.load(std::memory_order_relaxed);
+    s.latencyMs = (publishedDistance.load(std::memory_order_relaxed) + 2.0 * CHUNK) * 1000.0 / RATE;
+    s.underruns = underruns.load(std::memory_order_relaxed);
+    s.drops = drops.load(std::memory_order_relaxed);
+    s.inserts = inserts.load(std::memory_order_relaxed);
+    return s;
+}
@@ -0,0 +1,61 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include "audioProcessor.h"
+#include <atomic>
+
+#define MONITOR_CROSSFADE 32     /// Samples crossfaded when a sample is dropped or inserted
+#define MONITOR_WINDOW 128       /// Playback callbacks per jitter measurement window
+#define MONITOR_STABLE_WINDOWS 8 /// Underrun-free windows before the target starts narrowing
+
+/// Snapshot of the monitoring path, safe to read from any thread
+struct MonitorStats
+{
+    int targetSamples;  /// Current target distance between write and read pointers
+    double latencyMs;   /// Estimated capture-to-playback round-trip latency
+    int underruns;      /// Callbacks that found too little data
+    int drops;          /// Samples dropped to correct drift
+    int inserts;        /// Samples inserted to correct drift
+};
+
+/**
+ * -------------------------
+ * ----class JitterBuffer----
+ * -------------------------
+ * Single-producer/single-consumer buffer for low-latency monitoring. The playback read
+ * pointer follows the capture write pointer at a target distance that widens after an
+ * underrun and slowly narrows while callbacks are stable. Clock drift between the two
+ * devices is absorbed by dropping or inserting one sample under a short crossfade.
+ * write() and read() are real-time safe.
+ */
+class JitterBuffer
+{
+private:
+    int len;                          /// Capacity in samples
+    sample *audio;                    /// Ring storage
+    std::atomic<long long> written;   /// Total samples written (capture thread)
+    long long readPos;                /// Absolute read position (playback thread)
+    bool anchored;                    /// Whether readPos has been placed behind the writer
+    int minTarget, maxTarget, target; /// Target distance bounds and current value
+    float smoothedDistance;           /// Exponential average of the distance at callback start
+    int windowMin, windowMax;         /// Distance extremes in the current window
+    int windowCallbacks;              /// Callbacks observed in the current window
+    int stableWindows;                /// Consecutive windows without underrun
+    bool underrunInWindow;
+
+    std::atomic<int> publishedTarget, publishedDistance;
+    std::atomic<int> underruns, drops, inserts;
+
+    void widen(int amount);
+    void endWindow(int callbackSamples);
+
+public:
+    JitterBuffer(int capacity = 65536, int minTarget = 2 * CHUNK, int maxTarget = 32 * CHUNK); /// Constructor
+    ~JitterBuffer();                                                                          /// Destructor
+
+    void write(const sample *input, int n_samples);               /// Capture side
+    void read(sample *output, int n_samples, float volume = 1);   /// Playback side
+    MonitorStats stats() const;                                   /// Current statistics
+};
+
+#endif // JITTER_BUFFER_H
@@ -1,90 +1,33 @@
 #include "logger.h"
 #include "visualizer.h"
+#include "audioDevice.h"
+#include "scheduling.h"
+#include "captureEngine.h"
+#include "analysisServer.h"
+#include "delayEstimator.h"
+#include "fingerprint.h"
+#include "similaritySearch.h"
+#include "selfSimilarity.h"
+#include "takeAlignment.h"
+#include "wavFile.h"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <iomanip>
 #include <filesystem>
+#include <memory>
 #include <math.h>
 #include <complex>
 #include <windows.h>
-#include <conio.h>
 #include <climits>
+#include <cstdlib>
+#include <ctime>
 #include <SDL2/SDL.h>
 
-#define REFRESH_TIME 10 // Refresh rate in milliseconds
-
-float echoVolume;                    // Echo playback volume
-AudioQueue MainAudioQueue(10000000); // Main AudioQueue for recording and playback
-
-/**
- * @brief Callback for recording audio data.
- *
- * Pushes audio samples from the recording stream into the MainAudioQueue.
- * @param userdata Unused user data pointer.
- * @param stream Pointer to the audio stream buffer.
- * @param streamLength Length of the audio stream buffer in bytes.
- */
-void RecCallback(void *userdata, Uint8 *stream, int streamLength)
-{
-    Uint32 length = (Uint32)streamLength;
-    MainAudioQueue.push((sample *)stream, length / sizeof(sample));
-}
-
-/**
- * @brief Callback for playing back audio data.
- *
- * Pops audio samples from the MainAudioQueue and writes them to the playback stream.
- * @param userdata Unused user data pointer.
- * @param stream Pointer to the audio stream buffer.
- * @param streamLength Length of the audio stream buffer in bytes.
- */
-void PlayCallback(void *userdata, Uint8 *stream, int streamLength)
-{
-    Uint32 length = (Uint32)streamLength;
-    MainAudioQueue.pop((sample *)stream, length / sizeof(sample), ::echoVolume);
-}
-
-/**
- * @brief Initializes SDL audio devices for recording and playback.
- *
- * Sets up the SDL audio system, configures recording and playback devices, and starts audio processing.
- * @param RecDevice Reference to the recording audio device ID.
- * @param PlayDevice Reference to the playback audio device ID.
- * @throws std::runtime_error if initialization fails for either recording or playback device.
- */
-void InitializeAudio(SDL_AudioDeviceID &RecDevice, SDL_AudioDeviceID &PlayDevice)
-{
-    SDL_Init(SDL_INIT_AUDIO); // Initialize SDL audio
-    logMessage("Initializing SDL audio", "INFO");
-
-    SDL_AudioSpec RecSpec{}, PlaySpec{};
-    RecSpec.freq = RATE;
-    RecSpec.format = AUDIO_S16SYS;
-    RecSpec.samples = CHUNK;
-    RecSpec.callback = RecCallback; // Callback for recording
-    RecSpec.channels = 1;
-
-    PlaySpec = RecSpec;
-    PlaySpec.callback = PlayCallback;
-
-    RecDevice = SDL_OpenAudioDevice(NULL, 1, &RecSpec, NULL, 0);
-    PlayDevice = SDL_OpenAudioDevice(NULL, 0, &PlaySpec, NULL, 0);
-
-    if (PlayDevice <= 0)
-    {
-        logMessage("Failed to open playback device: " + std::string(SDL_GetError()), "ERROR");
-        throw std::runtime_error("Failed to open playback device: " + std::string(SDL_GetError()));
-    }
-    if (RecDevice <= 0)
-    {
-        logMessage("Failed to open recording device: " + std::string(SDL_GetError()), "ERROR");
-        throw std::runtime_error("Failed to open recording device: " + std::string(SDL_GetError()));
-    }
-
-    SDL_PauseAudioDevice(RecDevice, 0);  // Start recording
-    SDL_Delay(2000);                     // Fill audio buffer
-    SDL_PauseAudioDevice(PlayDevice, 0); // Start playback
-
-    logMessage("Audio devices initialized successfully", "INFO");
-}
+#define SESSION_TIME 600000 // Milliseconds before a visualizer session ends on its own
+#define IDLE_TIMEOUT 500     // Longest sleep without new audio, in milliseconds
+#define SOURCE_FRAME 4096    // Samples per source in each aligned multi-device frame
+#define LOOKBACK_SECONDS 30  // Seconds of history the 's' key saves
 
 /**
  * @brief Prompts the user for input and validates the range.
@@ -137,6 +80,8 @@ void runVisualizer(int choice, int lim1, int lim2, bool adaptive, int consoleWid
     SemilogVisualizer semilogVis;
     LinearVisualizer linearVis;
     LoglogVisualizer loglogVis;
+    static FilterbankVisualizer melVis(BandScale::Mel); // Static so the filterbank is built once
+    static FilterbankVisualizer barkVis(BandScale::Bark);
 
     switch (choice)
     {
@@ -162,13 +107,49 @@ void runVisualizer(int choice, int lim1, int lim2, bool adaptive, int consoleWid
     case 10:
         ChordGuesser(MainAudioQueue, logOnce);
         break;
+    case 11:
+        melVis.visualize(MainAudioQueue, lim1, lim2, consoleWidth, consoleHeight, adaptive, logOnce);
+        break;
+    case 12:
+        barkVis.visualize(MainAudioQueue, lim1, lim2, consoleWidth, consoleHeight, adaptive, logOnce);
+        break;
+    case 13:
+        if (OctaveFilterbank *bank = OctaveBank.load())
+            OctaveBandDisplay(*bank, consoleWidth, consoleHeight, logOnce);
+        break;
     default:
         logMessage("Invalid visualizer option selected", "ERROR");
         throw std::invalid_argument("Invalid visualizer option");
     }
-    SDL_Delay(REFRESH_TIME);
 }
 
+/**
+ * @brief Closes the audio devices and detaches everything the recording callback writes into.
+ *
+ * main() declares it after the objects the callback reaches through History, FileHistory,
+ * OctaveBank and DefaultCapture, so however the session ends, including by an exception, the
+ * devices are closed before those objects are destroyed.
+ */
+struct AudioSession
+{
+    SDL_AudioDeviceID &rec, &play;
+
+    ~AudioSession() { close(); }
+
+    void close()
+    {
+        if (play > 0)
+            SDL_CloseAudioDevice(play); // Returns once the callback has finished
+        if (rec > 0)
+            SDL_CloseAudioDevice(rec);
+        rec = play = 0;
+        History = nullptr;
+        FileHistory = nullptr;
+        OctaveBank.store(nullptr);
+        DefaultCapture.store(nullptr);
+    }
+};
+
 /**
  * @brief Displays the main menu and prompts the user to select an option.
  *
@@ -192,39 +173,413 @@ int displayMenu()
               << "\n\nMusic Algorithms\n----------------"
               << "\n9 . Pitch recognition (automatic tuner)"
               << "\n10. Chord Guesser"
+              << "\n\nPerceptual Bands (Adaptive)\n---------------------------"
+              << "\n11. Mel filterbank"
+              << "\n12. Bark filterbank"
+              << "\n\nLow Latency\n-----------"
+              << "\n13. Third-octave band levels (IIR)"
+              << "\n14. Stereo correlation and goniometer (needs --capture-devices 1)"
+              << "\n\nDescriptors\n-----------"
+              << "\n15. Spectral centroid, rolloff, flatness, flux and band energies"
+              << "\n16. Identify the playing track (needs --fingerprint-dir or --fingerprint-index)"
+              << "\n17. Find similar passages (needs --similarity-dir or --similarity-index)"
+              << "\n\nSession\n-------"
+              << "\n18. Zoomable spectrogram of everything heard so far"
+              << "\n19. Practice report for the last hour (needs --results-dir)"
               << "\n\nEnter choice: ";
-    return getValidatedInput("", 1, 10);
+    return getValidatedInput("", 1, 19);
 }
 
 /**
- * @brief Captures a single key press from the user.
+ * @brief Prints and logs the monitoring latency when the jitter buffer target or the latency changes.
  *
- * Checks for and returns a character if a key is pressed.
- * @return The captured character, or 0 if no key is pressed.
+ * Called after every redraw, so an unchanged status is not printed again under the display.
+ * @param lastTarget The last target distance reported; updated on change.
+ * @param lastLatencyMs The last latency reported, in whole milliseconds; updated on change.
  */
-char capture_button_press()
+void reportMonitoring(int &lastTarget, int &lastLatencyMs)
 {
-    if (_kbhit())
-        return getch();
-    return 0;
+    MonitorStats stats = MonitorBuffer.stats();
+    int latencyMs = static_cast<int>(std::lround(stats.latencyMs));
+    if (stats.targetSamples == lastTarget && latencyMs == lastLatencyMs)
+        return;
+    std::cout << "Monitoring latency: " << stats.latencyMs << " ms (target " << stats.targetSamples << " samples, "
+              << stats.underruns << " underruns, " << stats.drops << " drops, " << stats.inserts << " inserts)\n";
+    if (stats.targetSamples != lastTarget)
+        logMessage("Monitoring target " + std::to_string(stats.targetSamples) + " samples, round-trip latency " + std::to_string(stats.latencyMs) + " ms", "INFO");
+    lastTarget = stats.targetSamples;
+    lastLatencyMs = latencyMs;
+}
+
+/**
+ * @brief Analyzes the newest aligned frame from the extra capture devices and prints their levels.
+ *
+ * @param engine The capture engine; its level node fills levels.
+ * @param levels RMS level of each source in dBFS, from the last aligned frame.
+ * @param delay Arrival delay of source 1 behind source 0, or nullptr with fewer than two sources.
+ */
+void reportCaptureSources(CaptureEngine &engine, const std::vector<double> &levels, const DelayEstimator *delay)
+{
+    if (!engine.process(SOURCE_FRAME))
+        return;
+    std::cout << "Sources:";
+    for (int i = 0; i < engine.sourceCount(); i++)
+        std::cout << "  [" << i << "] " << static_cast<int>(levels[i]) << " dB";
+    if (delay)
+    {
+        const DelayEstimate &estimate = delay->estimate();
+        std::cout << "  delay " << std::fixed << std::setprecision(2) << estimate.seconds * 1000 << " ms ("
+                  << std::setprecision(1) << estimate.samples << " samples, confidence " << std::setprecision(2)
+                  << estimate.confidence << ")" << std::defaultfloat;
+    }
+    std::cout << "\n";
+}
+
+/**
+ * @brief Saves the last LOOKBACK_SECONDS of captured audio to a WAV file named after the time.
+ *
+ * The memory-mapped file history is read in place through a span; the compressed history is
+ * decoded instead when it is the only one. Must run on the thread that compresses the history.
+ * @param history Compressed history, or nullptr.
+ * @param fileHistory File-backed history, or nullptr; preferred when both are kept.
+ */
+void saveLookback(CaptureHistory *history, const MappedHistory *fileHistory)
+{
+    std::vector<sample> audio;
+    if (fileHistory)
+    {
+        uint64_t end = fileHistory->newestPosition();
+        uint64_t start = std::max(fileHistory->oldestPosition(), end - std::min<uint64_t>(end, static_cast<uint64_t>(LOOKBACK_SECONDS) * RATE));
+        HistorySpan view = fileHistory->span(start, static_cast<size_t>(end - start));
+        audio.assign(view.first, view.first + view.firstCount);
+        audio.insert(audio.end(), view.second, view.second + view.secondCount);
+        if (!fileHistory->stillValid(start))
+            audio.clear();
+    }
+    else if (history)
+    {
+        uint64_t end = history->newestPosition();
+        uint64_t start = std::max(history->oldestPosition(), end - std::min<uint64_t>(end, static_cast<uint64_t>(LOOKBACK_SECONDS) * RATE));
+        audio.resize(static_cast<size_t>(end - start));
+        if (!history->read(start, audio.data(), static_cast<int>(audio.size())))
+            audio.clear();
+    }
+    if (audio.empty())
+    {
+        logMessage("No lookback history to save; start with --history-mb or --history-file.", "WARNING");
+        return;
+    }
+
+    char path[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(path, sizeof(path), "lookback-%Y%m%d-%H%M%S.wav", std::localtime(&now));
+    writeWav(path, audio.data(), audio.size());
+    logMessage("Saved " + std::to_string(audio.size() / RATE) + " s of lookback history to " + path, "INFO");
+    std::cout << "Saved " << audio.size() / RATE << " s to " << path << "\n";
+}
+
+/**
+ * @brief Lists the WAV files in a directory, sorted by path.
+ *
+ * @param directory Directory to scan; subdirectories are not entered.
+ * @return Paths of the .wav files.
+ */
+std::vector<std::string> wavFilesIn(const std::string &directory)
+{
+    std::vector<std::string> paths;
+    for (const auto &entry : std::filesystem::directory_iterator(directory))
+    {
+        std::string extension = entry.path().extension().string();
+        if (entry.is_regular_file() && (extension == ".wav" || extension == ".WAV"))
+            paths.push_back(entry.path().string());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
 }
 
 /**
  * @brief Entry point of the application.
  *
  * Initializes audio, displays the menu, and handles user input and visualization.
+ * Pass --monitor for low-latency monitoring instead of the 2 second echo, and
+ * --latency-ceiling MS to let the device buffer size adapt up to that round-trip latency.
+ * --analysis-cpu N, --render-cpu N, --rt-policy fifo|rr, --rt-priority N and --mlock control
+ * thread placement, audio thread scheduling and memory locking; on Windows only the first three
+ * are accepted, --rt-policy raising the audio threads to THREAD_PRIORITY_TIME_CRITICAL. --hop N sets how many
+ * new samples wake the analysis loop; otherwise the spectrum displays pick their own FFT size and
+ * hop from the frequency range, capped by --latency-budget MS. --capture-devices N additionally captures from up to N
+ * more microphones in one engine, together with the default one, and reports their time-aligned levels. --server PIPE... runs the pitch
+ * and chord detectors headless over raw PCM pipes instead, with --workers N analysis threads.
+ * --history-mb N keeps a compressed capture history of up to N MB for after-the-fact analysis;
+ * --history-file PATH keeps the last --history-hours H (default 1) raw in a memory-mapped file.
+ * With either, 's' during a session saves the last LOOKBACK_SECONDS to a timestamped WAV file.
+ * --features-csv PATH appends the spectral descriptors of every frame of the feature display to a CSV file.
+ * --fingerprint-dir DIR indexes the WAV files in DIR for track identification; --fingerprint-index PATH
+ * maps a saved index instead, or saves the one just built there. --similarity-dir DIR and
+ * --similarity-index PATH do the same for the chroma/MFCC feature matrix behind the similar-passage
+ * search; its inverted file is kept next to it as PATH.ivf. --overview-file PATH continues the
+ * session overview spectrogram stored there and saves it on exit. --results-dir DIR records pitch,
+ * cents, chord, RMS and onsets every RESULTS_HOP samples in the column store in DIR.
+ * --sections FILE prints where the sections of a WAV recording begin, using --workers threads, and exits.
+ * --align REFERENCE TAKE prints a time map of the WAV take onto the WAV reference, one line of
+ * reference and take seconds per feature frame, and exits.
  * @param argc Number of command-line arguments.
  * @param argv Array of command-line arguments.
  * @return Exit status of the application.
  */
 int main(int argc, char **argv)
 {
-    SDL_AudioDeviceID RecDevice, PlayDevice;
+    SDL_AudioDeviceID RecDevice = 0, PlayDevice = 0;
+    bool monitoring = false;
+    int latencyCeiling = 0; // 0 keeps the fixed CHUNK buffer
+    int captureDevices = 0; // Extra synchronized capture sources
+    int historyMb = 0;      // Compressed history budget; 0 disables it
+    bool fixedHop = false;  // --hop given, so keep it instead of following the analysis plan
+    std::string historyFile;
+    double historyHours = 1;
+    std::string featuresCsv;
+    std::string fingerprintDir, fingerprintIndex;
+    std::string similarityDir, similarityIndex;
+    std::string overviewFile;
+    std::string resultsDir;
+    std::string sectionsFile;
+    std::string alignReference, alignTake;
+    std::vector<std::string> serverPipes;
+    int serverWorkers = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+    SchedulingOptions scheduling;
 
     try
     {
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--monitor")
+                monitoring = true;
+            else if (arg == "--latency-ceiling" && i + 1 < argc)
+            {
+                latencyCeiling = std::atoi(argv[++i]);
+                int lowest = static_cast<int>(std::ceil(2 * chunkPeriodMs(CHUNK)));
+                if (latencyCeiling < lowest)
+                    throw std::invalid_argument("--latency-ceiling must be at least " + std::to_string(lowest) + " ms, the round trip of two " +
+                                                std::to_string(CHUNK) + "-sample buffers");
+            }
+            else if (arg == "--hop" && i + 1 < argc)
+            {
+                AnalysisNotifier.setHop(std::atoi(argv[++i]));
+                fixedHop = true;
+            }
+            else if (arg == "--latency-budget" && i + 1 < argc)
+            {
+                char *end = nullptr;
+                double budget = std::strtod(argv[++i], &end);
+                double lowest = FFT_MIN_DISPLAY * 1000.0 / RATE;
+                if (end == argv[i] || *end != '\0' || !std::isfinite(budget) || budget < lowest)
+                    throw std::invalid_argument("--latency-budget must be a number of at least " + std::to_string(lowest) +
+                                                " ms, the length of the smallest " + std::to_string(FFT_MIN_DISPLAY) + "-sample frame");
+                Visualizer::latencyBudgetMs = static_cast<float>(budget);
+            }
+            else if (arg == "--capture-devices" && i + 1 < argc)
+                captureDevices = std::atoi(argv[++i]);
+            else if (arg == "--history-mb" && i + 1 < argc)
+                historyMb = std::atoi(argv[++i]);
+            else if (arg == "--history-file" && i + 1 < argc)
+                historyFile = argv[++i];
+            else if (arg == "--history-hours" && i + 1 < argc)
+                historyHours = std::atof(argv[++i]);
+            else if (arg == "--features-csv" && i + 1 < argc)
+                featuresCsv = argv[++i];
+            else if (arg == "--fingerprint-dir" && i + 1 < argc)
+                fingerprintDir = argv[++i];
+            else if (arg == "--fingerprint-index" && i + 1 < argc)
+                fingerprintIndex = argv[++i];
+            else if (arg == "--similarity-dir" && i + 1 < argc)
+                similarityDir = argv[++i];
+            else if (arg == "--similarity-index" && i + 1 < argc)
+                similarityIndex = argv[++i];
+            else if (arg == "--overview-file" && i + 1 < argc)
+                overviewFile = argv[++i];
+            else if (arg == "--results-dir" && i + 1 < argc)
+                resultsDir = argv[++i];
+            else if (arg == "--sections" && i + 1 < argc)
+                sectionsFile = argv[++i];
+            else if (arg == "--align" && i + 2 < argc)
+            {
+                alignReference = argv[++i];
+                alignTake = argv[++i];
+            }
+            else if (arg == "--workers" && i + 1 < argc)
+                serverWorkers = std::atoi(argv[++i]);
+            else if (arg == "--server")
+            {
+                while (i + 1 < argc && argv[i + 1][0] != '-')
+                    serverPipes.push_back(argv[++i]);
+                if (serverPipes.empty())
+                    throw std::invalid_argument("--server needs at least one PCM pipe");
+            }
+            else if (!parseSchedulingArgument(scheduling, i, argc, argv))
+                logMessage("Ignoring unknown argument: " + arg, "WARNING");
+        }
+
         logMessage("Application started", "INFO");
-        InitializeAudio(RecDevice, PlayDevice);
+        if (!serverPipes.empty())
+        {
+            runAnalysisServer(serverPipes, serverWorkers);
+            logMessage("Application terminated successfully", "INFO");
+            return 0;
+        }
+        if (!sectionsFile.empty())
+        {
+            WavAudio audio = readWav(sectionsFile);
+            std::vector<double> boundaries = sectionBoundaries(audio.samples.data(), audio.samples.size(), serverWorkers);
+            std::cout << sectionsFile << ": " << boundaries.size() + 1 << " sections over " << static_cast<int>(audio.seconds()) << " s\n";
+            for (double seconds : boundaries)
+                std::cout << "  " << static_cast<int>(seconds) / 60 << ":" << std::setw(2) << std::setfill('0') << static_cast<int>(seconds) % 60 << std::setfill(' ') << "\n";
+            logMessage("Application terminated successfully", "INFO");
+            return 0;
+        }
+        if (!alignReference.empty())
+        {
+            WavAudio reference = readWav(alignReference), take = readWav(alignTake);
+            std::vector<std::pair<double, double>> map = alignTakes(reference.samples.data(), reference.samples.size(), take.samples.data(),
+                                                                    take.samples.size(), serverWorkers);
+            std::cout << "# " << alignReference << " (" << static_cast<int>(reference.seconds()) << " s) -> " << alignTake << " ("
+                      << static_cast<int>(take.seconds()) << " s)\n"
+                      << std::fixed << std::setprecision(2);
+            for (const std::pair<double, double> &point : map)
+                std::cout << point.first << "\t" << point.second << "\n";
+            logMessage("Application terminated successfully", "INFO");
+            return 0;
+        }
+        if (scheduling.lockMemory)
+            lockProcessMemory();
+        pinCurrentThread(scheduling.analysisCpu, scheduling.renderCpu); // The main thread analyzes and renders
+        requestAudioThreadPolicy(scheduling.audioPolicy, scheduling.audioPriority);
+
+        std::unique_ptr<CaptureHistory> history;
+        if (historyMb > 0)
+        {
+            history.reset(new CaptureHistory(static_cast<size_t>(historyMb) << 20));
+            History = history.get();
+        }
+        std::unique_ptr<MappedHistory> fileHistory;
+        if (!historyFile.empty())
+        {
+            fileHistory.reset(new MappedHistory(historyFile, static_cast<uint64_t>(historyHours * 3600 * RATE)));
+            FileHistory = fileHistory.get();
+        }
+
+        std::unique_ptr<FingerprintIndex> fingerprints;
+        if (!fingerprintIndex.empty() && std::filesystem::exists(fingerprintIndex))
+        {
+            fingerprints.reset(new FingerprintIndex());
+            fingerprints->load(fingerprintIndex);
+        }
+        else if (!fingerprintDir.empty())
+        {
+            std::vector<std::string> paths = wavFilesIn(fingerprintDir);
+            std::cout << "Indexing " << paths.size() << " tracks with " << serverWorkers << " threads...\n";
+            fingerprints.reset(new FingerprintIndex());
+            fingerprints->buildFromFiles(paths, serverWorkers);
+            if (!fingerprintIndex.empty())
+                fingerprints->save(fingerprintIndex);
+        }
+
+        FeatureMatrix similarityFeatures;
+        std::unique_ptr<SimilarityIndex> similarity;
+        if (!similarityIndex.empty() && std::filesystem::exists(similarityIndex))
+        {
+            similarityFeatures.load(similarityIndex);
+            similarity.reset(new SimilarityIndex(similarityFeatures));
+            if (std::filesystem::exists(similarityIndex + ".ivf"))
+                similarity->load(similarityIndex + ".ivf");
+            else
+                similarity->train(0, serverWorkers);
+        }
+        else if (!similarityDir.empty())
+        {
+            std::vector<std::string> paths = wavFilesIn(similarityDir);
+            std::cout << "Extracting similarity features of " << paths.size() << " files with " << serverWorkers << " threads...\n";
+            similarityFeatures.build(paths, serverWorkers);
+            similarity.reset(new SimilarityIndex(similarityFeatures));
+            similarity->train(0, serverWorkers);
+            if (!similarityIndex.empty() && similarity->trained())
+            {
+                similarityFeatures.save(similarityIndex);
+                similarity->save(similarityIndex + ".ivf");
+            }
+        }
+
+        std::unique_ptr<SpectrogramPyramid> overview(new SpectrogramPyramid());
+        if (!overviewFile.empty() && std::filesystem::exists(overviewFile))
+        {
+            overview->load(overviewFile);
+            if (overview->bins() != PYRAMID_BANDS)
+            {
+                logMessage("Overview " + overviewFile + " has other bands; starting a new one.", "WARNING");
+                overview.reset(new SpectrogramPyramid());
+            }
+        }
+        uint64_t overviewSpan = 0; // Columns shown by the overview; 0 shows the whole session
+        std::unique_ptr<ColumnStore> results;
+        if (!resultsDir.empty())
+            results.reset(new ColumnStore(resultsDir, resultsColumns()));
+
+        // Everything the audio callbacks reach through globals is declared before the session guard
+        CaptureEngine captureEngine;
+        std::vector<double> sourceLevels;
+        StereoMeter stereoMeter;       // Fed by the first two capture sources
+        DelayEstimator delayEstimator; // Likewise
+        double stereoFedUntil = 0;     // Timeline end of the samples the stereo meter has seen
+        OctaveFilterbank octaveBank;   // Fed by the recording callback only while its display runs
+        AudioSession audio{RecDevice, PlayDevice};
+
+        InitializeAudio(RecDevice, PlayDevice, monitoring);
+        describeAudioThreadPolicy("Recording", RecThreadPolicy);
+        describeAudioThreadPolicy("Playback", PlayThreadPolicy);
+        logMessage("Analysis/render thread: " + describeCurrentThread(), "INFO");
+        int monitorTarget = 0, monitorLatencyMs = -1;
+        std::unique_ptr<BufferSizeController> bufferController;
+        if (latencyCeiling > 0)
+            bufferController.reset(new BufferSizeController(latencyCeiling));
+
+        if (captureDevices > 0)
+        {
+            int shared = captureEngine.addSource("default"); // RecDevice already holds the default device; RecCallback feeds it
+            captureEngine.openAllDevices(captureDevices, true);
+            DefaultCapture.store(&captureEngine.source(shared), std::memory_order_release);
+            sourceLevels.assign(captureEngine.sourceCount(), -96.0);
+            captureEngine.addNode([&sourceLevels](const AlignedFrame &frame)
+                                  {
+                                      for (size_t c = 0; c < frame.channels.size(); c++)
+                                      {
+                                          double energy = 0;
+                                          for (int i = 0; i < frame.length; i++)
+                                              energy += static_cast<double>(frame.channels[c][i]) * frame.channels[c][i];
+                                          double rms = std::sqrt(energy / frame.length) / 32768.0;
+                                          sourceLevels[c] = rms > 1.6e-5 ? 20 * std::log10(rms) : -96.0; // Floor at -96 dBFS
+                                      } });
+            if (captureEngine.sourceCount() >= 2)
+            {
+                captureEngine.addNode([&stereoMeter, &stereoFedUntil](const AlignedFrame &frame)
+                                      {
+                                          // Successive frames overlap; accumulate only the samples not seen yet
+                                          double end = frame.time + static_cast<double>(frame.length) / RATE;
+                                          int fresh = static_cast<int>(std::min<long>(frame.length, std::lround((end - stereoFedUntil) * RATE)));
+                                          if (fresh > 0)
+                                              stereoMeter.process(frame.channels[0] + frame.length - fresh, frame.channels[1] + frame.length - fresh, fresh);
+                                          stereoFedUntil = std::max(stereoFedUntil, end); });
+                captureEngine.addNode([&delayEstimator](const AlignedFrame &frame)
+                                      {
+                                          if (frame.length >= delayEstimator.getFrameSize())
+                                              delayEstimator.update(frame.channels[0], frame.channels[1]); });
+            }
+            captureEngine.start();
+        }
+
+        std::unique_ptr<FeatureCsvExporter> featureExporter;
+        if (!featuresCsv.empty())
+            featureExporter.reset(new FeatureCsvExporter(featuresCsv));
+        int analysisHop = AnalysisNotifier.getHop();
 
         int choice, lowerFreq, upperFreq;
         bool adaptive = false;
@@ -233,39 +588,130 @@ int main(int argc, char **argv)
         system("cls");
         choice = displayMenu();
 
-        if (choice < 7)
+        if (choice < 7 || choice == 11 || choice == 12)
         {
             lowerFreq = getValidatedInput("Enter lower frequency limit: ", 20, 10000);
             upperFreq = getValidatedInput("Enter upper frequency limit: ", lowerFreq + 1, 20000);
         }
 
         echoVolume = getValidatedInput("Enter echo volume (0 = no echo): ", 0, 100);
+        OctaveBank.store(choice == 13 ? &octaveBank : nullptr);
         logMessage("Running visualizer with choice: " + std::to_string(choice), "INFO");
 
         CONSOLE_SCREEN_BUFFER_INFO csbi;
         int consoleWidth, consoleHeight;
 
-        std::cout << "\nStarting... Press 'x' to exit or 'm' to return to menu.\n";
+        int hop = analysisHop;
+        if (choice == 13)
+            hop = OCTAVE_DISPLAY_HOP; // Redraw as often as the levels change
+        else if (choice < 7 && !fixedHop)
+        {
+            GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
+            AnalysisPlan plan = chooseAnalysisPlan(lowerFreq, upperFreq, csbi.srWindow.Right - csbi.srWindow.Left, choice != 2 && choice != 5, Visualizer::latencyBudgetMs);
+            hop = plan.hop;
+            logMessage("Using " + std::to_string(plan.fftSize) + "-point frames every " + std::to_string(hop) + " samples.", "INFO");
+        }
+        AnalysisNotifier.setHop(hop);
+
+        std::cout << "\nStarting... Press 'x' to exit or 'm' to return to menu"
+                  << (history || fileHistory ? ", 's' saves the last " + std::to_string(LOOKBACK_SECONDS) + " s" : std::string()) << ".\n";
         SDL_Delay(1000);
         system("cls");
         static bool logOnce = true;
 
-        for (int i = 0; i < 600000 / REFRESH_TIME; i++)
+        // Sleep until a hop of new audio or a key press arrives instead of polling
+        Uint32 sessionStart = SDL_GetTicks(), lastAdapt = sessionStart;
+        uint64_t overviewFed = 0; // Overview periods of this session already covered
+        int64_t resultsStart = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        uint64_t resultsWritten = 0;
+        while (SDL_GetTicks() - sessionStart < SESSION_TIME)
         {
-            GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
-            consoleWidth = csbi.srWindow.Right - csbi.srWindow.Left;
-            consoleHeight = csbi.srWindow.Bottom - csbi.srWindow.Top;
-            runVisualizer(choice, lowerFreq, upperFreq, (choice >= 4 && choice <= 8), consoleWidth, consoleHeight, logOnce);
-            logOnce = false;
-            char input = capture_button_press();
+            char input = 0;
+            WakeReason reason = AnalysisNotifier.wait(IDLE_TIMEOUT, input);
             if (input == 'x')
                 break;
             if (input == 'm')
                 goto MAIN_MENU;
+            if (input == 's')
+                saveLookback(history.get(), fileHistory.get());
+            else if (input == '+')
+                overviewSpan = std::max<uint64_t>((overviewSpan > 0 ? overviewSpan : overview->columns()) / 2, 16);
+            else if (input == '-')
+                overviewSpan = overviewSpan * 2 < overview->columns() ? overviewSpan * 2 : 0;
+
+            if (History)
+                History->compressPending();
+            if (FileHistory)
+                FileHistory->maintain();
+            if (bufferController && SDL_GetTicks() - lastAdapt >= 500)
+            {
+                AdaptBufferSize(*bufferController, RecDevice, PlayDevice);
+                lastAdapt = SDL_GetTicks();
+            }
+            if (reason != WakeReason::Samples)
+                continue;
+            // One overview column per PYRAMID_FRAME of time; a stall skips columns rather than repeating one
+            uint64_t overviewDue = static_cast<uint64_t>(SDL_GetTicks() - sessionStart) * RATE / (1000 * PYRAMID_FRAME);
+            if (overviewDue > overviewFed)
+            {
+                OverviewFeed(*overview, MainAudioQueue);
+                overviewFed = overviewDue;
+            }
+            // Likewise one results row per RESULTS_HOP, stamped with when it was analyzed; the store treats longer gaps as pauses
+            Uint32 elapsed = SDL_GetTicks() - sessionStart;
+            uint64_t resultsDue = static_cast<uint64_t>(elapsed) * RATE / (1000 * RESULTS_HOP);
+            if (results && resultsDue > resultsWritten)
+            {
+                ResultsFeed(*results, MainAudioQueue, resultsStart + elapsed, logOnce);
+                resultsWritten = resultsDue;
+            }
+
+            GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi);
+            consoleWidth = csbi.srWindow.Right - csbi.srWindow.Left;
+            consoleHeight = csbi.srWindow.Bottom - csbi.srWindow.Top;
+            if (choice == 14)
+            {
+                if (captureEngine.sourceCount() >= 2)
+                    StereoDisplay(stereoMeter, consoleWidth, logOnce);
+                else
+                    std::cout << "The stereo display needs a second microphone; start with --capture-devices 1.\n";
+            }
+            else if (choice == 16)
+                FingerprintDisplay(fingerprints.get(), MainAudioQueue, logOnce);
+            else if (choice == 17)
+                SimilarityDisplay(similarity.get(), MainAudioQueue, logOnce);
+            else if (choice == 18)
+                OverviewDisplay(*overview, overviewSpan, consoleWidth, consoleHeight, logOnce);
+            else if (choice == 19)
+            {
+                if (results)
+                    ResultsDisplay(*results, logOnce);
+                else
+                    std::cout << "The practice report needs --results-dir.\n";
+            }
+            else if (choice == 15)
+            {
+                const SpectralFeatures &features = FeatureDisplay(MainAudioQueue, consoleWidth, logOnce);
+                if (featureExporter)
+                    featureExporter->write((SDL_GetTicks() - sessionStart) / 1000.0, features);
+            }
+            else
+                runVisualizer(choice, lowerFreq, upperFreq, (choice >= 4 && choice <= 8) || choice == 11 || choice == 12, consoleWidth, consoleHeight, logOnce);
+            if (monitoring)
+                reportMonitoring(monitorTarget, monitorLatencyMs);
+            if (captureEngine.sourceCount() > 0)
+                reportCaptureSources(captureEngine, sourceLevels, captureEngine.sourceCount() >= 2 ? &delayEstimator : nullptr);
+            logOnce = false;
         }
 
-        SDL_CloseAudioDevice(PlayDevice);
-        SDL_CloseAudioDevice(RecDevice);
+        audio.close();
+        if (history)
+            logMessage("Capture history held " + std::to_string(history->secondsHeld()) + " s in " + std::to_string(history->compressedBytes() >> 10) +
+                           " KiB (ratio " + std::to_string(history->compressionRatio()) + ", " + std::to_string(history->getLostSamples()) + " samples lost)",
+                       "INFO");
+        if (!overviewFile.empty())
+            overview->save(overviewFile);
+        results.reset();
         logMessage("Application terminated successfully", "INFO");
     }
     catch (const std::exception &e)
@@ -0,0 +1,69 @@
+#include "mappedFile.h"
+#include "logger.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX // Keep std::min/std::max usable
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Maps a file read-only.
+ *
+ * @param path File to map; must not be empty.
+ * @throws std::runtime_error if the file cannot be opened or mapped.
+ */
+MappedFile::MappedFile(const std::string &path)
+{
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER fileSize;
+    void *view = nullptr;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 ||
+        !(mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL)) || !(view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)))
+    {
+        if (mapping)
+            CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        logMessage("Cannot map file " + path, "ERROR");
+        throw std::runtime_error("Cannot map file " + path);
+    }
+    base = static_cast<const uint8_t *>(view);
+    length = static_cast<size_t>(fileSize.QuadPart);
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat info;
+    void *view = MAP_FAILED;
+    if (fd >= 0 && fstat(fd, &info) == 0 && info.st_size > 0)
+        view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    if (fd >= 0)
+        close(fd); // The mapping stays valid
+    if (view == MAP_FAILED)
+    {
+        logMessage("Cannot map file " + path, "ERROR");
+        throw std::runtime_error("Cannot map file " + path);
+    }
+    base = static_cast<const uint8_t *>(view);
+    length = static_cast<size_t>(info.st_size);
+#endif
+}
+
+/**
+ * @brief Unmaps the file.
+ */
+MappedFile::~MappedFile()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(base);
+    CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    munmap(const_cast<uint8_t *>(base), length);
+#endif
+}
@@ -0,0 +1,36 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * ------------------------
+ * ----class MappedFile----
+ * ------------------------
+ * A whole file mapped read-only. Index and feature files are written in the layout they are
+ * used in, so mapping one makes it usable at once; the operating system pages in only what
+ * lookups touch and can share the pages between processes.
+ */
+class MappedFile
+{
+private:
+    const uint8_t *base = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#endif
+
+public:
+    explicit MappedFile(const std::string &path); /// Throws std::runtime_error if the file cannot be mapped
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *data() const { return base; }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,324 @@
+#include "mappedHistory.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX // Keep std::min/std::max usable
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char historyMagic[8] = {'A', 'D', 'S', 'P', 'H', 'I', 'S', '1'};
+
+/**
+ * @brief Size of a virtual memory page, for aligning madvise/msync ranges.
+ */
+static size_t pageSize()
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwPageSize;
+#else
+    return static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+/**
+ * @brief Opens or creates the history file and maps it.
+ *
+ * The file is sized and preallocated up front so writes never extend it, and the first pages the
+ * callback will write are faulted in writable. An existing file with the same capacity is reused
+ * together with the samples it holds; any other file is reset.
+ * @param path Path of the history file.
+ * @param capacitySamples Samples in the circular buffer.
+ * @throws std::invalid_argument if the capacity is too small.
+ * @throws std::runtime_error if the file cannot be created or mapped.
+ */
+MappedHistory::MappedHistory(const std::string &path, uint64_t capacitySamples)
+    : path(path), capacity(capacitySamples), mappedBytes(MAPPED_HEADER + capacitySamples * sizeof(sample))
+{
+    if (capacitySamples < 2 * MAPPED_PREFAULT)
+    {
+        logMessage("History file must hold at least " + std::to_string(2 * MAPPED_PREFAULT) + " samples.", "ERROR");
+        throw std::invalid_argument("History file must hold at least " + std::to_string(2 * MAPPED_PREFAULT) + " samples.");
+    }
+
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        logMessage("Cannot open history file: " + path, "ERROR");
+        throw std::runtime_error("Cannot open history file: " + path);
+    }
+    LARGE_INTEGER size;
+    size.QuadPart = static_cast<LONGLONG>(mappedBytes);
+    mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL); // Grows the file as needed
+    if (!mapping || !(base = static_cast<uint8_t *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, mappedBytes))))
+    {
+        release();
+        logMessage("Cannot map history file: " + path, "ERROR");
+        throw std::runtime_error("Cannot map history file: " + path);
+    }
+#else
+    fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        release();
+        logMessage("Cannot open history file: " + path, "ERROR");
+        throw std::runtime_error("Cannot open history file: " + path);
+    }
+    if (static_cast<size_t>(info.st_size) != mappedBytes)
+    {
+        bool sized = ftruncate(fd, static_cast<off_t>(mappedBytes)) == 0;
+#ifdef __linux__
+        sized = sized && posix_fallocate(fd, 0, static_cast<off_t>(mappedBytes)) == 0; // Reserve blocks now, not on first writeback
+#endif
+        if (!sized)
+        {
+            release();
+            logMessage("Cannot allocate history file: " + path, "ERROR");
+            throw std::runtime_error("Cannot allocate history file: " + path);
+        }
+    }
+    void *mapped = mmap(nullptr, mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED)
+    {
+        release();
+        logMessage("Cannot map history file: " + path, "ERROR");
+        throw std::runtime_error("Cannot map history file: " + path);
+    }
+    base = static_cast<uint8_t *>(mapped);
+#endif
+
+    header = reinterpret_cast<Header *>(base);
+    data = reinterpret_cast<sample *>(base + MAPPED_HEADER);
+    if (std::memcmp(header->magic, historyMagic, sizeof(historyMagic)) != 0 || header->capacity != capacity)
+    {
+        std::memcpy(header->magic, historyMagic, sizeof(historyMagic));
+        header->capacity = capacity;
+        header->written.store(0);
+    }
+    header->written.fetch_add(0); // The callback stores to the header page too; make it writable now
+    prefaultedUpTo = flushedUpTo = newestPosition();
+    maintain();
+    logMessage("History file " + path + " holds " + std::to_string(static_cast<double>(capacity) / RATE / 3600) + " h, resuming at sample " + std::to_string(newestPosition()), "INFO");
+}
+
+/**
+ * @brief Queues the remaining dirty pages for writeback and unmaps the file.
+ */
+MappedHistory::~MappedHistory()
+{
+    release();
+}
+
+/**
+ * @brief Unmaps the file and closes whatever handles are open.
+ *
+ * Safe on a partly constructed object, so the constructor can clean up before throwing.
+ */
+void MappedHistory::release()
+{
+#ifdef _WIN32
+    if (base)
+    {
+        FlushViewOfFile(base, 0);
+        UnmapViewOfFile(base);
+    }
+    if (mapping)
+        CloseHandle(mapping);
+    if (file && file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    file = mapping = nullptr;
+#else
+    if (base)
+    {
+        msync(base, mappedBytes, MS_ASYNC);
+        munmap(base, mappedBytes);
+    }
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+#endif
+    base = nullptr;
+}
+
+/**
+ * @brief Appends captured samples. Safe to call from the audio callback.
+ *
+ * Only copies into the mapping. maintain() has already made the pages resident and writable, so
+ * the copy does not fault. The session clock keeps the earliest implied origin, since blocks
+ * can only be delivered late.
+ * @param input Samples to append.
+ * @param n Number of samples.
+ * @param deliveredAt Timeline time at which the block was delivered.
+ */
+void MappedHistory::write(const sample *input, int n, double deliveredAt)
+{
+    uint64_t position = header->written.load(std::memory_order_relaxed);
+    uint64_t index = position % capacity;
+    uint64_t first = std::min<uint64_t>(n, capacity - index);
+    std::memcpy(data + index, input, first * sizeof(sample));
+    std::memcpy(data, input + first, (n - first) * sizeof(sample));
+
+    double estimate = deliveredAt - static_cast<double>(position + n) / RATE;
+    if (!haveOrigin || estimate < origin.load(std::memory_order_relaxed))
+    {
+        origin.store(estimate, std::memory_order_relaxed);
+        haveOrigin = true;
+    }
+    header->written.store(position + n, std::memory_order_release);
+}
+
+/**
+ * @brief Splits a range of positions into at most two contiguous byte ranges of the mapping.
+ *
+ * @return Number of ranges (0 to 2).
+ */
+int MappedHistory::byteRanges(uint64_t from, uint64_t to, uint8_t *starts[2], size_t lengths[2]) const
+{
+    if (to <= from)
+        return 0;
+    to = std::min(to, from + capacity);
+    uint64_t index = from % capacity;
+    uint64_t first = std::min(to - from, capacity - index);
+    starts[0] = reinterpret_cast<uint8_t *>(data + index);
+    lengths[0] = first * sizeof(sample);
+    if (first == to - from)
+        return 1;
+    starts[1] = reinterpret_cast<uint8_t *>(data);
+    lengths[1] = (to - from - first) * sizeof(sample);
+    return 2;
+}
+
+/**
+ * @brief Starts asynchronous writeback of a byte range without waiting for it.
+ */
+void MappedHistory::writeBack(uint8_t *start, size_t length)
+{
+#ifdef _WIN32
+    FlushViewOfFile(start, length); // Initiates the writes; FlushFileBuffers would wait for them
+#elif defined(__linux__)
+    sync_file_range(fd, start - base, length, SYNC_FILE_RANGE_WRITE);
+#else
+    uintptr_t page = pageSize();
+    uint8_t *aligned = reinterpret_cast<uint8_t *>(reinterpret_cast<uintptr_t>(start) & ~(page - 1));
+    msync(aligned, length + (start - aligned), MS_ASYNC);
+#endif
+}
+
+/**
+ * @brief Keeps the writer away from I/O. Call regularly from the analysis thread.
+ *
+ * Write-touches every page in the next MAPPED_PREFAULT samples so the recording callback finds
+ * them resident and already writable: a read would only map them read-only, leaving a
+ * page-mkwrite fault for the callback's first store. The touch is an atomic or with zero, so it
+ * cannot undo a sample the callback stores to the same page meanwhile. Everything written since
+ * the last call is queued for writeback, so dirty pages do not pile up until the kernel has to
+ * flush them synchronously.
+ */
+void MappedHistory::maintain()
+{
+    uint64_t written = newestPosition();
+    uint8_t *starts[2];
+    size_t lengths[2];
+    size_t page = pageSize();
+
+    prefaultedUpTo = std::max(prefaultedUpTo, written);
+    uint64_t target = written + MAPPED_PREFAULT;
+    int ranges = byteRanges(prefaultedUpTo, target, starts, lengths);
+    for (int r = 0; r < ranges; r++)
+    {
+#ifndef _WIN32
+        uintptr_t aligned = reinterpret_cast<uintptr_t>(starts[r]) & ~(page - 1);
+        madvise(reinterpret_cast<void *>(aligned), lengths[r] + (reinterpret_cast<uintptr_t>(starts[r]) - aligned), MADV_WILLNEED);
+#endif
+        for (size_t offset = 0; offset < lengths[r]; offset += page)
+            __atomic_fetch_or(starts[r] + offset, static_cast<uint8_t>(0), __ATOMIC_RELAXED);
+    }
+    prefaultedUpTo = std::max(prefaultedUpTo, target);
+
+    ranges = byteRanges(flushedUpTo, written, starts, lengths);
+    for (int r = 0; r < ranges; r++)
+        writeBack(starts[r], lengths[r]);
+    flushedUpTo = written;
+}
+
+/**
+ * @brief Oldest stream position still held in the file.
+ */
+uint64_t MappedHistory::oldestPosition() const
+{
+    uint64_t written = newestPosition();
+    return written > capacity ? written - capacity : 0;
+}
+
+/**
+ * @brief Converts a timeline time from this session to a stream position.
+ *
+ * @param time Timeline time in seconds (see captureClock()).
+ * @return The position, clamped to the range held.
+ */
+uint64_t MappedHistory::positionAt(double time) const
+{
+    double position = (time - origin.load(std::memory_order_relaxed)) * RATE;
+    uint64_t clamped = position > 0 ? static_cast<uint64_t>(position + 0.5) : 0;
+    return std::min(std::max(clamped, oldestPosition()), newestPosition());
+}
+
+/**
+ * @brief Returns a zero-copy view of a range.
+ *
+ * The view points into the mapping; the writer may overwrite the oldest part of the file, so
+ * check stillValid() after using a span that starts near oldestPosition().
+ * @param position Stream position of the first sample.
+ * @param n Number of samples.
+ * @return The span, or an empty span if the range is not held.
+ */
+HistorySpan MappedHistory::span(uint64_t position, size_t n) const
+{
+    HistorySpan result;
+    if (position < oldestPosition() || position + n > newestPosition())
+        return result;
+
+    uint64_t index = position % capacity;
+    result.first = data + index;
+    result.firstCount = static_cast<size_t>(std::min<uint64_t>(n, capacity - index));
+    if (result.firstCount < n)
+    {
+        result.second = data;
+        result.secondCount = n - result.firstCount;
+    }
+    return result;
+}
+
+/**
+ * @brief Checks that data from a position onwards has not been overwritten.
+ */
+bool MappedHistory::stillValid(uint64_t position) const
+{
+    return position >= oldestPosition();
+}
+
+/**
+ * @brief Copies a range out of the file.
+ *
+ * @return false if the range is not held or was overwritten during the copy.
+ */
+bool MappedHistory::read(uint64_t position, sample *output, size_t n) const
+{
+    HistorySpan view = span(position, n);
+    if (view.size() != n)
+        return false;
+    std::memcpy(output, view.first, view.firstCount * sizeof(sample));
+    std::memcpy(output + view.firstCount, view.second, view.secondCount * sizeof(sample));
+    return stillValid(position);
+}
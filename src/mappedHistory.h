@@ -0,0 +1,86 @@
+#ifndef MAPPED_HISTORY_H
+#define MAPPED_HISTORY_H
+
+#include "audioProcessor.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#define MAPPED_PREFAULT 262144   /// Samples ahead of the writer kept resident by maintain() (~6 s)
+#define MAPPED_HEADER 4096       /// Bytes reserved at the start of the file for the header
+
+/// A zero-copy view of a history range; split in two where it wraps around the end of the file
+struct HistorySpan
+{
+    const sample *first = nullptr;
+    size_t firstCount = 0;
+    const sample *second = nullptr;
+    size_t secondCount = 0;
+
+    size_t size() const { return firstCount + secondCount; }
+    sample operator[](size_t i) const { return i < firstCount ? first[i] : second[i - firstCount]; }
+};
+
+/**
+ * --------------------------
+ * ----class MappedHistory----
+ * --------------------------
+ * Capture history in a preallocated, memory-mapped file used as one large circular buffer.
+ * The page cache decides what stays resident. The recording callback only copies into the
+ * mapping; maintain(), called from the analysis thread, faults in the pages just ahead of the
+ * writer and starts asynchronous writeback of the pages just behind it, so the callback neither
+ * waits for a page to be read nor for dirty pages to be flushed. Readers get zero-copy spans.
+ * The sample count survives a restart, so a reopened file still holds the previous session.
+ */
+class MappedHistory
+{
+private:
+    /// Layout of the first bytes of the file
+    struct Header
+    {
+        char magic[8];
+        uint64_t capacity;             /// Samples in the circular buffer
+        std::atomic<uint64_t> written; /// Samples written over the file's lifetime
+    };
+
+    std::string path;
+    uint64_t capacity;
+    size_t mappedBytes;
+    uint8_t *base = nullptr;       /// Start of the mapping
+    Header *header = nullptr;
+    sample *data = nullptr;        /// Start of the circular buffer
+    std::atomic<double> origin{0}; /// Timeline time of position 0 for this session
+    bool haveOrigin = false;       /// Producer only
+    uint64_t prefaultedUpTo = 0;   /// Consumer only: positions below this have been faulted in
+    uint64_t flushedUpTo = 0;      /// Consumer only: positions below this have been queued for writeback
+#ifdef _WIN32
+    void *file = nullptr;
+    void *mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    int byteRanges(uint64_t from, uint64_t to, uint8_t *starts[2], size_t lengths[2]) const;
+    void writeBack(uint8_t *start, size_t length);
+    void release(); /// Unmaps the file and closes its handles; also undoes a partly finished constructor
+
+public:
+    MappedHistory(const std::string &path, uint64_t capacitySamples); /// Opens or creates the file
+    ~MappedHistory();                                                 /// Flushes and unmaps
+    MappedHistory(const MappedHistory &) = delete;
+    MappedHistory &operator=(const MappedHistory &) = delete;
+
+    void write(const sample *input, int n, double deliveredAt); /// Recording side; never waits for I/O
+    void maintain();                                            /// Analysis side: prefault ahead, write back behind
+
+    uint64_t getCapacity() const { return capacity; }
+    uint64_t newestPosition() const { return header->written.load(std::memory_order_acquire); }
+    uint64_t oldestPosition() const;
+    uint64_t positionAt(double time) const; /// Stream position captured at a timeline time this session
+
+    HistorySpan span(uint64_t position, size_t n) const; /// Zero-copy view; empty if not held
+    bool stillValid(uint64_t position) const;            /// Whether a span starting here has not been overwritten since
+    bool read(uint64_t position, sample *output, size_t n) const;
+};
+
+#endif // MAPPED_HISTORY_H
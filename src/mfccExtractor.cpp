@@ -0,0 +1,150 @@
+#include "mfccExtractor.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief Constructor for MfccExtractor.
+ *
+ * @param frameSize Samples per frame; a power of two.
+ * @param hop Samples between frame starts.
+ * @param coefficients Cepstral coefficients kept per frame, c0 first.
+ * @param melBands Mel bands under the cepstrum; at least coefficients.
+ * @param minFreq Lower edge of the lowest band in Hz.
+ * @param maxFreq Upper edge of the highest band in Hz.
+ * @throws std::invalid_argument if the hop or the coefficient count is out of range.
+ */
+MfccExtractor::MfccExtractor(int frameSize, int hop, int coefficients, int melBands, float minFreq, float maxFreq)
+    : frameSize(frameSize), hop(hop), coefficientCount(coefficients), plan(FFTPlan::get(frameSize)),
+      mel(melBands, frameSize, minFreq, maxFreq, BandScale::Mel, RATE), window(frameSize)
+{
+    if (hop < 1 || coefficients < 1 || coefficients > melBands)
+    {
+        logMessage("MFCC needs a positive hop and between 1 and " + std::to_string(melBands) + " coefficients.", "ERROR");
+        throw std::invalid_argument("MFCC needs a positive hop and between 1 and " + std::to_string(melBands) + " coefficients.");
+    }
+
+    // Scale so a full-scale sine peaks near 1, as Stft does
+    double sum = 0;
+    for (int i = 0; i < frameSize; i++)
+        sum += 0.54 - 0.46 * std::cos(2 * M_PI * i / frameSize);
+    for (int i = 0; i < frameSize; i++)
+        window[i] = static_cast<float>((0.54 - 0.46 * std::cos(2 * M_PI * i / frameSize)) * 2 / (sum * (MAX_SAMPLE_VALUE + 1)));
+
+    dct.resize(static_cast<size_t>(melBands) * coefficients);
+    for (int b = 0; b < melBands; b++)
+        for (int c = 0; c < coefficients; c++)
+            dct[static_cast<size_t>(b) * coefficients + c] = static_cast<float>(std::sqrt((c == 0 ? 1.0 : 2.0) / melBands) *
+                                                                                std::cos(M_PI * c * (b + 0.5) / melBands));
+
+    framed.resize(static_cast<size_t>(MFCC_BATCH) * frameSize);
+    power.resize(static_cast<size_t>(MFCC_BATCH) * bins());
+    bands.resize(static_cast<size_t>(MFCC_BATCH) * melBands);
+    spectrum.resize(2 * static_cast<size_t>(bins()));
+    scratch.resize(frameSize);
+}
+
+/**
+ * @brief Computes the MFCC of every frame of a stretch of audio.
+ *
+ * Pre-emphasis runs across frame boundaries: the first sample of each frame is differenced
+ * against the sample before it, so a frame's coefficients do not depend on where the batch starts.
+ * @param audio Samples at RATE.
+ * @param n Number of samples.
+ * @param output Receives frameCount(n) rows of coefficients() floats.
+ */
+void MfccExtractor::extract(const sample *audio, size_t n, float *output)
+{
+    size_t frames = frameCount(n);
+    const int binCount = bins();
+    for (size_t first = 0; first < frames; first += MFCC_BATCH)
+    {
+        size_t count = std::min<size_t>(MFCC_BATCH, frames - first);
+        for (size_t f = 0; f < count; f++)
+        {
+            const sample *x = audio + (first + f) * hop;
+            float *out = framed.data() + f * frameSize;
+            float previous = first + f == 0 ? 0.0f : x[-1];
+            out[0] = (x[0] - MFCC_PRE_EMPHASIS * previous) * window[0];
+            for (int i = 1; i < frameSize; i++)
+                out[i] = (x[i] - MFCC_PRE_EMPHASIS * x[i - 1]) * window[i];
+        }
+
+        for (size_t f = 0; f < count; f += 2)
+        {
+            const float *a = framed.data() + f * frameSize;
+            const float *b = f + 1 < count ? a + frameSize : a;
+            plan.forwardRealPair(a, b, spectrum.data(), spectrum.data() + binCount, scratch.data());
+            for (size_t side = 0; side < 2 && f + side < count; side++)
+            {
+                float *p = power.data() + (f + side) * binCount;
+                const cmplx *s = spectrum.data() + side * binCount;
+                for (int k = 0; k < binCount; k++)
+                    p[k] = static_cast<float>(s[k].real() * s[k].real() + s[k].imag() * s[k].imag());
+            }
+        }
+
+        cepstrum(power.data(), count, output + first * coefficientCount);
+    }
+}
+
+/**
+ * @brief Computes the MFCC of every frame of a stretch of audio into a vector.
+ *
+ * @param audio Samples at RATE.
+ * @param n Number of samples.
+ * @param output Resized to frameCount(n) * coefficients() floats.
+ */
+void MfccExtractor::extract(const sample *audio, size_t n, std::vector<float> &output)
+{
+    output.resize(frameCount(n) * coefficientCount);
+    extract(audio, n, output.data());
+}
+
+/**
+ * @brief Runs the mel, log and DCT stages on power spectra computed elsewhere.
+ *
+ * Lets an analysis that already has the spectra of its frames, such as the similarity features,
+ * add cepstra without a second transform. The DCT accumulates one band at a time into the output
+ * row, so the inner loop runs over contiguous coefficients with no reduction.
+ * @param powerSpectra frames rows of bins() power values.
+ * @param frames Number of frames.
+ * @param output Receives frames rows of coefficients() floats.
+ */
+void MfccExtractor::cepstrum(const float *powerSpectra, size_t frames, float *output)
+{
+    const int melBands = mel.size();
+    for (size_t first = 0; first < frames; first += MFCC_BATCH)
+    {
+        size_t count = std::min<size_t>(MFCC_BATCH, frames - first);
+        for (size_t f = 0; f < count; f++)
+            mel.applyLog(powerSpectra + (first + f) * bins(), bands.data() + f * melBands);
+
+        for (size_t f = 0; f < count; f++)
+        {
+            float *out = output + (first + f) * coefficientCount;
+            std::fill(out, out + coefficientCount, 0.0f);
+            for (int b = 0; b < melBands; b++)
+            {
+                float energy = bands[f * melBands + b];
+                const float *basis = dct.data() + static_cast<size_t>(b) * coefficientCount;
+                for (int c = 0; c < coefficientCount; c++)
+                    out[c] += energy * basis[c];
+            }
+        }
+    }
+}
+
+/**
+ * @brief Per-instance memory, excluding the shared plan, in bytes.
+ */
+size_t MfccExtractor::memoryBytes() const
+{
+    return sizeof(*this) + mel.memoryBytes() - sizeof(mel) +
+           (window.capacity() + dct.capacity() + framed.capacity() + power.capacity() + bands.capacity()) * sizeof(float) +
+           (spectrum.capacity() + scratch.capacity()) * sizeof(cmplx);
+}
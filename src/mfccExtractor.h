@@ -0,0 +1,61 @@
+#ifndef MFCC_EXTRACTOR_H
+#define MFCC_EXTRACTOR_H
+
+#include "fftPlan.h"
+#include "filterbank.h"
+#include <vector>
+
+#define MFCC_FRAME 1024          /// Samples per frame (23 ms)
+#define MFCC_HOP 512             /// Samples between frames (11.6 ms)
+#define MFCC_COEFFICIENTS 13     /// c0 to c12
+#define MFCC_MEL_BANDS 26        /// Mel bands under the cepstrum
+#define MFCC_MIN_FREQ 20.0f      /// Lower edge of the lowest mel band in Hz
+#define MFCC_MAX_FREQ 8000.0f    /// Upper edge of the highest mel band in Hz
+#define MFCC_PRE_EMPHASIS 0.97f  /// First-order high-pass coefficient applied before windowing
+#define MFCC_BATCH 32            /// Frames carried through each stage together
+
+/**
+ * ---------------------------
+ * ----class MfccExtractor----
+ * ---------------------------
+ * Mel-frequency cepstral coefficients of every frame of a recording, computed in batches of
+ * MFCC_BATCH frames one stage at a time: pre-emphasis, framing and Hamming window; power
+ * spectra from the shared FFTPlan, two frames per complex transform; the sparse mel filterbank
+ * in dB; and an orthonormal DCT-II as a precomputed bands-by-coefficients matrix. Each stage
+ * runs a short loop over the whole batch, so its tables stay in cache and its inner loops
+ * vectorize. The output is frame-major: coefficients() floats per frame, frames back to back.
+ * Holds scratch buffers, so use one instance per thread.
+ */
+class MfccExtractor
+{
+private:
+    int frameSize;
+    int hop;
+    int coefficientCount;
+    const FFTPlan &plan;
+    Filterbank mel;
+    std::vector<float> window;   /// Hamming window, scaled to full-scale samples
+    std::vector<float> dct;      /// bands x coefficients, orthonormal DCT-II
+    std::vector<float> framed;   /// MFCC_BATCH windowed frames
+    std::vector<float> power;    /// MFCC_BATCH power spectra
+    std::vector<float> bands;    /// MFCC_BATCH log mel spectra
+    std::vector<cmplx> spectrum; /// One pair of spectra
+    std::vector<cmplx> scratch;
+
+public:
+    explicit MfccExtractor(int frameSize = MFCC_FRAME, int hop = MFCC_HOP, int coefficients = MFCC_COEFFICIENTS, int melBands = MFCC_MEL_BANDS,
+                           float minFreq = MFCC_MIN_FREQ, float maxFreq = MFCC_MAX_FREQ); /// frameSize must be a power of two
+
+    int getFrameSize() const { return frameSize; }
+    int getHop() const { return hop; }
+    int coefficients() const { return coefficientCount; }
+    int bins() const { return frameSize / 2 + 1; }
+    size_t frameCount(size_t n) const { return n < static_cast<size_t>(frameSize) ? 0 : (n - frameSize) / hop + 1; }
+
+    void extract(const sample *audio, size_t n, float *output);              /// Writes frameCount(n) * coefficients() floats
+    void extract(const sample *audio, size_t n, std::vector<float> &output);
+    void cepstrum(const float *powerSpectra, size_t frames, float *output);  /// Mel, log and DCT of bins() power bins per frame
+    size_t memoryBytes() const;
+};
+
+#endif // MFCC_EXTRACTOR_H
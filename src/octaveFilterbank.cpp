@@ -0,0 +1,288 @@
+#include "octaveFilterbank.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const float antiDenormal = 1e-20f; // Keeps idle filter state out of the denormal range
+
+/**
+ * @brief Designs the two sections of a 4th-order Butterworth band-pass at one rate.
+ *
+ * Transforms the 2nd-order Butterworth lowpass prototype to a band-pass between the prewarped
+ * band edges, splits its poles into two sections and maps each with the bilinear transform.
+ * The result is normalized to unity gain at the band centre.
+ * @param low Lower band edge in Hz.
+ * @param high Upper band edge in Hz.
+ * @param fs Sample rate of the stage in Hz.
+ * @param coefficients Receives b0, b2, a1, a2 for each section.
+ */
+static void designBandpass(double low, double high, double fs, double coefficients[2][4])
+{
+    double k = 2 * fs;
+    double wLow = k * std::tan(M_PI * low / fs), wHigh = k * std::tan(M_PI * high / fs);
+    double w0 = std::sqrt(wLow * wHigh), bandwidth = wHigh - wLow;
+
+    cmplx prototype(-M_SQRT1_2, M_SQRT1_2);
+    cmplx root = std::sqrt(prototype * prototype * bandwidth * bandwidth - 4 * w0 * w0);
+    cmplx poles[2] = {(prototype * bandwidth + root) / 2.0, (prototype * bandwidth - root) / 2.0};
+
+    cmplx z = std::polar(1.0, 2 * std::atan(w0 / k)); // Digital image of the analog centre
+    cmplx response = 1;
+    for (int s = 0; s < 2; s++)
+    {
+        double a = -2 * poles[s].real(), b = std::norm(poles[s]);
+        double a0 = k * k + a * k + b;
+        coefficients[s][0] = bandwidth * k / a0;
+        coefficients[s][1] = -bandwidth * k / a0;
+        coefficients[s][2] = (2 * b - 2 * k * k) / a0;
+        coefficients[s][3] = (k * k - a * k + b) / a0;
+        response *= (coefficients[s][0] + coefficients[s][1] / (z * z)) / (1.0 + coefficients[s][2] / z + coefficients[s][3] / (z * z));
+    }
+
+    double scale = 1 / std::sqrt(std::abs(response));
+    for (int s = 0; s < 2; s++)
+    {
+        coefficients[s][0] *= scale;
+        coefficients[s][1] *= scale;
+    }
+}
+
+/**
+ * @brief Designs one RBJ lowpass biquad.
+ *
+ * @param cutoff Cutoff as a fraction of the sample rate.
+ * @param q Quality factor.
+ * @param coefficients Receives b0, b1, b2, a1, a2.
+ */
+static void designLowpass(double cutoff, double q, float coefficients[5])
+{
+    double w = 2 * M_PI * cutoff, alpha = std::sin(w) / (2 * q), c = std::cos(w);
+    double a0 = 1 + alpha;
+    coefficients[0] = static_cast<float>((1 - c) / 2 / a0);
+    coefficients[1] = static_cast<float>((1 - c) / a0);
+    coefficients[2] = coefficients[0];
+    coefficients[3] = static_cast<float>(-2 * c / a0);
+    coefficients[4] = static_cast<float>((1 - alpha) / a0);
+}
+
+/**
+ * @brief Lays out the bands and designs every filter.
+ *
+ * Band centres follow the base-2 series 1000 * 2^(k / bandsPerOctave) Hz. Each band runs at the
+ * lowest rate at which its upper edge stays below an eighth of the rate, so the anti-aliasing
+ * lowpass (4th-order Butterworth at a quarter of the decimated rate) leaves it untouched.
+ * @param bandsPerOctave Bands per octave, e.g. 1 for octave or 3 for third-octave bands.
+ * @param minFreq Lowest band centre in Hz.
+ * @param maxFreq Highest band centre in Hz.
+ * @param rate Input sample rate in Hz.
+ * @throws std::invalid_argument if no bands fit or the top band reaches the Nyquist frequency.
+ */
+OctaveFilterbank::OctaveFilterbank(int bandsPerOctave, float minFreq, float maxFreq, int rate)
+    : scratch(OCTAVE_UPDATE)
+{
+    double halfBand = bandsPerOctave > 0 ? std::pow(2.0, 0.5 / bandsPerOctave) : 0;
+    if (bandsPerOctave < 1 || bandsPerOctave > 24 || minFreq <= 0 || maxFreq < minFreq || maxFreq * halfBand >= 0.45 * rate)
+    {
+        logMessage("Invalid octave filterbank configuration.", "ERROR");
+        throw std::invalid_argument("Invalid octave filterbank configuration.");
+    }
+
+    int first = static_cast<int>(std::ceil(bandsPerOctave * std::log2(minFreq / 1000.0) - 1e-9));
+    int last = static_cast<int>(std::floor(bandsPerOctave * std::log2(maxFreq / 1000.0) + 1e-9));
+    for (int k = first; k <= last; k++)
+        centers.push_back(static_cast<float>(1000.0 * std::pow(2.0, static_cast<double>(k) / bandsPerOctave)));
+    if (centers.empty())
+    {
+        logMessage("Octave filterbank range holds no bands.", "ERROR");
+        throw std::invalid_argument("Octave filterbank range holds no bands.");
+    }
+
+    int bands = size();
+    std::vector<int> stageOf(bands);
+    for (int b = 0; b < bands; b++)
+    {
+        int d = 0;
+        while (d + 1 < OCTAVE_MAX_STAGES && centers[b] * halfBand <= rate / std::pow(2.0, d + 1) / 8)
+            d++;
+        stageOf[b] = d;
+    }
+
+    stages.resize(stageOf[0] + 1);
+    for (int d = 0; d < stageCount(); d++)
+    {
+        Stage &stage = stages[d];
+        double stageRate = rate / std::pow(2.0, d);
+        stage.first = static_cast<int>(std::find(stageOf.begin(), stageOf.end(), d) - stageOf.begin());
+        stage.count = static_cast<int>(std::count(stageOf.begin(), stageOf.end(), d));
+        stage.alpha = static_cast<float>(1 - std::exp(-1 / (OCTAVE_RESPONSE * stageRate)));
+        designLowpass(0.125, 0.54119610, stage.lowpass[0]);
+        designLowpass(0.125, 1.30656296, stage.lowpass[1]);
+    }
+
+    for (Sections &s : sections)
+    {
+        s.b0.resize(bands);
+        s.b2.resize(bands);
+        s.a1.resize(bands);
+        s.a2.resize(bands);
+        s.z1.assign(bands, 0.0f);
+        s.z2.assign(bands, 0.0f);
+    }
+    for (int b = 0; b < bands; b++)
+    {
+        double coefficients[2][4];
+        designBandpass(centers[b] / halfBand, centers[b] * halfBand, rate / std::pow(2.0, stageOf[b]), coefficients);
+        for (int s = 0; s < 2; s++)
+        {
+            sections[s].b0[b] = static_cast<float>(coefficients[s][0]);
+            sections[s].b2[b] = static_cast<float>(coefficients[s][1]);
+            sections[s].a1[b] = static_cast<float>(coefficients[s][2]);
+            sections[s].a2[b] = static_cast<float>(coefficients[s][3]);
+        }
+    }
+
+    power.assign(bands, 0.0f);
+    published.reset(new std::atomic<float>[bands]);
+    for (int b = 0; b < bands; b++)
+        published[b].store(0.0f);
+    logMessage("Octave filterbank: " + std::to_string(bands) + " bands in " + std::to_string(stageCount()) + " stages.", "INFO");
+}
+
+/**
+ * @brief Filters one stage's samples through all of its bands and updates their levels.
+ *
+ * The inner loop runs across bands with no dependency between iterations, so the compiler can
+ * process several bands per instruction.
+ */
+void OctaveFilterbank::runStage(int index, const float *input, int n)
+{
+    const Stage &stage = stages[index];
+    int count = stage.count;
+    float alpha = stage.alpha;
+    const float *b0a = sections[0].b0.data() + stage.first, *b2a = sections[0].b2.data() + stage.first;
+    const float *a1a = sections[0].a1.data() + stage.first, *a2a = sections[0].a2.data() + stage.first;
+    float *z1a = sections[0].z1.data() + stage.first, *z2a = sections[0].z2.data() + stage.first;
+    const float *b0b = sections[1].b0.data() + stage.first, *b2b = sections[1].b2.data() + stage.first;
+    const float *a1b = sections[1].a1.data() + stage.first, *a2b = sections[1].a2.data() + stage.first;
+    float *z1b = sections[1].z1.data() + stage.first, *z2b = sections[1].z2.data() + stage.first;
+    float *p = power.data() + stage.first;
+
+    for (int i = 0; i < n; i++)
+    {
+        float x = input[i];
+        for (int j = 0; j < count; j++)
+        {
+            float y1 = b0a[j] * x + z1a[j];
+            z1a[j] = z2a[j] - a1a[j] * y1;
+            z2a[j] = b2a[j] * x - a2a[j] * y1;
+            y1 += antiDenormal;
+
+            float y2 = b0b[j] * y1 + z1b[j];
+            z1b[j] = z2b[j] - a1b[j] * y2;
+            z2b[j] = b2b[j] * y1 - a2b[j] * y2;
+
+            p[j] += alpha * (y2 * y2 + antiDenormal - p[j]);
+        }
+    }
+}
+
+/**
+ * @brief Lowpass filters a stage's samples and keeps every second one, in place.
+ *
+ * The decimation phase carries over between calls, so blocks of any length work.
+ * @return Number of samples left in the buffer for the next stage.
+ */
+int OctaveFilterbank::decimate(int index, float *buffer, int n)
+{
+    Stage &stage = stages[index];
+    int kept = 0;
+    for (int i = 0; i < n; i++)
+    {
+        float x = buffer[i];
+        for (int s = 0; s < 2; s++)
+        {
+            const float *c = stage.lowpass[s];
+            float *z = stage.state[s];
+            float y = c[0] * x + z[0];
+            z[0] = c[1] * x - c[3] * y + z[1];
+            z[1] = c[2] * x - c[4] * y;
+            x = y;
+        }
+        stage.keep = !stage.keep;
+        if (stage.keep)
+            buffer[kept++] = x;
+    }
+    return kept;
+}
+
+/**
+ * @brief Feeds captured samples through the filterbank. Safe to call from the audio callback.
+ *
+ * Works in pieces that end on update boundaries, so levels are published every OCTAVE_UPDATE
+ * input samples whatever the device block size.
+ * @param input Captured samples.
+ * @param n Number of samples.
+ */
+void OctaveFilterbank::process(const sample *input, int n)
+{
+    while (n > 0)
+    {
+        int piece = std::min(n, OCTAVE_UPDATE - sinceUpdate);
+        for (int i = 0; i < piece; i++)
+            scratch[i] = input[i] * (1.0f / 32768) + antiDenormal;
+
+        int length = piece;
+        for (int d = 0; d < stageCount(); d++)
+        {
+            runStage(d, scratch.data(), length);
+            if (d + 1 < stageCount())
+                length = decimate(d, scratch.data(), length);
+        }
+
+        input += piece;
+        n -= piece;
+        sinceUpdate += piece;
+        if (sinceUpdate == OCTAVE_UPDATE)
+        {
+            for (int b = 0; b < size(); b++)
+                published[b].store(power[b], std::memory_order_relaxed);
+            sinceUpdate = 0;
+        }
+    }
+}
+
+/**
+ * @brief Reads the most recently published band levels.
+ *
+ * @param output Array of size() levels in dB; a full-scale sine at a band centre reads 0 dB.
+ */
+void OctaveFilterbank::levels(float *output) const
+{
+    for (int b = 0; b < size(); b++)
+        output[b] = 10.0f * std::log10(std::max(2 * published[b].load(std::memory_order_relaxed), 1e-15f));
+}
+
+/**
+ * @brief Clears all filter state and levels.
+ */
+void OctaveFilterbank::reset()
+{
+    for (Sections &s : sections)
+    {
+        std::fill(s.z1.begin(), s.z1.end(), 0.0f);
+        std::fill(s.z2.begin(), s.z2.end(), 0.0f);
+    }
+    for (Stage &stage : stages)
+    {
+        std::fill(&stage.state[0][0], &stage.state[0][0] + 4, 0.0f);
+        stage.keep = false;
+    }
+    std::fill(power.begin(), power.end(), 0.0f);
+    for (int b = 0; b < size(); b++)
+        published[b].store(0.0f);
+    sinceUpdate = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef OCTAVE_FILTERBANK_H
+#define OCTAVE_FILTERBANK_H
+
+#include "audioProcessor.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#define OCTAVE_MAX_STAGES 8     /// Decimation stages; the last runs at RATE / 128
+#define OCTAVE_UPDATE CHUNK     /// Input samples between published level updates
+#define OCTAVE_RESPONSE 0.010f  /// Time constant of the level detectors in seconds
+#define OCTAVE_RANGE_DB 60      /// Dynamic range shown by the octave band display
+#define OCTAVE_DISPLAY_HOP 256  /// New samples between octave display refreshes (~6 ms)
+
+/**
+ * ------------------------------
+ * ----class OctaveFilterbank----
+ * ------------------------------
+ * Fractional-octave band levels computed in the time domain, for a level display with only a
+ * few milliseconds of latency. Each band is a 4th-order Butterworth band-pass made of two
+ * biquads. Filter state is stored band-major in flat arrays, so each sample updates every band
+ * of a stage in one vectorizable loop. Lower octaves run on successively half-rate copies of
+ * the input, which keeps their poles away from the unit circle and their cost negligible.
+ * process() is real-time safe and publishes levels every OCTAVE_UPDATE samples; levels() can be
+ * read from any thread.
+ */
+class OctaveFilterbank
+{
+private:
+    /// Coefficients and state of one biquad section for every band, one array per term
+    struct Sections
+    {
+        std::vector<float> b0, b2, a1, a2; /// b1 is zero for a band-pass section
+        std::vector<float> z1, z2;
+    };
+
+    /// Bands sharing one sample rate, plus the anti-aliasing filter feeding the next stage
+    struct Stage
+    {
+        int first = 0, count = 0;  /// Range of bands processed at this rate
+        float alpha = 0;           /// Level detector coefficient at this rate
+        float lowpass[2][5] = {};  /// Two lowpass biquads: b0, b1, b2, a1, a2
+        float state[2][2] = {};    /// Their z1, z2
+        bool keep = false;         /// Decimation phase
+    };
+
+    std::vector<float> centers;
+    Sections sections[2];
+    std::vector<float> power;                    /// Smoothed mean square of each band
+    std::unique_ptr<std::atomic<float>[]> published;
+    std::vector<Stage> stages;
+    std::vector<float> scratch;                  /// One update's input, decimated in place stage by stage
+    int sinceUpdate = 0;
+
+    void runStage(int index, const float *input, int n);
+    int decimate(int index, float *buffer, int n);
+
+public:
+    OctaveFilterbank(int bandsPerOctave = 3, float minFreq = 20, float maxFreq = 16000, int rate = RATE); /// Constructor
+
+    int size() const { return static_cast<int>(centers.size()); }
+    int stageCount() const { return static_cast<int>(stages.size()); }
+    float centerFrequency(int band) const { return centers[band]; }
+
+    void process(const sample *input, int n); /// Capture side; real-time safe
+    void levels(float *output) const;         /// Latest band levels in dB relative to a full-scale sine
+    void reset();                             /// Clears filter state and levels; not concurrent with process()
+};
+
+#endif // OCTAVE_FILTERBANK_H
@@ -0,0 +1,182 @@
+#include "partialTracker.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Finds the strongest local maxima of a magnitude spectrum.
+ *
+ * Each peak's frequency and height come from a parabola through the peak bin and its
+ * neighbours, which brings the frequency error well below one bin.
+ * @param output Receives the peaks, sorted by frequency.
+ * @param magnitude Magnitude spectrum.
+ * @param bins Number of bins.
+ * @param binHz Frequency spacing of the bins in Hz.
+ * @param threshold Smallest magnitude that counts as a peak.
+ * @param maxPeaks Most peaks to keep; the weakest are dropped first.
+ */
+void findPeaks(std::vector<SpectralPeak> &output, const float *magnitude, int bins, float binHz, float threshold, int maxPeaks)
+{
+    output.clear();
+    for (int k = 1; k + 1 < bins; k++)
+    {
+        float m = magnitude[k];
+        if (m < threshold || m <= magnitude[k - 1] || m < magnitude[k + 1])
+            continue;
+
+        float left = magnitude[k - 1], right = magnitude[k + 1];
+        float curvature = left - 2 * m + right;
+        float offset = curvature < 0 ? 0.5f * (left - right) / curvature : 0.0f;
+        output.push_back({(k + offset) * binHz, m - 0.25f * (left - right) * offset});
+    }
+
+    if (static_cast<int>(output.size()) > maxPeaks)
+    {
+        std::nth_element(output.begin(), output.begin() + maxPeaks, output.end(), [](const SpectralPeak &a, const SpectralPeak &b)
+                         { return a.magnitude > b.magnitude; });
+        output.resize(maxPeaks);
+        std::sort(output.begin(), output.end(), [](const SpectralPeak &a, const SpectralPeak &b)
+                  { return a.frequency < b.frequency; });
+    }
+}
+
+/**
+ * @brief Constructs a tracker.
+ *
+ * @param maxPartials Most partials alive at once; further births are dropped, weakest first.
+ * @param maxDeviationCents Largest frequency change between frames that continues a partial.
+ * @param graceFrames Frames a partial may go unmatched before it dies.
+ * @throws std::invalid_argument if a parameter is out of range.
+ */
+PartialTracker::PartialTracker(int maxPartials, float maxDeviationCents, int graceFrames)
+    : maxPartials(maxPartials), maxRatio(std::pow(2.0f, maxDeviationCents / 1200)), grace(graceFrames)
+{
+    if (maxPartials <= 0 || maxDeviationCents <= 0 || graceFrames < 0)
+    {
+        logMessage("Invalid partial tracker configuration.", "ERROR");
+        throw std::invalid_argument("Invalid partial tracker configuration.");
+    }
+    active.reserve(maxPartials);
+    continued.reserve(maxPartials);
+    born.reserve(maxPartials);
+}
+
+/**
+ * @brief Distance between two frequencies as a ratio, so it is symmetric in pitch.
+ */
+static float pitchDistance(float a, float b)
+{
+    return a > b ? a / b : b / a;
+}
+
+/**
+ * @brief Links one frame's peaks to the live partials.
+ *
+ * Sweeps the partials and peaks together in frequency order. A peak below the current partial's
+ * window starts a new partial, a partial below the current peak's window coasts, and a pair
+ * within range matches unless the next peak is closer to the partial or the next partial is
+ * closer to the peak, in which case the loser is passed over. Partials that coast longer than
+ * the grace period die.
+ * @param peaks This frame's peaks, sorted by frequency.
+ * @param events Cleared, then receives a birth, continuation or death for each partial touched.
+ */
+void PartialTracker::update(const std::vector<SpectralPeak> &peaks, std::vector<PartialUpdate> &events)
+{
+    events.clear();
+    continued.clear();
+    born.clear();
+
+    auto coast = [&](Partial partial)
+    {
+        partial.age++;
+        if (++partial.missed > grace)
+            events.push_back({PartialEvent::Death, partial});
+        else
+            continued.push_back(partial);
+    };
+    auto birth = [&](const SpectralPeak &peak)
+    {
+        born.push_back({-1, peak.frequency, peak.magnitude, 0, 0});
+    };
+
+    size_t i = 0, j = 0;
+    while (i < active.size() && j < peaks.size())
+    {
+        const Partial &partial = active[i];
+        const SpectralPeak &peak = peaks[j];
+        if (peak.frequency * maxRatio < partial.frequency)
+        {
+            birth(peak);
+            j++;
+            continue;
+        }
+        if (partial.frequency * maxRatio < peak.frequency)
+        {
+            coast(partial);
+            i++;
+            continue;
+        }
+
+        float distance = pitchDistance(partial.frequency, peak.frequency);
+        if (j + 1 < peaks.size() && pitchDistance(partial.frequency, peaks[j + 1].frequency) < distance)
+        {
+            birth(peak); // The partial prefers the next peak
+            j++;
+            continue;
+        }
+        if (i + 1 < active.size() && pitchDistance(active[i + 1].frequency, peak.frequency) < distance)
+        {
+            coast(partial); // The peak prefers the next partial
+            i++;
+            continue;
+        }
+
+        Partial next = partial;
+        next.frequency = peak.frequency;
+        next.magnitude = peak.magnitude;
+        next.age++;
+        next.missed = 0;
+        continued.push_back(next);
+        events.push_back({PartialEvent::Continue, next});
+        i++;
+        j++;
+    }
+    for (; i < active.size(); i++)
+        coast(active[i]);
+    for (; j < peaks.size(); j++)
+        birth(peaks[j]);
+
+    // Keep only the strongest births that fit, then restore frequency order
+    int room = maxPartials - static_cast<int>(continued.size());
+    if (static_cast<int>(born.size()) > room)
+    {
+        std::nth_element(born.begin(), born.begin() + room, born.end(), [](const Partial &a, const Partial &b)
+                         { return a.magnitude > b.magnitude; });
+        born.resize(room);
+        std::sort(born.begin(), born.end(), [](const Partial &a, const Partial &b)
+                  { return a.frequency < b.frequency; });
+    }
+    for (Partial &partial : born)
+    {
+        partial.id = nextId++;
+        events.push_back({PartialEvent::Birth, partial});
+    }
+
+    // Coasting partials keep their old frequency, so the merge can need a final touch-up
+    active.resize(continued.size() + born.size());
+    std::merge(continued.begin(), continued.end(), born.begin(), born.end(), active.begin(), [](const Partial &a, const Partial &b)
+               { return a.frequency < b.frequency; });
+    if (!std::is_sorted(active.begin(), active.end(), [](const Partial &a, const Partial &b)
+                        { return a.frequency < b.frequency; }))
+        std::sort(active.begin(), active.end(), [](const Partial &a, const Partial &b)
+                  { return a.frequency < b.frequency; });
+}
+
+/**
+ * @brief Forgets all partials. Ids keep increasing.
+ */
+void PartialTracker::reset()
+{
+    active.clear();
+}
@@ -0,0 +1,84 @@
+#ifndef PARTIAL_TRACKER_H
+#define PARTIAL_TRACKER_H
+
+#include <vector>
+
+#define PARTIAL_MAX 64        /// Most partials tracked at once
+#define PARTIAL_DEVIATION 50  /// Largest frequency jump between frames that continues a partial, in cents
+#define PARTIAL_GRACE 2       /// Frames a partial may go unmatched before it dies
+#define PARTIAL_MIN_AGE 3     /// Frames a partial must last before it counts as established
+
+/// A spectral peak in one frame
+struct SpectralPeak
+{
+    float frequency; /// Interpolated frequency in Hz
+    float magnitude; /// Interpolated peak magnitude
+};
+
+/// A partial followed across frames
+struct Partial
+{
+    int id;          /// Unique for the tracker's lifetime
+    float frequency; /// Frequency in the latest frame it was matched
+    float magnitude; /// Magnitude in the latest frame it was matched
+    int age;         /// Frames since birth
+    int missed;      /// Consecutive frames without a matching peak
+};
+
+/// What happened to a partial in one update
+enum class PartialEvent
+{
+    Birth,
+    Continue,
+    Death
+};
+
+/// One entry of the event list produced by PartialTracker::update()
+struct PartialUpdate
+{
+    PartialEvent event;
+    Partial partial; /// State after the update; for a death, the last state
+};
+
+/**
+ * findPeaks()
+ * Finds local maxima of a magnitude spectrum, refined by parabolic interpolation.
+ * @param output: Receives at most maxPeaks of the strongest peaks, sorted by frequency.
+ * @param magnitude: Magnitude spectrum.
+ * @param bins: Number of bins in magnitude.
+ * @param binHz: Frequency spacing of the bins in Hz.
+ * @param threshold: Smallest magnitude that counts as a peak.
+ * @param maxPeaks: Most peaks to return.
+ */
+void findPeaks(std::vector<SpectralPeak> &output, const float *magnitude, int bins, float binHz, float threshold, int maxPeaks = PARTIAL_MAX);
+
+/**
+ * ----------------------------
+ * ----class PartialTracker----
+ * ----------------------------
+ * Links spectral peaks between successive frames into partials, McAulay-Quatieri style. Both
+ * the live partials and each frame's peaks are kept sorted by frequency, so matching is a single
+ * merge-like sweep that is linear in their combined count. A partial and a peak match when they
+ * are within PARTIAL_DEVIATION cents and neither has a closer candidate next to it. State is
+ * bounded by PARTIAL_MAX and, after the first frames, update() does not allocate.
+ */
+class PartialTracker
+{
+private:
+    int maxPartials;
+    float maxRatio; /// Largest frequency ratio between matched frames
+    int grace;
+    int nextId = 0;
+    std::vector<Partial> active;    /// Sorted by frequency
+    std::vector<Partial> continued; /// Scratch for update()
+    std::vector<Partial> born;      /// Scratch for update()
+
+public:
+    PartialTracker(int maxPartials = PARTIAL_MAX, float maxDeviationCents = PARTIAL_DEVIATION, int graceFrames = PARTIAL_GRACE); /// Constructor
+
+    void update(const std::vector<SpectralPeak> &peaks, std::vector<PartialUpdate> &events); /// Peaks must be sorted by frequency
+    const std::vector<Partial> &partials() const { return active; }                         /// Live partials, sorted by frequency
+    void reset();
+};
+
+#endif // PARTIAL_TRACKER_H
@@ -0,0 +1,88 @@
+#include "reassignment.h"
+#include <cmath>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+/**
+ * @brief Constructor for ReassignedStft.
+ *
+ * @param frameSize Samples per frame.
+ * @throws std::invalid_argument if frameSize is not a power of two.
+ */
+ReassignedStft::ReassignedStft(int frameSize)
+    : frameSize(frameSize), plan(FFTPlan::get(frameSize)), window(frameSize), input(frameSize + 1), framed(2 * static_cast<size_t>(frameSize)),
+      current(frameSize / 2 + 1), next(frameSize / 2 + 1), scratch(frameSize)
+{
+    for (int i = 0; i < frameSize; i++)
+    {
+        window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2 * M_PI * i / frameSize));
+    }
+}
+
+/**
+ * @brief Computes magnitudes and reassigned frequencies of one frame.
+ *
+ * The input is converted once and both windowed frames are read from it, then transformed
+ * together with FFTPlan::forwardRealPair(). Each bin's frequency
+ * is the phase advance from the first frame to the second, which is one sample later, so it
+ * needs no unwrapping.
+ * @param frame samplesNeeded() input samples.
+ * @param magnitude Array of bins() magnitudes, normalized like Stft::magnitude().
+ * @param frequency Array of bins() frequencies in Hz.
+ */
+void ReassignedStft::analyze(const sample *frame, float *magnitude, float *frequency)
+{
+    for (int i = 0; i <= frameSize; i++)
+    {
+        input[i] = frame[i];
+    }
+    float *first = framed.data(), *second = framed.data() + frameSize;
+    for (int i = 0; i < frameSize; i++)
+    {
+        first[i] = input[i] * window[i];
+        second[i] = input[i + 1] * window[i];
+    }
+    plan.forwardRealPair(first, second, current.data(), next.data(), scratch.data());
+
+    const double scale = 4.0 / (static_cast<double>(frameSize) * (MAX_SAMPLE_VALUE + 1));
+    const double hzPerRadian = RATE / (2 * M_PI);
+    for (int k = 0; k < bins(); k++)
+    {
+        magnitude[k] = static_cast<float>(std::abs(current[k]) * scale);
+        frequency[k] = static_cast<float>(std::arg(next[k] * std::conj(current[k])) * hzPerRadian);
+    }
+}
+
+/**
+ * @brief Memory held by this instance, in bytes. The shared plan is not included.
+ */
+size_t ReassignedStft::memoryBytes() const
+{
+    return sizeof(*this) + (window.capacity() + input.capacity() + framed.capacity()) * sizeof(float) +
+           (current.capacity() + next.capacity() + scratch.capacity()) * sizeof(cmplx);
+}
+
+/**
+ * @brief Returns the reassigned frequency of the strongest bin.
+ *
+ * @param magnitude Magnitudes from ReassignedStft::analyze().
+ * @param frequency Frequencies from ReassignedStft::analyze().
+ * @param bins Number of bins.
+ * @param minBin First bin to search.
+ * @return Frequency in Hz, or 0 if every searched bin is zero.
+ */
+float reassignedPeakFrequency(const float *magnitude, const float *frequency, int bins, int minBin)
+{
+    int best = -1;
+    float bestMagnitude = 0;
+    for (int k = minBin; k < bins; k++)
+    {
+        if (magnitude[k] > bestMagnitude)
+        {
+            bestMagnitude = magnitude[k];
+            best = k;
+        }
+    }
+    return best < 0 ? 0.0f : frequency[best];
+}
@@ -0,0 +1,53 @@
+#ifndef REASSIGNMENT_H
+#define REASSIGNMENT_H
+
+#include "fftPlan.h"
+#include <vector>
+
+#define REASSIGN_FRAME 4096 /// Frame size of the reassigned tuner
+
+/**
+ * ----------------------------
+ * ----class ReassignedStft----
+ * ----------------------------
+ * Windowed spectrum with a reassigned frequency for every bin. Two frames one sample apart are
+ * packed into one complex transform of the shared plan; the phase advance of each bin between them is the
+ * instantaneous frequency of the component dominating that bin. For a steady tone this is exact
+ * to a small fraction of a bin, so a 4096-point frame gives sub-cent pitch estimates that would
+ * otherwise need a frame many times longer.
+ */
+class ReassignedStft
+{
+private:
+    int frameSize;
+    const FFTPlan &plan;
+    std::vector<float> window;
+    std::vector<float> input;   /// frameSize + 1 converted samples, shared by both frames
+    std::vector<float> framed;  /// Both windowed frames, one after the other
+    std::vector<cmplx> current; /// Spectrum of samples 0 .. frameSize - 1
+    std::vector<cmplx> next;    /// Spectrum of samples 1 .. frameSize
+    std::vector<cmplx> scratch; /// Packed transform
+
+public:
+    explicit ReassignedStft(int frameSize = REASSIGN_FRAME); /// frameSize must be a power of two
+
+    int getFrameSize() const { return frameSize; }
+    int bins() const { return frameSize / 2 + 1; }
+    int samplesNeeded() const { return frameSize + 1; }
+
+    void analyze(const sample *frame, float *magnitude, float *frequency); /// Reads samplesNeeded() samples
+    size_t memoryBytes() const;
+};
+
+/**
+ * reassignedPeakFrequency()
+ * Finds the strongest bin of an analysis and returns its reassigned frequency.
+ * @param magnitude: Magnitudes from ReassignedStft::analyze().
+ * @param frequency: Frequencies from ReassignedStft::analyze().
+ * @param bins: Number of bins.
+ * @param minBin: First bin to search; skips DC and rumble.
+ * @return Frequency in Hz, or 0 if every searched bin is zero.
+ */
+float reassignedPeakFrequency(const float *magnitude, const float *frequency, int bins, int minBin = 2);
+
+#endif // REASSIGNMENT_H
@@ -0,0 +1,332 @@
+#include "rtSafety.h"
+#include "logger.h"
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#include <sstream>
+
+#if defined(__GLIBC__)
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+static thread_local bool realtimeThread = false; // Set inside a RealtimeScope
+static thread_local bool insideHook = false;     // Guards against hooks firing while recording a violation
+
+/**
+ * @brief Captures the return addresses of the current call stack.
+ *
+ * @param frames Array to store the addresses.
+ * @param max_frames Capacity of frames.
+ * @return The number of frames captured (0 where unsupported).
+ */
+static int captureStack(void **frames, int max_frames)
+{
+#if defined(__GLIBC__)
+    return backtrace(frames, max_frames);
+#elif defined(_WIN32)
+    return CaptureStackBackTrace(0, max_frames, frames, nullptr);
+#else
+    (void)frames;
+    (void)max_frames;
+    return 0;
+#endif
+}
+
+/**
+ * @brief Returns a printable name for a violation kind.
+ */
+static const char *kindName(RTViolationKind kind)
+{
+    switch (kind)
+    {
+    case RTViolationKind::Allocation:
+        return "allocation";
+    case RTViolationKind::Deallocation:
+        return "deallocation";
+    case RTViolationKind::Lock:
+        return "mutex lock";
+    case RTViolationKind::FileWrite:
+        return "file write";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Retrieves the singleton instance of RTSafetyChecker.
+ *
+ * @return RTSafetyChecker& A reference to the singleton instance.
+ */
+RTSafetyChecker &RTSafetyChecker::getInstance()
+{
+    static RTSafetyChecker instance;
+    return instance;
+}
+
+/**
+ * @brief Reports whether the interposed hooks were compiled into this binary.
+ *
+ * @return true if built with RT_SAFETY_HOOKS, false otherwise.
+ */
+bool RTSafetyChecker::hooksInstalled()
+{
+#ifdef RT_SAFETY_HOOKS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Reports whether C allocations, mutex locks and file writes are hooked too.
+ *
+ * @return true if built with RT_SAFETY_HOOKS against glibc; elsewhere only operator new/delete are checked.
+ */
+bool RTSafetyChecker::libcHooksInstalled()
+{
+#if defined(RT_SAFETY_HOOKS) && defined(__GLIBC__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Starts recording violations.
+ *
+ * Captures one stack trace up front so that lazy initialization inside the unwinder
+ * does not allocate the first time a violation is recorded.
+ */
+void RTSafetyChecker::arm()
+{
+    void *frames[1];
+    captureStack(frames, 1);
+    isArmed.store(true);
+    logMessage("Real-time safety checker armed.", "INFO");
+}
+
+/**
+ * @brief Stops recording violations. Already recorded violations are kept.
+ */
+void RTSafetyChecker::disarm()
+{
+    isArmed.store(false);
+    logMessage("Real-time safety checker disarmed with " + std::to_string(violationCount()) + " violation(s).", "INFO");
+}
+
+/**
+ * @brief Records a violation if the checker is armed and the caller is a real-time thread.
+ *
+ * Does not allocate: stack traces go into preallocated slots and are only symbolized by report().
+ * @param kind The kind of forbidden operation that was attempted.
+ */
+void RTSafetyChecker::notify(RTViolationKind kind)
+{
+    if (!realtimeThread || insideHook || !armed())
+        return;
+
+    insideHook = true;
+    int slot = count.fetch_add(1);
+    if (slot < RT_MAX_VIOLATIONS)
+    {
+        violations[slot].kind = kind;
+        violations[slot].depth = captureStack(violations[slot].frames, RT_MAX_FRAMES);
+    }
+    insideHook = false;
+}
+
+/**
+ * @brief Returns the number of violations recorded since the last reset.
+ */
+int RTSafetyChecker::violationCount() const
+{
+    return count.load();
+}
+
+/**
+ * @brief Formats all recorded violations with their stack traces.
+ *
+ * Must not be called from a real-time thread; symbolizing allocates.
+ * @return std::string The formatted report.
+ */
+std::string RTSafetyChecker::report() const
+{
+    int total = violationCount();
+    std::ostringstream oss;
+    oss << total << " real-time violation(s)";
+
+    for (int i = 0; i < total && i < RT_MAX_VIOLATIONS; i++)
+    {
+        const RTViolation &v = violations[i];
+        oss << "\n#" << i << ' ' << kindName(v.kind) << " on real-time thread";
+#if defined(__GLIBC__)
+        char **symbols = backtrace_symbols(v.frames, v.depth);
+        for (int j = 0; symbols && j < v.depth; j++)
+        {
+            oss << "\n    " << symbols[j];
+        }
+        std::free(symbols);
+#else
+        for (int j = 0; j < v.depth; j++)
+        {
+            oss << "\n    " << v.frames[j];
+        }
+#endif
+    }
+    if (total > RT_MAX_VIOLATIONS)
+        oss << "\n(" << total - RT_MAX_VIOLATIONS << " more without stack traces)";
+    return oss.str();
+}
+
+/**
+ * @brief Forgets all recorded violations.
+ */
+void RTSafetyChecker::reset()
+{
+    count.store(0);
+}
+
+/**
+ * @brief Marks the current thread as real-time until the scope ends.
+ */
+RealtimeScope::RealtimeScope() : previous(realtimeThread)
+{
+    realtimeThread = true;
+}
+
+/**
+ * @brief Restores the thread's previous real-time state.
+ */
+RealtimeScope::~RealtimeScope()
+{
+    realtimeThread = previous;
+}
+
+/**
+ * @brief Checks whether the calling thread is inside a RealtimeScope.
+ *
+ * @return true if the thread is marked real-time, false otherwise.
+ */
+bool isRealtimeThread()
+{
+    return realtimeThread;
+}
+
+#ifdef RT_SAFETY_HOOKS
+/*
+ * Interposed hooks. Each forwards to the real implementation after reporting the call.
+ * Only test and benchmark builds define RT_SAFETY_HOOKS; the application never pays for them.
+ */
+
+static inline void rtHook(RTViolationKind kind)
+{
+    if (realtimeThread)
+        RTSafetyChecker::getInstance().notify(kind);
+}
+
+#if defined(__GLIBC__)
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void __libc_free(void *ptr);
+
+static void *rawMalloc(size_t size) { return __libc_malloc(size); }
+static void rawFree(void *ptr) { __libc_free(ptr); }
+
+extern "C" void *malloc(size_t size) noexcept
+{
+    rtHook(RTViolationKind::Allocation);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) noexcept
+{
+    rtHook(RTViolationKind::Allocation);
+    return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) noexcept
+{
+    rtHook(RTViolationKind::Allocation);
+    return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void *ptr) noexcept
+{
+    if (ptr)
+        rtHook(RTViolationKind::Deallocation);
+    __libc_free(ptr);
+}
+
+// Resolved lazily with dlsym; a benign race at worst stores the same pointer twice.
+static int (*realMutexLock)(pthread_mutex_t *) = nullptr;
+static ssize_t (*realWrite)(int, const void *, size_t) = nullptr;
+static size_t (*realFwrite)(const void *, size_t, size_t, FILE *) = nullptr;
+
+extern "C" int pthread_mutex_lock(pthread_mutex_t *mutex) noexcept
+{
+    if (!realMutexLock)
+        realMutexLock = reinterpret_cast<int (*)(pthread_mutex_t *)>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+    rtHook(RTViolationKind::Lock);
+    return realMutexLock(mutex);
+}
+
+extern "C" ssize_t write(int fd, const void *buf, size_t n)
+{
+    if (!realWrite)
+        realWrite = reinterpret_cast<ssize_t (*)(int, const void *, size_t)>(dlsym(RTLD_NEXT, "write"));
+    rtHook(RTViolationKind::FileWrite);
+    return realWrite(fd, buf, n);
+}
+
+extern "C" size_t fwrite(const void *ptr, size_t size, size_t n, FILE *stream)
+{
+    if (!realFwrite)
+        realFwrite = reinterpret_cast<size_t (*)(const void *, size_t, size_t, FILE *)>(dlsym(RTLD_NEXT, "fwrite"));
+    rtHook(RTViolationKind::FileWrite);
+    return realFwrite(ptr, size, n, stream);
+}
+#else
+static void *rawMalloc(size_t size) { return std::malloc(size); }
+static void rawFree(void *ptr) { std::free(ptr); }
+#endif
+
+void *operator new(std::size_t size)
+{
+    rtHook(RTViolationKind::Allocation);
+    if (void *ptr = rawMalloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr)
+        rtHook(RTViolationKind::Deallocation);
+    rawFree(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    ::operator delete(ptr);
+}
+#endif // RT_SAFETY_HOOKS
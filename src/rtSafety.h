@@ -0,0 +1,85 @@
+#ifndef RT_SAFETY_H
+#define RT_SAFETY_H
+
+#include <atomic>
+#include <string>
+
+#define RT_MAX_FRAMES 24     /// Stack frames recorded per violation
+#define RT_MAX_VIOLATIONS 64 /// Violations stored with stack traces; later ones are only counted
+
+/// Operations that are forbidden on a thread marked real-time
+enum class RTViolationKind
+{
+    Allocation,
+    Deallocation,
+    Lock,
+    FileWrite
+};
+
+/// A single forbidden call made from a real-time thread
+struct RTViolation
+{
+    RTViolationKind kind;
+    int depth;                  /// Number of valid entries in frames
+    void *frames[RT_MAX_FRAMES]; /// Raw return addresses, symbolized on report()
+};
+
+/**
+ * ---------------------------
+ * ----class RTSafetyChecker---
+ * ---------------------------
+ * Detects allocations, locks and file writes made from threads marked real-time.
+ * The interposed malloc/free/operator new, pthread_mutex_lock and write/fwrite hooks are
+ * compiled in only when RT_SAFETY_HOOKS is defined (test and benchmark builds). Only
+ * operator new/delete can be replaced portably: the malloc, lock and write hooks need glibc,
+ * so on MinGW and other C runtimes C allocations, locks and writes go unseen (see
+ * libcHooksInstalled()). Violations are only recorded while the checker is armed.
+ */
+class RTSafetyChecker
+{
+public:
+    static RTSafetyChecker &getInstance();
+
+    static bool hooksInstalled();     /// True if built with RT_SAFETY_HOOKS
+    static bool libcHooksInstalled(); /// True if malloc/free, mutex locks and writes are hooked as well
+
+    void arm();    /// Start recording violations
+    void disarm(); /// Stop recording violations
+    bool armed() const { return isArmed.load(std::memory_order_relaxed); }
+
+    void notify(RTViolationKind kind); /// Called by the hooks; records if armed and on a real-time thread
+    int violationCount() const;        /// Total violations since the last reset()
+    std::string report() const;        /// Human readable list of violations with stack traces
+    void reset();                      /// Forget all recorded violations
+
+private:
+    RTSafetyChecker() = default;
+    RTSafetyChecker(const RTSafetyChecker &) = delete;
+    RTSafetyChecker &operator=(const RTSafetyChecker &) = delete;
+
+    std::atomic<bool> isArmed{false};
+    std::atomic<int> count{0};
+    RTViolation violations[RT_MAX_VIOLATIONS];
+};
+
+/**
+ * ------------------------
+ * ---class RealtimeScope---
+ * ------------------------
+ * Marks the current thread as real-time for the lifetime of the object.
+ * Cheap enough to construct at the top of every audio callback.
+ */
+class RealtimeScope
+{
+public:
+    RealtimeScope();
+    ~RealtimeScope();
+
+private:
+    bool previous; /// Real-time state of the thread before this scope
+};
+
+/// Whether the calling thread is currently inside a RealtimeScope
+bool isRealtimeThread();
+
+#endif // RT_SAFETY_H
@@ -0,0 +1,148 @@
+#include "sampleNotifier.h"
+#include "logger.h"
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <conio.h>
+#else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Constructs a SampleNotifier.
+ *
+ * @param hop Number of new samples per wakeup.
+ * @param watchKeyboard Whether wait() should also return on key presses.
+ * @throws std::invalid_argument if hop is not positive.
+ * @throws std::runtime_error if the wakeup object cannot be created.
+ */
+SampleNotifier::SampleNotifier(int hop, bool watchKeyboard) : hop(hop), total(0), watchKeyboard(watchKeyboard)
+{
+    if (hop <= 0)
+    {
+        logMessage("Analysis hop must be greater than zero.", "ERROR");
+        throw std::invalid_argument("Analysis hop must be greater than zero.");
+    }
+#ifdef _WIN32
+    event = CreateEvent(NULL, FALSE, FALSE, NULL);
+    if (event == NULL)
+#else
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
+#endif
+    {
+        logMessage("Failed to create analysis wakeup event.", "ERROR");
+        throw std::runtime_error("Failed to create analysis wakeup event.");
+    }
+}
+
+/**
+ * @brief Destructor for SampleNotifier.
+ */
+SampleNotifier::~SampleNotifier()
+{
+#ifdef _WIN32
+    CloseHandle(event);
+#else
+    close(fd);
+#endif
+}
+
+/**
+ * @brief Changes how many new samples wake the analysis thread.
+ *
+ * @param n_samples Samples per wakeup.
+ * @throws std::invalid_argument if n_samples is not positive.
+ */
+void SampleNotifier::setHop(int n_samples)
+{
+    if (n_samples <= 0)
+    {
+        logMessage("Analysis hop must be greater than zero.", "ERROR");
+        throw std::invalid_argument("Analysis hop must be greater than zero.");
+    }
+    hop.store(n_samples);
+    logMessage("Analysis hop set to " + std::to_string(n_samples) + " samples", "INFO");
+}
+
+/**
+ * @brief Signals the waiting thread. Several signals before a wait collapse into one wakeup.
+ */
+void SampleNotifier::signal()
+{
+#ifdef _WIN32
+    SetEvent(event);
+#else
+    eventfd_write(fd, 1);
+#endif
+}
+
+/**
+ * @brief Records pushed samples and signals each time another hop is complete. Real-time safe.
+ *
+ * @param n_samples Number of samples just pushed.
+ */
+void SampleNotifier::notify(int n_samples)
+{
+    int h = hop.load(std::memory_order_relaxed);
+    long long before = total.fetch_add(n_samples, std::memory_order_relaxed);
+    if ((before + n_samples) / h != before / h)
+        signal();
+}
+
+/**
+ * @brief Sleeps until a hop of samples is ready, a key is pressed, or the timeout expires.
+ *
+ * Key presses take priority; a pending data signal stays set for the next call.
+ * @param timeoutMs Maximum time to sleep in milliseconds.
+ * @param key Set to the pressed key when the result is WakeReason::Key.
+ * @return WakeReason Why the call returned.
+ */
+WakeReason SampleNotifier::wait(int timeoutMs, char &key)
+{
+#ifdef _WIN32
+    // WaitForMultipleObjects reports the lowest signalled index, so the console goes first
+    HANDLE handles[2] = {GetStdHandle(STD_INPUT_HANDLE), event};
+    if (!watchKeyboard)
+        return WaitForSingleObject(event, timeoutMs) == WAIT_OBJECT_0 ? WakeReason::Samples : WakeReason::Idle;
+    DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeoutMs);
+    if (result == WAIT_OBJECT_0)
+    {
+        if (_kbhit())
+        {
+            key = getch();
+            return WakeReason::Key;
+        }
+        FlushConsoleInputBuffer(handles[0]); // Mouse, focus or resize events only
+        return WaitForSingleObject(event, 0) == WAIT_OBJECT_0 ? WakeReason::Samples : WakeReason::Idle;
+    }
+    return result == WAIT_OBJECT_0 + 1 ? WakeReason::Samples : WakeReason::Idle;
+#else
+    pollfd fds[2] = {{fd, POLLIN, 0}, {STDIN_FILENO, POLLIN, 0}};
+    int ready = poll(fds, watchKeyboard ? 2 : 1, timeoutMs);
+    if (ready <= 0)
+        return WakeReason::Idle;
+
+    if (watchKeyboard && (fds[1].revents & (POLLIN | POLLHUP)))
+    {
+        char c;
+        if (read(STDIN_FILENO, &c, 1) == 1)
+        {
+            key = c;
+            return WakeReason::Key;
+        }
+        watchKeyboard = false; // End of input; stop polling it
+    }
+    if (fds[0].revents & POLLIN)
+    {
+        eventfd_t count;
+        eventfd_read(fd, &count);
+        return WakeReason::Samples;
+    }
+    return WakeReason::Idle;
+#endif
+}
@@ -0,0 +1,55 @@
+#ifndef SAMPLE_NOTIFIER_H
+#define SAMPLE_NOTIFIER_H
+
+#include <atomic>
+
+#define ANALYSIS_HOP 2048 /// Default number of new samples that wakes the analysis thread
+
+#ifdef _WIN32
+typedef void *HANDLE;
+#endif
+
+/// Why SampleNotifier::wait() returned
+enum class WakeReason
+{
+    Samples, /// At least one hop of new samples has arrived
+    Key,     /// A key was pressed
+    Idle     /// Timed out, or woke for an unrelated console event
+};
+
+/**
+ * ---------------------------
+ * ----class SampleNotifier----
+ * ---------------------------
+ * Wakes the analysis thread when the capture path has pushed a hop of new samples.
+ * notify() is real-time safe: it only signals an eventfd (Linux) or event object (Windows).
+ * wait() sleeps on that signal multiplexed with keyboard input, so an idle application
+ * uses no CPU and analysis starts as soon as data is ready.
+ */
+class SampleNotifier
+{
+private:
+    std::atomic<int> hop;         /// Samples per wakeup
+    std::atomic<long long> total; /// Samples notified so far
+    bool watchKeyboard;           /// Whether wait() also returns on key presses
+#ifdef _WIN32
+    HANDLE event;
+#else
+    int fd; /// eventfd
+#endif
+
+    void signal();
+
+public:
+    SampleNotifier(int hop = ANALYSIS_HOP, bool watchKeyboard = true); /// Constructor
+    ~SampleNotifier();                                                 /// Destructor
+    SampleNotifier(const SampleNotifier &) = delete;
+    SampleNotifier &operator=(const SampleNotifier &) = delete;
+
+    void setHop(int n_samples);                  /// Changes the wakeup granularity
+    int getHop() const { return hop.load(); }
+    void notify(int n_samples);                  /// Capture side: n_samples were pushed
+    WakeReason wait(int timeoutMs, char &key);   /// Analysis side: sleep until data, a key or timeout
+};
+
+#endif // SAMPLE_NOTIFIER_H
@@ -0,0 +1,341 @@
+#include "scheduling.h"
+#include "logger.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+#define FALLBACK_NICE -10 // Nice value tried when real-time scheduling is denied
+
+static std::atomic<int> requestedPolicy(static_cast<int>(SchedPolicy::Default));
+static std::atomic<int> requestedPriority(0);
+
+#ifndef __linux__
+/**
+ * @brief Logs and throws for a scheduling option this platform cannot honour.
+ *
+ * @param arg The option.
+ * @param reason Why it is not available.
+ * @throws std::invalid_argument always.
+ */
+static void rejectUnsupported(const std::string &arg, const std::string &reason)
+{
+    logMessage(arg + " is not supported here: " + reason, "ERROR");
+    throw std::invalid_argument(arg + " is not supported here: " + reason);
+}
+#endif
+
+/**
+ * @brief Parses one scheduling option.
+ *
+ * Recognizes --analysis-cpu N, --render-cpu N, --rt-policy fifo|rr, --rt-priority N and --mlock.
+ * Options the platform cannot apply are rejected rather than accepted and ignored: Windows has
+ * no mlockall() and no numbered real-time priorities, and other systems support none of them.
+ * @param options Options to update.
+ * @param i Index of the current argument; advanced past a consumed value.
+ * @param argc Number of command-line arguments.
+ * @param argv Array of command-line arguments.
+ * @return true if the argument was a scheduling option.
+ * @throws std::invalid_argument if an option is missing its value, the value is invalid or the
+ *         platform does not support the option.
+ */
+bool parseSchedulingArgument(SchedulingOptions &options, int &i, int argc, char **argv)
+{
+    std::string arg = argv[i];
+    if (arg != "--mlock" && arg != "--analysis-cpu" && arg != "--render-cpu" && arg != "--rt-policy" && arg != "--rt-priority")
+        return false;
+#if defined(_WIN32)
+    if (arg == "--mlock")
+        rejectUnsupported(arg, "Windows cannot lock future allocations of a process in RAM");
+    if (arg == "--rt-priority")
+        rejectUnsupported(arg, "Windows has no numbered real-time priorities; --rt-policy alone raises the audio threads to THREAD_PRIORITY_TIME_CRITICAL");
+#elif !defined(__linux__)
+    rejectUnsupported(arg, "thread scheduling and memory locking are only implemented for Linux and Windows");
+#endif
+    if (arg == "--mlock")
+    {
+        options.lockMemory = true;
+        return true;
+    }
+
+    if (i + 1 >= argc)
+    {
+        logMessage("Missing value for " + arg, "ERROR");
+        throw std::invalid_argument("Missing value for " + arg);
+    }
+    std::string value = argv[++i];
+
+    if (arg == "--rt-policy")
+    {
+        if (value == "fifo")
+            options.audioPolicy = SchedPolicy::Fifo;
+        else if (value == "rr")
+            options.audioPolicy = SchedPolicy::RoundRobin;
+        else
+        {
+            logMessage("Invalid --rt-policy: " + value, "ERROR");
+            throw std::invalid_argument("--rt-policy must be fifo or rr");
+        }
+        return true;
+    }
+
+    int number = std::atoi(value.c_str());
+    if (arg == "--analysis-cpu")
+        options.analysisCpu = number;
+    else if (arg == "--render-cpu")
+        options.renderCpu = number;
+    else if (number < 1 || number > 99)
+    {
+        logMessage("Invalid --rt-priority: " + value, "ERROR");
+        throw std::invalid_argument("--rt-priority must be between 1 and 99");
+    }
+    else
+        options.audioPriority = number;
+    return true;
+}
+
+#ifdef __linux__
+/**
+ * @brief Returns the name of a Linux scheduling policy.
+ */
+static std::string policyName(int policy)
+{
+    switch (policy)
+    {
+    case SCHED_FIFO:
+        return "SCHED_FIFO";
+    case SCHED_RR:
+        return "SCHED_RR";
+    case SCHED_OTHER:
+        return "SCHED_OTHER";
+    default:
+        return "policy " + std::to_string(policy);
+    }
+}
+#elif defined(_WIN32)
+/**
+ * @brief Lists the cores set in a Windows affinity mask, e.g. "0,2".
+ */
+static std::string cpuList(DWORD_PTR mask)
+{
+    std::string cpus;
+    for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); cpu++)
+    {
+        if (mask & (static_cast<DWORD_PTR>(1) << cpu))
+            cpus += (cpus.empty() ? "" : ",") + std::to_string(cpu);
+    }
+    return cpus;
+}
+#endif
+
+/**
+ * @brief Pins the calling thread to one or two cores.
+ *
+ * @param cpu1 First core, or -1.
+ * @param cpu2 Second core, or -1.
+ * @return std::string Description of the outcome, also logged.
+ */
+std::string pinCurrentThread(int cpu1, int cpu2)
+{
+    std::string result;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : {cpu1, cpu2})
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &set);
+    }
+    if (CPU_COUNT(&set) == 0)
+        return "no CPU affinity requested";
+
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    result = err == 0 ? "pinned to " + describeCurrentThread() : "CPU affinity failed: " + std::string(std::strerror(err));
+    logMessage(result, err == 0 ? "INFO" : "WARNING");
+#elif defined(_WIN32)
+    DWORD_PTR mask = 0;
+    for (int cpu : {cpu1, cpu2})
+    {
+        if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8))
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    if (mask == 0)
+        return "no CPU affinity requested";
+
+    bool pinned = SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+    result = pinned ? "pinned to " + describeCurrentThread() + ", CPUs " + cpuList(mask) : "CPU affinity failed: error " + std::to_string(GetLastError());
+    logMessage(result, pinned ? "INFO" : "WARNING");
+#else
+    (void)cpu1;
+    (void)cpu2;
+    result = "CPU affinity is only supported on Linux and Windows";
+    logMessage(result, "WARNING");
+#endif
+    return result;
+}
+
+/**
+ * @brief Locks all current and future pages of the process in RAM.
+ *
+ * @return std::string Description of the outcome, also logged.
+ */
+std::string lockProcessMemory()
+{
+    std::string result;
+#ifdef __linux__
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) == 0)
+    {
+        result = "process memory locked";
+    }
+    else
+    {
+        int err = errno;
+        rlimit limit{};
+        getrlimit(RLIMIT_MEMLOCK, &limit);
+        result = "mlockall failed: " + std::string(std::strerror(err)) + " (RLIMIT_MEMLOCK is " +
+                 (limit.rlim_cur == RLIM_INFINITY ? std::string("unlimited") : std::to_string(limit.rlim_cur / 1024) + " KiB") +
+                 "; raise memlock in /etc/security/limits.conf)";
+    }
+    logMessage(result, result == "process memory locked" ? "INFO" : "WARNING");
+#else
+    result = "memory locking is only supported on Linux";
+    logMessage(result, "WARNING");
+#endif
+    return result;
+}
+
+/**
+ * @brief Describes the calling thread's effective scheduling.
+ *
+ * @return std::string Policy, priority and allowed CPUs, e.g. "SCHED_OTHER priority 0, CPUs 0,1".
+ */
+std::string describeCurrentThread()
+{
+#ifdef __linux__
+    int policy = 0;
+    sched_param param{};
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    std::string result = policyName(policy) + " priority " + std::to_string(param.sched_priority);
+    if (policy == SCHED_OTHER)
+        result += " nice " + std::to_string(getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid))));
+
+    cpu_set_t set;
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+    {
+        std::string cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus += (cpus.empty() ? "" : ",") + std::to_string(cpu);
+        }
+        result += ", CPUs " + cpus;
+    }
+    return result;
+#elif defined(_WIN32)
+    int priority = GetThreadPriority(GetCurrentThread());
+    return std::string(priority == THREAD_PRIORITY_TIME_CRITICAL ? "THREAD_PRIORITY_TIME_CRITICAL" : "thread priority") + " " + std::to_string(priority);
+#else
+    return "default scheduling (policy reporting is only supported on Linux and Windows)";
+#endif
+}
+
+/**
+ * @brief Sets the policy that audio threads apply on their first callback.
+ *
+ * @param policy The scheduling policy.
+ * @param priority The real-time priority (1-99).
+ */
+void requestAudioThreadPolicy(SchedPolicy policy, int priority)
+{
+    requestedPriority.store(priority);
+    requestedPolicy.store(static_cast<int>(policy));
+}
+
+/**
+ * @brief Applies the requested policy to the calling audio thread, once per thread.
+ *
+ * SDL owns the audio threads, so they configure themselves from inside the callback.
+ * Only system calls are made here; the outcome goes into slot for the main thread to log.
+ * On Linux, if real-time scheduling is denied, a raised nice value is tried instead (no rtkit
+ * needed). Windows has one real-time level for a thread, so either policy sets
+ * THREAD_PRIORITY_TIME_CRITICAL.
+ * @param slot Where to store the outcome.
+ */
+void applyAudioThreadPolicy(AudioThreadPolicy &slot)
+{
+    static thread_local bool applied = false;
+    SchedPolicy policy = static_cast<SchedPolicy>(requestedPolicy.load(std::memory_order_relaxed));
+    if (applied || policy == SchedPolicy::Default)
+        return;
+    applied = true;
+
+#ifdef __linux__
+    sched_param param{};
+    param.sched_priority = requestedPriority.load(std::memory_order_relaxed);
+    int err = pthread_setschedparam(pthread_self(), policy == SchedPolicy::Fifo ? SCHED_FIFO : SCHED_RR, &param);
+    if (err == 0)
+    {
+        slot.state.store(1);
+        return;
+    }
+    if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), FALLBACK_NICE) == 0)
+        slot.state.store(2);
+    else
+        slot.state.store(-err);
+#elif defined(_WIN32)
+    slot.state.store(SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) ? 1 : -EPERM);
+#else
+    slot.state.store(-ENOSYS);
+#endif
+}
+
+/**
+ * @brief Describes what an audio thread reported after applying the policy.
+ *
+ * @param name Name of the thread for the message.
+ * @param slot The thread's outcome slot.
+ * @return std::string Description of the effective policy, also logged.
+ */
+std::string describeAudioThreadPolicy(const std::string &name, const AudioThreadPolicy &slot)
+{
+    SchedPolicy policy = static_cast<SchedPolicy>(requestedPolicy.load());
+#ifdef _WIN32
+    std::string requested = "THREAD_PRIORITY_TIME_CRITICAL";
+#else
+    std::string requested = std::string(policy == SchedPolicy::Fifo ? "SCHED_FIFO" : "SCHED_RR") + " priority " + std::to_string(requestedPriority.load());
+#endif
+    int state = slot.state.load();
+    std::string result;
+    std::string level = "INFO";
+
+    if (policy == SchedPolicy::Default)
+        result = name + " thread: default scheduling";
+    else if (state == 0)
+        result = name + " thread: " + requested + " requested, thread has not run yet";
+    else if (state == 1)
+        result = name + " thread: " + requested;
+    else
+    {
+        std::string hint;
+#ifdef __linux__
+        rlimit limit{};
+        getrlimit(RLIMIT_RTPRIO, &limit);
+        hint = " (RLIMIT_RTPRIO is " + std::to_string(limit.rlim_cur) + "; grant CAP_SYS_NICE or raise rtprio in /etc/security/limits.conf)";
+#endif
+        result = name + " thread: " + requested + " denied" + hint + (state == 2 ? ", fell back to SCHED_OTHER nice " + std::to_string(FALLBACK_NICE) : ", using default scheduling (" + std::string(std::strerror(-state)) + ")");
+        level = "WARNING";
+    }
+    logMessage(result, level);
+    return result;
+}
@@ -0,0 +1,52 @@
+#ifndef SCHEDULING_H
+#define SCHEDULING_H
+
+#include <atomic>
+#include <string>
+
+/// Scheduling policy requested for audio-adjacent threads
+enum class SchedPolicy
+{
+    Default,
+    Fifo,
+    RoundRobin
+};
+
+/// Startup scheduling options, set from the command line
+struct SchedulingOptions
+{
+    int analysisCpu = -1;                           /// Core for the analysis thread (-1 = any)
+    int renderCpu = -1;                             /// Core for the render thread (-1 = any)
+    SchedPolicy audioPolicy = SchedPolicy::Default; /// Policy for the SDL audio threads
+    int audioPriority = 70;                         /// Real-time priority for the SDL audio threads
+    bool lockMemory = false;                        /// Lock all current and future pages in RAM
+};
+
+/// Outcome of applying the audio policy, written by the audio thread itself
+struct AudioThreadPolicy
+{
+    std::atomic<int> state{0}; /// 0 = not applied yet, 1 = real-time, 2 = nice fallback, -errno on failure
+};
+
+/// Consumes argv[i] (and its value) if it is a scheduling option; returns false otherwise
+bool parseSchedulingArgument(SchedulingOptions &options, int &i, int argc, char **argv);
+
+/// Pins the calling thread to the given cores (-1 entries are ignored)
+std::string pinCurrentThread(int cpu1, int cpu2 = -1);
+
+/// Locks the process memory so audio and analysis never page-fault to disk
+std::string lockProcessMemory();
+
+/// Describes the calling thread's effective policy, priority and CPU set
+std::string describeCurrentThread();
+
+/// Sets the policy the audio threads apply on their first callback
+void requestAudioThreadPolicy(SchedPolicy policy, int priority);
+
+/// Applies the requested policy once per thread. Called from audio callbacks; real-time safe.
+void applyAudioThreadPolicy(AudioThreadPolicy &slot);
+
+/// Describes what an audio thread reported in its slot
+std::string describeAudioThreadPolicy(const std::string &name, const AudioThreadPolicy &slot);
+
+#endif // SCHEDULING_H
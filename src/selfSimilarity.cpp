@@ -0,0 +1,198 @@
+#include "selfSimilarity.h"
+#include "featureMatrix.h"
+#include "helper.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+
+/**
+ * @brief Fills the band of the self-similarity matrix of a feature sequence.
+ *
+ * Rows are scaled to unit length first, so each entry is a cosine similarity; an all-zero row is
+ * similar to nothing, itself included. Worker threads take row tiles in turn and compute the
+ * tiles to their right that reach into the band.
+ * @param features frames rows of dims floats.
+ * @param frames Number of rows.
+ * @param dims Floats per row.
+ * @param bandWidth Lags to keep, or 0 for the full matrix; at most frames are kept.
+ * @param threads Worker threads.
+ * @throws std::invalid_argument if a size is negative or dims is not positive.
+ */
+void SelfSimilarity::compute(const float *features, int frames, int dims, int bandWidth, int threads)
+{
+    if (frames < 0 || dims < 1 || bandWidth < 0)
+    {
+        logMessage("Self-similarity needs a frame count, positive dimensions and a band width.", "ERROR");
+        throw std::invalid_argument("Self-similarity needs a frame count, positive dimensions and a band width.");
+    }
+    frameCount = frames;
+    width = bandWidth == 0 ? frames : std::min(bandWidth, frames);
+    lag.assign(static_cast<size_t>(frames) * width, 0.0f);
+
+    std::vector<float> unit(static_cast<size_t>(frames) * dims);
+    for (int i = 0; i < frames; i++)
+    {
+        const float *row = features + static_cast<size_t>(i) * dims;
+        double energy = 0;
+        for (int d = 0; d < dims; d++)
+            energy += static_cast<double>(row[d]) * row[d];
+        float scale = energy > 0 ? static_cast<float>(1 / std::sqrt(energy)) : 0.0f;
+        for (int d = 0; d < dims; d++)
+            unit[static_cast<size_t>(i) * dims + d] = row[d] * scale;
+    }
+
+    const int tiles = (frames + SSM_TILE - 1) / SSM_TILE;
+    std::atomic<int> next{0};
+    runWorkers(threads, [&]()
+               {
+                   std::vector<float> columns(static_cast<size_t>(dims) * SSM_TILE);
+                   for (int tile; (tile = next.fetch_add(1)) < tiles;)
+                   {
+                       int first = tile * SSM_TILE, last = std::min(frames, first + SSM_TILE);
+                       int reach = std::min(frames, last - 1 + width);
+                       for (int column = first; column < reach; column += SSM_TILE)
+                       {
+                           int count = std::min(SSM_TILE, reach - column);
+                           for (int d = 0; d < dims; d++)
+                               for (int c = 0; c < SSM_TILE; c++)
+                                   columns[static_cast<size_t>(d) * SSM_TILE + c] = c < count ? unit[static_cast<size_t>(column + c) * dims + d] : 0.0f;
+
+                           for (int i = first; i < last; i++)
+                           {
+                               float dots[SSM_TILE] = {0};
+                               const float *row = unit.data() + static_cast<size_t>(i) * dims;
+                               for (int d = 0; d < dims; d++)
+                               {
+                                   const float *values = columns.data() + static_cast<size_t>(d) * SSM_TILE;
+                                   float a = row[d];
+                                   for (int c = 0; c < SSM_TILE; c++)
+                                       dots[c] += a * values[c];
+                               }
+                               for (int j = std::max(column, i); j < std::min(column + count, i + width); j++)
+                                   lag[static_cast<size_t>(j - i) * frameCount + i] = dots[j - column];
+                           }
+                       }
+                   } });
+}
+
+/**
+ * @brief Similarity of two frames, or 0 if they are a band width or more apart.
+ */
+float SelfSimilarity::at(int i, int j) const
+{
+    int d = std::abs(i - j);
+    return d < width ? lag[static_cast<size_t>(d) * frameCount + std::min(i, j)] : 0.0f;
+}
+
+/**
+ * @brief Correlates a checkerboard kernel along the main diagonal.
+ *
+ * The kernel covers kernelHalf frames before and after each frame; its quadrants weigh
+ * similarity within the past and within the future positively and across the frame negatively,
+ * tapered by a Gaussian of a standard deviation of half the kernel, and its absolute weights sum
+ * to one. Frames closer than kernelHalf to either end, where the kernel would reach past the
+ * recording, get no novelty. Each thread takes a run of frames and passes over the diagonals it
+ * needs once per kernel entry above the diagonal.
+ * @param out Receives one value per frame; about 0.5 for a frame between two uniform sections
+ *        that share nothing.
+ * @param kernelHalf Frames on each side of the kernel centre.
+ * @param threads Worker threads.
+ * @throws std::invalid_argument if the kernel is wider than the band.
+ */
+void SelfSimilarity::novelty(std::vector<float> &out, int kernelHalf, int threads) const
+{
+    const int span = 2 * kernelHalf;
+    if (kernelHalf < 1 || (span > width && width < frameCount))
+    {
+        logMessage("Novelty kernel must be positive and fit in the similarity band.", "ERROR");
+        throw std::invalid_argument("Novelty kernel must be positive and fit in the similarity band.");
+    }
+
+    std::vector<float> kernel(static_cast<size_t>(span) * span);
+    double total = 0;
+    for (int a = 0; a < span; a++)
+    {
+        for (int b = 0; b < span; b++)
+        {
+            double x = (a - kernelHalf + 0.5) / (0.5 * kernelHalf), y = (b - kernelHalf + 0.5) / (0.5 * kernelHalf);
+            double weight = std::exp(-0.5 * (x * x + y * y));
+            kernel[static_cast<size_t>(a) * span + b] = static_cast<float>((a < kernelHalf) == (b < kernelHalf) ? weight : -weight);
+            total += weight;
+        }
+    }
+    for (float &weight : kernel)
+        weight = static_cast<float>(weight / total);
+
+    out.assign(frameCount, 0.0f);
+    const int chunk = 4096; // Frames per work item; their diagonals stay in cache across the kernel
+    std::atomic<int> next{0};
+    runWorkers(threads, [&]()
+               {
+                   for (int first; (first = next.fetch_add(chunk)) < frameCount;)
+                   {
+                       int last = std::min(frameCount, first + chunk);
+                       float *result = out.data();
+                       for (int a = 0; a < span; a++)
+                       {
+                           for (int b = a; b < span && b - a < width; b++)
+                           {
+                               // Frame i meets frames i + a - kernelHalf and i + b - kernelHalf, lag b - a
+                               float weight = (a == b ? 1 : 2) * kernel[static_cast<size_t>(a) * span + b];
+                               int shift = a - kernelHalf;
+                               int begin = std::max(first, kernelHalf), end = std::min(last, frameCount - kernelHalf);
+                               const float *diagonal = lag.data() + static_cast<size_t>(b - a) * frameCount;
+                               for (int i = begin; i < end; i++)
+                                   result[i] += weight * diagonal[i + shift];
+                           }
+                       }
+                   } });
+}
+
+/**
+ * @brief Frames where the novelty peaks: the highest within minGap frames on either side and above a threshold.
+ *
+ * @param novelty Novelty curve from SelfSimilarity::novelty().
+ * @param minGap Frames on each side a peak must dominate.
+ * @param threshold Lowest novelty accepted.
+ * @return Frame numbers in increasing order.
+ */
+std::vector<int> noveltyPeaks(const std::vector<float> &novelty, int minGap, float threshold)
+{
+    std::vector<int> peaks;
+    const int n = static_cast<int>(novelty.size());
+    for (int i = 0; i < n; i++)
+    {
+        if (novelty[i] <= threshold)
+            continue;
+        bool highest = true;
+        for (int j = std::max(0, i - minGap); j <= std::min(n - 1, i + minGap) && highest; j++)
+            highest = j < i ? novelty[j] < novelty[i] : novelty[j] <= novelty[i];
+        if (highest)
+            peaks.push_back(i);
+    }
+    return peaks;
+}
+
+/**
+ * @brief Finds where sections of a recording begin from the novelty of its chroma and MFCC.
+ *
+ * @param audio Mono samples at RATE.
+ * @param n Number of samples.
+ * @param threads Worker threads.
+ * @return Start times in seconds of every section after the first.
+ */
+std::vector<double> sectionBoundaries(const sample *audio, size_t n, int threads)
+{
+    std::vector<float> features, curve;
+    extractSimilarityFeatures(audio, n, features, threads);
+    SelfSimilarity matrix;
+    matrix.compute(features.data(), static_cast<int>(features.size() / SIMILARITY_DIMS), SIMILARITY_DIMS, SSM_BAND, threads);
+    matrix.novelty(curve, NOVELTY_KERNEL, threads);
+
+    std::vector<double> seconds;
+    for (int frame : noveltyPeaks(curve))
+        seconds.push_back(static_cast<double>(frame) * SIMILARITY_HOP / RATE);
+    return seconds;
+}
@@ -0,0 +1,47 @@
+#ifndef SELF_SIMILARITY_H
+#define SELF_SIMILARITY_H
+
+#include "audioProcessor.h"
+#include <cstddef>
+#include <vector>
+
+#define SSM_TILE 64               /// Frames per side of a tile; a tile of 24-dimensional rows is 6 KiB
+#define SSM_BAND 128              /// Lags kept by default, about 12 s of similarity rows
+#define NOVELTY_KERNEL 32         /// Half width of the checkerboard kernel in frames, about 3 s
+#define NOVELTY_MIN_GAP 54        /// Frames between section boundaries, about 5 s
+#define NOVELTY_THRESHOLD 0.05f   /// Lowest normalized novelty taken as a boundary
+
+/**
+ * ----------------------------
+ * ----class SelfSimilarity----
+ * ----------------------------
+ * Cosine similarity between every pair of feature frames closer than a band width, stored by
+ * lag: one contiguous diagonal per lag, so memory grows with the band width rather than the
+ * square of the frame count, and a band as wide as the recording is the full matrix. The band
+ * is filled in square tiles of SSM_TILE frames on several threads; each tile transposes its
+ * columns once so the dot products run across the tile in vector registers. Foote's novelty
+ * curve is correlated along the main diagonal with a Gaussian-tapered checkerboard kernel,
+ * which reads only lags below the kernel width; with lags stored contiguously each kernel entry
+ * is one pass over a diagonal.
+ */
+class SelfSimilarity
+{
+private:
+    int frameCount = 0;
+    int width = 0;          /// Lags kept, 0 up to width - 1
+    std::vector<float> lag; /// lag[d * frameCount + i] is the similarity of frames i and i + d
+
+public:
+    void compute(const float *features, int frames, int dims, int bandWidth = SSM_BAND, int threads = 1);
+    void novelty(std::vector<float> &out, int kernelHalf = NOVELTY_KERNEL, int threads = 1) const;
+    float at(int i, int j) const; /// 0 beyond the band
+
+    int frames() const { return frameCount; }
+    int band() const { return width; }
+    size_t memoryBytes() const { return lag.size() * sizeof(float); }
+};
+
+std::vector<int> noveltyPeaks(const std::vector<float> &novelty, int minGap = NOVELTY_MIN_GAP, float threshold = NOVELTY_THRESHOLD);
+std::vector<double> sectionBoundaries(const sample *audio, size_t n, int threads = 1); /// Seconds where sections begin
+
+#endif // SELF_SIMILARITY_H
@@ -0,0 +1,469 @@
+#include "similaritySearch.h"
+#include "helper.h"
+#include "logger.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static const char ivfMagic[8] = {'A', 'D', 'S', 'P', 'I', 'V', 'F', '1'};
+static const size_t assignBlock = 4096; // Rows a worker takes at a time
+static const int centroidBlock = 16;    // Centroids scored together; the transposed centroids are padded to a multiple
+
+/// Layout of the start of an inverted file; centroids, list offsets and list rows follow
+struct IvfFileHeader
+{
+    char magic[8];
+    uint32_t dims;
+    uint32_t lists;
+    uint64_t rows;
+};
+
+/**
+ * @brief Squared distance between a query and a half row.
+ *
+ * Four partial sums, so the compiler can keep them in one vector register without reordering
+ * the additions of a single sum; the half decode is branch-free for the same reason.
+ */
+static inline float rowDistance(const float *query, const uint16_t *row)
+{
+    float lanes[4] = {0, 0, 0, 0};
+    for (int d = 0; d < SIMILARITY_DIMS; d += 4)
+    {
+        for (int l = 0; l < 4; l++)
+        {
+            float diff = halfToFloat(row[d + l]) - query[d + l];
+            lanes[l] += diff * diff;
+        }
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+/**
+ * @brief Offers a row to a max-heap of the k nearest rows seen so far.
+ */
+static inline void keepNearest(std::vector<SimilarityMatch> &heap, size_t k, size_t row, float distance)
+{
+    auto farther = [](const SimilarityMatch &a, const SimilarityMatch &b)
+    { return a.distance < b.distance; };
+    if (heap.size() < k)
+    {
+        heap.push_back({row, distance});
+        std::push_heap(heap.begin(), heap.end(), farther);
+    }
+    else if (distance < heap.front().distance)
+    {
+        std::pop_heap(heap.begin(), heap.end(), farther);
+        heap.back() = {row, distance};
+        std::push_heap(heap.begin(), heap.end(), farther);
+    }
+}
+
+/**
+ * @brief Sorts a heap of matches nearest first, ties by row.
+ */
+static std::vector<SimilarityMatch> sortedMatches(std::vector<SimilarityMatch> &heap)
+{
+    std::sort(heap.begin(), heap.end(), [](const SimilarityMatch &a, const SimilarityMatch &b)
+              { return a.distance < b.distance || (a.distance == b.distance && a.row < b.row); });
+    return heap;
+}
+
+SimilarityIndex::SimilarityIndex(const FeatureMatrix &matrix) : matrix(matrix) {}
+
+/**
+ * @brief Replaces the centroids and their transposed copy.
+ */
+void SimilarityIndex::setCentroids(const float *values, int count)
+{
+    lists = count;
+    centroids.assign(values, values + static_cast<size_t>(count) * SIMILARITY_DIMS);
+    stride = (count + centroidBlock - 1) / centroidBlock * centroidBlock;
+    centroidColumns.assign(static_cast<size_t>(stride) * SIMILARITY_DIMS, 0.0f);
+    for (int c = 0; c < count; c++)
+        for (int d = 0; d < SIMILARITY_DIMS; d++)
+            centroidColumns[static_cast<size_t>(d) * stride + c] = centroids[static_cast<size_t>(c) * SIMILARITY_DIMS + d];
+}
+
+/**
+ * @brief Squared distances from a query to every centroid.
+ *
+ * Walks the transposed centroids one dimension at a time, so the inner loop updates independent
+ * distances and vectorizes without a reduction. The distances build up in a local block the
+ * compiler knows nothing else points into, which spares it an aliasing check it would not
+ * vectorize under.
+ * @param query SIMILARITY_DIMS floats.
+ * @param out Receives listCount() distances.
+ */
+void SimilarityIndex::centroidDistances(const float *query, float *out) const
+{
+    for (int first = 0; first < lists; first += centroidBlock)
+    {
+        int count = std::min(centroidBlock, lists - first);
+        float block[centroidBlock] = {0};
+        for (int d = 0; d < SIMILARITY_DIMS; d++)
+        {
+            const float *column = centroidColumns.data() + static_cast<size_t>(d) * stride + first;
+            float q = query[d];
+            for (int c = 0; c < centroidBlock; c++)
+            {
+                float diff = column[c] - q;
+                block[c] += diff * diff;
+            }
+        }
+        std::copy_n(block, count, out + first);
+    }
+}
+
+/**
+ * @brief Nearest centroid of each of a block of rows, on several threads.
+ *
+ * @param rows SIMILARITY_DIMS floats per row.
+ * @param count Number of rows.
+ * @param out Receives one list number per row.
+ * @param threads Worker threads.
+ */
+void SimilarityIndex::assign(const float *rows, size_t count, uint32_t *out, int threads) const
+{
+    std::atomic<size_t> next{0};
+    runWorkers(threads, [&]()
+               {
+                   std::vector<float> distances(lists);
+                   for (size_t start; (start = next.fetch_add(assignBlock)) < count;)
+                   {
+                       for (size_t r = start; r < std::min(count, start + assignBlock); r++)
+                       {
+                           centroidDistances(rows + r * SIMILARITY_DIMS, distances.data());
+                           out[r] = static_cast<uint32_t>(std::min_element(distances.begin(), distances.end()) - distances.begin());
+                       }
+                   } });
+}
+
+/**
+ * @brief Clusters the rows and builds the inverted lists.
+ *
+ * k-means runs on SEARCH_TRAIN_PER_LIST evenly spaced rows per list, seeded with evenly spaced
+ * rows; a list that loses all its rows keeps its centroid. Then every row is assigned to its
+ * nearest centroid and the rows are grouped by list with a counting sort, each list in row order.
+ * @param listCount Number of lists, or 0 for the square root of the row count clamped to
+ *        [SEARCH_MIN_LISTS, SEARCH_MAX_LISTS].
+ * @param threads Worker threads for the assignments.
+ */
+void SimilarityIndex::train(int listCount, int threads)
+{
+    size_t n = matrix.rowCount();
+    mapped.reset();
+    listOffsets = listRows = nullptr;
+    if (n == 0)
+    {
+        lists = 0;
+        return;
+    }
+    if (listCount <= 0)
+        listCount = std::clamp(static_cast<int>(std::sqrt(static_cast<double>(n))), SEARCH_MIN_LISTS, SEARCH_MAX_LISTS);
+    listCount = static_cast<int>(std::min<size_t>(listCount, n));
+
+    size_t samples = std::min(n, static_cast<size_t>(listCount) * SEARCH_TRAIN_PER_LIST);
+    std::vector<float> training(samples * SIMILARITY_DIMS);
+    for (size_t s = 0; s < samples; s++)
+    {
+        const uint16_t *row = matrix.row(s * n / samples);
+        for (int d = 0; d < SIMILARITY_DIMS; d++)
+            training[s * SIMILARITY_DIMS + d] = halfToFloat(row[d]);
+    }
+    std::vector<float> seeds(static_cast<size_t>(listCount) * SIMILARITY_DIMS);
+    for (int c = 0; c < listCount; c++)
+        std::copy_n(training.data() + c * samples / listCount * SIMILARITY_DIMS, SIMILARITY_DIMS, seeds.data() + static_cast<size_t>(c) * SIMILARITY_DIMS);
+    setCentroids(seeds.data(), listCount);
+
+    std::vector<uint32_t> assignment(samples);
+    std::vector<double> sums(seeds.size());
+    std::vector<size_t> counts(listCount);
+    for (int iteration = 0; iteration < SEARCH_ITERATIONS; iteration++)
+    {
+        assign(training.data(), samples, assignment.data(), threads);
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (size_t s = 0; s < samples; s++)
+        {
+            counts[assignment[s]]++;
+            for (int d = 0; d < SIMILARITY_DIMS; d++)
+                sums[assignment[s] * SIMILARITY_DIMS + d] += training[s * SIMILARITY_DIMS + d];
+        }
+        for (int c = 0; c < listCount; c++)
+            for (int d = 0; d < SIMILARITY_DIMS && counts[c] > 0; d++)
+                seeds[static_cast<size_t>(c) * SIMILARITY_DIMS + d] = static_cast<float>(sums[static_cast<size_t>(c) * SIMILARITY_DIMS + d] / counts[c]);
+        setCentroids(seeds.data(), listCount);
+    }
+    std::vector<float>().swap(training);
+
+    std::vector<uint32_t> listOf(n);
+    std::vector<float> block(assignBlock * SIMILARITY_DIMS);
+    for (size_t start = 0; start < n; start += assignBlock)
+    {
+        size_t count = std::min(assignBlock, n - start);
+        for (size_t i = 0; i < count * SIMILARITY_DIMS; i++)
+            block[i] = halfToFloat(matrix.row(start)[i]);
+        assign(block.data(), count, listOf.data() + start, threads);
+    }
+
+    ownedOffsets.assign(listCount + 1, 0);
+    for (uint32_t list : listOf)
+        ownedOffsets[list + 1]++;
+    for (int c = 0; c < listCount; c++)
+        ownedOffsets[c + 1] += ownedOffsets[c];
+    ownedRows.resize(n);
+    std::vector<uint32_t> cursor(ownedOffsets.begin(), ownedOffsets.end() - 1);
+    for (size_t r = 0; r < n; r++)
+        ownedRows[cursor[listOf[r]]++] = static_cast<uint32_t>(r);
+    listOffsets = ownedOffsets.data();
+    listRows = ownedRows.data();
+    logMessage("Similarity index sorted " + std::to_string(n) + " rows into " + std::to_string(listCount) + " lists.", "INFO");
+}
+
+/**
+ * @brief Writes the centroids and lists so load() can map them.
+ *
+ * @param path File to create or truncate.
+ * @throws std::runtime_error if the index is untrained or the file cannot be written.
+ */
+void SimilarityIndex::save(const std::string &path) const
+{
+    IvfFileHeader header = {};
+    std::memcpy(header.magic, ivfMagic, sizeof(ivfMagic));
+    header.dims = SIMILARITY_DIMS;
+    header.lists = static_cast<uint32_t>(lists);
+    header.rows = matrix.rowCount();
+
+    std::ofstream out(path, std::ios::binary);
+    if (trained())
+    {
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(centroids.data()), static_cast<std::streamsize>(centroids.size() * sizeof(float)));
+        out.write(reinterpret_cast<const char *>(listOffsets), static_cast<std::streamsize>((lists + 1) * sizeof(uint32_t)));
+        out.write(reinterpret_cast<const char *>(listRows), static_cast<std::streamsize>(header.rows * sizeof(uint32_t)));
+    }
+    if (!trained() || !out)
+    {
+        logMessage("Cannot write similarity index " + path, "ERROR");
+        throw std::runtime_error("Cannot write similarity index " + path);
+    }
+}
+
+/**
+ * @brief Checks that a mapped inverted file is complete, self-consistent and fits the matrix.
+ *
+ * The list offsets must rise from 0 to the row count and every list entry must name an existing
+ * row, so approximate() can trust the mapping.
+ * @param base Start of the mapped file.
+ * @param size Size of the file in bytes.
+ * @param rowCount Rows in the feature matrix the index belongs to.
+ * @param header Receives the file header.
+ * @return true if the file can be served as is.
+ */
+static bool parseIvfFile(const uint8_t *base, size_t size, size_t rowCount, IvfFileHeader &header)
+{
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, base, sizeof(header));
+    size_t rest = size - sizeof(header);
+    if (std::memcmp(header.magic, ivfMagic, sizeof(ivfMagic)) != 0 || header.dims != SIMILARITY_DIMS || header.lists == 0 ||
+        header.rows != rowCount || header.lists > rest / (SIMILARITY_DIMS * sizeof(float) + sizeof(uint32_t)) ||
+        rest != header.lists * SIMILARITY_DIMS * sizeof(float) + (uint64_t(header.lists) + 1 + header.rows) * sizeof(uint32_t))
+        return false;
+
+    const uint32_t *offsets = reinterpret_cast<const uint32_t *>(base + sizeof(header) + header.lists * SIMILARITY_DIMS * sizeof(float));
+    if (offsets[0] != 0 || offsets[header.lists] != header.rows)
+        return false;
+    for (uint32_t c = 0; c < header.lists; c++)
+    {
+        if (offsets[c] > offsets[c + 1])
+            return false;
+    }
+    const uint32_t *entries = offsets + header.lists + 1;
+    for (uint64_t i = 0; i < header.rows; i++)
+    {
+        if (entries[i] >= header.rows)
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Maps an inverted file written by save(); the centroids are copied, the lists are not.
+ *
+ * The header, list offsets and list rows are validated once before the mapping is accepted.
+ * @param path Index file.
+ * @throws std::runtime_error if the file cannot be mapped, is damaged or belongs to another matrix.
+ */
+void SimilarityIndex::load(const std::string &path)
+{
+    std::unique_ptr<MappedFile> file(new MappedFile(path));
+    const uint8_t *base = file->data();
+    IvfFileHeader header;
+    if (!parseIvfFile(base, file->size(), matrix.rowCount(), header))
+    {
+        logMessage("Similarity index " + path + " is damaged or belongs to another feature matrix.", "ERROR");
+        throw std::runtime_error("Similarity index " + path + " is damaged or belongs to another feature matrix.");
+    }
+
+    mapped = std::move(file);
+    std::vector<float> values(header.lists * SIMILARITY_DIMS);
+    std::memcpy(values.data(), base + sizeof(header), values.size() * sizeof(float));
+    setCentroids(values.data(), static_cast<int>(header.lists));
+    listOffsets = reinterpret_cast<const uint32_t *>(base + sizeof(header) + values.size() * sizeof(float));
+    listRows = listOffsets + lists + 1;
+    std::vector<uint32_t>().swap(ownedOffsets);
+    std::vector<uint32_t>().swap(ownedRows);
+    logMessage("Mapped similarity index of " + std::to_string(lists) + " lists from " + path, "INFO");
+}
+
+/**
+ * @brief Scans every row for the k nearest to a query.
+ *
+ * @param query SIMILARITY_DIMS floats.
+ * @param k Number of neighbours.
+ * @return Up to k matches, nearest first.
+ */
+std::vector<SimilarityMatch> SimilarityIndex::exact(const float *query, int k) const
+{
+    std::vector<SimilarityMatch> heap;
+    heap.reserve(k);
+    size_t n = matrix.rowCount();
+    for (size_t r = 0; r < n && k > 0; r++)
+        keepNearest(heap, k, r, rowDistance(query, matrix.row(r)));
+    return sortedMatches(heap);
+}
+
+/**
+ * @brief Approximate k nearest rows, scanning the lists of the nearest centroids.
+ *
+ * @param query SIMILARITY_DIMS floats.
+ * @param k Number of neighbours.
+ * @param probes Lists to scan; more finds more of the true neighbours at proportional cost.
+ * @return Up to k matches, nearest first.
+ */
+std::vector<SimilarityMatch> SimilarityIndex::search(const float *query, int k, int probes) const
+{
+    if (!trained())
+        return exact(query, k);
+
+    std::vector<float> distances(lists);
+    centroidDistances(query, distances.data());
+    std::vector<int> order(lists);
+    for (int c = 0; c < lists; c++)
+        order[c] = c;
+    probes = std::clamp(probes, 1, lists);
+    std::partial_sort(order.begin(), order.begin() + probes, order.end(), [&](int a, int b)
+                      { return distances[a] < distances[b]; });
+
+    std::vector<SimilarityMatch> heap;
+    heap.reserve(k);
+    for (int p = 0; p < probes && k > 0; p++)
+        for (uint32_t i = listOffsets[order[p]]; i < listOffsets[order[p] + 1]; i++)
+            keepNearest(heap, k, listRows[i], rowDistance(query, matrix.row(listRows[i])));
+    return sortedMatches(heap);
+}
+
+/**
+ * @brief Finds where in the library a sequence of frames best recurs.
+ *
+ * Each query frame i takes its SEARCH_CANDIDATES nearest rows; a neighbour at row r votes for a
+ * passage starting at row r - i. Votes are sorted and each start is scored with those of its two
+ * neighbouring starts, since the query rarely lines up with the hop grid. The best starts are
+ * reported, skipping any within a query length of a better one in the same file.
+ * @param frames SIMILARITY_DIMS floats per query frame.
+ * @param k Number of passages.
+ * @return Up to k passages, most votes first.
+ */
+std::vector<PassageMatch> SimilarityIndex::searchPassage(const std::vector<float> &frames, int k) const
+{
+    struct Vote
+    {
+        int64_t start;
+        float distance;
+    };
+    size_t count = frames.size() / SIMILARITY_DIMS;
+    std::vector<Vote> votes;
+    votes.reserve(count * SEARCH_CANDIDATES);
+    for (size_t i = 0; i < count; i++)
+    {
+        for (const SimilarityMatch &match : search(frames.data() + i * SIMILARITY_DIMS, SEARCH_CANDIDATES))
+        {
+            int64_t start = static_cast<int64_t>(match.row) - static_cast<int64_t>(i);
+            if (start >= 0 && matrix.fileOf(static_cast<size_t>(start)) == matrix.fileOf(match.row))
+                votes.push_back({start, match.distance});
+        }
+    }
+    std::sort(votes.begin(), votes.end(), [](const Vote &a, const Vote &b)
+              { return a.start < b.start; });
+
+    struct Run
+    {
+        int64_t start;
+        int count;
+        float distance;
+        int score;
+    };
+    std::vector<Run> runs;
+    for (size_t i = 0; i < votes.size();)
+    {
+        Run run = {votes[i].start, 0, 0, 0};
+        for (; i < votes.size() && votes[i].start == run.start; i++)
+        {
+            run.count++;
+            run.distance += votes[i].distance;
+        }
+        runs.push_back(run);
+    }
+    for (size_t r = 0; r < runs.size(); r++)
+    {
+        runs[r].score = runs[r].count;
+        if (r > 0 && runs[r - 1].start + 1 == runs[r].start)
+            runs[r].score += runs[r - 1].count;
+        if (r + 1 < runs.size() && runs[r + 1].start == runs[r].start + 1)
+            runs[r].score += runs[r + 1].count;
+    }
+    std::sort(runs.begin(), runs.end(), [](const Run &a, const Run &b)
+              { return a.score > b.score || (a.score == b.score && a.distance * b.count < b.distance * a.count); });
+
+    std::vector<PassageMatch> passages;
+    std::vector<int64_t> taken;
+    for (const Run &run : runs)
+    {
+        if (static_cast<int>(passages.size()) >= k)
+            break;
+        int file = matrix.fileOf(static_cast<size_t>(run.start));
+        bool overlaps = false;
+        for (size_t p = 0; p < passages.size() && !overlaps; p++)
+            overlaps = passages[p].file == file && std::llabs(taken[p] - run.start) < static_cast<int64_t>(std::max<size_t>(count, 1));
+        if (overlaps)
+            continue;
+        PassageMatch passage;
+        passage.file = file;
+        passage.name = matrix.fileName(file);
+        passage.seconds = matrix.timeOf(static_cast<size_t>(run.start));
+        passage.votes = run.score;
+        passage.distance = run.distance / run.count;
+        passages.push_back(passage);
+        taken.push_back(run.start);
+    }
+    return passages;
+}
+
+/**
+ * @brief Finds where in the library a stretch of audio best recurs.
+ *
+ * @param audio Samples at RATE; at least SIMILARITY_FRAME of them.
+ * @param n Number of samples.
+ * @param k Number of passages.
+ * @return Up to k passages, most votes first.
+ */
+std::vector<PassageMatch> SimilarityIndex::searchPassage(const sample *audio, size_t n, int k) const
+{
+    std::vector<float> frames;
+    extractSimilarityFeatures(audio, n, frames);
+    return searchPassage(frames, k);
+}
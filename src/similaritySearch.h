@@ -0,0 +1,81 @@
+#ifndef SIMILARITY_SEARCH_H
+#define SIMILARITY_SEARCH_H
+
+#include "featureMatrix.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define SEARCH_MIN_LISTS 16         /// Fewest inverted lists train() chooses by itself
+#define SEARCH_MAX_LISTS 2048       /// Most inverted lists train() chooses by itself
+#define SEARCH_TRAIN_PER_LIST 64    /// Rows sampled per list to train the centroids
+#define SEARCH_ITERATIONS 10        /// k-means iterations over the sample
+#define SEARCH_PROBES 8             /// Lists scanned per query frame
+#define SEARCH_CANDIDATES 16        /// Neighbours of each query frame that vote in a passage search
+#define SEARCH_QUERY (2 * FFTLEN)   /// Samples of live audio in each passage query (3 s)
+#define SEARCH_RESULTS 3            /// Passages listed by the live display
+
+/// A row of the matrix and its squared distance to the query
+struct SimilarityMatch
+{
+    size_t row;
+    float distance;
+};
+
+/// A stretch of a file that resembles a query passage
+struct PassageMatch
+{
+    int file = -1;
+    std::string name;
+    double seconds = 0;  /// Where the passage starts in the file
+    int votes = 0;       /// Query frames whose neighbours agree on that start
+    float distance = 0;  /// Mean squared distance of the agreeing neighbours
+};
+
+/**
+ * -----------------------------
+ * ----class SimilarityIndex----
+ * -----------------------------
+ * Nearest-neighbour search over the rows of a FeatureMatrix. exact() scans every row and is the
+ * reference. train() builds an inverted file: k-means on a sample of the rows gives centroids,
+ * every row is listed under its nearest centroid, and search() scans only the lists of the
+ * SEARCH_PROBES centroids nearest the query, a few thousandths of the rows. searchPassage()
+ * matches a sequence of frames by letting each frame's neighbours vote for where the sequence
+ * would start, as the fingerprint index does with landmarks. The matrix must outlive the index.
+ */
+class SimilarityIndex
+{
+private:
+    const FeatureMatrix &matrix;
+    int lists = 0;
+    int stride = 0;                       /// lists rounded up to a whole block of centroids
+    std::vector<float> centroids;         /// lists x SIMILARITY_DIMS, as saved
+    std::vector<float> centroidColumns;   /// SIMILARITY_DIMS x stride, for scoring all centroids at once
+    std::vector<uint32_t> ownedOffsets, ownedRows;
+    const uint32_t *listOffsets = nullptr; /// lists + 1 entries
+    const uint32_t *listRows = nullptr;    /// Matrix rows grouped by list
+    std::unique_ptr<MappedFile> mapped;    /// Holds the lists after load()
+
+    void setCentroids(const float *values, int count);
+    void centroidDistances(const float *query, float *out) const;
+    void assign(const float *rows, size_t count, uint32_t *out, int threads) const;
+
+public:
+    explicit SimilarityIndex(const FeatureMatrix &matrix);
+    SimilarityIndex(const SimilarityIndex &) = delete;
+    SimilarityIndex &operator=(const SimilarityIndex &) = delete;
+
+    void train(int listCount, int threads); /// listCount 0 picks the square root of the row count
+    void save(const std::string &path) const;
+    void load(const std::string &path);     /// Maps a file written by save() for the same matrix
+    bool trained() const { return listOffsets != nullptr; }
+    int listCount() const { return lists; }
+
+    std::vector<SimilarityMatch> exact(const float *query, int k) const;
+    std::vector<SimilarityMatch> search(const float *query, int k, int probes = SEARCH_PROBES) const; /// exact() until trained
+    std::vector<PassageMatch> searchPassage(const std::vector<float> &frames, int k) const;            /// Rows from extractSimilarityFeatures()
+    std::vector<PassageMatch> searchPassage(const sample *audio, size_t n, int k) const;
+};
+
+#endif // SIMILARITY_SEARCH_H
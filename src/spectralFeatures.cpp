@@ -0,0 +1,98 @@
+#include "spectralFeatures.h"
+#include "logger.h"
+#include <stdexcept>
+
+/**
+ * @brief Returns the lower edge of a band: 0 Hz for the first, then octaves from 125 Hz.
+ *
+ * @param band Band index, 0 to FEATURE_BANDS.
+ */
+float featureBandEdge(int band)
+{
+    return band == 0 ? 0.0f : 125.0f * static_cast<float>(1 << (band - 1));
+}
+
+/**
+ * @brief Splits a spectrum into segments that each lie in one band and one rolloff block.
+ *
+ * @param bins Bins in the spectrum.
+ * @param binHz Spacing of the bins in Hz.
+ * @return Segments in bin order, covering every bin once.
+ */
+std::vector<FeatureSegment> featureSegments(int bins, float binHz)
+{
+    std::vector<FeatureSegment> segments;
+    int band = 0;
+    for (int start = 0; start < bins;)
+    {
+        while (band + 1 < FEATURE_BANDS && start * binHz >= featureBandEdge(band + 1))
+            band++;
+        int end = std::min(bins, (start / FEATURE_BLOCK + 1) * FEATURE_BLOCK);
+        if (band + 1 < FEATURE_BANDS)
+            end = std::min(end, static_cast<int>(std::ceil(featureBandEdge(band + 1) / binHz)));
+        end = std::max(end, start + 1);
+        segments.push_back({start, end - start, band, start / FEATURE_BLOCK});
+        start = end;
+    }
+    return segments;
+}
+
+/**
+ * @brief Opens a CSV file and writes its header.
+ *
+ * @param path File to create or truncate.
+ * @param set Features to export, as SpectralFeature bits.
+ * @throws std::runtime_error if the file cannot be opened.
+ */
+FeatureCsvExporter::FeatureCsvExporter(const std::string &path, unsigned set) : file(path), set(set)
+{
+    if (!file)
+    {
+        logMessage("Cannot open feature export file " + path, "ERROR");
+        throw std::runtime_error("Cannot open feature export file " + path);
+    }
+    file << "time";
+    if (set & FeatureCentroid)
+        file << ",centroid";
+    if (set & FeatureSpread)
+        file << ",spread";
+    if (set & FeatureRolloff)
+        file << ",rolloff";
+    if (set & FeatureFlatness)
+        file << ",flatness";
+    if (set & FeatureFlux)
+        file << ",flux";
+    if (set & FeatureBandEnergy)
+    {
+        for (int b = 0; b < FEATURE_BANDS; b++)
+            file << ",band" << static_cast<int>(featureBandEdge(b));
+    }
+    file << "\n";
+}
+
+/**
+ * @brief Appends the descriptors of one frame.
+ *
+ * @param seconds Time of the frame since the session started.
+ * @param features Descriptors from FeatureBank::compute().
+ */
+void FeatureCsvExporter::write(double seconds, const SpectralFeatures &features)
+{
+    file << seconds;
+    if (set & FeatureCentroid)
+        file << "," << features.centroid;
+    if (set & FeatureSpread)
+        file << "," << features.spread;
+    if (set & FeatureRolloff)
+        file << "," << features.rolloff;
+    if (set & FeatureFlatness)
+        file << "," << features.flatness;
+    if (set & FeatureFlux)
+        file << "," << features.flux;
+    if (set & FeatureBandEnergy)
+    {
+        for (int b = 0; b < FEATURE_BANDS; b++)
+            file << "," << features.bands[b];
+    }
+    file << "\n";
+}
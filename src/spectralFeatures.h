@@ -0,0 +1,288 @@
+#ifndef SPECTRAL_FEATURES_H
+#define SPECTRAL_FEATURES_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#define FEATURE_BANDS 8        /// Band energies: below 125 Hz, six octaves up to 8 kHz, and above
+#define FEATURE_BLOCK 64       /// Bins per block of the fused pass; the rolloff search rescans one block
+#define FEATURE_LANES 4        /// Independent partial sums per accumulator, so the pass vectorizes
+#define FEATURE_ROLLOFF 0.85f  /// Share of the energy below the rolloff frequency
+#define FEATURE_FFT 8192       /// Frame size of the feature display
+#define FEATURE_HANN_POWER 1.5 /// Power a Hann window spreads a full-scale sine over, in Stft magnitude units
+
+/// Descriptors a FeatureBank can compute, combined as a bit set
+enum SpectralFeature : unsigned
+{
+    FeatureCentroid = 1u << 0, /// Magnitude-weighted mean frequency
+    FeatureSpread = 1u << 1,   /// Magnitude-weighted standard deviation around the centroid
+    FeatureRolloff = 1u << 2,  /// Frequency below which FEATURE_ROLLOFF of the energy lies
+    FeatureFlatness = 1u << 3, /// Geometric over arithmetic mean of the power, 0 tonal to 1 noise
+    FeatureFlux = 1u << 4,     /// Half-wave rectified change of the magnitudes since the last frame
+    FeatureBandEnergy = 1u << 5,
+    AllFeatures = (1u << 6) - 1
+};
+
+/// Descriptors of one frame; fields outside the computed set are left at zero
+struct SpectralFeatures
+{
+    float centroid = 0; /// Hz
+    float spread = 0;   /// Hz
+    float rolloff = 0;  /// Hz
+    float flatness = 0;
+    float flux = 0;
+    float bands[FEATURE_BANDS] = {0}; /// dB relative to a full-scale sine
+};
+
+/// One stretch of bins that lies in a single band and a single rolloff block
+struct FeatureSegment
+{
+    int start;
+    int count;
+    int band;
+    int block;
+};
+
+/**
+ * @brief Base-2 logarithm of a positive normal float, to within 2e-4.
+ *
+ * Splits off the exponent and fits the mantissa with a quartic, using only arithmetic the
+ * compiler can vectorize; std::log is a library call and would keep the fused pass scalar.
+ */
+inline float featureLog2(float x)
+{
+    uint32_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    float exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+    bits = (bits & 0x007FFFFFu) | 0x3F800000u;
+    float t;
+    std::memcpy(&t, &bits, sizeof(t));
+    t -= 1.0f;
+    return exponent + 1.14580e-4f + t * (1.4368749f + t * (-0.67088268f + t * (0.31226948f + t * -0.078440676f)));
+}
+
+std::vector<FeatureSegment> featureSegments(int bins, float binHz); /// Splits the spectrum at band and block edges
+float featureBandEdge(int band);                                     /// Lower edge of a band in Hz
+
+/**
+ * -------------------------
+ * ----class FeatureBank----
+ * -------------------------
+ * Computes a fixed set of spectral descriptors in one pass over a magnitude spectrum. The
+ * spectrum is walked in short segments that never cross a band or block edge, so every sum the
+ * selected features need is gathered while the segment is in cache, in FEATURE_LANES independent
+ * partial sums the compiler can keep in vector registers. The set is a template argument:
+ * accumulators and state of features outside it are compiled out. Rolloff needs the total
+ * energy first, so the pass records each block's energy and afterwards rescans only the block
+ * where the running total crosses the threshold.
+ */
+template <unsigned Set>
+class FeatureBank
+{
+private:
+    static constexpr bool wantMoments = (Set & (FeatureCentroid | FeatureSpread)) != 0;
+    static constexpr bool wantSpread = (Set & FeatureSpread) != 0;
+    static constexpr bool wantRolloff = (Set & FeatureRolloff) != 0;
+    static constexpr bool wantFlatness = (Set & FeatureFlatness) != 0;
+    static constexpr bool wantFlux = (Set & FeatureFlux) != 0;
+    static constexpr bool wantBands = (Set & FeatureBandEnergy) != 0;
+    static constexpr bool wantPower = wantRolloff || wantFlatness || wantBands;
+
+    int bins;
+    float binHz;
+    std::vector<FeatureSegment> segments;
+    std::vector<float> previous;    /// Last frame's magnitudes, only for flux
+    std::vector<double> blockPower; /// Energy of each block, only for rolloff
+
+public:
+    static constexpr unsigned features = Set;
+
+    FeatureBank(int bins, float binHz);
+    void compute(const float *magnitude, SpectralFeatures &out);
+    void reset();
+    int size() const { return bins; }
+};
+
+/**
+ * @brief Constructor for FeatureBank.
+ *
+ * @param bins Bins in each magnitude spectrum, DC included.
+ * @param binHz Spacing of the bins in Hz.
+ */
+template <unsigned Set>
+FeatureBank<Set>::FeatureBank(int bins, float binHz)
+    : bins(bins), binHz(binHz), segments(featureSegments(bins, binHz))
+{
+    if constexpr (wantFlux)
+        previous.assign(bins, 0.0f);
+    if constexpr (wantRolloff)
+        blockPower.assign((bins + FEATURE_BLOCK - 1) / FEATURE_BLOCK, 0.0);
+}
+
+/**
+ * @brief Computes the selected descriptors of one frame.
+ *
+ * @param magnitude size() magnitudes, normalized like Stft::magnitude().
+ * @param out Receives the descriptors; other fields are left untouched.
+ */
+template <unsigned Set>
+void FeatureBank<Set>::compute(const float *magnitude, SpectralFeatures &out)
+{
+    constexpr int L = FEATURE_LANES;
+    double sumM = 0, sumKM = 0, sumKKM = 0, sumP = 0, sumLogM = 0, sumFlux = 0;
+    double band[FEATURE_BANDS] = {0};
+    if constexpr (wantRolloff)
+        std::fill(blockPower.begin(), blockPower.end(), 0.0);
+
+    for (const FeatureSegment &segment : segments)
+    {
+        const float *m = magnitude + segment.start;
+        const float *prev = wantFlux ? previous.data() + segment.start : nullptr;
+        float m0[L] = {0}, km[L] = {0}, kkm[L] = {0}, p[L] = {0}, logm[L] = {0}, flux[L] = {0};
+        int i = 0;
+        for (; i + L <= segment.count; i += L)
+        {
+            for (int j = 0; j < L; j++)
+            {
+                float v = m[i + j];
+                float k = static_cast<float>(i + j); // Relative to the segment start; shifted below
+                if constexpr (wantMoments)
+                {
+                    m0[j] += v;
+                    km[j] += k * v;
+                    if constexpr (wantSpread)
+                        kkm[j] += k * k * v;
+                }
+                if constexpr (wantPower)
+                    p[j] += v * v;
+                if constexpr (wantFlatness)
+                    logm[j] += featureLog2(v + 1e-10f);
+                if constexpr (wantFlux)
+                {
+                    float change = v - prev[i + j];
+                    float rise = 0.5f * (change + std::fabs(change)); // max(change, 0) without a branch
+                    flux[j] += rise * rise;
+                }
+            }
+        }
+        for (; i < segment.count; i++)
+        {
+            float v = m[i], k = static_cast<float>(i);
+            if constexpr (wantMoments)
+            {
+                m0[0] += v;
+                km[0] += k * v;
+                if constexpr (wantSpread)
+                    kkm[0] += k * k * v;
+            }
+            if constexpr (wantPower)
+                p[0] += v * v;
+            if constexpr (wantFlatness)
+                logm[0] += featureLog2(v + 1e-10f);
+            if constexpr (wantFlux)
+            {
+                float change = v - prev[i];
+                float rise = 0.5f * (change + std::fabs(change));
+                flux[0] += rise * rise;
+            }
+        }
+        // Stores in the loop above could alias the magnitudes and would keep it scalar
+        if constexpr (wantFlux)
+            std::copy(m, m + segment.count, previous.begin() + segment.start);
+
+        double s0 = 0, s1 = 0, s2 = 0, sp = 0, sl = 0, sf = 0;
+        for (int j = 0; j < L; j++)
+        {
+            s0 += m0[j];
+            s1 += km[j];
+            s2 += kkm[j];
+            sp += p[j];
+            sl += logm[j];
+            sf += flux[j];
+        }
+        // Moments were taken about the segment start; move them to bin 0
+        double base = segment.start;
+        sumM += s0;
+        sumKM += s1 + base * s0;
+        sumKKM += s2 + 2 * base * s1 + base * base * s0;
+        sumP += sp;
+        sumLogM += sl;
+        sumFlux += sf;
+        if constexpr (wantBands)
+            band[segment.band] += sp;
+        if constexpr (wantRolloff)
+            blockPower[segment.block] += sp;
+    }
+
+    if constexpr (wantMoments)
+    {
+        double centroidBin = sumM > 0 ? sumKM / sumM : 0.0;
+        out.centroid = static_cast<float>(centroidBin * binHz);
+        if constexpr (wantSpread)
+        {
+            double variance = sumM > 0 ? sumKKM / sumM - centroidBin * centroidBin : 0.0;
+            out.spread = static_cast<float>(std::sqrt(std::max(variance, 0.0)) * binHz);
+        }
+    }
+    if constexpr (wantFlatness)
+    {
+        double meanPower = sumP / bins;
+        out.flatness = meanPower > 1e-20 ? static_cast<float>(std::exp2(2 * sumLogM / bins) / meanPower) : 0.0f;
+    }
+    if constexpr (wantFlux)
+        out.flux = static_cast<float>(std::sqrt(sumFlux));
+    if constexpr (wantBands)
+    {
+        for (int b = 0; b < FEATURE_BANDS; b++)
+            out.bands[b] = static_cast<float>(10 * std::log10(std::max(band[b] / FEATURE_HANN_POWER, 1e-12)));
+    }
+    if constexpr (wantRolloff)
+    {
+        double target = FEATURE_ROLLOFF * sumP, below = 0;
+        int block = 0;
+        while (block + 1 < static_cast<int>(blockPower.size()) && below + blockPower[block] < target)
+            below += blockPower[block++];
+        int k = block * FEATURE_BLOCK, end = std::min(bins, k + FEATURE_BLOCK);
+        for (; k < end - 1; k++)
+        {
+            below += static_cast<double>(magnitude[k]) * magnitude[k];
+            if (below >= target)
+                break;
+        }
+        out.rolloff = k * binHz;
+    }
+}
+
+/**
+ * @brief Forgets the previous frame, so the next flux is measured from silence.
+ */
+template <unsigned Set>
+void FeatureBank<Set>::reset()
+{
+    std::fill(previous.begin(), previous.end(), 0.0f);
+}
+
+/**
+ * --------------------------------
+ * ----class FeatureCsvExporter----
+ * --------------------------------
+ * Appends one row of descriptors per frame to a CSV file, with a header naming the columns of
+ * the exported feature set.
+ */
+class FeatureCsvExporter
+{
+private:
+    std::ofstream file;
+    unsigned set;
+
+public:
+    FeatureCsvExporter(const std::string &path, unsigned set = AllFeatures);
+    void write(double seconds, const SpectralFeatures &features);
+};
+
+#endif // SPECTRAL_FEATURES_H
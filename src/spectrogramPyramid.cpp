@@ -0,0 +1,256 @@
+#include "spectrogramPyramid.h"
+#include "logger.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+static const char pyramidMagic[8] = {'A', 'D', 'S', 'P', 'S', 'P', 'Y', '1'};
+
+/// Layout of the start of a pyramid file; the column count of each level and the levels follow
+struct PyramidFileHeader
+{
+    char magic[8];
+    uint32_t bins;
+    uint32_t pooling;
+    uint32_t levels;
+    uint32_t reserved;
+};
+
+/**
+ * @brief Constructor for SpectrogramPyramid.
+ *
+ * @param bins Values per column.
+ * @param pooling How pairs of columns combine into the next level.
+ * @throws std::invalid_argument if bins is not positive.
+ */
+SpectrogramPyramid::SpectrogramPyramid(int bins, PyramidPooling pooling)
+    : binCount(bins), pooling(pooling), ownedLevels(1), levels(1, nullptr), counts(1, 0)
+{
+    if (bins < 1)
+    {
+        logMessage("Spectrogram pyramid needs at least one bin per column.", "ERROR");
+        throw std::invalid_argument("Spectrogram pyramid needs at least one bin per column.");
+    }
+}
+
+/**
+ * @brief Copies mapped levels into memory so columns can be appended.
+ */
+void SpectrogramPyramid::takeOwnership()
+{
+    ownedLevels.assign(counts.size(), std::vector<uint8_t>());
+    for (size_t level = 0; level < counts.size(); level++)
+    {
+        ownedLevels[level].assign(levels[level], levels[level] + counts[level] * binCount);
+        levels[level] = ownedLevels[level].data();
+    }
+    mapped.reset();
+}
+
+/**
+ * @brief Adds a spectrogram column and completes any pairs it closes at the levels above.
+ *
+ * Levels hold only complete pairs, so level L gains a column every 2^L appends; the work per
+ * append is one pooling pass on average.
+ * @param columnDb bins() levels in dB; clamped to [PYRAMID_FLOOR_DB, 0].
+ */
+void SpectrogramPyramid::append(const float *columnDb)
+{
+    if (mapped)
+        takeOwnership();
+
+    std::vector<uint8_t> &base = ownedLevels[0];
+    base.resize(base.size() + binCount);
+    uint8_t *code = base.data() + counts[0] * binCount;
+    for (int b = 0; b < binCount; b++)
+        code[b] = static_cast<uint8_t>(std::lround(std::clamp((columnDb[b] - PYRAMID_FLOOR_DB) * 2.0f, 0.0f, 255.0f)));
+    levels[0] = base.data();
+    counts[0]++;
+
+    for (size_t level = 0; counts[level] % 2 == 0 && level < PYRAMID_MAX_LEVELS; level++)
+    {
+        if (level + 1 == counts.size())
+        {
+            ownedLevels.emplace_back();
+            levels.push_back(nullptr);
+            counts.push_back(0);
+        }
+        std::vector<uint8_t> &above = ownedLevels[level + 1];
+        above.resize(above.size() + binCount);
+        const uint8_t *left = levels[level] + (counts[level] - 2) * binCount, *right = left + binCount;
+        uint8_t *pooled = above.data() + counts[level + 1] * binCount;
+        if (pooling == PyramidPooling::Max)
+            for (int b = 0; b < binCount; b++)
+                pooled[b] = std::max(left[b], right[b]);
+        else
+            for (int b = 0; b < binCount; b++)
+                pooled[b] = static_cast<uint8_t>((left[b] + right[b] + 1) >> 1);
+        levels[level + 1] = above.data();
+        counts[level + 1]++;
+    }
+}
+
+/**
+ * @brief Pools columns [first, last) of a level into an accumulator.
+ *
+ * Columns the level does not have yet, because their pair is incomplete, are taken from the
+ * level below, so the most recent audio shows up at every zoom. Each column counts with the
+ * number of spectrogram columns it stands for.
+ * @param level Level to read.
+ * @param first First column, in units of the level.
+ * @param last One past the last column.
+ * @param accumulated bins() running maxima or weighted sums of codes.
+ * @param weight Spectrogram columns accumulated so far; 0 if none.
+ */
+void SpectrogramPyramid::pool(int level, uint64_t first, uint64_t last, float *accumulated, float &weight) const
+{
+    uint64_t available = std::min(last, counts[level]);
+    float columnWeight = static_cast<float>(uint64_t(1) << level);
+    for (uint64_t c = first; c < available; c++)
+    {
+        const uint8_t *code = levels[level] + c * binCount;
+        if (pooling == PyramidPooling::Max)
+            for (int b = 0; b < binCount; b++)
+                accumulated[b] = std::max(accumulated[b], static_cast<float>(code[b]));
+        else
+            for (int b = 0; b < binCount; b++)
+                accumulated[b] += columnWeight * code[b];
+        weight += columnWeight;
+    }
+    if (last > counts[level] && level > 0)
+        pool(level - 1, std::max(first, counts[level]) * 2, last * 2, accumulated, weight);
+}
+
+/**
+ * @brief Draws columns [first, last) of the spectrogram into width output columns.
+ *
+ * Each output column covers a run of spectrogram columns and reads the level whose columns are
+ * as wide as that run, rounded down, so it pools two or three stored columns whatever the span.
+ * Output columns past the recorded audio are left at the floor.
+ * @param first First spectrogram column of the view.
+ * @param last One past the last column of the view.
+ * @param width Output columns.
+ * @param output Receives width columns of bins() values in dB, column after column.
+ */
+void SpectrogramPyramid::render(uint64_t first, uint64_t last, int width, float *output) const
+{
+    std::fill(output, output + static_cast<size_t>(std::max(width, 0)) * binCount, PYRAMID_FLOOR_DB);
+    if (width <= 0 || last <= first)
+        return;
+
+    uint64_t span = last - first;
+    std::vector<float> accumulated(binCount);
+    for (int x = 0; x < width; x++)
+    {
+        uint64_t begin = first + span * x / width;
+        uint64_t end = std::max(first + span * (x + 1) / width, begin + 1);
+        if (begin >= counts[0])
+            break;
+        end = std::min(end, counts[0]);
+
+        int level = 0;
+        while (level + 1 < levelCount() && (uint64_t(2) << level) <= end - begin)
+            level++;
+        std::fill(accumulated.begin(), accumulated.end(), 0.0f);
+        float weight = 0;
+        pool(level, begin >> level, ((end - 1) >> level) + 1, accumulated.data(), weight);
+
+        float scale = pooling == PyramidPooling::Max ? 0.5f : 0.5f / weight;
+        float *pixel = output + static_cast<size_t>(x) * binCount;
+        for (int b = 0; b < binCount; b++)
+            pixel[b] = PYRAMID_FLOOR_DB + accumulated[b] * scale;
+    }
+}
+
+/**
+ * @brief Writes every level so load() can map them.
+ *
+ * @param path File to create or truncate.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void SpectrogramPyramid::save(const std::string &path) const
+{
+    PyramidFileHeader header = {};
+    std::memcpy(header.magic, pyramidMagic, sizeof(pyramidMagic));
+    header.bins = static_cast<uint32_t>(binCount);
+    header.pooling = static_cast<uint32_t>(pooling);
+    header.levels = static_cast<uint32_t>(counts.size());
+
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(counts.data()), static_cast<std::streamsize>(counts.size() * sizeof(uint64_t)));
+    for (size_t level = 0; level < counts.size(); level++)
+        if (counts[level] > 0)
+            out.write(reinterpret_cast<const char *>(levels[level]), static_cast<std::streamsize>(counts[level] * binCount));
+    if (!out)
+    {
+        logMessage("Cannot write spectrogram pyramid " + path, "ERROR");
+        throw std::runtime_error("Cannot write spectrogram pyramid " + path);
+    }
+}
+
+/**
+ * @brief Maps a pyramid written by save(); its bin count and pooling replace this one's.
+ *
+ * @param path Pyramid file.
+ * @throws std::runtime_error if the file cannot be mapped or is not a consistent pyramid.
+ */
+void SpectrogramPyramid::load(const std::string &path)
+{
+    std::unique_ptr<MappedFile> file(new MappedFile(path));
+    const uint8_t *base = file->data();
+    size_t size = file->size();
+    PyramidFileHeader header;
+    std::vector<uint64_t> levelCounts;
+    bool valid = size >= sizeof(header);
+    if (valid)
+    {
+        std::memcpy(&header, base, sizeof(header));
+        valid = std::memcmp(header.magic, pyramidMagic, sizeof(pyramidMagic)) == 0 && header.bins > 0 && header.pooling <= 1 &&
+                header.levels >= 1 && header.levels <= PYRAMID_MAX_LEVELS + 1 && size >= sizeof(header) + header.levels * sizeof(uint64_t);
+    }
+    if (valid)
+    {
+        levelCounts.resize(header.levels);
+        std::memcpy(levelCounts.data(), base + sizeof(header), header.levels * sizeof(uint64_t));
+        uint64_t total = 0;
+        for (uint32_t level = 0; level < header.levels; level++)
+        {
+            valid = valid && (level == 0 || levelCounts[level] == levelCounts[level - 1] / 2);
+            total += levelCounts[level];
+        }
+        valid = valid && size == sizeof(header) + header.levels * sizeof(uint64_t) + total * header.bins;
+    }
+    if (!valid)
+    {
+        logMessage("Spectrogram pyramid " + path + " is damaged.", "ERROR");
+        throw std::runtime_error("Spectrogram pyramid " + path + " is damaged.");
+    }
+
+    mapped = std::move(file);
+    binCount = static_cast<int>(header.bins);
+    pooling = static_cast<PyramidPooling>(header.pooling);
+    counts = levelCounts;
+    ownedLevels.assign(counts.size(), std::vector<uint8_t>());
+    levels.assign(counts.size(), nullptr);
+    const uint8_t *data = base + sizeof(header) + counts.size() * sizeof(uint64_t);
+    for (size_t level = 0; level < counts.size(); level++)
+    {
+        levels[level] = data;
+        data += counts[level] * binCount;
+    }
+    logMessage("Mapped spectrogram pyramid of " + std::to_string(counts[0]) + " columns from " + path, "INFO");
+}
+
+/**
+ * @brief Bytes held by all levels.
+ */
+size_t SpectrogramPyramid::bytes() const
+{
+    size_t total = 0;
+    for (uint64_t count : counts)
+        total += static_cast<size_t>(count) * binCount;
+    return total;
+}
@@ -0,0 +1,64 @@
+#ifndef SPECTROGRAM_PYRAMID_H
+#define SPECTROGRAM_PYRAMID_H
+
+#include "mappedFile.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define PYRAMID_FRAME 4096       /// STFT frame of the session overview
+#define PYRAMID_BANDS 64         /// Mel bands per overview column
+#define PYRAMID_FLOOR_DB -127.5f /// Quietest level a column stores; each step is 0.5 dB up to 0 dB
+#define PYRAMID_MAX_LEVELS 40    /// Levels above the spectrogram itself; 2^40 columns is never reached
+
+/// How two neighbouring columns combine into one column of the next level
+enum class PyramidPooling
+{
+    Max,  /// Keeps short loud events visible when zoomed out
+    Mean
+};
+
+/**
+ * --------------------------------
+ * ----class SpectrogramPyramid----
+ * --------------------------------
+ * A spectrogram and successively coarser copies of it, each level pooling pairs of columns of
+ * the level below, so a view of any span can be drawn from about one precomputed column per
+ * output column. Columns are stored as one byte per bin in 0.5 dB steps, which is finer than any
+ * display and keeps pooling to byte-wide max or average. The pyramid grows as frames arrive:
+ * appending a column completes at most one pair per level, so the cost per frame is constant on
+ * average. save() writes the levels after a small header; load() maps them, and an appended
+ * column first copies the mapped levels into memory.
+ */
+class SpectrogramPyramid
+{
+private:
+    int binCount;
+    PyramidPooling pooling;
+    std::vector<std::vector<uint8_t>> ownedLevels; /// Level 0 is the spectrogram
+    std::vector<const uint8_t *> levels;
+    std::vector<uint64_t> counts;                  /// Columns in each level
+    std::unique_ptr<MappedFile> mapped;            /// Holds the levels after load()
+
+    void takeOwnership();
+    void pool(int level, uint64_t first, uint64_t last, float *sum, float &weight) const;
+
+public:
+    explicit SpectrogramPyramid(int bins = PYRAMID_BANDS, PyramidPooling pooling = PyramidPooling::Max);
+    SpectrogramPyramid(const SpectrogramPyramid &) = delete;
+    SpectrogramPyramid &operator=(const SpectrogramPyramid &) = delete;
+
+    void append(const float *columnDb);  /// One column of bins() levels in dB
+    void render(uint64_t first, uint64_t last, int width, float *output) const; /// width x bins() dB, columns [first, last)
+    void save(const std::string &path) const;
+    void load(const std::string &path);
+
+    int bins() const { return binCount; }
+    uint64_t columns() const { return counts[0]; }
+    int levelCount() const { return static_cast<int>(counts.size()); }
+    uint64_t levelColumns(int level) const { return counts[level]; }
+    size_t bytes() const;
+};
+
+#endif // SPECTROGRAM_PYRAMID_H
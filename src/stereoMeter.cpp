@@ -0,0 +1,115 @@
+#include "stereoMeter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * @brief Constructor for StereoMeter.
+ */
+StereoMeter::StereoMeter() : scope(SCOPE_SIZE * SCOPE_SIZE, 0.0f), left(STEREO_BLOCK), right(STEREO_BLOCK)
+{
+}
+
+/**
+ * @brief Converts a mean square to decibels relative to a full-scale sine.
+ */
+static float powerDb(double power)
+{
+    return static_cast<float>(10 * std::log10(std::max(2 * power, 1e-10)));
+}
+
+/**
+ * @brief Adds one block of a stereo pair to the meters and the goniometer.
+ *
+ * The three sums are accumulated in 64-bit integers: each product is exact and the compiler is
+ * free to vectorize the loop without changing the result.
+ * @param leftInput Left channel samples.
+ * @param rightInput Right channel samples.
+ * @param n Samples per channel.
+ */
+void StereoMeter::process(const sample *leftInput, const sample *rightInput, int n)
+{
+    if (n <= 0)
+        return;
+
+    int64_t ll = 0, rr = 0, lr = 0;
+    int blockPeak = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int l = leftInput[i], r = rightInput[i];
+        ll += l * l;
+        rr += r * r;
+        lr += l * r;
+        blockPeak = std::max(blockPeak, std::max(std::abs(l), std::abs(r)));
+    }
+
+    const double fullScale = 32768.0 * 32768.0;
+    double alpha = 1 - std::exp(-n / (STEREO_RESPONSE * RATE));
+    leftPower += alpha * (ll / fullScale / n - leftPower);
+    rightPower += alpha * (rr / fullScale / n - rightPower);
+    crossPower += alpha * (lr / fullScale / n - crossPower);
+
+    // Scope: fade the old trace, then plot mid up and side across at the recent peak's scale
+    float fade = std::exp(-n / (SCOPE_PERSISTENCE * RATE));
+    for (float &cell : scope)
+        cell *= fade;
+    peak = std::max(peak * std::sqrt(fade), static_cast<float>(blockPeak));
+    if (peak < 1)
+        return;
+    float toCell = (SCOPE_SIZE - 1) / (2 * peak);
+    int centre = SCOPE_SIZE / 2;
+    for (int i = 0; i < n; i++)
+    {
+        float mid = 0.5f * (leftInput[i] + rightInput[i]), side = 0.5f * (leftInput[i] - rightInput[i]);
+        int column = centre + static_cast<int>(std::lround(side * toCell));
+        int row = centre - static_cast<int>(std::lround(mid * toCell));
+        scope[row * SCOPE_SIZE + column] += 1.0f;
+    }
+}
+
+/**
+ * @brief Adds interleaved stereo frames, deinterleaving them in fixed-size blocks first.
+ *
+ * @param input Interleaved left and right samples.
+ * @param frames Number of frames (sample pairs).
+ */
+void StereoMeter::processInterleaved(const sample *input, int frames)
+{
+    while (frames > 0)
+    {
+        int block = std::min(frames, STEREO_BLOCK);
+        for (int i = 0; i < block; i++)
+        {
+            left[i] = input[2 * i];
+            right[i] = input[2 * i + 1];
+        }
+        process(left.data(), right.data(), block);
+        input += 2 * block;
+        frames -= block;
+    }
+}
+
+/**
+ * @brief Normalized correlation of the two channels over the meter time constant.
+ */
+float StereoMeter::correlation() const
+{
+    double norm = std::sqrt(leftPower * rightPower);
+    return norm > 1e-12 ? static_cast<float>(crossPower / norm) : 0.0f;
+}
+
+float StereoMeter::leftDb() const { return powerDb(leftPower); }
+float StereoMeter::rightDb() const { return powerDb(rightPower); }
+float StereoMeter::midDb() const { return powerDb((leftPower + 2 * crossPower + rightPower) / 4); }
+float StereoMeter::sideDb() const { return powerDb((leftPower - 2 * crossPower + rightPower) / 4); }
+
+/**
+ * @brief Clears the meters and the goniometer.
+ */
+void StereoMeter::reset()
+{
+    leftPower = rightPower = crossPower = 0;
+    peak = 0;
+    std::fill(scope.begin(), scope.end(), 0.0f);
+}
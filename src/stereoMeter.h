@@ -0,0 +1,45 @@
+#ifndef STEREO_METER_H
+#define STEREO_METER_H
+
+#include "audioProcessor.h"
+#include <vector>
+
+#define STEREO_RESPONSE 0.3f    /// Time constant of the meters in seconds
+#define STEREO_BLOCK 1024       /// Frames deinterleaved per pass by processInterleaved()
+#define SCOPE_SIZE 33           /// Goniometer cells per side; odd so mono lands on the centre column
+#define SCOPE_PERSISTENCE 0.15f /// Time constant of the goniometer trace in seconds
+
+/**
+ * -------------------------
+ * ----class StereoMeter----
+ * -------------------------
+ * Phase correlation, left/right and mid/side levels, and a goniometer for a stereo pair or two
+ * microphones. Each block is reduced to three integer sums (L*L, R*R and L*R), which vectorize
+ * exactly; every meter follows from those through one-pole smoothing, so the state per metric is
+ * a single number. The goniometer is a fixed grid of decaying hit counts with mid plotted up and
+ * side across, scaled to the recent peak.
+ */
+class StereoMeter
+{
+private:
+    double leftPower = 0, rightPower = 0, crossPower = 0; /// Smoothed mean squares, full scale = 1
+    float peak = 0;                                      /// Decaying peak of |L| and |R| that scales the scope
+    std::vector<float> scope;                            /// SCOPE_SIZE * SCOPE_SIZE cells, row 0 at the top
+    std::vector<sample> left, right;                     /// Deinterleaving scratch
+
+public:
+    StereoMeter();
+
+    void process(const sample *leftInput, const sample *rightInput, int n); /// Deinterleaved channels
+    void processInterleaved(const sample *input, int frames);              /// L R L R ...
+
+    float correlation() const; /// +1 mono, 0 unrelated, -1 out of phase
+    float leftDb() const;
+    float rightDb() const;
+    float midDb() const;
+    float sideDb() const;
+    const std::vector<float> &goniometer() const { return scope; }
+    void reset();
+};
+
+#endif // STEREO_METER_H
@@ -0,0 +1,426 @@
+#include "takeAlignment.h"
+#include "featureMatrix.h"
+#include "logger.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+static const float unreachable = std::numeric_limits<float>::infinity();
+
+/**
+ * @brief Every cell of an n by m cost matrix.
+ */
+DtwWindow DtwWindow::full(int n, int m)
+{
+    DtwWindow window;
+    for (int k = 0; k < n + m - 1; k++)
+    {
+        window.low.push_back(std::max(0, k - (m - 1)));
+        window.high.push_back(std::min(n - 1, k));
+    }
+    return window;
+}
+
+/**
+ * @brief A Sakoe-Chiba band: the cells within radius take frames of the straight line from the first cell to the last.
+ *
+ * Every anti-diagonal keeps at least the cell nearest the line, so a band narrower than the slope
+ * of a very uneven pair still connects.
+ * @param n Reference frames.
+ * @param m Take frames.
+ * @param radius Take frames on either side of the line.
+ */
+DtwWindow DtwWindow::band(int n, int m, int radius)
+{
+    if (n < 2 || m < 2)
+        return full(n, m);
+    DtwWindow window;
+    const double slope = static_cast<double>(m - 1) / (n - 1);
+    for (int k = 0; k < n + m - 1; k++)
+    {
+        // On anti-diagonal k, j - slope * i = k - (1 + slope) * i
+        int first = std::max(0, k - (m - 1)), last = std::min(n - 1, k);
+        int centre = std::min(last, std::max(first, static_cast<int>(std::lround(k / (1 + slope)))));
+        int low = static_cast<int>(std::ceil((k - radius) / (1 + slope)));
+        int high = static_cast<int>(std::floor((k + radius) / (1 + slope)));
+        window.low.push_back(std::max(first, std::min(low, centre)));
+        window.high.push_back(std::min(last, std::max(high, centre)));
+    }
+    return window;
+}
+
+/**
+ * @brief The window FastDTW searches at one level: the path found at half the resolution, widened.
+ *
+ * Each cell of the coarse path stands for two by two cells here. Anti-diagonals skipped by a
+ * diagonal step between two of those blocks borrow from their neighbours, and every anti-diagonal
+ * then reaches radius cells further on either side.
+ * @param coarsePath Warping path of the sequences at half the frame rate.
+ * @param n Reference frames at this level.
+ * @param m Take frames at this level.
+ * @param radius Cells added on either side along each anti-diagonal.
+ */
+DtwWindow DtwWindow::around(const std::vector<WarpStep> &coarsePath, int n, int m, int radius)
+{
+    const int diagonals = n + m - 1;
+    std::vector<int> first(diagonals, INT_MAX), last(diagonals, -1);
+    for (const WarpStep &step : coarsePath)
+    {
+        for (int i = 2 * step.first; i < std::min(n, 2 * step.first + 2); i++)
+        {
+            for (int j = 2 * step.second; j < std::min(m, 2 * step.second + 2); j++)
+            {
+                first[i + j] = std::min(first[i + j], i);
+                last[i + j] = std::max(last[i + j], i);
+            }
+        }
+    }
+
+    DtwWindow window;
+    for (int k = 0; k < diagonals; k++)
+    {
+        int low = INT_MAX, high = -1;
+        for (int near = std::max(0, k - 1); near <= std::min(diagonals - 1, k + 1); near++)
+        {
+            low = std::min(low, first[near]);
+            high = std::max(high, last[near]);
+        }
+        window.low.push_back(std::max(std::max(0, k - (m - 1)), low - radius));
+        window.high.push_back(std::min(std::min(n - 1, k), high + radius));
+    }
+    return window;
+}
+
+/**
+ * @brief Number of cells inside the window.
+ */
+size_t DtwWindow::cells() const
+{
+    size_t total = 0;
+    for (size_t k = 0; k < low.size(); k++)
+        total += static_cast<size_t>(std::max(0, high[k] - low[k] + 1));
+    return total;
+}
+
+/**
+ * @brief Stores both sequences dimension by dimension, the take back to front.
+ *
+ * @param referenceRows referenceFrames rows of dims floats, each of unit length or zero.
+ * @param referenceFrames Number of reference rows.
+ * @param takeRows takeFrames rows of dims floats, each of unit length or zero.
+ * @param takeFrames Number of take rows.
+ * @param dims Floats per row.
+ * @throws std::invalid_argument if either sequence is empty or dims is not positive.
+ */
+Dtw::Dtw(const float *referenceRows, int referenceFrames, const float *takeRows, int takeFrames, int dims)
+    : dims(dims), n(referenceFrames), m(takeFrames)
+{
+    if (n < 1 || m < 1 || dims < 1)
+    {
+        logMessage("Time warping needs two non-empty sequences of positive dimensions.", "ERROR");
+        throw std::invalid_argument("Time warping needs two non-empty sequences of positive dimensions.");
+    }
+    reference.assign(static_cast<size_t>(dims) * (n + DTW_BLOCK), 0.0f);
+    reversed.assign(static_cast<size_t>(dims) * (m + DTW_BLOCK), 0.0f);
+    for (int d = 0; d < dims; d++)
+    {
+        for (int i = 0; i < n; i++)
+            reference[static_cast<size_t>(d) * (n + DTW_BLOCK) + i] = referenceRows[static_cast<size_t>(i) * dims + d];
+        for (int j = 0; j < m; j++)
+            reversed[static_cast<size_t>(d) * (m + DTW_BLOCK) + m - 1 - j] = takeRows[static_cast<size_t>(j) * dims + d];
+    }
+}
+
+/**
+ * @brief Makes every lane infinite, clearing only the cells written since the last reset.
+ */
+void Dtw::resetLanes()
+{
+    for (int l = 0; l < 3; l++)
+    {
+        if (lanes[l].size() != static_cast<size_t>(n) + 1 + DTW_BLOCK)
+            lanes[l].assign(static_cast<size_t>(n) + 1 + DTW_BLOCK, unreachable);
+        else
+            std::fill(lanes[l].begin() + laneLow[l] + 1, lanes[l].begin() + laneHigh[l] + 2, unreachable);
+        laneLow[l] = 0;
+        laneHigh[l] = -1;
+    }
+}
+
+/**
+ * @brief Lane of anti-diagonal k, emptied and marked as holding the window cells of k.
+ */
+float *Dtw::lane(int k)
+{
+    int l = k % 3;
+    std::fill(lanes[l].begin() + laneLow[l] + 1, lanes[l].begin() + laneHigh[l] + 2, unreachable);
+    laneLow[l] = window->low[k];
+    laneHigh[l] = window->high[k];
+    return lanes[l].data();
+}
+
+/**
+ * @brief Accumulates the cost along anti-diagonals first to last - 1.
+ *
+ * The lanes must hold anti-diagonals first - 2 and first - 1. Cell (i, j) costs one minus the
+ * cosine of reference row i and take row j, plus the cheapest of (i - 1, j), (i, j - 1) and
+ * (i - 1, j - 1).
+ * @param keep If not null, the window cells of every anti-diagonal are appended to it.
+ */
+void Dtw::sweep(int first, int last, std::vector<float> *keep)
+{
+    for (int k = first; k < last; k++)
+    {
+        const int low = window->low[k], count = window->high[k] - low + 1;
+        const float *previous = lanes[(k + 2) % 3].data() + low; // Cell i - 1 of k - 1 at [c], cell i at [c + 1]
+        const float *diagonal = lanes[(k + 1) % 3].data() + low; // Cell i - 1 of k - 2 at [c]
+        float *cost = lane(k) + low + 1;
+
+        // Whole blocks of DTW_BLOCK cells, so the loops have a fixed length; rows and lanes are padded for the overhang
+        for (int block = 0; block < count; block += DTW_BLOCK)
+        {
+            float cells[DTW_BLOCK] = {0};
+            for (int d = 0; d < dims; d++)
+            {
+                const float *x = reference.data() + static_cast<size_t>(d) * (n + DTW_BLOCK) + low + block;
+                const float *y = reversed.data() + static_cast<size_t>(d) * (m + DTW_BLOCK) + (m - 1 - k) + low + block;
+                for (int c = 0; c < DTW_BLOCK; c++)
+                    cells[c] += x[c] * y[c];
+            }
+            const float start = 1.0f - cells[0]; // The first cell has no predecessor
+            for (int c = 0; c < DTW_BLOCK; c++)
+                cells[c] = 1.0f - cells[c] + std::min(diagonal[block + c], std::min(previous[block + c], previous[block + c + 1]));
+            if (k == 0)
+                cells[0] = start;
+            std::copy(cells, cells + std::min(DTW_BLOCK, count - block), cost + block);
+        }
+
+        evaluated += count;
+        if (keep)
+            keep->insert(keep->end(), cost, cost + count);
+    }
+}
+
+/**
+ * @brief Finds the cheapest warping path within a window.
+ *
+ * The cost is accumulated once over the whole window, keeping the two anti-diagonals before every
+ * DTW_CHECKPOINT-th. The path is then traced from the last cell back to the first: each segment
+ * between checkpoints is evaluated again from its checkpoint and kept whole while the trace
+ * crosses it. Among equally cheap predecessors the diagonal step is taken first.
+ * @param window Cells to search; an anti-diagonal with low one above high is empty.
+ * @param path Receives the cells of the path from (0, 0) to (n - 1, m - 1).
+ * @return Total cost of the path.
+ * @throws std::invalid_argument if the window is not of these sequences or reaches outside the matrix.
+ * @throws std::runtime_error if no path inside the window reaches the last cell.
+ */
+double Dtw::align(const DtwWindow &window, std::vector<WarpStep> &path)
+{
+    const int diagonals = n + m - 1;
+    bool fits = static_cast<int>(window.low.size()) == diagonals && static_cast<int>(window.high.size()) == diagonals;
+    for (int k = 0; k < diagonals && fits; k++)
+        fits = window.low[k] >= std::max(0, k - (m - 1)) && window.high[k] <= std::min(n - 1, k) && window.low[k] <= window.high[k] + 1;
+    if (!fits)
+    {
+        logMessage("Time warping window does not match the sequences.", "ERROR");
+        throw std::invalid_argument("Time warping window does not match the sequences.");
+    }
+    this->window = &window;
+    resetLanes();
+
+    // Checkpoint s holds anti-diagonals s * DTW_CHECKPOINT - 2 and - 1, from checkpointStarts[s]
+    const int segments = (diagonals + DTW_CHECKPOINT - 1) / DTW_CHECKPOINT;
+    std::vector<float> checkpoints;
+    std::vector<size_t> checkpointStarts(segments + 1, 0);
+    for (int s = 0; s < segments; s++)
+    {
+        int end = std::min(diagonals, (s + 1) * DTW_CHECKPOINT);
+        sweep(s * DTW_CHECKPOINT, end, nullptr);
+        checkpointStarts[s + 1] = checkpoints.size();
+        for (int k = std::max(0, end - 2); k < end && end < diagonals; k++)
+            checkpoints.insert(checkpoints.end(), lanes[k % 3].begin() + window.low[k] + 1, lanes[k % 3].begin() + window.high[k] + 2);
+    }
+    const float total = lanes[(diagonals - 1) % 3][n];
+    if (!(total < unreachable))
+    {
+        logMessage("Time warping window does not connect the first cell to the last.", "ERROR");
+        throw std::runtime_error("Time warping window does not connect the first cell to the last.");
+    }
+
+    std::vector<float> segment;
+    std::vector<size_t> starts; // Offsets of the anti-diagonals in the segment, so each step reads one
+    size_t segmentBytes = 0;
+    path.clear();
+    int i = n - 1, j = m - 1;
+    path.push_back(WarpStep(i, j));
+    for (int s = segments - 1; s >= 0 && i + j > 0; s--)
+    {
+        const int begin = s * DTW_CHECKPOINT, end = std::min(diagonals, begin + DTW_CHECKPOINT);
+        resetLanes();
+        segment.clear();
+        const float *saved = checkpoints.data() + checkpointStarts[s];
+        for (int k = std::max(0, begin - 2); k < begin; k++)
+        {
+            std::copy(saved, saved + window.high[k] - window.low[k] + 1, lane(k) + window.low[k] + 1);
+            saved += window.high[k] - window.low[k] + 1;
+        }
+        sweep(begin, end, &segment);
+        segmentBytes = std::max(segmentBytes, segment.size() * sizeof(float));
+
+        starts.assign(end - begin + 1, 0);
+        for (int k = begin; k < end; k++)
+            starts[k - begin + 1] = starts[k - begin] + window.high[k] - window.low[k] + 1;
+        auto stored = [&](int k, int row)
+        {
+            if (k < 0 || row < window.low[k] || row > window.high[k])
+                return unreachable;
+            if (k >= begin)
+                return segment[starts[k - begin] + row - window.low[k]];
+            size_t offset = checkpointStarts[s] + (k == begin - 1 ? window.high[k - 1] - window.low[k - 1] + 1 : 0);
+            return checkpoints[offset + row - window.low[k]];
+        };
+
+        while (i + j >= begin && i + j > 0)
+        {
+            const int k = i + j;
+            float diagonal = i > 0 && j > 0 ? stored(k - 2, i - 1) : unreachable;
+            float up = i > 0 ? stored(k - 1, i - 1) : unreachable;
+            float left = j > 0 ? stored(k - 1, i) : unreachable;
+            if (diagonal <= up && diagonal <= left)
+                i--, j--;
+            else if (up <= left)
+                i--;
+            else
+                j--;
+            path.push_back(WarpStep(i, j));
+        }
+    }
+    std::reverse(path.begin(), path.end());
+
+    peak = std::max(peak, (3 * lanes[0].size() + checkpoints.size()) * sizeof(float) + segmentBytes);
+    this->window = nullptr;
+    return total;
+}
+
+/**
+ * @brief Averages pairs of rows and scales the averages back to unit length.
+ */
+static std::vector<float> halveRows(const std::vector<float> &rows, int frames, int dims)
+{
+    const int half = (frames + 1) / 2;
+    std::vector<float> out(static_cast<size_t>(half) * dims, 0.0f);
+    for (int r = 0; r < frames; r++)
+        for (int d = 0; d < dims; d++)
+            out[static_cast<size_t>(r / 2) * dims + d] += rows[static_cast<size_t>(r) * dims + d];
+    for (int r = 0; r < half; r++)
+    {
+        float *row = out.data() + static_cast<size_t>(r) * dims;
+        double energy = 0;
+        for (int d = 0; d < dims; d++)
+            energy += static_cast<double>(row[d]) * row[d];
+        float scale = energy > 0 ? static_cast<float>(1 / std::sqrt(energy)) : 0.0f;
+        for (int d = 0; d < dims; d++)
+            row[d] *= scale;
+    }
+    return out;
+}
+
+/**
+ * @brief FastDTW: aligns the sequences at half the frame rate, then searches only around that path.
+ */
+static std::vector<WarpStep> multiscale(const std::vector<float> &reference, int n, const std::vector<float> &take, int m, int dims,
+                                        int radius, size_t &cells, size_t &bytes)
+{
+    Dtw dtw(reference.data(), n, take.data(), m, dims);
+    std::vector<WarpStep> path;
+    if (n <= DTW_COARSEST && m <= DTW_COARSEST)
+        dtw.align(DtwWindow::full(n, m), path);
+    else
+    {
+        std::vector<WarpStep> coarse = multiscale(halveRows(reference, n, dims), (n + 1) / 2, halveRows(take, m, dims), (m + 1) / 2, dims,
+                                                  radius, cells, bytes);
+        dtw.align(DtwWindow::around(coarse, n, m, radius), path);
+    }
+    cells += dtw.cellsEvaluated();
+    bytes = std::max(bytes, dtw.peakBytes());
+    return path;
+}
+
+/**
+ * @brief Aligns two feature sequences by multiscale DTW.
+ *
+ * Both sequences are halved until neither is longer than DTW_COARSEST frames, aligned there over
+ * the whole cost matrix, and the path is refined one level at a time within radius cells of the
+ * path of the level below. The work grows with the length times the radius.
+ * @param reference n rows of dims floats, each of unit length or zero.
+ * @param n Reference frames.
+ * @param take m rows of dims floats, each of unit length or zero.
+ * @param m Take frames.
+ * @param dims Floats per row.
+ * @param radius Cells the window reaches around each projected path.
+ * @param cells If not null, receives the cells evaluated over all levels.
+ * @param bytes If not null, receives the largest cost storage of any level.
+ * @return Warping path from (0, 0) to (n - 1, m - 1).
+ */
+std::vector<WarpStep> multiscaleDtw(const float *reference, int n, const float *take, int m, int dims, int radius, size_t *cells, size_t *bytes)
+{
+    size_t evaluated = 0, peak = 0;
+    std::vector<WarpStep> path = multiscale(std::vector<float>(reference, reference + static_cast<size_t>(std::max(n, 0)) * std::max(dims, 0)), n,
+                                            std::vector<float>(take, take + static_cast<size_t>(std::max(m, 0)) * std::max(dims, 0)), m,
+                                            dims, radius, evaluated, peak);
+    if (cells)
+        *cells = evaluated;
+    if (bytes)
+        *bytes = peak;
+    return path;
+}
+
+/**
+ * @brief Maps the time of a take onto a reference recording of the same piece.
+ *
+ * Both are reduced to chroma every SIMILARITY_HOP samples and aligned by multiscaleDtw(); where
+ * the path holds a reference frame against several take frames, their times are averaged.
+ * @param reference Mono reference samples at RATE.
+ * @param n Number of reference samples.
+ * @param take Mono take samples at RATE.
+ * @param m Number of take samples.
+ * @param threads Worker threads for feature extraction.
+ * @return One pair per reference frame: seconds into the reference, and the matching seconds
+ *         into the take, both nondecreasing.
+ * @throws std::invalid_argument if either recording is shorter than one feature frame.
+ */
+std::vector<std::pair<double, double>> alignTakes(const sample *reference, size_t n, const sample *take, size_t m, int threads)
+{
+    std::vector<float> features[2], chroma[2];
+    extractSimilarityFeatures(reference, n, features[0], threads);
+    extractSimilarityFeatures(take, m, features[1], threads);
+    for (int t = 0; t < 2; t++)
+    {
+        size_t rows = features[t].size() / SIMILARITY_DIMS;
+        if (rows == 0)
+        {
+            logMessage("Both recordings must be at least one feature frame long to align.", "ERROR");
+            throw std::invalid_argument("Both recordings must be at least one feature frame long to align.");
+        }
+        for (size_t r = 0; r < rows; r++)
+            chroma[t].insert(chroma[t].end(), features[t].begin() + r * SIMILARITY_DIMS, features[t].begin() + r * SIMILARITY_DIMS + SIMILARITY_CHROMA);
+    }
+
+    const int frames = static_cast<int>(chroma[0].size() / SIMILARITY_CHROMA);
+    std::vector<WarpStep> path = multiscaleDtw(chroma[0].data(), frames, chroma[1].data(), static_cast<int>(chroma[1].size() / SIMILARITY_CHROMA),
+                                               SIMILARITY_CHROMA);
+    std::vector<double> sum(frames, 0.0);
+    std::vector<int> count(frames, 0);
+    for (const WarpStep &step : path)
+    {
+        sum[step.first] += step.second;
+        count[step.first]++;
+    }
+    std::vector<std::pair<double, double>> map;
+    const double secondsPerFrame = static_cast<double>(SIMILARITY_HOP) / RATE;
+    for (int i = 0; i < frames; i++)
+        map.push_back(std::make_pair(i * secondsPerFrame, sum[i] / count[i] * secondsPerFrame));
+    return map;
+}
@@ -0,0 +1,74 @@
+#ifndef TAKE_ALIGNMENT_H
+#define TAKE_ALIGNMENT_H
+
+#include "audioProcessor.h"
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#define DTW_RADIUS 24      /// Frames the window reaches beyond the path projected from the coarser level
+#define DTW_COARSEST 512   /// Sequences this short are aligned over the whole cost matrix
+#define DTW_CHECKPOINT 256 /// Anti-diagonals between the pairs kept for recovering the path
+#define DTW_BLOCK 16       /// Cells of an anti-diagonal evaluated together, four SSE registers
+
+/// Pair of frames on a warping path: reference first, take second
+typedef std::pair<int, int> WarpStep;
+
+/**
+ * The cells of a cost matrix a DTW may visit, listed by anti-diagonal: cell (i, k - i) is inside
+ * when low[k] <= i <= high[k]. Anti-diagonals are the order cells are evaluated in, since every
+ * cell of one depends only on the two before it.
+ */
+struct DtwWindow
+{
+    std::vector<int> low, high;
+
+    static DtwWindow full(int n, int m);
+    static DtwWindow band(int n, int m, int radius);
+    static DtwWindow around(const std::vector<WarpStep> &coarsePath, int n, int m, int radius);
+    size_t cells() const;
+};
+
+/**
+ * -----------------
+ * ----class Dtw----
+ * -----------------
+ * Dynamic time warping of two sequences of unit-length feature rows under a cosine distance,
+ * restricted to a DtwWindow. Cells are evaluated one anti-diagonal at a time: the take is stored
+ * reversed and both sequences dimension by dimension, so the rows meeting along an anti-diagonal
+ * sit at consecutive addresses in both and the distances and the recurrence run across the
+ * diagonal in vector registers. Only the last two anti-diagonals are kept while the cost is
+ * accumulated, plus a pair every DTW_CHECKPOINT; the path is then traced back from the end one
+ * segment at a time, each segment evaluated again from the checkpoint before it. Memory follows
+ * the window width instead of the window area.
+ */
+class Dtw
+{
+private:
+    int dims, n, m;
+    std::vector<float> reference; /// reference[d * (n + DTW_BLOCK) + i]
+    std::vector<float> reversed;  /// reversed[d * (m + DTW_BLOCK) + m - 1 - j] is dimension d of take row j
+    const DtwWindow *window = nullptr;
+    std::vector<float> lanes[3];  /// Accumulated cost of anti-diagonal k in lanes[k % 3], cell i at i + 1
+    int laneLow[3], laneHigh[3];  /// Cells a lane holds; the rest of it is infinite
+    size_t evaluated = 0;
+    size_t peak = 0;
+
+    void resetLanes();
+    float *lane(int k);
+    void sweep(int first, int last, std::vector<float> *keep);
+
+public:
+    Dtw(const float *referenceRows, int referenceFrames, const float *takeRows, int takeFrames, int dims);
+
+    double align(const DtwWindow &window, std::vector<WarpStep> &path);
+
+    size_t cellsEvaluated() const { return evaluated; } /// Including the cells evaluated again to trace the path
+    size_t peakBytes() const { return peak; }           /// Largest cost storage held by one alignment
+};
+
+std::vector<WarpStep> multiscaleDtw(const float *reference, int n, const float *take, int m, int dims, int radius = DTW_RADIUS,
+                                    size_t *cells = nullptr, size_t *bytes = nullptr);
+std::vector<std::pair<double, double>> alignTakes(const sample *reference, size_t n, const sample *take, size_t m, int threads = 1);
+
+#endif // TAKE_ALIGNMENT_H
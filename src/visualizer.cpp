@@ -3,6 +3,11 @@
 #include <algorithm>
 #include <stdexcept>
 #include <cmath>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+float Visualizer::latencyBudgetMs = FFT_LATENCY_BUDGET;
 
 /**
  * @brief Initializes the histogram for the visualizer.
@@ -53,6 +58,30 @@ void Visualizer::smoothHistogram(bool logOnce)
     logMessage("Smoothed histogram for " + std::to_string(numbers) + " bars.", "INFO", logOnce);
 }
 
+/**
+ * @brief Computes the spectrum of the freshest audio with the smallest frame that resolves the range.
+ *
+ * The frame size comes from chooseAnalysisPlan() for the current number of bars. Magnitudes are
+ * scaled by FFTLEN / size so a steady tone reads the same whatever frame is used.
+ * @param MainAudioQueue The audio queue to process.
+ * @param spectrum Receives the magnitude spectrum; must hold FFTLEN values.
+ * @param minfreq The minimum frequency to display.
+ * @param maxfreq The maximum frequency to display.
+ * @param logSpacing Whether bars are spaced logarithmically.
+ * @param logOnce Whether to log this operation only once.
+ * @return The frame size used.
+ */
+int Visualizer::analyzeRange(AudioQueue &MainAudioQueue, sample *spectrum, int minfreq, int maxfreq, bool logSpacing, bool logOnce)
+{
+    static thread_local std::vector<sample> workingBuffer(FFTLEN);
+    AnalysisPlan plan = chooseAnalysisPlan(static_cast<float>(minfreq), static_cast<float>(maxfreq), numbers, logSpacing, latencyBudgetMs);
+
+    MainAudioQueue.peekFreshData(workingBuffer.data(), plan.fftSize);
+    FindFrequencyContent(spectrum, workingBuffer.data(), plan.fftSize, logOnce, 0.005f * FFTLEN / plan.fftSize);
+    logMessage("Analyzing " + std::to_string(minfreq) + "-" + std::to_string(maxfreq) + " Hz with a " + std::to_string(plan.fftSize) + "-point frame.", "INFO", logOnce);
+    return plan.fftSize;
+}
+
 /**
  * @brief Visualizes audio data using a semilogarithmic scale.
  *
@@ -69,23 +98,22 @@ void SemilogVisualizer::visualize(AudioQueue &MainAudioQueue, int minfreq, int m
 {
     logMessage("Semilog visualization started.", "INFO", logOnce);
 
-    sample workingBuffer[FFTLEN];
     sample spectrum[FFTLEN];
 
     numbers = consoleWidth;
     graphheight = consoleHeight;
     initializeHistogram(logOnce);
 
-    MainAudioQueue.peekFreshData(workingBuffer, FFTLEN);
-    FindFrequencyContent(spectrum, workingBuffer, FFTLEN, logOnce);
+    int frameSize = analyzeRange(MainAudioQueue, spectrum, minfreq, maxfreq, true, logOnce);
+    float binScale = static_cast<float>(FFTLEN) / frameSize; // FFTLEN bins per bin of this frame
 
-    int Freq0idx = freq2index(minfreq, logOnce);
-    int FreqLidx = freq2index(maxfreq, logOnce);
+    int Freq0idx = std::max(1, static_cast<int>(freq2index(minfreq, logOnce) / binScale));
+    int FreqLidx = std::max(Freq0idx + 1, static_cast<int>(freq2index(maxfreq, logOnce) / binScale));
 
     for (int i = Freq0idx; i < FreqLidx; i++)
     {
         int index = static_cast<int>(mapLin2Log(Freq0idx, FreqLidx - Freq0idx, 0, numbers, i, logOnce));
-        bargraph[index] += spectrum[i] / i;
+        bargraph[index] += spectrum[i] / (i * binScale);
     }
 
     smoothHistogram(logOnce);
@@ -112,19 +140,18 @@ void LinearVisualizer::visualize(AudioQueue &MainAudioQueue, int minfreq, int ma
 {
     logMessage("Linear visualization started.", "INFO", logOnce);
 
-    sample workingBuffer[FFTLEN];
     sample spectrum[FFTLEN];
 
     numbers = consoleWidth;
     graphheight = consoleHeight;
     initializeHistogram(logOnce);
 
-    MainAudioQueue.peekFreshData(workingBuffer, FFTLEN);
-    FindFrequencyContent(spectrum, workingBuffer, FFTLEN, logOnce);
+    int frameSize = analyzeRange(MainAudioQueue, spectrum, minfreq, maxfreq, false, logOnce);
+    float binScale = static_cast<float>(FFTLEN) / frameSize; // FFTLEN bins per bin of this frame
 
-    int bucketwidth = FFTLEN / numbers;
-    int Freq0idx = freq2index(minfreq, logOnce);
-    int FreqLidx = freq2index(maxfreq, logOnce);
+    int Freq0idx = std::max(1, static_cast<int>(freq2index(minfreq, logOnce) / binScale));
+    int FreqLidx = std::max(Freq0idx + 1, static_cast<int>(freq2index(maxfreq, logOnce) / binScale));
+    float bucketwidth = std::max(1.0f, static_cast<float>(FreqLidx - Freq0idx) / numbers); // Bins of this frame summed into each bar
 
     for (int i = Freq0idx; i < FreqLidx; i++)
     {
@@ -156,23 +183,22 @@ void LoglogVisualizer::visualize(AudioQueue &MainAudioQueue, int minfreq, int ma
 {
     logMessage("Loglog visualization started.", "INFO", logOnce);
 
-    sample workingBuffer[FFTLEN];
     sample spectrum[FFTLEN];
 
     numbers = consoleWidth;
     graphheight = consoleHeight;
     initializeHistogram(logOnce);
 
-    MainAudioQueue.peekFreshData(workingBuffer, FFTLEN);
-    FindFrequencyContent(spectrum, workingBuffer, FFTLEN, logOnce);
+    int frameSize = analyzeRange(MainAudioQueue, spectrum, minfreq, maxfreq, true, logOnce);
+    float binScale = static_cast<float>(FFTLEN) / frameSize; // FFTLEN bins per bin of this frame
 
-    int Freq0idx = freq2index(minfreq, logOnce);
-    int FreqLidx = freq2index(maxfreq, logOnce);
+    int Freq0idx = std::max(1, static_cast<int>(freq2index(minfreq, logOnce) / binScale));
+    int FreqLidx = std::max(Freq0idx + 1, static_cast<int>(freq2index(maxfreq, logOnce) / binScale));
 
     for (int i = Freq0idx; i < FreqLidx; i++)
     {
         int index = static_cast<int>(mapLin2Log(Freq0idx, FreqLidx - Freq0idx, 0, numbers, i, logOnce));
-        bargraph[index] += spectrum[i] / i;
+        bargraph[index] += spectrum[i] / (i * binScale);
     }
 
     applyAdaptiveScaling(adaptive, graphScale, logOnce);
@@ -182,6 +208,64 @@ void LoglogVisualizer::visualize(AudioQueue &MainAudioQueue, int minfreq, int ma
     logMessage("Loglog visualization completed.", "INFO", logOnce);
 }
 
+/**
+ * @brief Creates a visualizer for one perceptual scale.
+ *
+ * @param scale Mel or Bark band spacing.
+ */
+FilterbankVisualizer::FilterbankVisualizer(BandScale scale)
+    : scale(scale), stft(FILTERBANK_FFT), workingBuffer(FILTERBANK_FFT), magnitudes(stft.bins())
+{
+}
+
+/**
+ * @brief Visualizes audio data as mel or Bark band energies.
+ *
+ * One bar per band, with the band count following the console width between
+ * FILTERBANK_MIN_BANDS and FILTERBANK_MAX_BANDS. Bars show the last FILTERBANK_RANGE_DB decibels
+ * below full scale, or below the loudest band if adaptive scaling is enabled.
+ * @param MainAudioQueue The audio queue to process.
+ * @param minfreq The lower edge of the first band.
+ * @param maxfreq The upper edge of the last band.
+ * @param consoleWidth The width of the console.
+ * @param consoleHeight The height of the console.
+ * @param adaptive Whether to use adaptive scaling.
+ * @param logOnce Whether to log this operation only once.
+ * @param graphScale Unused; bars are scaled in decibels.
+ */
+void FilterbankVisualizer::visualize(AudioQueue &MainAudioQueue, int minfreq, int maxfreq, int consoleWidth, int consoleHeight, bool adaptive, bool logOnce, float graphScale)
+{
+    (void)graphScale;
+    logMessage("Filterbank visualization started.", "INFO", logOnce);
+
+    int bands = std::max(FILTERBANK_MIN_BANDS, std::min(FILTERBANK_MAX_BANDS, consoleWidth));
+    if (!filterbank || filterbank->size() != bands || builtMin != minfreq || builtMax != maxfreq)
+    {
+        filterbank.reset(new Filterbank(bands, FILTERBANK_FFT, static_cast<float>(minfreq), static_cast<float>(maxfreq), scale));
+        energies.resize(bands);
+        builtMin = minfreq;
+        builtMax = maxfreq;
+        logMessage("Built " + std::to_string(bands) + "-band filterbank using " + std::to_string(filterbank->memoryBytes()) + " bytes.", "INFO", logOnce);
+    }
+
+    MainAudioQueue.peekFreshData(workingBuffer.data(), FILTERBANK_FFT);
+    stft.magnitude(workingBuffer.data(), magnitudes.data());
+    for (float &m : magnitudes)
+        m *= m;
+    filterbank->applyLog(magnitudes.data(), energies.data());
+
+    float top = adaptive ? *std::max_element(energies.begin(), energies.end()) : 0.0f;
+    numbers = bands;
+    graphheight = consoleHeight;
+    initializeHistogram(logOnce);
+    for (int b = 0; b < bands; b++)
+        bargraph[b] = std::max(0, static_cast<int>(100 * (energies[b] - top + FILTERBANK_RANGE_DB)));
+
+    system("cls");
+    show_bargraph(bargraph.data(), numbers, logOnce, graphheight, std::max(1, consoleWidth / bands), static_cast<float>(graphheight) / (100 * FILTERBANK_RANGE_DB), ':');
+    logMessage("Filterbank visualization completed.", "INFO", logOnce);
+}
+
 /**
  * @brief Visualizes audio data using a spectral tuner display.
  *
@@ -236,6 +320,40 @@ void SpectralTuner(AudioQueue &MainAudioQueue, int consoleWidth, int consoleHeig
     logMessage("Spectral tuner visualization completed.", "INFO", logOnce);
 }
 
+/**
+ * @brief Estimates the pitch of the freshest audio from the strongest peaks of a reassigned spectrum.
+ *
+ * A short frame with reassigned frequencies resolves pitch to well under a cent.
+ * @param MainAudioQueue The audio queue to analyze.
+ * @param logOnce Whether to log this operation only once.
+ * @return The pitch in Hz, or 0 if there is no peak.
+ */
+static float detectPitch(AudioQueue &MainAudioQueue, bool logOnce)
+{
+    static ReassignedStft analyzer;
+    static std::vector<sample> workingBuffer(analyzer.samplesNeeded());
+    static std::vector<float> magnitude(analyzer.bins()), frequency(analyzer.bins());
+    MainAudioQueue.peekFreshData(workingBuffer.data(), analyzer.samplesNeeded());
+    analyzer.analyze(workingBuffer.data(), magnitude.data(), frequency.data());
+
+    std::vector<int> maxima;
+    for (int k = 2; k + 1 < analyzer.bins(); k++)
+    {
+        if (magnitude[k] > magnitude[k - 1] && magnitude[k] >= magnitude[k + 1])
+            maxima.push_back(k);
+    }
+    const int numSpikes = std::min(5, static_cast<int>(maxima.size()));
+    std::partial_sort(maxima.begin(), maxima.begin() + numSpikes, maxima.end(), [](int a, int b)
+                      { return magnitude[a] > magnitude[b]; });
+    float spikeFrequencies[5];
+    for (int i = 0; i < numSpikes; i++)
+    {
+        spikeFrequencies[i] = frequency[maxima[i]];
+    }
+
+    return numSpikes > 1 ? approx_hcf(spikeFrequencies, numSpikes, logOnce, 5, 5) : (numSpikes == 1 ? spikeFrequencies[0] : 0.0f);
+}
+
 /**
  * @brief Visualizes audio data using an auto-tuner display.
  *
@@ -248,23 +366,7 @@ void AutoTuner(AudioQueue &MainAudioQueue, int consoleWidth, bool logOnce, int s
 {
     logMessage("Auto tuner visualization started.", "INFO", logOnce);
 
-    sample workingBuffer[FFTLEN];
-    sample spectrum[FFTLEN];
-
-    MainAudioQueue.peekFreshData(workingBuffer, FFTLEN);
-    FindFrequencyContent(spectrum, workingBuffer, FFTLEN, logOnce);
-
-    const int numSpikes = 5;
-    int spikeIndices[numSpikes];
-    float spikeFrequencies[numSpikes];
-
-    Find_n_Largest(spikeIndices, spectrum, numSpikes, FFTLEN / 2, logOnce);
-    for (int i = 0; i < numSpikes; i++)
-    {
-        spikeFrequencies[i] = index2freq(spikeIndices[i], logOnce);
-    }
-
-    float pitch = approx_hcf(spikeFrequencies, numSpikes, logOnce, 5, 5);
+    float pitch = detectPitch(MainAudioQueue, logOnce);
     if (pitch <= 0)
     {
         logMessage("No pitch detected.", "WARNING", logOnce);
@@ -273,7 +375,7 @@ void AutoTuner(AudioQueue &MainAudioQueue, int consoleWidth, bool logOnce, int s
     }
 
     float centsOff = 0.0f;
-    int pitchNum = pitchNumber(pitch, &centsOff);
+    int pitchNum = pitchNumber(pitch, logOnce, &centsOff);
 
     std::vector<char> notenames(consoleWidth + 1, ' ');
 
@@ -289,41 +391,43 @@ void AutoTuner(AudioQueue &MainAudioQueue, int consoleWidth, bool logOnce, int s
 }
 
 /**
- * @brief Attempts to identify chords from audio data.
+ * @brief Picks the distinct notes of the strongest established partials.
  *
- * @param MainAudioQueue The audio queue to process.
+ * Only partials that have lasted a few frames count, so a transient peak cannot flip the chord
+ * for one frame; partials within a quartertone of a chosen one are skipped.
+ * @param partials Partials from a tracker.
  * @param logOnce Whether to log this operation only once.
- * @param max_notes The maximum number of notes to consider.
+ * @param max_notes The maximum number of notes to pick.
+ * @return Sorted pitch numbers of the notes.
  */
-void ChordGuesser(AudioQueue &MainAudioQueue, bool logOnce, int max_notes)
+static std::vector<int> chordTonesOf(const std::vector<Partial> &partials, bool logOnce, int max_notes)
 {
-    logMessage("Chord guesser started.", "INFO", logOnce);
-
-    sample workingBuffer[FFTLEN];
-    sample spectrum[FFTLEN];
-
-    MainAudioQueue.peekFreshData(workingBuffer, FFTLEN);
-    FindFrequencyContent(spectrum, workingBuffer, FFTLEN, logOnce);
-
-    const int numSpikes = 10;
-    int spikeIndices[numSpikes];
-    float spikeFrequencies[numSpikes];
+    std::vector<Partial> established;
+    for (const Partial &partial : partials)
+    {
+        if (partial.age >= PARTIAL_MIN_AGE && partial.missed == 0)
+            established.push_back(partial);
+    }
+    std::sort(established.begin(), established.end(), [](const Partial &a, const Partial &b)
+              { return a.magnitude > b.magnitude; });
 
-    Find_n_Largest(spikeIndices, spectrum, numSpikes, FFTLEN / 2, false);
+    const int numSpikes = std::min(10, static_cast<int>(established.size()));
+    float spikeFrequencies[10];
     for (int i = 0; i < numSpikes; i++)
     {
-        spikeFrequencies[i] = index2freq(spikeIndices[i], logOnce);
+        spikeFrequencies[i] = established[i].frequency;
     }
 
     const float quartertone = pow(2.0, 1.0 / 24.0);
     std::vector<int> chordTones;
+    std::vector<float> chosenFrequencies; // Frequencies behind chordTones, for the quartertone test
 
-    for (int i = 0; i < numSpikes && chordTones.size() < max_notes; i++)
+    for (int i = 0; i < numSpikes && static_cast<int>(chordTones.size()) < max_notes; i++)
     {
         bool distinct = true;
-        for (int tone : chordTones)
+        for (float chosen : chosenFrequencies)
         {
-            float separation = std::max(spikeFrequencies[i], static_cast<float>(tone)) / std::min(spikeFrequencies[i], static_cast<float>(tone));
+            float separation = std::max(spikeFrequencies[i], chosen) / std::min(spikeFrequencies[i], chosen);
             if (separation < quartertone)
             {
                 distinct = false;
@@ -333,14 +437,52 @@ void ChordGuesser(AudioQueue &MainAudioQueue, bool logOnce, int max_notes)
         if (distinct)
         {
             chordTones.push_back(pitchNumber(spikeFrequencies[i], logOnce));
+            chosenFrequencies.push_back(spikeFrequencies[i]);
         }
     }
 
     std::sort(chordTones.begin(), chordTones.end());
     chordTones.erase(std::unique(chordTones.begin(), chordTones.end()), chordTones.end());
+    return chordTones;
+}
 
-    char chordName[CHORD_NAME_SIZE] = {0};
-    int nameLength = identify_chord(chordName, chordTones.data(), chordTones.size());
+/**
+ * @brief Attempts to identify chords from audio data.
+ *
+ * @param MainAudioQueue The audio queue to process.
+ * @param logOnce Whether to log this operation only once.
+ * @param max_notes The maximum number of notes to consider.
+ */
+void ChordGuesser(AudioQueue &MainAudioQueue, bool logOnce, int max_notes)
+{
+    logMessage("Chord guesser started.", "INFO", logOnce);
+
+    sample workingBuffer[FFTLEN];
+    sample spectrum[FFTLEN];
+
+    MainAudioQueue.peekFreshData(workingBuffer, FFTLEN);
+    FindFrequencyContent(spectrum, workingBuffer, FFTLEN, logOnce);
+
+    // Follow partials across calls
+    static PartialTracker tracker;
+    static std::vector<float> magnitude(FFTLEN / 2);
+    static std::vector<SpectralPeak> peaks;
+    static std::vector<PartialUpdate> events;
+    std::copy(spectrum, spectrum + FFTLEN / 2, magnitude.begin());
+    findPeaks(peaks, magnitude.data(), FFTLEN / 2, index2freq(1, logOnce), 1.0f);
+    tracker.update(peaks, events);
+    std::vector<int> chordTones = chordTonesOf(tracker.partials(), logOnce, max_notes);
+
+    // The established partials change far less often than frames arrive
+    static std::vector<int> lastTones;
+    static char chordName[CHORD_NAME_SIZE] = {0};
+    static int nameLength = 0;
+    if (chordTones != lastTones)
+    {
+        std::fill(chordName, chordName + CHORD_NAME_SIZE, 0);
+        nameLength = chordTones.empty() ? 0 : identify_chord(chordName, chordTones.data(), chordTones.size()); // Released into silence
+        lastTones = chordTones;
+    }
 
     if (nameLength > 0)
     {
@@ -360,4 +502,376 @@ void ChordGuesser(AudioQueue &MainAudioQueue, bool logOnce, int max_notes)
         logMessage("No chord detected.", "WARNING", logOnce);
     }
     logMessage("Chord guesser completed.", "INFO", logOnce);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Displays the band levels of a time-domain octave filterbank.
+ *
+ * The filterbank runs in the recording callback, so the bars trail the input by only the device
+ * buffer and the detector time constant instead of a 65536-sample FFT frame.
+ * @param bank The filterbank fed by the recording callback.
+ * @param consoleWidth The width of the console.
+ * @param consoleHeight The height of the console.
+ * @param logOnce Whether to log this operation only once.
+ */
+void OctaveBandDisplay(const OctaveFilterbank &bank, int consoleWidth, int consoleHeight, bool logOnce)
+{
+    logMessage("Octave band display started.", "INFO", logOnce);
+
+    std::vector<float> levels(bank.size());
+    bank.levels(levels.data());
+    std::vector<int> bars(bank.size());
+    for (int b = 0; b < bank.size(); b++)
+        bars[b] = std::max(0, static_cast<int>(100 * (levels[b] + OCTAVE_RANGE_DB)));
+
+    system("cls");
+    show_bargraph(bars.data(), bank.size(), logOnce, consoleHeight, std::max(1, consoleWidth / bank.size()), static_cast<float>(consoleHeight) / (100 * OCTAVE_RANGE_DB), '#');
+    std::cout << "Lowest band " << bank.centerFrequency(0) << " Hz, highest " << bank.centerFrequency(bank.size() - 1) << " Hz, " << OCTAVE_RANGE_DB << " dB range\n";
+    logMessage("Octave band display completed.", "INFO", logOnce);
+}
+
+/**
+ * @brief Draws the goniometer and the correlation and mid/side meters.
+ *
+ * Mono sits on the vertical axis, out-of-phase content on the horizontal one. Each cell is shaded
+ * by its share of the brightest cell.
+ * @param meter The meter fed with the stereo pair.
+ * @param consoleWidth The width of the console.
+ * @param logOnce Whether to log this operation only once.
+ */
+void StereoDisplay(const StereoMeter &meter, int consoleWidth, bool logOnce)
+{
+    logMessage("Stereo display started.", "INFO", logOnce);
+
+    static const char shades[] = " .:+*#@";
+    const std::vector<float> &scope = meter.goniometer();
+    float brightest = std::max(1e-6f, *std::max_element(scope.begin(), scope.end()));
+
+    std::string screen;
+    for (int row = 0; row < SCOPE_SIZE; row++)
+    {
+        for (int column = 0; column < SCOPE_SIZE; column++)
+        {
+            float cell = scope[row * SCOPE_SIZE + column];
+            char shade = shades[static_cast<int>(std::sqrt(cell / brightest) * 6)];
+            if (shade == ' ' && (column == SCOPE_SIZE / 2 || row == SCOPE_SIZE / 2))
+                shade = column == SCOPE_SIZE / 2 ? '|' : '-';
+            screen += shade;
+            screen += shade == '|' ? ' ' : shade; // Cells are twice as wide to look square
+        }
+        screen += '\n';
+    }
+
+    // Correlation bar from -1 (left end) to +1 (right end)
+    int width = std::max(11, std::min(consoleWidth - 20, 2 * SCOPE_SIZE));
+    std::string bar(width, '-');
+    bar[width / 2] = '|';
+    bar[static_cast<int>((meter.correlation() + 1) / 2 * (width - 1) + 0.5f)] = '#';
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "Correlation %+.2f  [%s]\nL %6.1f dB  R %6.1f dB  M %6.1f dB  S %6.1f dB\n", meter.correlation(), bar.c_str(),
+                  meter.leftDb(), meter.rightDb(), meter.midDb(), meter.sideDb());
+
+    system("cls");
+    std::cout << screen << line;
+    logMessage("Stereo display completed.", "INFO", logOnce);
+}
+
+/**
+ * @brief Computes the spectral descriptors of the newest frame and prints them.
+ *
+ * Each band energy is drawn as a bar over the last FILTERBANK_RANGE_DB decibels below full scale.
+ * @param MainAudioQueue The audio queue to process.
+ * @param consoleWidth The width of the console.
+ * @param logOnce Whether to log this operation only once.
+ * @return The descriptors, for exporters; valid until the next call.
+ */
+const SpectralFeatures &FeatureDisplay(AudioQueue &MainAudioQueue, int consoleWidth, bool logOnce)
+{
+    logMessage("Feature display started.", "INFO", logOnce);
+
+    static Stft stft(FEATURE_FFT);
+    static FeatureBank<AllFeatures> bank(stft.bins(), static_cast<float>(RATE) / FEATURE_FFT);
+    static std::vector<sample> workingBuffer(FEATURE_FFT);
+    static std::vector<float> magnitude(stft.bins());
+    static SpectralFeatures features;
+
+    MainAudioQueue.peekFreshData(workingBuffer.data(), FEATURE_FFT);
+    stft.magnitude(workingBuffer.data(), magnitude.data());
+    bank.compute(magnitude.data(), features);
+
+    char line[200];
+    std::snprintf(line, sizeof(line), "Centroid %7.0f Hz   Spread %7.0f Hz   Rolloff %7.0f Hz\nFlatness %7.3f      Flux %9.4f\n\n",
+                  features.centroid, features.spread, features.rolloff, features.flatness, features.flux);
+    std::string screen = line;
+
+    int width = std::max(10, consoleWidth - 22);
+    for (int b = 0; b < FEATURE_BANDS; b++)
+    {
+        float level = std::max(0.0f, std::min(1.0f, (features.bands[b] + FILTERBANK_RANGE_DB) / FILTERBANK_RANGE_DB));
+        std::snprintf(line, sizeof(line), "%5d Hz %6.1f dB ", static_cast<int>(featureBandEdge(b)), features.bands[b]);
+        screen += line;
+        screen += std::string(static_cast<int>(level * width), '#');
+        screen += '\n';
+    }
+
+    system("cls");
+    std::cout << screen;
+    logMessage("Feature display completed.", "INFO", logOnce);
+    return features;
+}
+
+/**
+ * @brief Identifies the track playing into the microphone from the last FINGERPRINT_QUERY samples.
+ *
+ * @param index The reference index, or nullptr if none was given on the command line.
+ * @param MainAudioQueue The audio queue to process.
+ * @param logOnce Whether to log this operation only once.
+ */
+void FingerprintDisplay(const FingerprintIndex *index, AudioQueue &MainAudioQueue, bool logOnce)
+{
+    logMessage("Fingerprint display started.", "INFO", logOnce);
+    if (!index)
+    {
+        std::cout << "No fingerprint index; start with --fingerprint-dir DIR or --fingerprint-index PATH.\n";
+        return;
+    }
+
+    static std::vector<sample> workingBuffer(FINGERPRINT_QUERY);
+    MainAudioQueue.peekFreshData(workingBuffer.data(), FINGERPRINT_QUERY);
+    FingerprintMatch match = index->query(workingBuffer.data(), FINGERPRINT_QUERY);
+
+    char line[300];
+    if (match.track >= 0)
+        std::snprintf(line, sizeof(line), "Playing: %s at %.1f s (%d of %d landmarks agree)\n", match.name.c_str(), match.offsetSeconds, match.votes, match.landmarks);
+    else
+        std::snprintf(line, sizeof(line), "No match among %d tracks (%d landmarks heard)\n", index->trackCount(), match.landmarks);
+
+    system("cls");
+    std::cout << line;
+    logMessage("Fingerprint display completed.", "INFO", logOnce);
+}
+
+/**
+ * @brief Lists the library passages most like the last SEARCH_QUERY samples.
+ *
+ * @param index The similarity index, or nullptr if none was given on the command line.
+ * @param MainAudioQueue The audio queue to process.
+ * @param logOnce Whether to log this operation only once.
+ */
+void SimilarityDisplay(const SimilarityIndex *index, AudioQueue &MainAudioQueue, bool logOnce)
+{
+    logMessage("Similarity display started.", "INFO", logOnce);
+    if (!index)
+    {
+        std::cout << "No similarity index; start with --similarity-dir DIR or --similarity-index PATH.\n";
+        return;
+    }
+
+    static std::vector<sample> workingBuffer(SEARCH_QUERY);
+    MainAudioQueue.peekFreshData(workingBuffer.data(), SEARCH_QUERY);
+    std::vector<PassageMatch> passages = index->searchPassage(workingBuffer.data(), SEARCH_QUERY, SEARCH_RESULTS);
+
+    std::string screen = "Most similar passages:\n";
+    char line[300];
+    for (const PassageMatch &passage : passages)
+    {
+        std::snprintf(line, sizeof(line), "  %-40s %7.1f s  (%d votes, distance %.3f)\n", passage.name.c_str(), passage.seconds, passage.votes, passage.distance);
+        screen += line;
+    }
+    if (passages.empty())
+        screen += "  none\n";
+
+    system("cls");
+    std::cout << screen;
+    logMessage("Similarity display completed.", "INFO", logOnce);
+}
+
+/**
+ * @brief Appends the mel spectrum of the freshest PYRAMID_FRAME samples to the session overview.
+ *
+ * The caller decides when a column is due, once per PYRAMID_FRAME of time; each call analyzes
+ * and appends exactly one column.
+ * @param pyramid The session overview; its bin count must not change between calls.
+ * @param MainAudioQueue The audio queue to read.
+ */
+void OverviewFeed(SpectrogramPyramid &pyramid, AudioQueue &MainAudioQueue)
+{
+    static Stft stft(PYRAMID_FRAME);
+    static Filterbank mel(pyramid.bins(), PYRAMID_FRAME, 40.0f, 16000.0f);
+    static std::vector<sample> workingBuffer(PYRAMID_FRAME);
+    static std::vector<float> power(stft.bins()), bands(pyramid.bins());
+
+    MainAudioQueue.peekFreshData(workingBuffer.data(), PYRAMID_FRAME);
+    stft.magnitude(workingBuffer.data(), power.data());
+    for (float &p : power)
+        p *= p;
+    mel.applyLog(power.data(), bands.data());
+    pyramid.append(bands.data());
+}
+
+/**
+ * @brief Draws the session overview: time across, mel bands up, shaded over FILTERBANK_RANGE_DB.
+ *
+ * @param pyramid The session overview.
+ * @param span Most recent columns to show; 0 shows the whole session.
+ * @param consoleWidth The width of the console.
+ * @param consoleHeight The height of the console.
+ * @param logOnce Whether to log this operation only once.
+ */
+void OverviewDisplay(const SpectrogramPyramid &pyramid, uint64_t span, int consoleWidth, int consoleHeight, bool logOnce)
+{
+    logMessage("Overview display started.", "INFO", logOnce);
+    static const char shades[] = " .:+*#@";
+    int width = std::max(1, consoleWidth - 1), rows = std::max(1, std::min(consoleHeight - 3, pyramid.bins()));
+    uint64_t last = pyramid.columns(), first = span > 0 && span < last ? last - span : 0;
+
+    static std::vector<float> view;
+    view.resize(static_cast<size_t>(width) * pyramid.bins());
+    pyramid.render(first, last, width, view.data());
+    float loudest = *std::max_element(view.begin(), view.end());
+
+    std::string screen;
+    for (int row = rows - 1; row >= 0; row--)
+    {
+        int lowBand = row * pyramid.bins() / rows, highBand = (row + 1) * pyramid.bins() / rows;
+        for (int x = 0; x < width; x++)
+        {
+            float level = *std::max_element(view.begin() + x * pyramid.bins() + lowBand, view.begin() + x * pyramid.bins() + highBand);
+            float shade = std::clamp(1.0f - (loudest - level) / FILTERBANK_RANGE_DB, 0.0f, 1.0f);
+            screen += shades[static_cast<int>(shade * 6)];
+        }
+        screen += '\n';
+    }
+
+    char line[160];
+    double seconds = static_cast<double>(PYRAMID_FRAME) / RATE;
+    std::snprintf(line, sizeof(line), "Last %.0f s of %.0f s, %.2f s per column ('+' zooms in, '-' out)\n", (last - first) * seconds, last * seconds,
+                  (last - first) * seconds / width);
+    screen += line;
+
+    system("cls");
+    std::cout << screen;
+    logMessage("Overview display completed.", "INFO", logOnce);
+}
+
+/**
+ * @brief Columns of the analysis results store, besides the time.
+ */
+std::vector<ColumnSpec> resultsColumns()
+{
+    return {{"pitch", ColumnType::Float}, {"cents", ColumnType::Float}, {"chord", ColumnType::Text}, {"rms", ColumnType::Float}, {"onset", ColumnType::Int}};
+}
+
+/**
+ * @brief Analyzes the freshest audio and appends one row to the results store.
+ *
+ * Pitch and cents come from the automatic tuner's estimate and are 0 without a pitch; the chord
+ * comes from partials tracked over a RESULTS_CHORD_FRAME spectrum and is empty without one; RMS
+ * is the level of the last hop in dBFS; an onset is marked when the spectral flux jumps above
+ * RESULTS_ONSET_RATIO times its running mean. The caller calls this about once per RESULTS_HOP;
+ * rows missed while the loop was busy are not filled in, the store counts the gap as a pause.
+ * @param store Store opened with resultsColumns().
+ * @param MainAudioQueue The audio queue to analyze.
+ * @param timeMs Time of the analysis, in milliseconds.
+ * @param logOnce Whether to log this operation only once.
+ */
+void ResultsFeed(ColumnStore &store, AudioQueue &MainAudioQueue, int64_t timeMs, bool logOnce)
+{
+    static Stft stft(RESULTS_CHORD_FRAME);
+    static FeatureBank<FeatureFlux> fluxBank(stft.bins(), static_cast<float>(RATE) / RESULTS_CHORD_FRAME);
+    static std::vector<sample> workingBuffer(RESULTS_CHORD_FRAME);
+    static std::vector<float> magnitude(stft.bins());
+    static PartialTracker tracker;
+    static std::vector<SpectralPeak> peaks;
+    static std::vector<PartialUpdate> events;
+    static std::vector<int> lastTones;
+    static int chordCode = -1;
+    static float meanFlux = 0;
+
+    float pitch = detectPitch(MainAudioQueue, logOnce), cents = 0;
+    if (pitch > 0)
+        pitchNumber(pitch, logOnce, &cents);
+    else
+        pitch = 0;
+
+    MainAudioQueue.peekFreshData(workingBuffer.data(), RESULTS_CHORD_FRAME);
+    double energy = 0;
+    for (int i = RESULTS_CHORD_FRAME - RESULTS_HOP; i < RESULTS_CHORD_FRAME; i++)
+        energy += static_cast<double>(workingBuffer[i]) * workingBuffer[i];
+    double rms = std::sqrt(energy / RESULTS_HOP) / 32768.0;
+
+    stft.magnitude(workingBuffer.data(), magnitude.data());
+    SpectralFeatures features;
+    fluxBank.compute(magnitude.data(), features);
+    bool onset = meanFlux > 0 && features.flux > RESULTS_ONSET_RATIO * meanFlux;
+    meanFlux += 0.05f * (features.flux - meanFlux);
+
+    findPeaks(peaks, magnitude.data(), stft.bins(), stft.binFrequency(1), 1e-3f); // Peaks above -60 dBFS
+    tracker.update(peaks, events);
+    std::vector<int> chordTones = chordTonesOf(tracker.partials(), logOnce, 4);
+    if (chordTones != lastTones || chordCode < 0)
+    {
+        char chordName[CHORD_NAME_SIZE] = {0};
+        if (!chordTones.empty())
+            identify_chord(chordName, chordTones.data(), chordTones.size());
+        chordCode = store.textCode(store.column("chord"), chordName);
+        lastTones = chordTones;
+    }
+
+    double values[5] = {pitch, cents, static_cast<double>(chordCode), rms > 1.6e-5 ? 20 * std::log10(rms) : -96.0, onset ? 1.0 : 0.0};
+    store.append(timeMs, values);
+}
+
+/**
+ * @brief Prints what the results store recorded over the last hour.
+ *
+ * The queries are repeated at most once a second; each reads only the columns it needs.
+ * @param store Store opened with resultsColumns().
+ * @param logOnce Whether to log this operation only once.
+ */
+void ResultsDisplay(const ColumnStore &store, bool logOnce)
+{
+    logMessage("Results report started.", "INFO", logOnce);
+    static std::string screen;
+    static int64_t reportedAt = 0;
+    int64_t now = store.lastTime();
+    if (screen.empty() || now - reportedAt >= 1000)
+    {
+        const double infinity = std::numeric_limits<double>::infinity();
+        int64_t from = now - 3600 * 1000, to = now + 1;
+        int cents = store.column("cents"), pitch = store.column("pitch"), chord = store.column("chord");
+        double pitched = store.secondsWithin(pitch, 1e-3, infinity, from, to);
+        double outOfTune = store.secondsWithin(cents, std::nextafter(10.0f, 100.0f), infinity, from, to) +
+                           store.secondsWithin(cents, -infinity, std::nextafter(-10.0f, -100.0f), from, to);
+        ColumnSummary level = store.summarize(store.column("rms"), from, to);
+        ColumnSummary onsets = store.summarize(store.column("onset"), from, to);
+
+        std::vector<int64_t> times;
+        std::vector<double> codes;
+        std::vector<uint64_t> counts;
+        store.scan(chord, from, to, times, codes);
+        for (double code : codes)
+        {
+            counts.resize(std::max(counts.size(), static_cast<size_t>(code) + 1));
+            counts[static_cast<size_t>(code)]++;
+        }
+        size_t common = counts.size();
+        for (size_t c = 0; c < counts.size(); c++)
+            if (!store.text(chord, static_cast<int>(c)).empty() && (common == counts.size() || counts[c] > counts[common]))
+                common = c;
+
+        char line[200];
+        std::snprintf(line, sizeof(line), "Last hour: %llu frames\n\nPitched   %8.1f s\nOut of tune by more than 10 cents %8.1f s (%.0f%% of pitched)\n",
+                      static_cast<unsigned long long>(level.rows), pitched, outOfTune, pitched > 0 ? 100 * outOfTune / pitched : 0.0);
+        screen = line;
+        std::snprintf(line, sizeof(line), "Mean level %6.1f dBFS, loudest %6.1f dBFS\nOnsets %llu\nMost common chord: %s\n", level.rows > 0 ? level.sum / level.rows : -96.0,
+                      level.max, static_cast<unsigned long long>(onsets.sum), common < counts.size() ? store.text(chord, static_cast<int>(common)).c_str() : "none");
+        screen += line;
+        reportedAt = now;
+    }
+
+    system("cls");
+    std::cout << screen;
+    logMessage("Results report completed.", "INFO", logOnce);
+}
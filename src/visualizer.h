@@ -6,6 +6,22 @@
 #include <cmath>
 #include "helper.h"
 #include "chordDictionary.h"
+#include "filterbank.h"
+#include "octaveFilterbank.h"
+#include "partialTracker.h"
+#include "reassignment.h"
+#include "stereoMeter.h"
+#include "spectralFeatures.h"
+#include "fingerprint.h"
+#include "similaritySearch.h"
+#include "spectrogramPyramid.h"
+#include "columnStore.h"
+#include "fftPlan.h"
+#include <memory>
+
+#define RESULTS_HOP 512            /// Samples between rows of the analysis results store
+#define RESULTS_CHORD_FRAME 16384  /// Spectrum the recorded chord and onsets are found in
+#define RESULTS_ONSET_RATIO 2.0f   /// Flux above this multiple of its running mean marks an onset
 
 /// Abstract Base Class for Visualizers
 class Visualizer
@@ -18,8 +34,11 @@ protected:
     void initializeHistogram(bool logOnce);
     void applyAdaptiveScaling(bool adaptive, float &graphScale, bool logOnce);
     void smoothHistogram(bool logOnce);
+    int analyzeRange(AudioQueue &MainAudioQueue, sample *spectrum, int minfreq, int maxfreq, bool logSpacing, bool logOnce);
 
 public:
+    static float latencyBudgetMs; /// Longest analysis frame; see chooseAnalysisPlan()
+
     virtual void visualize(AudioQueue &MainAudioQueue, int minfreq, int maxfreq, int consoleWidth, int consoleHeight, bool adaptive, bool logOnce, float graphScale = 0.0008) = 0;
 };
 
@@ -44,9 +63,36 @@ public:
     void visualize(AudioQueue &MainAudioQueue, int minfreq, int maxfreq, int consoleWidth, int consoleHeight, bool adaptive, bool logOnce, float graphScale = 0.0008) override;
 };
 
+/// Mel or Bark band energies in dB, from a sparse triangular filterbank
+class FilterbankVisualizer : public Visualizer
+{
+private:
+    BandScale scale;
+    Stft stft;
+    std::unique_ptr<Filterbank> filterbank; /// Rebuilt only when the band layout changes
+    int builtMin = 0, builtMax = 0;
+    std::vector<sample> workingBuffer; /// Latest FILTERBANK_FFT samples
+    std::vector<float> magnitudes;
+    std::vector<float> energies;
+
+public:
+    explicit FilterbankVisualizer(BandScale scale);
+    void visualize(AudioQueue &MainAudioQueue, int minfreq, int maxfreq, int consoleWidth, int consoleHeight, bool adaptive, bool logOnce, float graphScale = 0.0008) override;
+};
+
 /// Spectral Tuner
 void SpectralTuner(AudioQueue &MainAudioQueue, int consoleWidth, int consoleHeight, bool logOnce, bool adaptive = false, float graphScale = 0.0008);
 void AutoTuner(AudioQueue &MainAudioQueue, int consoleWidth, bool logOnce, int span_semitones = 4);
 void ChordGuesser(AudioQueue &MainAudioQueue, bool logOnce, int max_notes = 4);
+void OctaveBandDisplay(const OctaveFilterbank &bank, int consoleWidth, int consoleHeight, bool logOnce);
+void StereoDisplay(const StereoMeter &meter, int consoleWidth, bool logOnce);
+const SpectralFeatures &FeatureDisplay(AudioQueue &MainAudioQueue, int consoleWidth, bool logOnce);
+void FingerprintDisplay(const FingerprintIndex *index, AudioQueue &MainAudioQueue, bool logOnce);
+void SimilarityDisplay(const SimilarityIndex *index, AudioQueue &MainAudioQueue, bool logOnce);
+void OverviewFeed(SpectrogramPyramid &pyramid, AudioQueue &MainAudioQueue);
+void OverviewDisplay(const SpectrogramPyramid &pyramid, uint64_t span, int consoleWidth, int consoleHeight, bool logOnce);
+std::vector<ColumnSpec> resultsColumns();
+void ResultsFeed(ColumnStore &store, AudioQueue &MainAudioQueue, int64_t timeMs, bool logOnce);
+void ResultsDisplay(const ColumnStore &store, bool logOnce);
 
 #endif // VISUALIZER_H
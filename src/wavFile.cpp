@@ -0,0 +1,207 @@
+#include "wavFile.h"
+#include "logger.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+/**
+ * @brief Reads a little-endian unsigned integer of 1 to 4 bytes.
+ */
+static uint32_t readLittle(const uint8_t *bytes, int count)
+{
+    uint32_t value = 0;
+    for (int i = count - 1; i >= 0; i--)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+/**
+ * @brief Writes a little-endian unsigned integer of 1 to 4 bytes.
+ */
+static void writeLittle(std::ofstream &file, uint32_t value, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        file.put(static_cast<char>(value & 0xFF));
+        value >>= 8;
+    }
+}
+
+/**
+ * @brief Logs and throws a format error for a WAV file.
+ */
+[[noreturn]] static void wavError(const std::string &path, const std::string &problem)
+{
+    logMessage("Cannot read WAV file " + path + ": " + problem, "ERROR");
+    throw std::runtime_error("Cannot read WAV file " + path + ": " + problem);
+}
+
+/**
+ * @brief Converts one stored sample to the range of a 16-bit sample.
+ */
+static double decodeSample(const uint8_t *bytes, int bits, bool isFloat)
+{
+    if (isFloat)
+    {
+        float value;
+        std::memcpy(&value, bytes, sizeof(value));
+        return value * 32768.0;
+    }
+    switch (bits)
+    {
+    case 8:
+        return (static_cast<int>(bytes[0]) - 128) * 256.0; // 8-bit WAV is unsigned
+    case 16:
+        return static_cast<int16_t>(readLittle(bytes, 2));
+    case 24:
+        return static_cast<int32_t>(readLittle(bytes, 3) << 8) / 65536.0; // Sign-extended through the top byte
+    default:
+        return static_cast<int32_t>(readLittle(bytes, 4)) / 65536.0;
+    }
+}
+
+/**
+ * @brief Reads a WAV file and converts it to mono 16-bit samples at RATE.
+ *
+ * Understands integer PCM of 8, 16, 24 or 32 bits and 32-bit float, plain or in the extensible
+ * format. Channels are averaged and other rates are resampled linearly. Chunks other than
+ * "fmt " and "data" are skipped.
+ * @param path Path of the file.
+ * @return The converted audio.
+ * @throws std::runtime_error if the file cannot be read or its format is not supported.
+ */
+WavAudio readWav(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        wavError(path, "cannot open file");
+
+    uint8_t riff[12];
+    if (!file.read(reinterpret_cast<char *>(riff), sizeof(riff)) || std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0)
+        wavError(path, "not a RIFF/WAVE file");
+
+    int format = 0, channels = 0, rate = 0, bits = 0;
+    std::vector<uint8_t> data;
+    uint8_t chunk[8];
+    while (file.read(reinterpret_cast<char *>(chunk), sizeof(chunk)))
+    {
+        uint32_t size = readLittle(chunk + 4, 4);
+        if (std::memcmp(chunk, "fmt ", 4) == 0)
+        {
+            std::vector<uint8_t> fmt(size);
+            if (size < 16 || !file.read(reinterpret_cast<char *>(fmt.data()), size))
+                wavError(path, "truncated format chunk");
+            format = static_cast<int>(readLittle(fmt.data(), 2));
+            channels = static_cast<int>(readLittle(fmt.data() + 2, 2));
+            rate = static_cast<int>(readLittle(fmt.data() + 4, 4));
+            bits = static_cast<int>(readLittle(fmt.data() + 14, 2));
+            if (format == 0xFFFE && size >= 26)
+                format = static_cast<int>(readLittle(fmt.data() + 24, 2)); // Sub-format GUID starts with the format tag
+            if (size & 1)
+                file.seekg(1, std::ios::cur);
+        }
+        else if (std::memcmp(chunk, "data", 4) == 0)
+        {
+            data.resize(size);
+            file.read(reinterpret_cast<char *>(data.data()), size);
+            data.resize(static_cast<size_t>(file.gcount())); // Tolerate a truncated final chunk
+            break;
+        }
+        else
+            file.seekg(size + (size & 1), std::ios::cur); // Chunks are padded to even sizes
+    }
+
+    bool isFloat = format == 3;
+    if (channels == 0)
+        wavError(path, "missing format chunk");
+    if ((format != 1 && !isFloat) || (isFloat && bits != 32) || (!isFloat && bits != 8 && bits != 16 && bits != 24 && bits != 32))
+        wavError(path, "unsupported encoding (format " + std::to_string(format) + ", " + std::to_string(bits) + " bits)");
+    if (rate <= 0)
+        wavError(path, "invalid sample rate");
+
+    WavAudio audio;
+    audio.sourceRate = rate;
+    audio.sourceChannels = channels;
+    int bytesPerSample = bits / 8;
+    size_t frames = data.size() / (static_cast<size_t>(bytesPerSample) * channels);
+    std::vector<sample> mono(frames);
+    const uint8_t *p = data.data();
+    for (size_t i = 0; i < frames; i++)
+    {
+        double sum = 0;
+        for (int c = 0; c < channels; c++, p += bytesPerSample)
+            sum += decodeSample(p, bits, isFloat);
+        double value = sum / channels;
+        mono[i] = static_cast<sample>(value > MAX_SAMPLE_VALUE ? MAX_SAMPLE_VALUE : (value < -MAX_SAMPLE_VALUE - 1 ? -MAX_SAMPLE_VALUE - 1 : value));
+    }
+    audio.samples = rate == RATE ? std::move(mono) : resampleLinear(mono, rate, RATE);
+    return audio;
+}
+
+/**
+ * @brief Writes 16-bit mono PCM samples to a WAV file.
+ *
+ * @param path Path of the file to create or truncate.
+ * @param samples Samples to write.
+ * @param n Number of samples.
+ * @param rate Sample rate recorded in the header.
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void writeWav(const std::string &path, const sample *samples, size_t n, int rate)
+{
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+    {
+        logMessage("Cannot write WAV file " + path, "ERROR");
+        throw std::runtime_error("Cannot write WAV file " + path);
+    }
+    uint32_t dataBytes = static_cast<uint32_t>(n * sizeof(sample));
+    file.write("RIFF", 4);
+    writeLittle(file, 36 + dataBytes, 4);
+    file.write("WAVEfmt ", 8);
+    writeLittle(file, 16, 4);
+    writeLittle(file, 1, 2); // PCM
+    writeLittle(file, 1, 2); // Mono
+    writeLittle(file, static_cast<uint32_t>(rate), 4);
+    writeLittle(file, static_cast<uint32_t>(rate * sizeof(sample)), 4);
+    writeLittle(file, sizeof(sample), 2);
+    writeLittle(file, 16, 2);
+    file.write("data", 4);
+    writeLittle(file, dataBytes, 4);
+    for (size_t i = 0; i < n; i++)
+        writeLittle(file, static_cast<uint16_t>(samples[i]), 2);
+    if (!file)
+    {
+        logMessage("Cannot write WAV file " + path, "ERROR");
+        throw std::runtime_error("Cannot write WAV file " + path);
+    }
+}
+
+/**
+ * @brief Changes the sample rate by linear interpolation.
+ *
+ * Good enough for fingerprinting and level analysis; no anti-aliasing filter is applied when
+ * downsampling.
+ * @param input Samples at fromRate.
+ * @param fromRate Rate of input.
+ * @param toRate Rate of the result.
+ * @return The resampled signal.
+ */
+std::vector<sample> resampleLinear(const std::vector<sample> &input, int fromRate, int toRate)
+{
+    if (input.empty())
+        return {};
+    size_t length = static_cast<size_t>(static_cast<double>(input.size()) * toRate / fromRate);
+    std::vector<sample> output(length);
+    double step = static_cast<double>(fromRate) / toRate;
+    for (size_t i = 0; i < length; i++)
+    {
+        double position = i * step;
+        size_t index = static_cast<size_t>(position);
+        double fraction = position - index;
+        int next = index + 1 < input.size() ? input[index + 1] : input[index];
+        output[i] = static_cast<sample>(input[index] + fraction * (next - input[index]));
+    }
+    return output;
+}
@@ -0,0 +1,22 @@
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include "audioProcessor.h"
+#include <string>
+#include <vector>
+
+/// Contents of a WAV file after conversion to the application's format
+struct WavAudio
+{
+    int sourceRate = RATE;       /// Sample rate stored in the file
+    int sourceChannels = 1;      /// Channels stored in the file, mixed down in samples
+    std::vector<sample> samples; /// Mono samples at RATE
+
+    double seconds() const { return static_cast<double>(samples.size()) / RATE; }
+};
+
+WavAudio readWav(const std::string &path);                                                 /// PCM 8/16/24/32-bit or 32-bit float, any rate
+void writeWav(const std::string &path, const sample *samples, size_t n, int rate = RATE); /// 16-bit mono PCM
+std::vector<sample> resampleLinear(const std::vector<sample> &input, int fromRate, int toRate);
+
+#endif // WAV_FILE_H